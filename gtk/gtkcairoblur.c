@@ -25,6 +25,20 @@
 #include <math.h>
 #include <string.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define HAVE_BLUR_X86 1
+#include <immintrin.h>
+#define BLUR_TARGET_SSE2 __attribute__((target("sse2")))
+#define BLUR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_BLUR_NEON 1
+#include <arm_neon.h>
+#endif
+
 /*
  * Gets the size for a single box blur.
  *
@@ -218,6 +232,557 @@ _boxblur (guchar      *buffer,
   g_free (flipped_buffer);
 }
 
+/* The vectorized implementations below use a different layout than
+ * the scalar code above: instead of running the sliding window along
+ * a row, they run it down the columns, one row at a time, so that
+ * neighbouring columns can be processed in parallel. The horizontal
+ * pass is then done by transposing the buffer. The arithmetic is the
+ * same, so the results are identical to the scalar code.
+ */
+typedef void (* BlurRowFunc)        (guchar       *dst,
+                                     const guchar *add,
+                                     const guchar *sub,
+                                     gint32       *sums,
+                                     int           width,
+                                     int           d);
+typedef void (* TransposeBlockFunc) (guchar       *dst,
+                                     int           dst_stride,
+                                     const guchar *src,
+                                     int           src_stride);
+
+typedef struct {
+  const char         *name;
+  BlurRowFunc         blur_row;
+  TransposeBlockFunc  transpose_block;
+} BlurImpl;
+
+#define TRANSPOSE_BLOCK_SIZE 16
+
+/* Updates the running column sums for columns [start, end) by
+ * adding the row entering the window and removing the row leaving
+ * it, and writes the averaged row if there is one. */
+static inline void
+blur_row_span (guchar       *dst,
+               const guchar *add,
+               const guchar *sub,
+               gint32       *sums,
+               int           start,
+               int           end,
+               int           d)
+{
+  int j;
+
+  for (j = start; j < end; j++)
+    {
+      gint32 sum = sums[j];
+
+      if (add)
+        sum += add[j];
+      if (sub)
+        sum -= sub[j];
+      sums[j] = sum;
+
+      if (dst)
+        dst[j] = (sum + d / 2) / d;
+    }
+}
+
+#ifdef HAVE_BLUR_X86
+
+/* Computes (s + d / 2) / d. Single precision floats represent all
+ * the values involved exactly, so we compute the quotient with a
+ * multiplication by 1/d and then correct the result by one if the
+ * rounding of 1/d made us land on the wrong integer. */
+static inline BLUR_TARGET_SSE2 __m128i
+blur_div_sse2 (__m128i s,
+               __m128i half,
+               __m128  df,
+               __m128  inv)
+{
+  __m128 a, t;
+  __m128i q;
+
+  a = _mm_cvtepi32_ps (_mm_add_epi32 (s, half));
+  q = _mm_cvttps_epi32 (_mm_mul_ps (a, inv));
+  t = _mm_mul_ps (_mm_cvtepi32_ps (q), df);
+  q = _mm_add_epi32 (q, _mm_castps_si128 (_mm_cmpgt_ps (t, a)));
+  q = _mm_sub_epi32 (q, _mm_castps_si128 (_mm_cmple_ps (_mm_add_ps (t, df), a)));
+
+  return q;
+}
+
+static BLUR_TARGET_SSE2 void
+blur_row_sse2 (guchar       *dst,
+               const guchar *add,
+               const guchar *sub,
+               gint32       *sums,
+               int           width,
+               int           d)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i half = _mm_set1_epi32 (d / 2);
+  const __m128 df = _mm_set1_ps (d);
+  const __m128 inv = _mm_set1_ps (1.0f / d);
+  int j, k;
+
+  for (j = 0; j + 16 <= width; j += 16)
+    {
+      __m128i s[4], v, lo, hi;
+
+      for (k = 0; k < 4; k++)
+        s[k] = _mm_loadu_si128 ((const __m128i *) (sums + j + 4 * k));
+
+      if (add)
+        {
+          v = _mm_loadu_si128 ((const __m128i *) (add + j));
+          lo = _mm_unpacklo_epi8 (v, zero);
+          hi = _mm_unpackhi_epi8 (v, zero);
+          s[0] = _mm_add_epi32 (s[0], _mm_unpacklo_epi16 (lo, zero));
+          s[1] = _mm_add_epi32 (s[1], _mm_unpackhi_epi16 (lo, zero));
+          s[2] = _mm_add_epi32 (s[2], _mm_unpacklo_epi16 (hi, zero));
+          s[3] = _mm_add_epi32 (s[3], _mm_unpackhi_epi16 (hi, zero));
+        }
+
+      if (sub)
+        {
+          v = _mm_loadu_si128 ((const __m128i *) (sub + j));
+          lo = _mm_unpacklo_epi8 (v, zero);
+          hi = _mm_unpackhi_epi8 (v, zero);
+          s[0] = _mm_sub_epi32 (s[0], _mm_unpacklo_epi16 (lo, zero));
+          s[1] = _mm_sub_epi32 (s[1], _mm_unpackhi_epi16 (lo, zero));
+          s[2] = _mm_sub_epi32 (s[2], _mm_unpacklo_epi16 (hi, zero));
+          s[3] = _mm_sub_epi32 (s[3], _mm_unpackhi_epi16 (hi, zero));
+        }
+
+      for (k = 0; k < 4; k++)
+        _mm_storeu_si128 ((__m128i *) (sums + j + 4 * k), s[k]);
+
+      if (dst)
+        {
+          __m128i q[4];
+
+          for (k = 0; k < 4; k++)
+            q[k] = blur_div_sse2 (s[k], half, df, inv);
+
+          _mm_storeu_si128 ((__m128i *) (dst + j),
+                            _mm_packus_epi16 (_mm_packs_epi32 (q[0], q[1]),
+                                              _mm_packs_epi32 (q[2], q[3])));
+        }
+    }
+
+  blur_row_span (dst, add, sub, sums, j, width, d);
+}
+
+static inline BLUR_TARGET_AVX2 __m256i
+blur_div_avx2 (__m256i s,
+               __m256i half,
+               __m256  df,
+               __m256  inv)
+{
+  __m256 a, t;
+  __m256i q;
+
+  a = _mm256_cvtepi32_ps (_mm256_add_epi32 (s, half));
+  q = _mm256_cvttps_epi32 (_mm256_mul_ps (a, inv));
+  t = _mm256_mul_ps (_mm256_cvtepi32_ps (q), df);
+  q = _mm256_add_epi32 (q, _mm256_castps_si256 (_mm256_cmp_ps (t, a, _CMP_GT_OQ)));
+  q = _mm256_sub_epi32 (q, _mm256_castps_si256 (_mm256_cmp_ps (_mm256_add_ps (t, df), a, _CMP_LE_OQ)));
+
+  return q;
+}
+
+static BLUR_TARGET_AVX2 void
+blur_row_avx2 (guchar       *dst,
+               const guchar *add,
+               const guchar *sub,
+               gint32       *sums,
+               int           width,
+               int           d)
+{
+  const __m256i half = _mm256_set1_epi32 (d / 2);
+  const __m256 df = _mm256_set1_ps (d);
+  const __m256 inv = _mm256_set1_ps (1.0f / d);
+  int j, k;
+
+  for (j = 0; j + 32 <= width; j += 32)
+    {
+      __m256i s[4];
+
+      for (k = 0; k < 4; k++)
+        s[k] = _mm256_loadu_si256 ((const __m256i *) (sums + j + 8 * k));
+
+      if (add)
+        {
+          for (k = 0; k < 4; k++)
+            s[k] = _mm256_add_epi32 (s[k], _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (add + j + 8 * k))));
+        }
+
+      if (sub)
+        {
+          for (k = 0; k < 4; k++)
+            s[k] = _mm256_sub_epi32 (s[k], _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (sub + j + 8 * k))));
+        }
+
+      for (k = 0; k < 4; k++)
+        _mm256_storeu_si256 ((__m256i *) (sums + j + 8 * k), s[k]);
+
+      if (dst)
+        {
+          __m256i q[4], lo, hi;
+
+          for (k = 0; k < 4; k++)
+            q[k] = blur_div_avx2 (s[k], half, df, inv);
+
+          /* The packs work per 128bit lane, so we need to put the
+           * 64bit quarters back in order after each of them */
+          lo = _mm256_permute4x64_epi64 (_mm256_packus_epi32 (q[0], q[1]), 0xd8);
+          hi = _mm256_permute4x64_epi64 (_mm256_packus_epi32 (q[2], q[3]), 0xd8);
+          _mm256_storeu_si256 ((__m256i *) (dst + j),
+                               _mm256_permute4x64_epi64 (_mm256_packus_epi16 (lo, hi), 0xd8));
+        }
+    }
+
+  blur_row_span (dst, add, sub, sums, j, width, d);
+}
+
+/* Transposes a 16x16 block in registers by interleaving
+ * rows of increasing width: bytes, words, dwords, qwords. */
+static BLUR_TARGET_SSE2 void
+transpose_block_sse2 (guchar       *dst,
+                      int           dst_stride,
+                      const guchar *src,
+                      int           src_stride)
+{
+  __m128i a[16], b[16];
+  int k;
+
+  for (k = 0; k < 16; k++)
+    a[k] = _mm_loadu_si128 ((const __m128i *) (src + k * src_stride));
+
+  for (k = 0; k < 8; k++)
+    {
+      b[2 * k] = _mm_unpacklo_epi8 (a[2 * k], a[2 * k + 1]);
+      b[2 * k + 1] = _mm_unpackhi_epi8 (a[2 * k], a[2 * k + 1]);
+    }
+
+  for (k = 0; k < 16; k += 4)
+    {
+      a[k] = _mm_unpacklo_epi16 (b[k], b[k + 2]);
+      a[k + 1] = _mm_unpackhi_epi16 (b[k], b[k + 2]);
+      a[k + 2] = _mm_unpacklo_epi16 (b[k + 1], b[k + 3]);
+      a[k + 3] = _mm_unpackhi_epi16 (b[k + 1], b[k + 3]);
+    }
+
+  for (k = 0; k < 16; k += 8)
+    {
+      b[k] = _mm_unpacklo_epi32 (a[k], a[k + 4]);
+      b[k + 1] = _mm_unpackhi_epi32 (a[k], a[k + 4]);
+      b[k + 2] = _mm_unpacklo_epi32 (a[k + 1], a[k + 5]);
+      b[k + 3] = _mm_unpackhi_epi32 (a[k + 1], a[k + 5]);
+      b[k + 4] = _mm_unpacklo_epi32 (a[k + 2], a[k + 6]);
+      b[k + 5] = _mm_unpackhi_epi32 (a[k + 2], a[k + 6]);
+      b[k + 6] = _mm_unpacklo_epi32 (a[k + 3], a[k + 7]);
+      b[k + 7] = _mm_unpackhi_epi32 (a[k + 3], a[k + 7]);
+    }
+
+  for (k = 0; k < 8; k++)
+    {
+      _mm_storeu_si128 ((__m128i *) (dst + (2 * k) * dst_stride),
+                        _mm_unpacklo_epi64 (b[k], b[k + 8]));
+      _mm_storeu_si128 ((__m128i *) (dst + (2 * k + 1) * dst_stride),
+                        _mm_unpackhi_epi64 (b[k], b[k + 8]));
+    }
+}
+
+#endif /* HAVE_BLUR_X86 */
+
+#ifdef HAVE_BLUR_NEON
+
+static inline int32x4_t
+blur_div_neon (int32x4_t   s,
+               int32x4_t   half,
+               float32x4_t df,
+               float32x4_t inv)
+{
+  float32x4_t a, t;
+  int32x4_t q;
+
+  a = vcvtq_f32_s32 (vaddq_s32 (s, half));
+  q = vcvtq_s32_f32 (vmulq_f32 (a, inv));
+  t = vmulq_f32 (vcvtq_f32_s32 (q), df);
+  q = vaddq_s32 (q, vreinterpretq_s32_u32 (vcgtq_f32 (t, a)));
+  q = vsubq_s32 (q, vreinterpretq_s32_u32 (vcleq_f32 (vaddq_f32 (t, df), a)));
+
+  return q;
+}
+
+static void
+blur_row_neon (guchar       *dst,
+               const guchar *add,
+               const guchar *sub,
+               gint32       *sums,
+               int           width,
+               int           d)
+{
+  const int32x4_t half = vdupq_n_s32 (d / 2);
+  const float32x4_t df = vdupq_n_f32 (d);
+  const float32x4_t inv = vdupq_n_f32 (1.0f / d);
+  int j, k;
+
+  for (j = 0; j + 16 <= width; j += 16)
+    {
+      int32x4_t s[4];
+      uint16x8_t lo, hi;
+      uint8x16_t v;
+
+      for (k = 0; k < 4; k++)
+        s[k] = vld1q_s32 (sums + j + 4 * k);
+
+      if (add)
+        {
+          v = vld1q_u8 (add + j);
+          lo = vmovl_u8 (vget_low_u8 (v));
+          hi = vmovl_u8 (vget_high_u8 (v));
+          s[0] = vaddq_s32 (s[0], vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (lo))));
+          s[1] = vaddq_s32 (s[1], vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (lo))));
+          s[2] = vaddq_s32 (s[2], vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (hi))));
+          s[3] = vaddq_s32 (s[3], vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (hi))));
+        }
+
+      if (sub)
+        {
+          v = vld1q_u8 (sub + j);
+          lo = vmovl_u8 (vget_low_u8 (v));
+          hi = vmovl_u8 (vget_high_u8 (v));
+          s[0] = vsubq_s32 (s[0], vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (lo))));
+          s[1] = vsubq_s32 (s[1], vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (lo))));
+          s[2] = vsubq_s32 (s[2], vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (hi))));
+          s[3] = vsubq_s32 (s[3], vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (hi))));
+        }
+
+      for (k = 0; k < 4; k++)
+        vst1q_s32 (sums + j + 4 * k, s[k]);
+
+      if (dst)
+        {
+          int16x8_t p0, p1;
+
+          p0 = vcombine_s16 (vmovn_s32 (blur_div_neon (s[0], half, df, inv)),
+                             vmovn_s32 (blur_div_neon (s[1], half, df, inv)));
+          p1 = vcombine_s16 (vmovn_s32 (blur_div_neon (s[2], half, df, inv)),
+                             vmovn_s32 (blur_div_neon (s[3], half, df, inv)));
+          vst1q_u8 (dst + j, vcombine_u8 (vqmovun_s16 (p0), vqmovun_s16 (p1)));
+        }
+    }
+
+  blur_row_span (dst, add, sub, sums, j, width, d);
+}
+
+#endif /* HAVE_BLUR_NEON */
+
+/* The scalar implementation has no blur_row, it uses _boxblur() */
+static const BlurImpl blur_impl_scalar = { "scalar", NULL, NULL };
+#ifdef HAVE_BLUR_X86
+static const BlurImpl blur_impl_sse2 = { "sse2", blur_row_sse2, transpose_block_sse2 };
+static const BlurImpl blur_impl_avx2 = { "avx2", blur_row_avx2, transpose_block_sse2 };
+#endif
+#ifdef HAVE_BLUR_NEON
+static const BlurImpl blur_impl_neon = { "neon", blur_row_neon, NULL };
+#endif
+
+static gboolean blur_simd_enabled = TRUE;
+
+static const BlurImpl *
+get_blur_impl (void)
+{
+  static const BlurImpl *impl = NULL;
+
+  if (!blur_simd_enabled)
+    return &blur_impl_scalar;
+
+  if (g_once_init_enter (&impl))
+    {
+      const BlurImpl *result = &blur_impl_scalar;
+
+#ifdef HAVE_BLUR_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))
+        result = &blur_impl_avx2;
+      else if (__builtin_cpu_supports ("sse2"))
+        result = &blur_impl_sse2;
+#endif
+#ifdef HAVE_BLUR_NEON
+      result = &blur_impl_neon;
+#endif
+
+      g_once_init_leave (&impl, result);
+    }
+
+  return impl;
+}
+
+/* Swaps width and height, using the vectorized kernel
+ * for complete blocks if there is one */
+static void
+flip_buffer_blocked (guchar             *dst_buffer,
+                     const guchar       *src_buffer,
+                     int                 width,
+                     int                 height,
+                     TransposeBlockFunc  transpose_block)
+{
+  int i0, j0;
+
+  for (j0 = 0; j0 < height; j0 += TRANSPOSE_BLOCK_SIZE)
+    for (i0 = 0; i0 < width; i0 += TRANSPOSE_BLOCK_SIZE)
+      {
+        int max_j = MIN (j0 + TRANSPOSE_BLOCK_SIZE, height);
+        int max_i = MIN (i0 + TRANSPOSE_BLOCK_SIZE, width);
+        int i, j;
+
+        if (transpose_block &&
+            max_i - i0 == TRANSPOSE_BLOCK_SIZE &&
+            max_j - j0 == TRANSPOSE_BLOCK_SIZE)
+          {
+            transpose_block (dst_buffer + i0 * height + j0, height,
+                             src_buffer + j0 * width + i0, width);
+            continue;
+          }
+
+        for (i = i0; i < max_i; i++)
+          for (j = j0; j < max_j; j++)
+            dst_buffer[i * height + j] = src_buffer[j * width + i];
+      }
+}
+
+/* One box blur pass over the columns of src, see blur_xspan()
+ * for the meaning of d and shift */
+static void
+blur_cols (guchar       *dst_buffer,
+           const guchar *src_buffer,
+           gint32       *sums,
+           int           width,
+           int           height,
+           int           d,
+           int           shift,
+           BlurRowFunc   blur_row)
+{
+  int offset;
+  int i;
+
+  if (d % 2 == 1)
+    offset = d / 2;
+  else
+    offset = (d - shift) / 2;
+
+  memset (sums, 0, width * sizeof (gint32));
+
+  for (i = -d + offset; i < height + offset; i++)
+    {
+      blur_row (i >= offset ? dst_buffer + (i - offset) * width : NULL,
+                i >= 0 && i < height ? src_buffer + i * width : NULL,
+                i >= d ? src_buffer + (i - d) * width : NULL,
+                sums, width, d);
+    }
+}
+
+/* Does the three passes of blur_rows() on the columns of
+ * buffer, using tmp_buffer as the source of the middle pass.
+ * The result ends up in tmp_buffer. */
+static void
+blur_cols3 (guchar      *buffer,
+            guchar      *tmp_buffer,
+            gint32      *sums,
+            int          width,
+            int          height,
+            int          d,
+            BlurRowFunc  blur_row)
+{
+  if (d % 2 == 1)
+    {
+      blur_cols (tmp_buffer, buffer, sums, width, height, d, 0, blur_row);
+      blur_cols (buffer, tmp_buffer, sums, width, height, d, 0, blur_row);
+      blur_cols (tmp_buffer, buffer, sums, width, height, d, 0, blur_row);
+    }
+  else
+    {
+      blur_cols (tmp_buffer, buffer, sums, width, height, d, 1, blur_row);
+      blur_cols (buffer, tmp_buffer, sums, width, height, d, -1, blur_row);
+      blur_cols (tmp_buffer, buffer, sums, width, height, d + 1, 0, blur_row);
+    }
+}
+
+static void
+_boxblur_simd (const BlurImpl *impl,
+               guchar         *buffer,
+               int             width,
+               int             height,
+               int             radius,
+               GtkBlurFlags    flags)
+{
+  guchar *tmp_buffer;
+  gint32 *sums;
+  int d = get_box_filter_size (radius);
+
+  tmp_buffer = g_malloc (width * height);
+  sums = g_new (gint32, MAX (width, height) + 1);
+
+  if (flags & GTK_BLUR_Y)
+    {
+      /* Step 1: blur columns, no need to flip */
+      blur_cols3 (buffer, tmp_buffer, sums, width, height, d, impl->blur_row);
+
+      if (flags & GTK_BLUR_X)
+        flip_buffer_blocked (buffer, tmp_buffer, width, height, impl->transpose_block);
+      else
+        memcpy (buffer, tmp_buffer, width * height);
+    }
+  else
+    {
+      flip_buffer_blocked (tmp_buffer, buffer, width, height, impl->transpose_block);
+    }
+
+  if (flags & GTK_BLUR_X)
+    {
+      guchar *flipped = (flags & GTK_BLUR_Y) ? buffer : tmp_buffer;
+      guchar *other = (flags & GTK_BLUR_Y) ? tmp_buffer : buffer;
+
+      /* Step 2: blur rows, which are the columns of the flipped buffer */
+      blur_cols3 (flipped, other, sums, height, width, d, impl->blur_row);
+
+      /* Step 3: swap rows and columns back */
+      flip_buffer_blocked (flipped, other, height, width, impl->transpose_block);
+      if (flipped != buffer)
+        memcpy (buffer, flipped, width * height);
+    }
+
+  g_free (sums);
+  g_free (tmp_buffer);
+}
+
+/*
+ * _gtk_cairo_blur_set_simd_enabled:
+ * @enabled: whether to use vectorized code
+ *
+ * Allows forcing the scalar implementation, to compare
+ * results and performance in tests.
+ */
+void
+_gtk_cairo_blur_set_simd_enabled (gboolean enabled)
+{
+  blur_simd_enabled = enabled;
+}
+
+/*
+ * _gtk_cairo_blur_get_implementation:
+ *
+ * Returns: the name of the implementation used for blurring
+ */
+const char *
+_gtk_cairo_blur_get_implementation (void)
+{
+  return get_blur_impl ()->name;
+}
+
 /*
  * _gtk_cairo_blur_surface:
  * @surface: a cairo image surface.
@@ -230,6 +795,7 @@ _gtk_cairo_blur_surface (cairo_surface_t* surface,
                          double           radius_d,
                          GtkBlurFlags     flags)
 {
+  const BlurImpl *impl;
   int radius = radius_d;
 
   g_return_if_fail (surface != NULL);
@@ -247,10 +813,18 @@ _gtk_cairo_blur_surface (cairo_surface_t* surface,
   /* Before we mess with the surface, execute any pending drawing. */
   cairo_surface_flush (surface);
 
-  _boxblur (cairo_image_surface_get_data (surface),
-            cairo_image_surface_get_stride (surface),
-            cairo_image_surface_get_height (surface),
-            radius, flags);
+  impl = get_blur_impl ();
+  if (impl->blur_row)
+    _boxblur_simd (impl,
+                   cairo_image_surface_get_data (surface),
+                   cairo_image_surface_get_stride (surface),
+                   cairo_image_surface_get_height (surface),
+                   radius, flags);
+  else
+    _boxblur (cairo_image_surface_get_data (surface),
+              cairo_image_surface_get_stride (surface),
+              cairo_image_surface_get_height (surface),
+              radius, flags);
 
   /* Inform cairo we altered the surface contents. */
   cairo_surface_mark_dirty (surface);
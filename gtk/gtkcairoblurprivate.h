@@ -41,6 +41,9 @@ void            _gtk_cairo_blur_surface         (cairo_surface_t *surface,
 						 GtkBlurFlags     flags);;
 int             _gtk_cairo_blur_compute_pixels  (double           radius);
 
+const char *    _gtk_cairo_blur_get_implementation (void);
+void            _gtk_cairo_blur_set_simd_enabled   (gboolean      enabled);
+
 G_END_DECLS
 
 #endif /* _GTK_CAIRO_BLUR_H */
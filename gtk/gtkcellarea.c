@@ -347,8 +347,13 @@
 
 #include "gtkintl.h"
 #include "gtkcelllayout.h"
-#include "gtkcellarea.h"
+#include "gtkcellareaprivate.h"
 #include "gtkcellareacontext.h"
+#include "gtkcellrendererpixbufprivate.h"
+#include "gtkcellrendererprogressprivate.h"
+#include "gtkcellrenderertextprivate.h"
+#include "gtkcellrenderertoggleprivate.h"
+#include "gtkcolumnstore.h"
 #include "gtkmarshalers.h"
 #include "gtkprivate.h"
 #include "gtkrender.h"
@@ -502,10 +507,23 @@ typedef struct {
   GdkRectangle     cell_area;
 } CellByPositionData;
 
+/* Attributes of the built-in renderers which can be set
+ * directly from the typed columns of a GtkColumnStore */
+typedef enum {
+  ATTRIBUTE_BINDING_NONE,
+  ATTRIBUTE_BINDING_TEXT,
+  ATTRIBUTE_BINDING_PIXBUF,
+  ATTRIBUTE_BINDING_ICON_NAME,
+  ATTRIBUTE_BINDING_ACTIVE,
+  ATTRIBUTE_BINDING_VALUE
+} AttributeBinding;
+
 /* Attribute/Cell metadata */
 typedef struct {
-  const gchar *attribute;
-  gint         column;
+  const gchar      *attribute;
+  gint              column;
+  GParamSpec       *pspec;
+  AttributeBinding  binding;
 } CellAttribute;
 
 typedef struct {
@@ -599,6 +617,12 @@ enum {
  */
 static GParamSpecPool *cell_property_pool = NULL;
 static guint           cell_area_signals[LAST_SIGNAL] = { 0 };
+static guint           notify_signal_id = 0;
+
+/* Attributes applied by all cell areas, see
+ * _gtk_cell_area_get_attribute_statistics() */
+static guint64         n_direct_sets = 0;
+static guint64         n_property_sets = 0;
 
 #define PARAM_SPEC_PARAM_ID(pspec)              ((pspec)->param_id)
 #define PARAM_SPEC_SET_PARAM_ID(pspec, id)      ((pspec)->param_id = (id))
@@ -833,6 +857,8 @@ gtk_cell_area_class_init (GtkCellAreaClass *class)
   /* Pool for Cell Properties */
   if (!cell_property_pool)
     cell_property_pool = g_param_spec_pool_new (FALSE);
+
+  notify_signal_id = g_signal_lookup ("notify", G_TYPE_OBJECT);
 }
 
 /*************************************************************
@@ -863,6 +889,40 @@ cell_info_free (CellInfo *info)
   g_slice_free (CellInfo, info);
 }
 
+/* Subclasses may override the properties, so only the
+ * exact built-in types are bound directly */
+static AttributeBinding
+cell_attribute_get_binding (GtkCellRenderer *renderer,
+                            GParamSpec      *pspec)
+{
+  GType type = G_OBJECT_TYPE (renderer);
+
+  if (type == GTK_TYPE_CELL_RENDERER_TEXT)
+    {
+      if (strcmp (pspec->name, "text") == 0)
+        return ATTRIBUTE_BINDING_TEXT;
+    }
+  else if (type == GTK_TYPE_CELL_RENDERER_PIXBUF)
+    {
+      if (strcmp (pspec->name, "pixbuf") == 0)
+        return ATTRIBUTE_BINDING_PIXBUF;
+      else if (strcmp (pspec->name, "icon-name") == 0)
+        return ATTRIBUTE_BINDING_ICON_NAME;
+    }
+  else if (type == GTK_TYPE_CELL_RENDERER_TOGGLE)
+    {
+      if (strcmp (pspec->name, "active") == 0)
+        return ATTRIBUTE_BINDING_ACTIVE;
+    }
+  else if (type == GTK_TYPE_CELL_RENDERER_PROGRESS)
+    {
+      if (strcmp (pspec->name, "value") == 0)
+        return ATTRIBUTE_BINDING_VALUE;
+    }
+
+  return ATTRIBUTE_BINDING_NONE;
+}
+
 static CellAttribute  *
 cell_attribute_new  (GtkCellRenderer       *renderer,
                      const gchar           *attribute,
@@ -882,6 +942,8 @@ cell_attribute_new  (GtkCellRenderer       *renderer,
 
       cell_attribute->attribute = pspec->name;
       cell_attribute->column    = column;
+      cell_attribute->pspec     = pspec;
+      cell_attribute->binding   = cell_attribute_get_binding (renderer, pspec);
 
       return cell_attribute;
     }
@@ -1216,6 +1278,76 @@ gtk_cell_area_real_render (GtkCellArea          *area,
     }
 }
 
+/* Sets @attribute on @renderer straight from the typed storage of a
+ * GtkColumnStore, without boxing the value in a GValue and without
+ * going through g_object_set_property(). As that skips ::notify, it
+ * is only done while nobody listens for the property, neither with a
+ * detailed nor with a plain ::notify handler.
+ */
+static gboolean
+apply_cell_attribute_direct (GtkCellRenderer *renderer,
+                             CellAttribute   *attribute,
+                             GtkColumnStore  *store,
+                             GtkTreeIter     *iter)
+{
+  GType type;
+
+  if (attribute->binding == ATTRIBUTE_BINDING_NONE)
+    return FALSE;
+
+  if (g_signal_has_handler_pending (renderer, notify_signal_id, 0, TRUE) ||
+      g_signal_has_handler_pending (renderer, notify_signal_id,
+                                    g_param_spec_get_name_quark (attribute->pspec),
+                                    TRUE))
+    return FALSE;
+
+  type = gtk_tree_model_get_column_type (GTK_TREE_MODEL (store), attribute->column);
+
+  switch (attribute->binding)
+    {
+    case ATTRIBUTE_BINDING_TEXT:
+      if (type != G_TYPE_STRING)
+        return FALSE;
+      _gtk_cell_renderer_text_set_text (GTK_CELL_RENDERER_TEXT (renderer),
+                                        gtk_column_store_get_string (store, iter, attribute->column));
+      break;
+
+    case ATTRIBUTE_BINDING_PIXBUF:
+      if (!g_type_is_a (type, GDK_TYPE_PIXBUF))
+        return FALSE;
+      _gtk_cell_renderer_pixbuf_set_pixbuf (GTK_CELL_RENDERER_PIXBUF (renderer),
+                                            gtk_column_store_get_object (store, iter, attribute->column));
+      break;
+
+    case ATTRIBUTE_BINDING_ICON_NAME:
+      if (type != G_TYPE_STRING)
+        return FALSE;
+      _gtk_cell_renderer_pixbuf_set_icon_name (GTK_CELL_RENDERER_PIXBUF (renderer),
+                                               gtk_column_store_get_string (store, iter, attribute->column));
+      break;
+
+    case ATTRIBUTE_BINDING_ACTIVE:
+      if (type != G_TYPE_BOOLEAN)
+        return FALSE;
+      _gtk_cell_renderer_toggle_set_active (GTK_CELL_RENDERER_TOGGLE (renderer),
+                                            gtk_column_store_get_boolean (store, iter, attribute->column));
+      break;
+
+    case ATTRIBUTE_BINDING_VALUE:
+      if (type != G_TYPE_INT)
+        return FALSE;
+      _gtk_cell_renderer_progress_set_value (GTK_CELL_RENDERER_PROGRESS (renderer),
+                                             gtk_column_store_get_int (store, iter, attribute->column));
+      break;
+
+    case ATTRIBUTE_BINDING_NONE:
+    default:
+      g_assert_not_reached ();
+    }
+
+  return TRUE;
+}
+
 static void
 apply_cell_attributes (GtkCellRenderer *renderer,
                        CellInfo        *info,
@@ -1224,6 +1356,7 @@ apply_cell_attributes (GtkCellRenderer *renderer,
   CellAttribute *attribute;
   GSList        *list;
   GValue         value = G_VALUE_INIT;
+  GtkColumnStore *store;
   gboolean       is_expander;
   gboolean       is_expanded;
 
@@ -1241,14 +1374,23 @@ apply_cell_attributes (GtkCellRenderer *renderer,
   if (is_expanded != data->is_expanded)
     g_object_set (renderer, "is-expanded", data->is_expanded, NULL);
 
+  store = GTK_IS_COLUMN_STORE (data->model) ? GTK_COLUMN_STORE (data->model) : NULL;
+
   /* Apply the attributes directly to the renderer */
   for (list = info->attributes; list; list = list->next)
     {
       attribute = list->data;
 
+      if (store && apply_cell_attribute_direct (renderer, attribute, store, data->iter))
+        {
+          n_direct_sets++;
+          continue;
+        }
+
       gtk_tree_model_get_value (data->model, data->iter, attribute->column, &value);
       g_object_set_property (G_OBJECT (renderer), attribute->attribute, &value);
       g_value_unset (&value);
+      n_property_sets++;
     }
 
   /* Call any GtkCellLayoutDataFunc that may have been set by the user
@@ -3643,6 +3785,30 @@ gtk_cell_area_request_renderer (GtkCellArea        *area,
     }
 }
 
+gint
+_gtk_cell_area_get_sole_attribute_column (GtkCellArea     *area,
+                                          GtkCellRenderer *cell,
+                                          const gchar     *attribute)
+{
+  CellInfo      *info;
+  CellAttribute *cell_attribute;
+
+  g_return_val_if_fail (GTK_IS_CELL_AREA (area), -1);
+  g_return_val_if_fail (GTK_IS_CELL_RENDERER (cell), -1);
+
+  info = g_hash_table_lookup (area->priv->cell_info, cell);
+
+  if (info == NULL || info->func != NULL ||
+      info->attributes == NULL || info->attributes->next != NULL)
+    return -1;
+
+  cell_attribute = info->attributes->data;
+  if (strcmp (cell_attribute->attribute, attribute) != 0)
+    return -1;
+
+  return cell_attribute->column;
+}
+
 void
 _gtk_cell_area_set_cell_data_func_with_proxy (GtkCellArea           *area,
 					      GtkCellRenderer       *cell,
@@ -3693,3 +3859,17 @@ _gtk_cell_area_set_cell_data_func_with_proxy (GtkCellArea           *area,
       g_hash_table_insert (priv->cell_info, cell, info);
     }
 }
+
+/* Returns the number of cell attributes that were applied to renderers
+ * directly from typed model columns and the number that were set as
+ * GObject properties, since startup. Only touched from the main thread.
+ */
+void
+_gtk_cell_area_get_attribute_statistics (guint64 *n_direct,
+                                         guint64 *n_properties)
+{
+  if (n_direct)
+    *n_direct = n_direct_sets;
+  if (n_properties)
+    *n_properties = n_property_sets;
+}
@@ -529,6 +529,13 @@ void                 _gtk_cell_area_set_cell_data_func_with_proxy  (GtkCellArea
 								    GDestroyNotify         destroy,
 								    gpointer               proxy);
 
+/* Returns the model column that @attribute of @cell is mapped to, or -1
+ * if @cell has other attributes or a cell data function.
+ */
+gint                 _gtk_cell_area_get_sole_attribute_column      (GtkCellArea           *area,
+                                                                    GtkCellRenderer       *cell,
+                                                                    const gchar           *attribute);
+
 G_END_DECLS
 
 #endif /* __GTK_CELL_AREA_H__ */
@@ -0,0 +1,34 @@
+/* gtkcellareaprivate.h
+ *
+ * Copyright (C) 2010 Openismus GmbH
+ *
+ * Authors:
+ *      Tristan Van Berkom <tristanvb@openismus.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_CELL_AREA_PRIVATE_H__
+#define __GTK_CELL_AREA_PRIVATE_H__
+
+#include "gtkcellarea.h"
+
+G_BEGIN_DECLS
+
+void            _gtk_cell_area_get_attribute_statistics (guint64 *n_direct,
+                                                         guint64 *n_properties);
+
+G_END_DECLS
+
+#endif /* __GTK_CELL_AREA_PRIVATE_H__ */
@@ -18,7 +18,7 @@
 #include "config.h"
 #include <stdlib.h>
 #include <cairo-gobject.h>
-#include "gtkcellrendererpixbuf.h"
+#include "gtkcellrendererpixbufprivate.h"
 #include "deprecated/gtkiconfactory.h"
 #include "gtkiconhelperprivate.h"
 #include "gtkicontheme.h"
@@ -601,3 +601,37 @@ gtk_cell_renderer_pixbuf_render (GtkCellRenderer      *cell,
 
   gtk_style_context_restore (context);
 }
+
+/* Like setting GtkCellRendererPixbuf:pixbuf, but without emitting
+ * ::notify for the property itself. Used by GtkCellArea for typed
+ * model columns.
+ */
+void
+_gtk_cell_renderer_pixbuf_set_pixbuf (GtkCellRendererPixbuf *cellpixbuf,
+                                      GdkPixbuf             *pixbuf)
+{
+  GtkImageDefinition *def = cellpixbuf->priv->image_def;
+
+  if (pixbuf != NULL &&
+      gtk_image_definition_get_pixbuf (def) == pixbuf &&
+      gtk_image_definition_get_scale (def) == 1)
+    return;
+
+  take_image_definition (cellpixbuf, gtk_image_definition_new_pixbuf (pixbuf, 1));
+}
+
+/* Like setting GtkCellRendererPixbuf:icon-name, see
+ * _gtk_cell_renderer_pixbuf_set_pixbuf().
+ */
+void
+_gtk_cell_renderer_pixbuf_set_icon_name (GtkCellRendererPixbuf *cellpixbuf,
+                                         const gchar           *icon_name)
+{
+  GtkImageDefinition *def = cellpixbuf->priv->image_def;
+
+  if (icon_name != NULL &&
+      g_strcmp0 (gtk_image_definition_get_icon_name (def), icon_name) == 0)
+    return;
+
+  take_image_definition (cellpixbuf, gtk_image_definition_new_icon_name (icon_name));
+}
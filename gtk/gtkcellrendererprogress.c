@@ -26,7 +26,7 @@
 #include "config.h"
 #include <stdlib.h>
 
-#include "gtkcellrendererprogress.h"
+#include "gtkcellrendererprogressprivate.h"
 #include "gtkintl.h"
 #include "gtkorientable.h"
 #include "gtkprivate.h"
@@ -725,3 +725,17 @@ gtk_cell_renderer_progress_render (GtkCellRenderer      *cell,
       g_object_unref (layout);
     }
 }
+
+/* Like setting GtkCellRendererProgress:value, but without emitting
+ * ::notify. Used by GtkCellArea for typed model columns.
+ */
+void
+_gtk_cell_renderer_progress_set_value (GtkCellRendererProgress *cellprogress,
+                                       gint                     value)
+{
+  if (cellprogress->priv->value != value)
+    {
+      cellprogress->priv->value = value;
+      recompute_label (cellprogress);
+    }
+}
@@ -17,9 +17,10 @@
 
 #include "config.h"
 
-#include "gtkcellrenderertext.h"
+#include "gtkcellrenderertextprivate.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "gtkeditable.h"
 #include "gtkentry.h"
@@ -1109,6 +1110,25 @@ set_font_description (GtkCellRendererText  *celltext,
   g_object_thaw_notify (object);
 }
 
+static void
+take_text (GtkCellRendererText *celltext,
+           gchar               *text)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+
+  g_free (priv->text);
+
+  if (priv->markup_set)
+    {
+      if (priv->extra_attrs)
+        pango_attr_list_unref (priv->extra_attrs);
+      priv->extra_attrs = NULL;
+      priv->markup_set = FALSE;
+    }
+
+  priv->text = text;
+}
+
 static void
 gtk_cell_renderer_text_set_property (GObject      *object,
 				     guint         param_id,
@@ -1121,17 +1141,7 @@ gtk_cell_renderer_text_set_property (GObject      *object,
   switch (param_id)
     {
     case PROP_TEXT:
-      g_free (priv->text);
-
-      if (priv->markup_set)
-        {
-          if (priv->extra_attrs)
-            pango_attr_list_unref (priv->extra_attrs);
-          priv->extra_attrs = NULL;
-          priv->markup_set = FALSE;
-        }
-
-      priv->text = g_value_dup_string (value);
+      take_text (celltext, g_value_dup_string (value));
       g_object_notify_by_pspec (object, pspec);
       break;
 
@@ -1547,30 +1557,170 @@ add_attr (PangoAttrList  *attr_list,
   pango_attr_list_insert (attr_list, attr);
 }
 
-static PangoLayout*
-get_layout (GtkCellRendererText *celltext,
-            GtkWidget           *widget,
-            const GdkRectangle  *cell_area,
-            GtkCellRendererState flags)
+/* Layouts are cached per widget, so all text renderers of a view
+ * share them. Everything that goes into the attributes of a layout
+ * is part of the key; the width and alignment are set on each use,
+ * which Pango only acts on when they change.
+ */
+#define LAYOUT_CACHE_SIZE 1024
+
+typedef struct {
+  const gchar          *text;
+  PangoAttrList        *extra_attrs;
+  PangoFontDescription *font;
+  PangoLanguage        *language;
+  GdkRGBA               foreground;
+  gdouble               font_scale;
+  gint                  rise;
+  PangoUnderline        underline_style;
+  PangoEllipsizeMode    ellipsize;
+  PangoWrapMode         wrap_mode;
+
+  guint foreground_set    : 1;
+  guint strikethrough_set : 1;
+  guint strikethrough     : 1;
+  guint underline_set     : 1;
+  guint rise_set          : 1;
+  guint single_paragraph  : 1;
+  guint wrap              : 1;
+  guint for_render        : 1;
+} LayoutCacheKey;
+
+typedef struct {
+  LayoutCacheKey  key;         /* must be first, the entry is its own key */
+  PangoLayout    *layout;
+  gint            text_width;  /* unwrapped width, for wrapping layouts */
+  gsize           size;
+  GList           link;
+} LayoutCacheEntry;
+
+typedef struct {
+  GHashTable *entries;
+  GQueue      lru;             /* most recently used first */
+} LayoutCache;
+
+static guint64 layout_cache_hits = 0;
+static guint64 layout_cache_misses = 0;
+static guint64 layout_cache_evictions = 0;
+static gsize   layout_cache_bytes = 0;
+
+static guint
+layout_cache_key_hash (gconstpointer data)
 {
-  GtkCellRendererTextPrivate *priv = celltext->priv;
-  PangoAttrList *attr_list;
-  PangoLayout *layout;
-  PangoUnderline uline;
-  gint xpad;
-  gboolean placeholder_layout = show_placeholder_text (celltext);
+  const LayoutCacheKey *key = data;
+  guint hash;
 
-  layout = gtk_widget_create_pango_layout (widget, placeholder_layout ?
-                                           priv->placeholder_text : priv->text);
+  hash = g_str_hash (key->text);
+  hash = hash * 31 + pango_font_description_hash (key->font);
+  hash = hash * 31 + GPOINTER_TO_UINT (key->extra_attrs);
+  hash = hash * 31 + (key->for_render << 1 | key->wrap);
 
-  gtk_cell_renderer_get_padding (GTK_CELL_RENDERER (celltext), &xpad, NULL);
+  return hash;
+}
 
-  if (priv->extra_attrs)
-    attr_list = pango_attr_list_copy (priv->extra_attrs);
-  else
-    attr_list = pango_attr_list_new ();
+static gboolean
+layout_cache_key_equal (gconstpointer a,
+                        gconstpointer b)
+{
+  const LayoutCacheKey *key1 = a;
+  const LayoutCacheKey *key2 = b;
+
+  if (strcmp (key1->text, key2->text) != 0 ||
+      key1->extra_attrs != key2->extra_attrs ||
+      key1->language != key2->language ||
+      key1->font_scale != key2->font_scale ||
+      key1->ellipsize != key2->ellipsize ||
+      key1->wrap_mode != key2->wrap_mode ||
+      key1->foreground_set != key2->foreground_set ||
+      key1->strikethrough_set != key2->strikethrough_set ||
+      key1->underline_set != key2->underline_set ||
+      key1->rise_set != key2->rise_set ||
+      key1->single_paragraph != key2->single_paragraph ||
+      key1->wrap != key2->wrap ||
+      key1->for_render != key2->for_render)
+    return FALSE;
 
-  pango_layout_set_single_paragraph_mode (layout, priv->single_paragraph);
+  if (key1->foreground_set && !gdk_rgba_equal (&key1->foreground, &key2->foreground))
+    return FALSE;
+  if (key1->strikethrough_set && key1->strikethrough != key2->strikethrough)
+    return FALSE;
+  if (key1->underline_set && key1->underline_style != key2->underline_style)
+    return FALSE;
+  if (key1->rise_set && key1->rise != key2->rise)
+    return FALSE;
+
+  return pango_font_description_equal (key1->font, key2->font);
+}
+
+static void
+layout_cache_entry_free (LayoutCacheEntry *entry)
+{
+  layout_cache_bytes -= entry->size;
+
+  g_free ((gchar *) entry->key.text);
+  if (entry->key.extra_attrs)
+    pango_attr_list_unref (entry->key.extra_attrs);
+  pango_font_description_free (entry->key.font);
+  g_object_unref (entry->layout);
+
+  g_slice_free (LayoutCacheEntry, entry);
+}
+
+static void
+layout_cache_free (LayoutCache *cache)
+{
+  g_hash_table_destroy (cache->entries);
+  g_slice_free (LayoutCache, cache);
+}
+
+static LayoutCache *
+get_layout_cache (GtkWidget *widget)
+{
+  static GQuark quark = 0;
+  LayoutCache *cache;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("gtk-cell-renderer-text-layout-cache");
+
+  cache = g_object_get_qdata (G_OBJECT (widget), quark);
+  if (cache == NULL)
+    {
+      cache = g_slice_new (LayoutCache);
+      cache->entries = g_hash_table_new_full (layout_cache_key_hash,
+                                              layout_cache_key_equal,
+                                              NULL,
+                                              (GDestroyNotify) layout_cache_entry_free);
+      g_queue_init (&cache->lru);
+      g_object_set_qdata_full (G_OBJECT (widget), quark, cache,
+                               (GDestroyNotify) layout_cache_free);
+    }
+
+  return cache;
+}
+
+/* Collects everything the layout for @celltext depends on, apart
+ * from the width and alignment. Pointers in @key are borrowed.
+ */
+static void
+layout_cache_key_init (LayoutCacheKey       *key,
+                       GtkCellRendererText  *celltext,
+                       GtkWidget            *widget,
+                       const GdkRectangle   *cell_area,
+                       GtkCellRendererState  flags)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  gboolean placeholder_layout = show_placeholder_text (celltext);
+  PangoUnderline uline;
+
+  memset (key, 0, sizeof (LayoutCacheKey));
+
+  key->text = placeholder_layout ? priv->placeholder_text : priv->text;
+  if (key->text == NULL)
+    key->text = "";
+  key->extra_attrs = priv->extra_attrs;
+  key->font = priv->font;
+  key->single_paragraph = priv->single_paragraph;
+  key->for_render = cell_area != NULL;
 
   if (!placeholder_layout && cell_area)
     {
@@ -1583,49 +1733,32 @@ get_layout (GtkCellRendererText *celltext,
       if (priv->foreground_set
 	  && (flags & GTK_CELL_RENDERER_SELECTED) == 0)
         {
-          PangoColor color;
-          guint16 alpha;
-
-          color.red = CLAMP (priv->foreground.red * 65535. + 0.5, 0, 65535);
-          color.green = CLAMP (priv->foreground.green * 65535. + 0.5, 0, 65535);
-          color.blue = CLAMP (priv->foreground.blue * 65535. + 0.5, 0, 65535);
-          alpha = CLAMP (priv->foreground.alpha * 65535. + 0.5, 0, 65535);
-
-          add_attr (attr_list,
-                    pango_attr_foreground_new (color.red, color.green, color.blue));
-
-          add_attr (attr_list, pango_attr_foreground_alpha_new (alpha));
+          key->foreground_set = TRUE;
+          key->foreground = priv->foreground;
         }
 
       if (priv->strikethrough_set)
-        add_attr (attr_list, pango_attr_strikethrough_new (priv->strikethrough));
+        {
+          key->strikethrough_set = TRUE;
+          key->strikethrough = priv->strikethrough;
+        }
     }
   else if (placeholder_layout)
     {
-      PangoColor color;
-      guint16 alpha;
       GtkStyleContext *context;
       GdkRGBA fg = { 0.5, 0.5, 0.5, 1.0 };
 
       context = gtk_widget_get_style_context (widget);
       gtk_style_context_lookup_color (context, "placeholder_text_color", &fg);
 
-      color.red = CLAMP (fg.red * 65535. + 0.5, 0, 65535);
-      color.green = CLAMP (fg.green * 65535. + 0.5, 0, 65535);
-      color.blue = CLAMP (fg.blue * 65535. + 0.5, 0, 65535);
-      alpha = CLAMP (fg.alpha * 65535. + 0.5, 0, 65535);
-
-      add_attr (attr_list,
-                pango_attr_foreground_new (color.red, color.green, color.blue));
-
-      add_attr (attr_list, pango_attr_foreground_alpha_new (alpha));
+      key->foreground_set = TRUE;
+      key->foreground = fg;
     }
 
-  add_attr (attr_list, pango_attr_font_desc_new (priv->font));
-
-  if (priv->scale_set &&
-      priv->font_scale != 1.0)
-    add_attr (attr_list, pango_attr_scale_new (priv->font_scale));
+  if (priv->scale_set)
+    key->font_scale = priv->font_scale;
+  else
+    key->font_scale = 1.0;
 
   if (priv->underline_set)
     uline = priv->underline_style;
@@ -1633,7 +1766,7 @@ get_layout (GtkCellRendererText *celltext,
     uline = PANGO_UNDERLINE_NONE;
 
   if (priv->language_set)
-    add_attr (attr_list, pango_attr_language_new (priv->language));
+    key->language = priv->language;
 
   if ((flags & GTK_CELL_RENDERER_PRELIT) == GTK_CELL_RENDERER_PRELIT)
     {
@@ -1653,28 +1786,193 @@ get_layout (GtkCellRendererText *celltext,
     }
 
   if (uline != PANGO_UNDERLINE_NONE)
-    add_attr (attr_list, pango_attr_underline_new (priv->underline_style));
+    {
+      key->underline_set = TRUE;
+      key->underline_style = priv->underline_style;
+    }
 
   if (priv->rise_set)
-    add_attr (attr_list, pango_attr_rise_new (priv->rise));
+    {
+      key->rise_set = TRUE;
+      key->rise = priv->rise;
+    }
+
+  if (priv->ellipsize_set)
+    key->ellipsize = priv->ellipsize;
+  else
+    key->ellipsize = PANGO_ELLIPSIZE_NONE;
+
+  if (priv->wrap_width != -1)
+    {
+      key->wrap = TRUE;
+      key->wrap_mode = priv->wrap_mode;
+    }
+  else
+    key->wrap_mode = PANGO_WRAP_CHAR;
+}
+
+static PangoLayout *
+create_layout (GtkWidget            *widget,
+               const LayoutCacheKey *key)
+{
+  PangoAttrList *attr_list;
+  PangoLayout *layout;
+
+  layout = gtk_widget_create_pango_layout (widget, key->text);
+
+  if (key->extra_attrs)
+    attr_list = pango_attr_list_copy (key->extra_attrs);
+  else
+    attr_list = pango_attr_list_new ();
+
+  pango_layout_set_single_paragraph_mode (layout, key->single_paragraph);
+
+  if (key->foreground_set)
+    {
+      PangoColor color;
+      guint16 alpha;
+
+      color.red = CLAMP (key->foreground.red * 65535. + 0.5, 0, 65535);
+      color.green = CLAMP (key->foreground.green * 65535. + 0.5, 0, 65535);
+      color.blue = CLAMP (key->foreground.blue * 65535. + 0.5, 0, 65535);
+      alpha = CLAMP (key->foreground.alpha * 65535. + 0.5, 0, 65535);
+
+      add_attr (attr_list,
+                pango_attr_foreground_new (color.red, color.green, color.blue));
+
+      add_attr (attr_list, pango_attr_foreground_alpha_new (alpha));
+    }
+
+  if (key->strikethrough_set)
+    add_attr (attr_list, pango_attr_strikethrough_new (key->strikethrough));
+
+  add_attr (attr_list, pango_attr_font_desc_new (key->font));
+
+  if (key->font_scale != 1.0)
+    add_attr (attr_list, pango_attr_scale_new (key->font_scale));
+
+  if (key->language)
+    add_attr (attr_list, pango_attr_language_new (key->language));
+
+  if (key->underline_set)
+    add_attr (attr_list, pango_attr_underline_new (key->underline_style));
+
+  if (key->rise_set)
+    add_attr (attr_list, pango_attr_rise_new (key->rise));
 
   /* Now apply the attributes as they will effect the outcome
    * of pango_layout_get_extents() */
   pango_layout_set_attributes (layout, attr_list);
   pango_attr_list_unref (attr_list);
 
-  if (priv->ellipsize_set)
-    pango_layout_set_ellipsize (layout, priv->ellipsize);
+  pango_layout_set_ellipsize (layout, key->ellipsize);
+  pango_layout_set_wrap (layout, key->wrap_mode);
+  pango_layout_set_width (layout, -1);
+
+  return layout;
+}
+
+static gint
+get_unwrapped_width (PangoLayout *layout)
+{
+  PangoRectangle rect;
+
+  pango_layout_get_extents (layout, NULL, &rect);
+
+  return rect.width;
+}
+
+/* Returns the layout for @key from the cache of @widget, creating
+ * it if needed. Markup attributes are parsed into a new list each
+ * time the markup is set, so layouts using them are not cached.
+ */
+static PangoLayout *
+lookup_layout (GtkCellRendererText  *celltext,
+               GtkWidget            *widget,
+               const LayoutCacheKey *key,
+               gint                 *text_width)
+{
+  LayoutCache *cache;
+  LayoutCacheEntry *entry;
+
+  if (celltext->priv->markup_set)
+    {
+      PangoLayout *layout = create_layout (widget, key);
+
+      if (key->wrap)
+        *text_width = get_unwrapped_width (layout);
+
+      return layout;
+    }
+
+  cache = get_layout_cache (widget);
+
+  entry = g_hash_table_lookup (cache->entries, key);
+  if (entry)
+    {
+      layout_cache_hits++;
+
+      g_queue_unlink (&cache->lru, &entry->link);
+      g_queue_push_head_link (&cache->lru, &entry->link);
+    }
   else
-    pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_NONE);
+    {
+      layout_cache_misses++;
+
+      if (cache->lru.length >= LAYOUT_CACHE_SIZE)
+        {
+          GList *last = g_queue_pop_tail_link (&cache->lru);
+
+          g_hash_table_remove (cache->entries, last->data);
+          layout_cache_evictions++;
+        }
+
+      entry = g_slice_new (LayoutCacheEntry);
+      entry->key = *key;
+      entry->key.text = g_strdup (key->text);
+      if (key->extra_attrs)
+        pango_attr_list_ref (key->extra_attrs);
+      entry->key.font = pango_font_description_copy (key->font);
+      entry->layout = create_layout (widget, key);
+      entry->text_width = key->wrap ? get_unwrapped_width (entry->layout) : -1;
+
+      /* A rough estimate of the layout and its glyph strings */
+      entry->size = sizeof (LayoutCacheEntry) + sizeof (PangoLayout) +
+                    strlen (key->text) * (sizeof (PangoGlyphInfo) + sizeof (gint) +
+                                          sizeof (PangoLogAttr) + 1);
+      layout_cache_bytes += entry->size;
+
+      entry->link.data = entry;
+      entry->link.prev = entry->link.next = NULL;
+      g_queue_push_head_link (&cache->lru, &entry->link);
+      g_hash_table_add (cache->entries, entry);
+    }
+
+  *text_width = entry->text_width;
+
+  return g_object_ref (entry->layout);
+}
+
+static PangoLayout*
+get_layout (GtkCellRendererText *celltext,
+            GtkWidget           *widget,
+            const GdkRectangle  *cell_area,
+            GtkCellRendererState flags)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  LayoutCacheKey key;
+  PangoLayout *layout;
+  gint text_width;
+  gint xpad;
+
+  layout_cache_key_init (&key, celltext, widget, cell_area, flags);
+  layout = lookup_layout (celltext, widget, &key, &text_width);
+
+  gtk_cell_renderer_get_padding (GTK_CELL_RENDERER (celltext), &xpad, NULL);
 
   if (priv->wrap_width != -1)
     {
-      PangoRectangle rect;
-      gint           width, text_width;
-
-      pango_layout_get_extents (layout, NULL, &rect);
-      text_width = rect.width;
+      gint width;
 
       if (cell_area)
 	width = (cell_area->width - xpad * 2) * PANGO_SCALE;
@@ -1684,13 +1982,9 @@ get_layout (GtkCellRendererText *celltext,
       width = MIN (width, text_width);
 
       pango_layout_set_width (layout, width);
-      pango_layout_set_wrap (layout, priv->wrap_mode);
     }
   else
-    {
-      pango_layout_set_width (layout, -1);
-      pango_layout_set_wrap (layout, PANGO_WRAP_CHAR);
-    }
+    pango_layout_set_width (layout, -1);
 
   if (priv->align_set)
     pango_layout_set_alignment (layout, priv->align);
@@ -1709,7 +2003,6 @@ get_layout (GtkCellRendererText *celltext,
   return layout;
 }
 
-
 static void
 get_size (GtkCellRenderer    *cell,
 	  GtkWidget          *widget,
@@ -2253,3 +2546,88 @@ gtk_cell_renderer_text_get_aligned_area (GtkCellRenderer       *cell,
 
   g_object_unref (layout);
 }
+
+/* Returns %TRUE if the size of @celltext is the size of its text
+ * laid out with the attributes from
+ * _gtk_cell_renderer_text_get_measure_attributes() plus a constant,
+ * independent of the width it is given. GtkTreeView uses this to
+ * measure rows without going through the renderer.
+ */
+gboolean
+_gtk_cell_renderer_text_is_measured_by_text (GtkCellRendererText *celltext)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  gint fixed_height;
+
+  g_return_val_if_fail (GTK_IS_CELL_RENDERER_TEXT (celltext), FALSE);
+
+  gtk_cell_renderer_get_fixed_size (GTK_CELL_RENDERER (celltext), NULL, &fixed_height);
+
+  return priv->wrap_width == -1 &&
+         fixed_height == -1 &&
+         !priv->calc_fixed_height &&
+         !(priv->editable && priv->placeholder_text);
+}
+
+/* Returns the attributes that the text of @celltext is laid out with
+ * when it is measured for @widget, so that texts can be measured the
+ * same way with any PangoContext that matches the one of @widget.
+ */
+PangoAttrList *
+_gtk_cell_renderer_text_get_measure_attributes (GtkCellRendererText *celltext,
+                                                GtkWidget           *widget,
+                                                gboolean            *single_paragraph)
+{
+  PangoLayout *layout;
+  PangoAttrList *attrs;
+
+  g_return_val_if_fail (GTK_IS_CELL_RENDERER_TEXT (celltext), NULL);
+
+  layout = get_layout (celltext, widget, NULL, 0);
+
+  attrs = pango_attr_list_copy (pango_layout_get_attributes (layout));
+  if (attrs == NULL)
+    attrs = pango_attr_list_new ();
+
+  if (single_paragraph)
+    *single_paragraph = pango_layout_get_single_paragraph_mode (layout);
+
+  g_object_unref (layout);
+
+  return attrs;
+}
+
+/* Sets the text of @celltext like the GtkCellRendererText:text property
+ * does, without emitting ::notify. This is used by GtkCellArea to bind
+ * typed model columns to the renderer without a GValue round trip.
+ */
+void
+_gtk_cell_renderer_text_set_text (GtkCellRendererText *celltext,
+                                  const gchar         *text)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+
+  if (!priv->markup_set && g_strcmp0 (priv->text, text) == 0)
+    return;
+
+  take_text (celltext, g_strdup (text));
+}
+
+/* Returns totals for the layout caches of all widgets. The size is
+ * an estimate of the memory used by the cached layouts.
+ */
+void
+_gtk_cell_renderer_text_get_layout_cache_statistics (guint64 *n_hits,
+                                                     guint64 *n_misses,
+                                                     guint64 *n_evictions,
+                                                     gsize   *n_bytes)
+{
+  if (n_hits)
+    *n_hits = layout_cache_hits;
+  if (n_misses)
+    *n_misses = layout_cache_misses;
+  if (n_evictions)
+    *n_evictions = layout_cache_evictions;
+  if (n_bytes)
+    *n_bytes = layout_cache_bytes;
+}
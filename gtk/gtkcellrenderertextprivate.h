@@ -0,0 +1,38 @@
+/* gtkcellrenderertextprivate.h
+ * Copyright (C) 2000  Red Hat, Inc.,  Jonathan Blandford <jrb@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_CELL_RENDERER_TEXT_PRIVATE_H__
+#define __GTK_CELL_RENDERER_TEXT_PRIVATE_H__
+
+#include "gtkcellrenderertext.h"
+
+G_BEGIN_DECLS
+
+gboolean        _gtk_cell_renderer_text_is_measured_by_text    (GtkCellRendererText *celltext);
+PangoAttrList * _gtk_cell_renderer_text_get_measure_attributes (GtkCellRendererText *celltext,
+                                                                GtkWidget           *widget,
+                                                                gboolean            *single_paragraph);
+void            _gtk_cell_renderer_text_set_text               (GtkCellRendererText *celltext,
+                                                                const gchar         *text);
+void            _gtk_cell_renderer_text_get_layout_cache_statistics (guint64 *n_hits,
+                                                                     guint64 *n_misses,
+                                                                     guint64 *n_evictions,
+                                                                     gsize   *n_bytes);
+
+G_END_DECLS
+
+#endif /* __GTK_CELL_RENDERER_TEXT_PRIVATE_H__ */
@@ -17,7 +17,7 @@
 
 #include "config.h"
 #include <stdlib.h>
-#include "gtkcellrenderertoggle.h"
+#include "gtkcellrenderertoggleprivate.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
 #include "gtkprivate.h"
@@ -631,3 +631,13 @@ gtk_cell_renderer_toggle_set_activatable (GtkCellRendererToggle *toggle,
       g_object_notify (G_OBJECT (toggle), "activatable");
     }
 }
+
+/* Like setting GtkCellRendererToggle:active, but without emitting
+ * ::notify. Used by GtkCellArea for typed model columns.
+ */
+void
+_gtk_cell_renderer_toggle_set_active (GtkCellRendererToggle *toggle,
+                                      gboolean               active)
+{
+  toggle->priv->active = active != FALSE;
+}
@@ -0,0 +1,1338 @@
+/* gtkcolumnstore.c
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <gobject/gvaluecollector.h>
+#include "gtktreemodel.h"
+#include "gtkcolumnstore.h"
+
+
+/**
+ * SECTION:gtkcolumnstore
+ * @Short_description: A compact list model for large tables of simple values
+ * @Title: GtkColumnStore
+ * @See_also: #GtkTreeModel, #GtkListStore
+ *
+ * The #GtkColumnStore object is a list model for use with a #GtkTreeView
+ * widget, like #GtkListStore.  Instead of keeping a list of values for
+ * every row, it keeps every column in a single array of values of the
+ * column type.  This makes it considerably smaller and faster to access
+ * than a #GtkListStore when there are many rows of numbers and short
+ * strings.
+ *
+ * Only the following column types are supported: %G_TYPE_BOOLEAN,
+ * %G_TYPE_INT, %G_TYPE_UINT, %G_TYPE_INT64, %G_TYPE_FLOAT,
+ * %G_TYPE_DOUBLE, %G_TYPE_STRING and #GObject types.  Strings are
+ * interned, so a string that occurs in many rows is only stored once.
+ *
+ * Besides the #GtkTreeModel API, values can be read without going
+ * through a #GValue with the typed accessors such as
+ * gtk_column_store_get_int() and gtk_column_store_get_string().
+ *
+ * Inserting and removing rows invalidates all iters, and the store
+ * cannot be sorted by itself; wrap it in a #GtkTreeModelSort for that.
+ *
+ * Since: 3.24
+ */
+
+
+typedef struct
+{
+  GType   type;
+  GType   fundamental;
+  gsize   elem_size;
+  guint8 *data;
+} GtkColumnStoreColumn;
+
+struct _GtkColumnStorePrivate
+{
+  GtkColumnStoreColumn *columns;
+  gint n_columns;
+
+  gint n_rows;
+  gint n_allocated;
+
+  gint stamp;
+
+  /* interned strings, see gtk_column_store_intern_string() */
+  GHashTable *strings;
+};
+
+typedef struct
+{
+  guint ref_count;
+  gchar str[1];
+} InternedString;
+
+#define INTERNED_STRING(s) ((InternedString *) ((s) - G_STRUCT_OFFSET (InternedString, str)))
+
+#define CELL(column, row, type) (((type *) (column)->data)[row])
+
+#define ITER_ROW(iter) (GPOINTER_TO_INT ((iter)->user_data))
+
+#define VALID_ITER(iter, column_store) ((iter) != NULL && (iter)->stamp == (column_store)->priv->stamp && ITER_ROW (iter) >= 0 && ITER_ROW (iter) < (column_store)->priv->n_rows)
+
+static void         gtk_column_store_tree_model_init (GtkTreeModelIface *iface);
+static void         gtk_column_store_finalize        (GObject           *object);
+static GtkTreeModelFlags gtk_column_store_get_flags  (GtkTreeModel      *tree_model);
+static gint         gtk_column_store_get_n_columns   (GtkTreeModel      *tree_model);
+static GType        gtk_column_store_get_column_type (GtkTreeModel      *tree_model,
+                                                      gint               index);
+static gboolean     gtk_column_store_get_iter        (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter,
+                                                      GtkTreePath       *path);
+static GtkTreePath *gtk_column_store_get_path        (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter);
+static void         gtk_column_store_get_value       (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter,
+                                                      gint               column,
+                                                      GValue            *value);
+static gboolean     gtk_column_store_iter_next       (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter);
+static gboolean     gtk_column_store_iter_previous   (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter);
+static gboolean     gtk_column_store_iter_children   (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter,
+                                                      GtkTreeIter       *parent);
+static gboolean     gtk_column_store_iter_has_child  (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter);
+static gint         gtk_column_store_iter_n_children (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter);
+static gboolean     gtk_column_store_iter_nth_child  (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter,
+                                                      GtkTreeIter       *parent,
+                                                      gint               n);
+static gboolean     gtk_column_store_iter_parent     (GtkTreeModel      *tree_model,
+                                                      GtkTreeIter       *iter,
+                                                      GtkTreeIter       *child);
+
+
+G_DEFINE_TYPE_WITH_CODE (GtkColumnStore, gtk_column_store, G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (GtkColumnStore)
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+                                                gtk_column_store_tree_model_init))
+
+
+static void
+gtk_column_store_class_init (GtkColumnStoreClass *class)
+{
+  GObjectClass *object_class;
+
+  object_class = (GObjectClass *) class;
+
+  object_class->finalize = gtk_column_store_finalize;
+}
+
+static void
+gtk_column_store_tree_model_init (GtkTreeModelIface *iface)
+{
+  iface->get_flags = gtk_column_store_get_flags;
+  iface->get_n_columns = gtk_column_store_get_n_columns;
+  iface->get_column_type = gtk_column_store_get_column_type;
+  iface->get_iter = gtk_column_store_get_iter;
+  iface->get_path = gtk_column_store_get_path;
+  iface->get_value = gtk_column_store_get_value;
+  iface->iter_next = gtk_column_store_iter_next;
+  iface->iter_previous = gtk_column_store_iter_previous;
+  iface->iter_children = gtk_column_store_iter_children;
+  iface->iter_has_child = gtk_column_store_iter_has_child;
+  iface->iter_n_children = gtk_column_store_iter_n_children;
+  iface->iter_nth_child = gtk_column_store_iter_nth_child;
+  iface->iter_parent = gtk_column_store_iter_parent;
+}
+
+static void
+gtk_column_store_init (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+
+  column_store->priv = gtk_column_store_get_instance_private (column_store);
+  priv = column_store->priv;
+
+  priv->stamp = g_random_int ();
+  priv->strings = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL, g_free);
+}
+
+/* Returns the fundamental type values of @type are stored as, or
+ * %G_TYPE_INVALID if the store does not support @type.
+ */
+static GType
+gtk_column_store_storage_type (GType  type,
+                               gsize *elem_size)
+{
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+      *elem_size = sizeof (guint8);
+      return G_TYPE_BOOLEAN;
+    case G_TYPE_INT:
+      *elem_size = sizeof (gint);
+      return G_TYPE_INT;
+    case G_TYPE_UINT:
+      *elem_size = sizeof (guint);
+      return G_TYPE_UINT;
+    case G_TYPE_INT64:
+      *elem_size = sizeof (gint64);
+      return G_TYPE_INT64;
+    case G_TYPE_FLOAT:
+      *elem_size = sizeof (gfloat);
+      return G_TYPE_FLOAT;
+    case G_TYPE_DOUBLE:
+      *elem_size = sizeof (gdouble);
+      return G_TYPE_DOUBLE;
+    case G_TYPE_STRING:
+      *elem_size = sizeof (const gchar *);
+      return G_TYPE_STRING;
+    default:
+      if (g_type_is_a (type, G_TYPE_OBJECT))
+        {
+          *elem_size = sizeof (gpointer);
+          return G_TYPE_OBJECT;
+        }
+      return G_TYPE_INVALID;
+    }
+}
+
+static gboolean
+gtk_column_store_set_column_types (GtkColumnStore *column_store,
+                                   gint            n_columns,
+                                   GType          *types)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  priv->columns = g_new0 (GtkColumnStoreColumn, n_columns);
+  priv->n_columns = n_columns;
+
+  for (i = 0; i < n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &priv->columns[i];
+
+      column->type = types[i];
+      column->fundamental = gtk_column_store_storage_type (types[i],
+                                                           &column->elem_size);
+      if (column->fundamental == G_TYPE_INVALID)
+        {
+          g_warning ("%s: Invalid type %s", G_STRLOC, g_type_name (types[i]));
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Strings are reference counted in a hash table of the store, so that
+ * every distinct string is stored once and rows only hold a pointer.
+ */
+static const gchar *
+gtk_column_store_intern_string (GtkColumnStore *column_store,
+                                const gchar    *str)
+{
+  InternedString *interned;
+  gsize len;
+
+  if (str == NULL)
+    return NULL;
+
+  interned = g_hash_table_lookup (column_store->priv->strings, str);
+  if (interned)
+    {
+      interned->ref_count++;
+      return interned->str;
+    }
+
+  len = strlen (str);
+  interned = g_malloc (G_STRUCT_OFFSET (InternedString, str) + len + 1);
+  interned->ref_count = 1;
+  memcpy (interned->str, str, len + 1);
+
+  g_hash_table_insert (column_store->priv->strings, interned->str, interned);
+
+  return interned->str;
+}
+
+static void
+gtk_column_store_release_string (GtkColumnStore *column_store,
+                                 const gchar    *str)
+{
+  InternedString *interned;
+
+  if (str == NULL)
+    return;
+
+  interned = INTERNED_STRING (str);
+  if (--interned->ref_count == 0)
+    g_hash_table_remove (column_store->priv->strings, interned->str);
+}
+
+static void
+gtk_column_store_release_rows (GtkColumnStore *column_store,
+                               gint            start,
+                               gint            end)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i, row;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &priv->columns[i];
+
+      if (column->fundamental == G_TYPE_STRING)
+        {
+          for (row = start; row < end; row++)
+            gtk_column_store_release_string (column_store,
+                                             CELL (column, row, const gchar *));
+        }
+      else if (column->fundamental == G_TYPE_OBJECT)
+        {
+          for (row = start; row < end; row++)
+            if (CELL (column, row, gpointer))
+              g_object_unref (CELL (column, row, gpointer));
+        }
+    }
+}
+
+static void
+gtk_column_store_finalize (GObject *object)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (object);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  if (priv->columns)
+    {
+      gtk_column_store_release_rows (column_store, 0, priv->n_rows);
+
+      for (i = 0; i < priv->n_columns; i++)
+        g_free (priv->columns[i].data);
+      g_free (priv->columns);
+    }
+
+  g_hash_table_destroy (priv->strings);
+
+  G_OBJECT_CLASS (gtk_column_store_parent_class)->finalize (object);
+}
+
+/**
+ * gtk_column_store_new:
+ * @n_columns: number of columns in the column store
+ * @...: all #GType types for the columns, from first to last
+ *
+ * Creates a new column store with @n_columns columns each of the
+ * types passed in.  See the #GtkColumnStore documentation for the
+ * supported types.
+ *
+ * Returns: a new #GtkColumnStore
+ *
+ * Since: 3.24
+ */
+GtkColumnStore *
+gtk_column_store_new (gint n_columns,
+                      ...)
+{
+  GtkColumnStore *retval;
+  GType *types;
+  va_list args;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  types = g_new (GType, n_columns);
+
+  va_start (args, n_columns);
+  for (i = 0; i < n_columns; i++)
+    types[i] = va_arg (args, GType);
+  va_end (args);
+
+  retval = gtk_column_store_newv (n_columns, types);
+
+  g_free (types);
+
+  return retval;
+}
+
+/**
+ * gtk_column_store_newv: (rename-to gtk_column_store_new)
+ * @n_columns: number of columns in the column store
+ * @types: (array length=n_columns): an array of #GType types for the columns, from first to last
+ *
+ * Non-vararg creation function.  Used primarily by language bindings.
+ *
+ * Returns: (transfer full): a new #GtkColumnStore
+ *
+ * Since: 3.24
+ */
+GtkColumnStore *
+gtk_column_store_newv (gint   n_columns,
+                       GType *types)
+{
+  GtkColumnStore *retval;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  retval = g_object_new (GTK_TYPE_COLUMN_STORE, NULL);
+
+  if (!gtk_column_store_set_column_types (retval, n_columns, types))
+    {
+      g_object_unref (retval);
+      return NULL;
+    }
+
+  return retval;
+}
+
+/* Fulfill the GtkTreeModel requirements */
+static GtkTreeModelFlags
+gtk_column_store_get_flags (GtkTreeModel *tree_model)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+gtk_column_store_get_n_columns (GtkTreeModel *tree_model)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  return column_store->priv->n_columns;
+}
+
+static GType
+gtk_column_store_get_column_type (GtkTreeModel *tree_model,
+                                  gint          index)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  g_return_val_if_fail (index < priv->n_columns, G_TYPE_INVALID);
+
+  return priv->columns[index].type;
+}
+
+static gboolean
+gtk_column_store_get_iter (GtkTreeModel *tree_model,
+                           GtkTreeIter  *iter,
+                           GtkTreePath  *path)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return FALSE;
+
+  i = gtk_tree_path_get_indices (path)[0];
+
+  if (i < 0 || i >= priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->stamp = priv->stamp;
+  iter->user_data = GINT_TO_POINTER (i);
+
+  return TRUE;
+}
+
+static GtkTreePath *
+gtk_column_store_get_path (GtkTreeModel *tree_model,
+                           GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter->stamp == column_store->priv->stamp, NULL);
+
+  if (!VALID_ITER (iter, column_store))
+    return NULL;
+
+  return gtk_tree_path_new_from_indices (ITER_ROW (iter), -1);
+}
+
+static void
+gtk_column_store_get_value (GtkTreeModel *tree_model,
+                            GtkTreeIter  *iter,
+                            gint          column,
+                            GValue       *value)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkColumnStoreColumn *col;
+  gint row;
+
+  g_return_if_fail (column < priv->n_columns);
+  g_return_if_fail (VALID_ITER (iter, column_store));
+
+  col = &priv->columns[column];
+  row = ITER_ROW (iter);
+
+  g_value_init (value, col->type);
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      g_value_set_boolean (value, CELL (col, row, guint8));
+      break;
+    case G_TYPE_INT:
+      g_value_set_int (value, CELL (col, row, gint));
+      break;
+    case G_TYPE_UINT:
+      g_value_set_uint (value, CELL (col, row, guint));
+      break;
+    case G_TYPE_INT64:
+      g_value_set_int64 (value, CELL (col, row, gint64));
+      break;
+    case G_TYPE_FLOAT:
+      g_value_set_float (value, CELL (col, row, gfloat));
+      break;
+    case G_TYPE_DOUBLE:
+      g_value_set_double (value, CELL (col, row, gdouble));
+      break;
+    case G_TYPE_STRING:
+      g_value_set_string (value, CELL (col, row, const gchar *));
+      break;
+    case G_TYPE_OBJECT:
+      g_value_set_object (value, CELL (col, row, gpointer));
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gboolean
+gtk_column_store_iter_next (GtkTreeModel *tree_model,
+                            GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter->stamp == column_store->priv->stamp, FALSE);
+
+  if (ITER_ROW (iter) + 1 >= column_store->priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GINT_TO_POINTER (ITER_ROW (iter) + 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_previous (GtkTreeModel *tree_model,
+                                GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter->stamp == column_store->priv->stamp, FALSE);
+
+  if (ITER_ROW (iter) <= 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GINT_TO_POINTER (ITER_ROW (iter) - 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_children (GtkTreeModel *tree_model,
+                                GtkTreeIter  *iter,
+                                GtkTreeIter  *parent)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  /* this is a list, nodes have no children */
+  if (parent || column_store->priv->n_rows == 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (0);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_has_child (GtkTreeModel *tree_model,
+                                 GtkTreeIter  *iter)
+{
+  return FALSE;
+}
+
+static gint
+gtk_column_store_iter_n_children (GtkTreeModel *tree_model,
+                                  GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  if (iter == NULL)
+    return column_store->priv->n_rows;
+
+  g_return_val_if_fail (column_store->priv->stamp == iter->stamp, -1);
+
+  return 0;
+}
+
+static gboolean
+gtk_column_store_iter_nth_child (GtkTreeModel *tree_model,
+                                 GtkTreeIter  *iter,
+                                 GtkTreeIter  *parent,
+                                 gint          n)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (tree_model);
+
+  iter->stamp = 0;
+
+  if (parent || n < 0 || n >= column_store->priv->n_rows)
+    return FALSE;
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (n);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_parent (GtkTreeModel *tree_model,
+                              GtkTreeIter  *iter,
+                              GtkTreeIter  *child)
+{
+  iter->stamp = 0;
+  return FALSE;
+}
+
+static void
+gtk_column_store_set_cell (GtkColumnStore *column_store,
+                           gint            row,
+                           gint            column,
+                           const GValue   *value)
+{
+  GtkColumnStoreColumn *col = &column_store->priv->columns[column];
+  const gchar *str;
+  gpointer object;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      CELL (col, row, guint8) = g_value_get_boolean (value) != FALSE;
+      break;
+    case G_TYPE_INT:
+      CELL (col, row, gint) = g_value_get_int (value);
+      break;
+    case G_TYPE_UINT:
+      CELL (col, row, guint) = g_value_get_uint (value);
+      break;
+    case G_TYPE_INT64:
+      CELL (col, row, gint64) = g_value_get_int64 (value);
+      break;
+    case G_TYPE_FLOAT:
+      CELL (col, row, gfloat) = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      CELL (col, row, gdouble) = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      /* intern first, the new string may be the old one */
+      str = gtk_column_store_intern_string (column_store,
+                                            g_value_get_string (value));
+      gtk_column_store_release_string (column_store,
+                                       CELL (col, row, const gchar *));
+      CELL (col, row, const gchar *) = str;
+      break;
+    case G_TYPE_OBJECT:
+      object = g_value_dup_object (value);
+      if (CELL (col, row, gpointer))
+        g_object_unref (CELL (col, row, gpointer));
+      CELL (col, row, gpointer) = object;
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gboolean
+gtk_column_store_real_set_value (GtkColumnStore *column_store,
+                                 gint            row,
+                                 gint            column,
+                                 GValue         *value)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GValue real_value = G_VALUE_INIT;
+  gboolean converted = FALSE;
+
+  g_return_val_if_fail (column >= 0 && column < priv->n_columns, FALSE);
+  g_return_val_if_fail (G_IS_VALUE (value), FALSE);
+
+  if (! g_type_is_a (G_VALUE_TYPE (value), priv->columns[column].type))
+    {
+      if (! (g_value_type_transformable (G_VALUE_TYPE (value), priv->columns[column].type)))
+        {
+          g_warning ("%s: Unable to convert from %s to %s",
+                     G_STRLOC,
+                     g_type_name (G_VALUE_TYPE (value)),
+                     g_type_name (priv->columns[column].type));
+          return FALSE;
+        }
+
+      g_value_init (&real_value, priv->columns[column].type);
+      if (!g_value_transform (value, &real_value))
+        {
+          g_warning ("%s: Unable to make conversion from %s to %s",
+                     G_STRLOC,
+                     g_type_name (G_VALUE_TYPE (value)),
+                     g_type_name (priv->columns[column].type));
+          g_value_unset (&real_value);
+          return FALSE;
+        }
+      converted = TRUE;
+    }
+
+  gtk_column_store_set_cell (column_store, row, column,
+                             converted ? &real_value : value);
+
+  if (converted)
+    g_value_unset (&real_value);
+
+  return TRUE;
+}
+
+/**
+ * gtk_column_store_set_value:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @column: column number to modify
+ * @value: new value for the cell
+ *
+ * Sets the data in the cell specified by @iter and @column.
+ * The type of @value must be convertible to the type of the
+ * column.
+ *
+ * Since: 3.24
+ */
+void
+gtk_column_store_set_value (GtkColumnStore *column_store,
+                            GtkTreeIter    *iter,
+                            gint            column,
+                            GValue         *value)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+  g_return_if_fail (G_IS_VALUE (value));
+
+  if (gtk_column_store_real_set_value (column_store, ITER_ROW (iter),
+                                       column, value))
+    {
+      GtkTreePath *path;
+
+      path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (column_store), path, iter);
+      gtk_tree_path_free (path);
+    }
+}
+
+static gboolean
+gtk_column_store_set_valist_internal (GtkColumnStore *column_store,
+                                      gint            row,
+                                      va_list         var_args)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gboolean changed = FALSE;
+  gint column;
+
+  column = va_arg (var_args, gint);
+
+  while (column != -1)
+    {
+      GValue value = G_VALUE_INIT;
+      gchar *error = NULL;
+
+      if (column < 0 || column >= priv->n_columns)
+        {
+          g_warning ("%s: Invalid column number %d added to iter (remember to end your list of columns with a -1)", G_STRLOC, column);
+          break;
+        }
+
+      G_VALUE_COLLECT_INIT (&value, priv->columns[column].type,
+                            var_args, 0, &error);
+      if (error)
+        {
+          g_warning ("%s: %s", G_STRLOC, error);
+          g_free (error);
+
+          /* we purposely leak the value here, it might not be
+           * in a sane state if an error condition occoured
+           */
+          break;
+        }
+
+      changed = gtk_column_store_real_set_value (column_store, row,
+                                                 column, &value) || changed;
+
+      g_value_unset (&value);
+
+      column = va_arg (var_args, gint);
+    }
+
+  return changed;
+}
+
+/**
+ * gtk_column_store_set_valist:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @var_args: va_list of column/value pairs
+ *
+ * See gtk_column_store_set(); this version takes a va_list for use by
+ * language bindings.
+ *
+ * Since: 3.24
+ */
+void
+gtk_column_store_set_valist (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             va_list         var_args)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+
+  if (gtk_column_store_set_valist_internal (column_store, ITER_ROW (iter),
+                                            var_args))
+    {
+      GtkTreePath *path;
+
+      path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (column_store), path, iter);
+      gtk_tree_path_free (path);
+    }
+}
+
+/**
+ * gtk_column_store_set:
+ * @column_store: a #GtkColumnStore
+ * @iter: row iterator
+ * @...: pairs of column number and value, terminated with -1
+ *
+ * Sets the value of one or more cells in the row referenced by @iter.
+ * The variable argument list should contain integer column numbers,
+ * each column number followed by the value to be set.
+ * The list is terminated by a -1, as for gtk_list_store_set().
+ *
+ * Since: 3.24
+ */
+void
+gtk_column_store_set (GtkColumnStore *column_store,
+                      GtkTreeIter    *iter,
+                      ...)
+{
+  va_list var_args;
+
+  va_start (var_args, iter);
+  gtk_column_store_set_valist (column_store, iter, var_args);
+  va_end (var_args);
+}
+
+static gboolean
+gtk_column_store_check_cell (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             gint            column,
+                             GType           fundamental)
+{
+  GtkColumnStorePrivate *priv;
+
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (VALID_ITER (iter, column_store), FALSE);
+
+  priv = column_store->priv;
+
+  g_return_val_if_fail (column >= 0 && column < priv->n_columns, FALSE);
+  g_return_val_if_fail (priv->columns[column].fundamental == fundamental, FALSE);
+
+  return TRUE;
+}
+
+/**
+ * gtk_column_store_get_boolean:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of type %G_TYPE_BOOLEAN
+ *
+ * Gets the value of a boolean cell, without the cost of going
+ * through a #GValue.
+ *
+ * Returns: the value of the cell
+ *
+ * Since: 3.24
+ */
+gboolean
+gtk_column_store_get_boolean (GtkColumnStore *column_store,
+                              GtkTreeIter    *iter,
+                              gint            column)
+{
+  if (!gtk_column_store_check_cell (column_store, iter, column, G_TYPE_BOOLEAN))
+    return FALSE;
+
+  return CELL (&column_store->priv->columns[column], ITER_ROW (iter), guint8);
+}
+
+/**
+ * gtk_column_store_get_int:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of type %G_TYPE_INT
+ *
+ * Gets the value of an integer cell, without the cost of going
+ * through a #GValue.
+ *
+ * Returns: the value of the cell
+ *
+ * Since: 3.24
+ */
+gint
+gtk_column_store_get_int (GtkColumnStore *column_store,
+                          GtkTreeIter    *iter,
+                          gint            column)
+{
+  if (!gtk_column_store_check_cell (column_store, iter, column, G_TYPE_INT))
+    return 0;
+
+  return CELL (&column_store->priv->columns[column], ITER_ROW (iter), gint);
+}
+
+/**
+ * gtk_column_store_get_uint:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of type %G_TYPE_UINT
+ *
+ * Gets the value of an unsigned integer cell, without the cost of
+ * going through a #GValue.
+ *
+ * Returns: the value of the cell
+ *
+ * Since: 3.24
+ */
+guint
+gtk_column_store_get_uint (GtkColumnStore *column_store,
+                           GtkTreeIter    *iter,
+                           gint            column)
+{
+  if (!gtk_column_store_check_cell (column_store, iter, column, G_TYPE_UINT))
+    return 0;
+
+  return CELL (&column_store->priv->columns[column], ITER_ROW (iter), guint);
+}
+
+/**
+ * gtk_column_store_get_int64:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of type %G_TYPE_INT64
+ *
+ * Gets the value of a 64-bit integer cell, without the cost of going
+ * through a #GValue.
+ *
+ * Returns: the value of the cell
+ *
+ * Since: 3.24
+ */
+gint64
+gtk_column_store_get_int64 (GtkColumnStore *column_store,
+                            GtkTreeIter    *iter,
+                            gint            column)
+{
+  if (!gtk_column_store_check_cell (column_store, iter, column, G_TYPE_INT64))
+    return 0;
+
+  return CELL (&column_store->priv->columns[column], ITER_ROW (iter), gint64);
+}
+
+/**
+ * gtk_column_store_get_float:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of type %G_TYPE_FLOAT
+ *
+ * Gets the value of a single precision floating point cell, without
+ * the cost of going through a #GValue.
+ *
+ * Returns: the value of the cell
+ *
+ * Since: 3.24
+ */
+gfloat
+gtk_column_store_get_float (GtkColumnStore *column_store,
+                            GtkTreeIter    *iter,
+                            gint            column)
+{
+  if (!gtk_column_store_check_cell (column_store, iter, column, G_TYPE_FLOAT))
+    return 0.0;
+
+  return CELL (&column_store->priv->columns[column], ITER_ROW (iter), gfloat);
+}
+
+/**
+ * gtk_column_store_get_double:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of type %G_TYPE_DOUBLE or %G_TYPE_FLOAT
+ *
+ * Gets the value of a floating point cell, without the cost of going
+ * through a #GValue.
+ *
+ * Returns: the value of the cell
+ *
+ * Since: 3.24
+ */
+gdouble
+gtk_column_store_get_double (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             gint            column)
+{
+  GtkColumnStoreColumn *col;
+
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), 0.0);
+  g_return_val_if_fail (VALID_ITER (iter, column_store), 0.0);
+  g_return_val_if_fail (column >= 0 && column < column_store->priv->n_columns, 0.0);
+
+  col = &column_store->priv->columns[column];
+
+  if (col->fundamental == G_TYPE_FLOAT)
+    return CELL (col, ITER_ROW (iter), gfloat);
+
+  g_return_val_if_fail (col->fundamental == G_TYPE_DOUBLE, 0.0);
+
+  return CELL (col, ITER_ROW (iter), gdouble);
+}
+
+/**
+ * gtk_column_store_get_string:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of type %G_TYPE_STRING
+ *
+ * Gets the value of a string cell, without copying it.
+ *
+ * Returns: (nullable) (transfer none): the value of the cell. It is
+ *   owned by the store and only valid until the cell is changed or
+ *   the row is removed.
+ *
+ * Since: 3.24
+ */
+const gchar *
+gtk_column_store_get_string (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             gint            column)
+{
+  if (!gtk_column_store_check_cell (column_store, iter, column, G_TYPE_STRING))
+    return NULL;
+
+  return CELL (&column_store->priv->columns[column], ITER_ROW (iter), const gchar *);
+}
+
+/**
+ * gtk_column_store_get_object:
+ * @column_store: a #GtkColumnStore
+ * @iter: a valid #GtkTreeIter
+ * @column: a column of a #GObject type
+ *
+ * Gets the object in a cell, without taking a reference to it.
+ *
+ * Returns: (nullable) (transfer none) (type GObject): the object in the cell
+ *
+ * Since: 3.24
+ */
+gpointer
+gtk_column_store_get_object (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             gint            column)
+{
+  if (!gtk_column_store_check_cell (column_store, iter, column, G_TYPE_OBJECT))
+    return NULL;
+
+  return CELL (&column_store->priv->columns[column], ITER_ROW (iter), gpointer);
+}
+
+static void
+gtk_column_store_increment_stamp (GtkColumnStore *column_store)
+{
+  do
+    {
+      column_store->priv->stamp++;
+    }
+  while (column_store->priv->stamp == 0);
+}
+
+/* Makes room for a zeroed row at @position, without emitting signals */
+static void
+gtk_column_store_insert_row (GtkColumnStore *column_store,
+                             gint            position)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  if (priv->n_rows == priv->n_allocated)
+    {
+      priv->n_allocated = MAX (16, priv->n_allocated * 2);
+
+      for (i = 0; i < priv->n_columns; i++)
+        priv->columns[i].data = g_realloc_n (priv->columns[i].data,
+                                             priv->n_allocated,
+                                             priv->columns[i].elem_size);
+    }
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &priv->columns[i];
+
+      memmove (column->data + (position + 1) * column->elem_size,
+               column->data + position * column->elem_size,
+               (priv->n_rows - position) * column->elem_size);
+      memset (column->data + position * column->elem_size, 0,
+              column->elem_size);
+    }
+
+  priv->n_rows++;
+
+  gtk_column_store_increment_stamp (column_store);
+}
+
+static void
+gtk_column_store_emit_row_inserted (GtkColumnStore *column_store,
+                                    GtkTreeIter    *iter,
+                                    gint            position)
+{
+  GtkTreePath *path;
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (position);
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_insert:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out): An unset #GtkTreeIter to set to the new row
+ * @position: position to insert the new row, or -1 for last
+ *
+ * Creates a new row at @position.  @iter will be changed to point to
+ * this new row.  If @position is -1 or larger than the number of rows
+ * in the store, the new row will be appended.  All cells of the new
+ * row are zero, %FALSE or %NULL.
+ *
+ * Since: 3.24
+ */
+void
+gtk_column_store_insert (GtkColumnStore *column_store,
+                         GtkTreeIter    *iter,
+                         gint            position)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreeIter tmp_iter;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  priv = column_store->priv;
+
+  if (!iter)
+    iter = &tmp_iter;
+
+  if (position < 0 || position > priv->n_rows)
+    position = priv->n_rows;
+
+  gtk_column_store_insert_row (column_store, position);
+  gtk_column_store_emit_row_inserted (column_store, iter, position);
+}
+
+/**
+ * gtk_column_store_insert_with_values:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out) (allow-none): An unset #GtkTreeIter to set to the new row, or %NULL
+ * @position: position to insert the new row, or -1 to append after existing
+ *     rows
+ * @...: pairs of column number and value, terminated with -1
+ *
+ * Creates a new row at @position and fills it with values, emitting
+ * only #GtkTreeModel::row-inserted for it, as
+ * gtk_list_store_insert_with_values() does.
+ *
+ * Since: 3.24
+ */
+void
+gtk_column_store_insert_with_values (GtkColumnStore *column_store,
+                                     GtkTreeIter    *iter,
+                                     gint            position,
+                                     ...)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreeIter tmp_iter;
+  va_list var_args;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  priv = column_store->priv;
+
+  if (!iter)
+    iter = &tmp_iter;
+
+  if (position < 0 || position > priv->n_rows)
+    position = priv->n_rows;
+
+  gtk_column_store_insert_row (column_store, position);
+
+  va_start (var_args, position);
+  gtk_column_store_set_valist_internal (column_store, position, var_args);
+  va_end (var_args);
+
+  gtk_column_store_emit_row_inserted (column_store, iter, position);
+}
+
+/**
+ * gtk_column_store_append:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out): An unset #GtkTreeIter to set to the appended row
+ *
+ * Appends a new row to @column_store.  @iter will be changed to point
+ * to this new row.
+ *
+ * Since: 3.24
+ */
+void
+gtk_column_store_append (GtkColumnStore *column_store,
+                         GtkTreeIter    *iter)
+{
+  gtk_column_store_insert (column_store, iter, -1);
+}
+
+/**
+ * gtk_column_store_remove:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ *
+ * Removes the given row from the column store.  After being removed,
+ * @iter is set to be the next valid row, or invalidated if it pointed
+ * to the last row in @column_store.
+ *
+ * Returns: %TRUE if @iter is valid, %FALSE if not.
+ *
+ * Since: 3.24
+ */
+gboolean
+gtk_column_store_remove (GtkColumnStore *column_store,
+                         GtkTreeIter    *iter)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  gint row, i;
+
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (VALID_ITER (iter, column_store), FALSE);
+
+  priv = column_store->priv;
+  row = ITER_ROW (iter);
+
+  gtk_column_store_release_rows (column_store, row, row + 1);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &priv->columns[i];
+
+      memmove (column->data + row * column->elem_size,
+               column->data + (row + 1) * column->elem_size,
+               (priv->n_rows - row - 1) * column->elem_size);
+    }
+
+  priv->n_rows--;
+  gtk_column_store_increment_stamp (column_store);
+
+  path = gtk_tree_path_new_from_indices (row, -1);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+  gtk_tree_path_free (path);
+
+  if (row < priv->n_rows)
+    {
+      iter->stamp = priv->stamp;
+      return TRUE;
+    }
+
+  iter->stamp = 0;
+  return FALSE;
+}
+
+/**
+ * gtk_column_store_clear:
+ * @column_store: a #GtkColumnStore.
+ *
+ * Removes all rows from the column store, emitting a single
+ * #GtkTreeModel::rows-deleted signal for them.
+ *
+ * Since: 3.24
+ */
+void
+gtk_column_store_clear (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  gint n_rows;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  priv = column_store->priv;
+
+  if (priv->n_rows == 0)
+    return;
+
+  gtk_column_store_release_rows (column_store, 0, priv->n_rows);
+
+  n_rows = priv->n_rows;
+  priv->n_rows = 0;
+  gtk_column_store_increment_stamp (column_store);
+
+  path = gtk_tree_path_new_first ();
+  gtk_tree_model_rows_deleted (GTK_TREE_MODEL (column_store), path, n_rows);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_iter_is_valid:
+ * @column_store: A #GtkColumnStore.
+ * @iter: A #GtkTreeIter.
+ *
+ * Checks if the given iter is a valid iter for this #GtkColumnStore.
+ * Unlike for #GtkListStore, this is cheap.
+ *
+ * Returns: %TRUE if the iter is valid, %FALSE if the iter is invalid.
+ *
+ * Since: 3.24
+ */
+gboolean
+gtk_column_store_iter_is_valid (GtkColumnStore *column_store,
+                                GtkTreeIter    *iter)
+{
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  return VALID_ITER (iter, column_store);
+}
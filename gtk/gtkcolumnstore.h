@@ -0,0 +1,144 @@
+/* gtkcolumnstore.h
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_COLUMN_STORE_H__
+#define __GTK_COLUMN_STORE_H__
+
+#if !defined (__GTK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gtk/gtk.h> can be included directly."
+#endif
+
+#include <gdk/gdk.h>
+#include <gtk/gtktreemodel.h>
+
+
+G_BEGIN_DECLS
+
+
+#define GTK_TYPE_COLUMN_STORE	         (gtk_column_store_get_type ())
+#define GTK_COLUMN_STORE(obj)	         (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_TYPE_COLUMN_STORE, GtkColumnStore))
+#define GTK_COLUMN_STORE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GTK_TYPE_COLUMN_STORE, GtkColumnStoreClass))
+#define GTK_IS_COLUMN_STORE(obj)	 (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTK_TYPE_COLUMN_STORE))
+#define GTK_IS_COLUMN_STORE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GTK_TYPE_COLUMN_STORE))
+#define GTK_COLUMN_STORE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_COLUMN_STORE, GtkColumnStoreClass))
+
+typedef struct _GtkColumnStore              GtkColumnStore;
+typedef struct _GtkColumnStorePrivate       GtkColumnStorePrivate;
+typedef struct _GtkColumnStoreClass         GtkColumnStoreClass;
+
+struct _GtkColumnStore
+{
+  GObject parent;
+
+  /*< private >*/
+  GtkColumnStorePrivate *priv;
+};
+
+struct _GtkColumnStoreClass
+{
+  GObjectClass parent_class;
+
+  /* Padding for future expansion */
+  void (*_gtk_reserved1) (void);
+  void (*_gtk_reserved2) (void);
+  void (*_gtk_reserved3) (void);
+  void (*_gtk_reserved4) (void);
+};
+
+
+GDK_AVAILABLE_IN_3_24
+GType           gtk_column_store_get_type            (void) G_GNUC_CONST;
+GDK_AVAILABLE_IN_3_24
+GtkColumnStore *gtk_column_store_new                 (gint            n_columns,
+                                                      ...);
+GDK_AVAILABLE_IN_3_24
+GtkColumnStore *gtk_column_store_newv                (gint            n_columns,
+                                                      GType          *types);
+
+GDK_AVAILABLE_IN_3_24
+void            gtk_column_store_set_value           (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column,
+                                                      GValue         *value);
+GDK_AVAILABLE_IN_3_24
+void            gtk_column_store_set                 (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      ...);
+GDK_AVAILABLE_IN_3_24
+void            gtk_column_store_set_valist          (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      va_list         var_args);
+
+GDK_AVAILABLE_IN_3_24
+gboolean        gtk_column_store_get_boolean         (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+GDK_AVAILABLE_IN_3_24
+gint            gtk_column_store_get_int             (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+GDK_AVAILABLE_IN_3_24
+guint           gtk_column_store_get_uint            (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+GDK_AVAILABLE_IN_3_24
+gint64          gtk_column_store_get_int64           (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+GDK_AVAILABLE_IN_3_24
+gfloat          gtk_column_store_get_float           (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+GDK_AVAILABLE_IN_3_24
+gdouble         gtk_column_store_get_double          (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+GDK_AVAILABLE_IN_3_24
+const gchar *   gtk_column_store_get_string          (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+GDK_AVAILABLE_IN_3_24
+gpointer        gtk_column_store_get_object          (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            column);
+
+GDK_AVAILABLE_IN_3_24
+gboolean        gtk_column_store_remove              (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter);
+GDK_AVAILABLE_IN_3_24
+void            gtk_column_store_insert              (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            position);
+GDK_AVAILABLE_IN_3_24
+void            gtk_column_store_insert_with_values  (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter,
+                                                      gint            position,
+                                                      ...);
+GDK_AVAILABLE_IN_3_24
+void            gtk_column_store_append              (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter);
+GDK_AVAILABLE_IN_3_24
+void            gtk_column_store_clear               (GtkColumnStore *column_store);
+GDK_AVAILABLE_IN_3_24
+gboolean        gtk_column_store_iter_is_valid       (GtkColumnStore *column_store,
+                                                      GtkTreeIter    *iter);
+
+
+G_END_DECLS
+
+
+#endif /* __GTK_COLUMN_STORE_H__ */
@@ -320,12 +320,28 @@ gtk_css_value_array_print (const GtkCssValue *value,
     }
 }
 
+static GVariant *
+gtk_css_value_array_serialize (const GtkCssValue *value)
+{
+  GVariant *array;
+
+  if (value->n_values == 0)
+    return NULL;
+
+  array = _gtk_css_value_serialize_array (value->values, value->n_values);
+  if (array == NULL)
+    return NULL;
+
+  return g_variant_new ("(sv)", "array", array);
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_ARRAY = {
   gtk_css_value_array_free,
   gtk_css_value_array_compute,
   gtk_css_value_array_equal,
   gtk_css_value_array_transition,
-  gtk_css_value_array_print
+  gtk_css_value_array_print,
+  gtk_css_value_array_serialize
 };
 
 GtkCssValue *
@@ -352,6 +368,23 @@ _gtk_css_array_value_new_from_array (GtkCssValue **values,
   return result;
 }
 
+GtkCssValue *
+gtk_css_array_value_deserialize (GVariant *variant)
+{
+  GtkCssValue **values;
+  GtkCssValue *result;
+  guint n_values;
+
+  values = _gtk_css_value_deserialize_array (variant, &n_values);
+  if (values == NULL)
+    return NULL;
+
+  result = _gtk_css_array_value_new_from_array (values, n_values);
+  g_free (values);
+
+  return result;
+}
+
 GtkCssValue *
 _gtk_css_array_value_parse (GtkCssParser *parser,
                             GtkCssValue  *(* parse_func) (GtkCssParser *parser))
@@ -442,12 +442,60 @@ gtk_css_value_color_print (const GtkCssValue *value,
     }
 }
 
+static GVariant *
+gtk_css_value_color_serialize (const GtkCssValue *value)
+{
+  GVariant *data, *color1, *color2;
+
+  switch (value->type)
+    {
+    case COLOR_TYPE_LITERAL:
+      {
+        const GdkRGBA *rgba = _gtk_css_rgba_value_get_rgba (value->last_value);
+
+        data = g_variant_new ("(dddd)", rgba->red, rgba->green, rgba->blue, rgba->alpha);
+      }
+      break;
+    case COLOR_TYPE_NAME:
+      data = g_variant_new_string (value->sym_col.name);
+      break;
+    case COLOR_TYPE_SHADE:
+    case COLOR_TYPE_ALPHA:
+      color1 = _gtk_css_value_serialize (value->sym_col.shade.color);
+      if (color1 == NULL)
+        return NULL;
+      data = g_variant_new ("(vd)", color1, value->sym_col.shade.factor);
+      break;
+    case COLOR_TYPE_MIX:
+      color1 = _gtk_css_value_serialize (value->sym_col.mix.color1);
+      if (color1 == NULL)
+        return NULL;
+      color2 = _gtk_css_value_serialize (value->sym_col.mix.color2);
+      if (color2 == NULL)
+        {
+          g_variant_unref (g_variant_ref_sink (color1));
+          return NULL;
+        }
+      data = g_variant_new ("(vvd)", color1, color2, value->sym_col.mix.factor);
+      break;
+    case COLOR_TYPE_CURRENT_COLOR:
+      data = g_variant_new ("()");
+      break;
+    case COLOR_TYPE_WIN32:
+    default:
+      return NULL;
+    }
+
+  return g_variant_new ("(sv)", "color", g_variant_new ("(uv)", (guint32) value->type, data));
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_COLOR = {
   gtk_css_value_color_free,
   gtk_css_value_color_compute,
   gtk_css_value_color_equal,
   gtk_css_value_color_transition,
-  gtk_css_value_color_print
+  gtk_css_value_color_print,
+  gtk_css_value_color_serialize
 };
 
 GtkCssValue *
@@ -580,6 +628,95 @@ _gtk_css_color_value_new_current_color (void)
   return _gtk_css_value_ref (&current_color);
 }
 
+/* Deserializes a color that is part of another color */
+static GtkCssValue *
+gtk_css_color_value_deserialize_child (GVariant *variant)
+{
+  GtkCssValue *color;
+
+  color = _gtk_css_value_deserialize (variant);
+  if (color != NULL && color->class != &GTK_CSS_VALUE_COLOR)
+    {
+      _gtk_css_value_unref (color);
+      return NULL;
+    }
+
+  return color;
+}
+
+GtkCssValue *
+gtk_css_color_value_deserialize (GVariant *variant)
+{
+  GtkCssValue *value, *color1, *color2;
+  GVariant *data, *child1, *child2;
+  guint32 type;
+  gdouble factor;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("(uv)")))
+    return NULL;
+
+  g_variant_get (variant, "(uv)", &type, &data);
+
+  value = NULL;
+  switch (type)
+    {
+    case COLOR_TYPE_LITERAL:
+      if (g_variant_is_of_type (data, G_VARIANT_TYPE ("(dddd)")))
+        {
+          GdkRGBA rgba;
+
+          g_variant_get (data, "(dddd)", &rgba.red, &rgba.green, &rgba.blue, &rgba.alpha);
+          value = _gtk_css_color_value_new_literal (&rgba);
+        }
+      break;
+    case COLOR_TYPE_NAME:
+      if (g_variant_is_of_type (data, G_VARIANT_TYPE_STRING))
+        value = _gtk_css_color_value_new_name (g_variant_get_string (data, NULL));
+      break;
+    case COLOR_TYPE_SHADE:
+    case COLOR_TYPE_ALPHA:
+      if (g_variant_is_of_type (data, G_VARIANT_TYPE ("(vd)")))
+        {
+          g_variant_get (data, "(vd)", &child1, &factor);
+          color1 = gtk_css_color_value_deserialize_child (child1);
+          g_variant_unref (child1);
+          if (color1 == NULL)
+            break;
+
+          if (type == COLOR_TYPE_SHADE)
+            value = _gtk_css_color_value_new_shade (color1, factor);
+          else
+            value = _gtk_css_color_value_new_alpha (color1, factor);
+          _gtk_css_value_unref (color1);
+        }
+      break;
+    case COLOR_TYPE_MIX:
+      if (g_variant_is_of_type (data, G_VARIANT_TYPE ("(vvd)")))
+        {
+          g_variant_get (data, "(vvd)", &child1, &child2, &factor);
+          color1 = gtk_css_color_value_deserialize_child (child1);
+          color2 = gtk_css_color_value_deserialize_child (child2);
+          g_variant_unref (child1);
+          g_variant_unref (child2);
+
+          if (color1 != NULL && color2 != NULL)
+            value = _gtk_css_color_value_new_mix (color1, color2, factor);
+          g_clear_pointer (&color1, _gtk_css_value_unref);
+          g_clear_pointer (&color2, _gtk_css_value_unref);
+        }
+      break;
+    case COLOR_TYPE_CURRENT_COLOR:
+      value = _gtk_css_color_value_new_current_color ();
+      break;
+    default:
+      break;
+    }
+
+  g_variant_unref (data);
+
+  return value;
+}
+
 typedef enum {
   COLOR_RGBA,
   COLOR_RGB,
@@ -98,12 +98,26 @@ gtk_css_value_corner_print (const GtkCssValue *corner,
     }
 }
 
+static GVariant *
+gtk_css_value_corner_serialize (const GtkCssValue *corner)
+{
+  GtkCssValue *values[2] = { corner->x, corner->y };
+  GVariant *array;
+
+  array = _gtk_css_value_serialize_array (values, 2);
+  if (array == NULL)
+    return NULL;
+
+  return g_variant_new ("(sv)", "corner", array);
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_CORNER = {
   gtk_css_value_corner_free,
   gtk_css_value_corner_compute,
   gtk_css_value_corner_equal,
   gtk_css_value_corner_transition,
-  gtk_css_value_corner_print
+  gtk_css_value_corner_print,
+  gtk_css_value_corner_serialize
 };
 
 GtkCssValue *
@@ -119,6 +133,31 @@ _gtk_css_corner_value_new (GtkCssValue *x,
   return result;
 }
 
+GtkCssValue *
+gtk_css_corner_value_deserialize (GVariant *variant)
+{
+  GtkCssValue **values;
+  GtkCssValue *result;
+  guint n_values;
+
+  values = _gtk_css_value_deserialize_array (variant, &n_values);
+  if (values == NULL)
+    return NULL;
+
+  if (n_values != 2)
+    {
+      while (n_values-- > 0)
+        _gtk_css_value_unref (values[n_values]);
+      g_free (values);
+      return NULL;
+    }
+
+  result = _gtk_css_corner_value_new (values[0], values[1]);
+  g_free (values);
+
+  return result;
+}
+
 GtkCssValue *
 _gtk_css_corner_value_parse (GtkCssParser *parser)
 {
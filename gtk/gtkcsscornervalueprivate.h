@@ -28,6 +28,7 @@ G_BEGIN_DECLS
 GtkCssValue *   _gtk_css_corner_value_new           (GtkCssValue            *x,
                                                      GtkCssValue            *y);
 GtkCssValue *   _gtk_css_corner_value_parse         (GtkCssParser           *parser);
+GtkCssValue *   gtk_css_corner_value_deserialize    (GVariant               *variant);
 
 double          _gtk_css_corner_value_get_x         (const GtkCssValue      *corner,
                                                      double                  one_hundred_percent);
@@ -270,13 +270,21 @@ gtk_css_value_dimension_get_calc_term_order (const GtkCssValue *value)
   return 1000 + order_per_unit[value->unit];
 }
 
+static GVariant *
+gtk_css_value_dimension_serialize (const GtkCssValue *value)
+{
+  return g_variant_new ("(sv)", "dimension",
+                        g_variant_new ("(du)", value->value, (guint32) value->unit));
+}
+
 static const GtkCssNumberValueClass GTK_CSS_VALUE_DIMENSION = {
   {
     gtk_css_value_dimension_free,
     gtk_css_value_dimension_compute,
     gtk_css_value_dimension_equal,
     gtk_css_number_value_transition,
-    gtk_css_value_dimension_print
+    gtk_css_value_dimension_print,
+    gtk_css_value_dimension_serialize
   },
   gtk_css_value_dimension_get,
   gtk_css_value_dimension_get_dimension,
@@ -323,3 +331,19 @@ gtk_css_dimension_value_new (double     value,
   return result;
 }
 
+GtkCssValue *
+gtk_css_dimension_value_deserialize (GVariant *variant)
+{
+  double value;
+  guint32 unit;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("(du)")))
+    return NULL;
+
+  g_variant_get (variant, "(du)", &value, &unit);
+  if (unit > GTK_CSS_MS)
+    return NULL;
+
+  return gtk_css_dimension_value_new (value, unit);
+}
+
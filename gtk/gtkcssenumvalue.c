@@ -71,6 +71,8 @@ gtk_css_value_enum_print (const GtkCssValue *value,
   g_string_append (string, value->name);
 }
 
+static GVariant *gtk_css_value_enum_serialize (const GtkCssValue *value);
+
 /* GtkBorderStyle */
 
 static const GtkCssValueClass GTK_CSS_VALUE_BORDER_STYLE = {
@@ -78,7 +80,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_BORDER_STYLE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue border_style_values[] = {
@@ -133,7 +136,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_BLEND_MODE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue blend_mode_values[] = {
@@ -281,7 +285,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_FONT_SIZE = {
   gtk_css_value_font_size_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue font_size_values[] = {
@@ -335,7 +340,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_FONT_STYLE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue font_style_values[] = {
@@ -383,7 +389,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_FONT_VARIANT = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue font_variant_values[] = {
@@ -494,7 +501,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_FONT_WEIGHT = {
   gtk_css_value_font_weight_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_font_weight_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue font_weight_values[] = {
@@ -567,7 +575,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_FONT_STRETCH = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue font_stretch_values[] = {
@@ -621,7 +630,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_TEXT_DECORATION_LINE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue text_decoration_line_values[] = {
@@ -669,7 +679,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_TEXT_DECORATION_STYLE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue text_decoration_style_values[] = {
@@ -717,7 +728,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_AREA = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue area_values[] = {
@@ -771,7 +783,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_DIRECTION = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue direction_values[] = {
@@ -829,7 +842,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_PLAY_STATE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue play_state_values[] = {
@@ -882,7 +896,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_FILL_MODE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue fill_mode_values[] = {
@@ -937,7 +952,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_ICON_EFFECT = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue image_effect_values[] = {
@@ -1024,7 +1040,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_ICON_STYLE = {
   gtk_css_value_enum_compute,
   gtk_css_value_enum_equal,
   gtk_css_value_enum_transition,
-  gtk_css_value_enum_print
+  gtk_css_value_enum_print,
+  gtk_css_value_enum_serialize
 };
 
 static GtkCssValue icon_style_values[] = {
@@ -1070,3 +1087,61 @@ _gtk_css_icon_style_value_get (const GtkCssValue *value)
 
   return value->value;
 }
+
+/* serialization */
+
+static const struct {
+  GtkCssValue *values;
+  guint n_values;
+} enum_values[] = {
+  { border_style_values, G_N_ELEMENTS (border_style_values) },
+  { blend_mode_values, G_N_ELEMENTS (blend_mode_values) },
+  { font_size_values, G_N_ELEMENTS (font_size_values) },
+  { font_style_values, G_N_ELEMENTS (font_style_values) },
+  { font_variant_values, G_N_ELEMENTS (font_variant_values) },
+  { font_weight_values, G_N_ELEMENTS (font_weight_values) },
+  { font_stretch_values, G_N_ELEMENTS (font_stretch_values) },
+  { text_decoration_line_values, G_N_ELEMENTS (text_decoration_line_values) },
+  { text_decoration_style_values, G_N_ELEMENTS (text_decoration_style_values) },
+  { area_values, G_N_ELEMENTS (area_values) },
+  { direction_values, G_N_ELEMENTS (direction_values) },
+  { play_state_values, G_N_ELEMENTS (play_state_values) },
+  { fill_mode_values, G_N_ELEMENTS (fill_mode_values) },
+  { image_effect_values, G_N_ELEMENTS (image_effect_values) },
+  { icon_style_values, G_N_ELEMENTS (icon_style_values) }
+};
+
+/* All enum values are static, so they are identified by the table
+ * they are in and their position in it.
+ */
+static GVariant *
+gtk_css_value_enum_serialize (const GtkCssValue *value)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (enum_values); i++)
+    {
+      if (value >= enum_values[i].values &&
+          value < enum_values[i].values + enum_values[i].n_values)
+        return g_variant_new ("(sv)", "enum",
+                              g_variant_new ("(uu)", i, (guint) (value - enum_values[i].values)));
+    }
+
+  g_return_val_if_reached (NULL);
+}
+
+GtkCssValue *
+gtk_css_enum_value_deserialize (GVariant *variant)
+{
+  guint32 table, index;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("(uu)")))
+    return NULL;
+
+  g_variant_get (variant, "(uu)", &table, &index);
+  if (table >= G_N_ELEMENTS (enum_values) ||
+      index >= enum_values[table].n_values)
+    return NULL;
+
+  return _gtk_css_value_ref (&enum_values[table].values[index]);
+}
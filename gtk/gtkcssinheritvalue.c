@@ -77,12 +77,19 @@ gtk_css_value_inherit_print (const GtkCssValue *value,
   g_string_append (string, "inherit");
 }
 
+static GVariant *
+gtk_css_value_inherit_serialize (const GtkCssValue *value)
+{
+  return g_variant_new ("(sv)", "inherit", g_variant_new ("()"));
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_INHERIT = {
   gtk_css_value_inherit_free,
   gtk_css_value_inherit_compute,
   gtk_css_value_inherit_equal,
   gtk_css_value_inherit_transition,
-  gtk_css_value_inherit_print
+  gtk_css_value_inherit_print,
+  gtk_css_value_inherit_serialize
 };
 
 static GtkCssValue inherit = { &GTK_CSS_VALUE_INHERIT, 1 };
@@ -98,3 +105,12 @@ _gtk_css_inherit_value_get (void)
 {
   return &inherit;
 }
+
+GtkCssValue *
+gtk_css_inherit_value_deserialize (GVariant *variant)
+{
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE_UNIT))
+    return NULL;
+
+  return _gtk_css_inherit_value_new ();
+}
@@ -26,6 +26,7 @@ G_BEGIN_DECLS
 
 GtkCssValue *   _gtk_css_inherit_value_new            (void);
 GtkCssValue *   _gtk_css_inherit_value_get            (void);
+GtkCssValue *   gtk_css_inherit_value_deserialize     (GVariant *variant);
 
 G_END_DECLS
 
@@ -100,12 +100,19 @@ gtk_css_value_initial_print (const GtkCssValue *value,
   g_string_append (string, "initial");
 }
 
+static GVariant *
+gtk_css_value_initial_serialize (const GtkCssValue *value)
+{
+  return g_variant_new ("(sv)", "initial", g_variant_new ("()"));
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_INITIAL = {
   gtk_css_value_initial_free,
   gtk_css_value_initial_compute,
   gtk_css_value_initial_equal,
   gtk_css_value_initial_transition,
-  gtk_css_value_initial_print
+  gtk_css_value_initial_print,
+  gtk_css_value_initial_serialize
 };
 
 static GtkCssValue initial = { &GTK_CSS_VALUE_INITIAL, 1 };
@@ -121,3 +128,12 @@ _gtk_css_initial_value_get (void)
 {
   return &initial;
 }
+
+GtkCssValue *
+gtk_css_initial_value_deserialize (GVariant *variant)
+{
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE_UNIT))
+    return NULL;
+
+  return _gtk_css_initial_value_new ();
+}
@@ -166,6 +166,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_WIDGET_PATH = {
   gtk_css_matcher_widget_path_has_class,
   gtk_css_matcher_widget_path_has_id,
   gtk_css_matcher_widget_path_has_position,
+  FALSE,
   FALSE
 };
 
@@ -316,7 +317,8 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_NODE = {
   gtk_css_matcher_node_has_class,
   gtk_css_matcher_node_has_id,
   gtk_css_matcher_node_has_position,
-  FALSE
+  FALSE,
+  TRUE
 };
 
 void
@@ -325,6 +327,41 @@ _gtk_css_matcher_node_init (GtkCssMatcher *matcher,
 {
   matcher->node.klass = &GTK_CSS_MATCHER_NODE;
   matcher->node.node = node;
+  matcher->node.ancestors = gtk_css_node_get_ancestor_filter (node);
+}
+
+/* Adds the hashes of everything a node matcher for @node can match
+ * on to @filter. Returns %FALSE if @node is matched via a widget path,
+ * in which case @filter cannot be used for its descendants.
+ */
+gboolean
+_gtk_css_ancestor_filter_add_node (GtkCssAncestorFilter *filter,
+                                   GtkCssNode           *node)
+{
+  GtkCssMatcher matcher;
+  const GQuark *classes;
+  const char *id;
+  guint i, n_classes;
+
+  /* Matching never looks past nodes without a matcher */
+  if (!gtk_css_node_init_matcher (node, &matcher))
+    return TRUE;
+
+  if (!matcher.klass->is_node)
+    return FALSE;
+
+  _gtk_css_ancestor_filter_add_hash (filter,
+                                     _gtk_css_ancestor_filter_hash_name (gtk_css_node_get_name (node)));
+
+  id = gtk_css_node_get_id (node);
+  if (id)
+    _gtk_css_ancestor_filter_add_hash (filter, _gtk_css_ancestor_filter_hash_id (id));
+
+  classes = gtk_css_node_list_classes (node, &n_classes);
+  for (i = 0; i < n_classes; i++)
+    _gtk_css_ancestor_filter_add_hash (filter, _gtk_css_ancestor_filter_hash_class (classes[i]));
+
+  return TRUE;
 }
 
 /* GTK_CSS_MATCHER_WIDGET_ANY */
@@ -396,7 +433,8 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_ANY = {
   gtk_css_matcher_any_has_class,
   gtk_css_matcher_any_has_id,
   gtk_css_matcher_any_has_position,
-  TRUE
+  TRUE,
+  FALSE
 };
 
 void
@@ -489,6 +527,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_SUPERSET = {
   gtk_css_matcher_superset_has_class,
   gtk_css_matcher_superset_has_id,
   gtk_css_matcher_superset_has_position,
+  FALSE,
   FALSE
 };
 
@@ -24,11 +24,22 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GtkCssAncestorFilter GtkCssAncestorFilter;
 typedef struct _GtkCssMatcherNode GtkCssMatcherNode;
 typedef struct _GtkCssMatcherSuperset GtkCssMatcherSuperset;
 typedef struct _GtkCssMatcherWidgetPath GtkCssMatcherWidgetPath;
 typedef struct _GtkCssMatcherClass GtkCssMatcherClass;
 
+/* A bloom filter of the names, ids and classes of all ancestors
+ * of a node. If a hash is not contained in the filter, no ancestor
+ * can have the corresponding name, id or class.
+ */
+#define GTK_CSS_ANCESTOR_FILTER_WORDS 4
+
+struct _GtkCssAncestorFilter {
+  guint64 bits[GTK_CSS_ANCESTOR_FILTER_WORDS];
+};
+
 struct _GtkCssMatcherClass {
   gboolean        (* get_parent)                  (GtkCssMatcher          *matcher,
                                                    const GtkCssMatcher    *child);
@@ -47,6 +58,7 @@ struct _GtkCssMatcherClass {
                                                    int                    a,
                                                    int                    b);
   gboolean is_any;
+  gboolean is_node;
 };
 
 struct _GtkCssMatcherWidgetPath {
@@ -60,6 +72,7 @@ struct _GtkCssMatcherWidgetPath {
 struct _GtkCssMatcherNode {
   const GtkCssMatcherClass *klass;
   GtkCssNode               *node;
+  const GtkCssAncestorFilter *ancestors; /* may be NULL */
 };
 
 struct _GtkCssMatcherSuperset {
@@ -80,6 +93,8 @@ gboolean          _gtk_css_matcher_init           (GtkCssMatcher          *match
                                                    const GtkCssNodeDeclaration *decl) G_GNUC_WARN_UNUSED_RESULT;
 void              _gtk_css_matcher_node_init      (GtkCssMatcher          *matcher,
                                                    GtkCssNode             *node);
+gboolean          _gtk_css_ancestor_filter_add_node (GtkCssAncestorFilter *filter,
+                                                   GtkCssNode             *node);
 void              _gtk_css_matcher_any_init       (GtkCssMatcher          *matcher);
 void              _gtk_css_matcher_superset_init  (GtkCssMatcher          *matcher,
                                                    const GtkCssMatcher    *subset,
@@ -142,6 +157,77 @@ _gtk_css_matcher_matches_any (const GtkCssMatcher *matcher)
   return matcher->klass->is_any;
 }
 
+static inline const GtkCssAncestorFilter *
+_gtk_css_matcher_get_ancestor_filter (const GtkCssMatcher *matcher)
+{
+  if (!matcher->klass->is_node)
+    return NULL;
+
+  return matcher->node.ancestors;
+}
+
+static inline guint
+_gtk_css_ancestor_filter_hash_name (/*interned*/ const char *name)
+{
+  return GPOINTER_TO_UINT (name);
+}
+
+static inline guint
+_gtk_css_ancestor_filter_hash_id (/*interned*/ const char *id)
+{
+  return GPOINTER_TO_UINT (id) ^ 0x5bd1e995;
+}
+
+static inline guint
+_gtk_css_ancestor_filter_hash_class (GQuark class_name)
+{
+  return class_name ^ 0x27d4eb2d;
+}
+
+static inline void
+_gtk_css_ancestor_filter_add_hash (GtkCssAncestorFilter *filter,
+                                   guint                 hash)
+{
+  guint bit;
+
+  /* Fibonacci hashing, then use two bytes of the result as bit indexes */
+  hash *= 0x9e3779b1;
+
+  bit = hash >> 24;
+  filter->bits[bit / 64] |= G_GUINT64_CONSTANT (1) << (bit % 64);
+  bit = (hash >> 16) & 0xff;
+  filter->bits[bit / 64] |= G_GUINT64_CONSTANT (1) << (bit % 64);
+}
+
+static inline gboolean
+_gtk_css_ancestor_filter_is_empty (const GtkCssAncestorFilter *filter)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_ANCESTOR_FILTER_WORDS; i++)
+    {
+      if (filter->bits[i])
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Returns %FALSE if @filter definitely lacks one of the hashes in @required */
+static inline gboolean
+_gtk_css_ancestor_filter_contains (const GtkCssAncestorFilter *filter,
+                                   const GtkCssAncestorFilter *required)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_ANCESTOR_FILTER_WORDS; i++)
+    {
+      if (required->bits[i] & ~filter->bits[i])
+        return FALSE;
+    }
+
+  return TRUE;
+}
 
 G_END_DECLS
 
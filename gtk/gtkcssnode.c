@@ -21,10 +21,13 @@
 
 #include "gtkcssanimatedstyleprivate.h"
 #include "gtkcsssectionprivate.h"
+#include "gtkcssstaticstyleprivate.h"
 #include "gtkcssstylepropertyprivate.h"
+#include "gtkdebug.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
 #include "gtksettingsprivate.h"
+#include "gtkstyleproviderprivate.h"
 #include "gtktypebuiltins.h"
 
 /*
@@ -115,6 +118,23 @@ struct _GtkCssNodeStyleChange {
 static guint cssnode_signals[LAST_SIGNAL] = { 0 };
 static GParamSpec *cssnode_properties[NUM_PROPERTIES];
 
+/* The bloom filter of the ancestors of the children of the node
+ * that is currently being validated. It is handed to the matchers
+ * of those children, see gtk_css_node_get_ancestor_filter().
+ * The serial is bumped whenever a name, id, class or parent changes,
+ * which makes existing filters unusable.
+ */
+static GtkCssNode *ancestor_filter_parent;
+static const GtkCssAncestorFilter *ancestor_filter;
+static guint ancestor_filter_serial;
+static guint ancestor_filter_current_serial;
+
+static inline void
+gtk_css_node_invalidate_ancestor_filter (void)
+{
+  ancestor_filter_current_serial++;
+}
+
 static GtkStyleProviderPrivate *
 gtk_css_node_get_style_provider_or_null (GtkCssNode *cssnode)
 {
@@ -352,6 +372,182 @@ store_in_global_parent_cache (GtkCssNode                  *node,
                                                  style);
 }
 
+/* Style sharing
+ *
+ * Styles that cannot be put into the global parent cache (or whose
+ * parent has no cache) are looked up among a few recently computed
+ * siblings and cousins: if such a node has an equal declaration, the
+ * same parent style and, for cousins, a parent with an equal
+ * declaration, and its style does not depend on anything that
+ * differs between the two nodes, the style is reused.
+ */
+#define STYLE_SHARING_MAX_CANDIDATES 8
+#define STYLE_SHARING_MAX_PARENTS 2
+
+#define GTK_CSS_CHANGE_ANY_PARENT_SIBLING (GTK_CSS_CHANGE_PARENT_SIBLING_CLASS | GTK_CSS_CHANGE_PARENT_SIBLING_NAME | \
+                                           GTK_CSS_CHANGE_PARENT_SIBLING_ID | GTK_CSS_CHANGE_PARENT_SIBLING_STATE | \
+                                           GTK_CSS_CHANGE_PARENT_SIBLING_POSITION)
+
+static guint64 n_style_lookups;
+static guint64 n_style_cache_hits;
+static guint64 n_style_shared;
+
+static gboolean
+may_share_style_with (GtkCssNode                  *node,
+                      const GtkCssNodeDeclaration *decl,
+                      GtkCssNode                  *candidate)
+{
+  GtkCssStyle *style;
+  GtkCssChange change;
+  GtkCssMatcher matcher;
+
+  style = candidate->style;
+  if (style == NULL || candidate->style_is_invalid)
+    return FALSE;
+
+  if (candidate->parent->style != node->parent->style ||
+      candidate->parent->style_is_invalid)
+    return FALSE;
+
+  /* Parents keep their style across class and state changes that
+   * selectors of their children can still see */
+  if (candidate->parent != node->parent &&
+      !gtk_css_node_declaration_equal (candidate->parent->decl, node->parent->decl))
+    return FALSE;
+
+  if (GTK_IS_CSS_ANIMATED_STYLE (style))
+    style = GTK_CSS_ANIMATED_STYLE (style)->style;
+
+  if (!GTK_IS_CSS_STATIC_STYLE (style))
+    return FALSE;
+
+  if (!gtk_css_node_declaration_equal (decl, candidate->decl))
+    return FALSE;
+
+  change = gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style));
+
+  if (change & (GTK_CSS_CHANGE_ANY_SIBLING | GTK_CSS_CHANGE_NTH_CHILD | GTK_CSS_CHANGE_NTH_LAST_CHILD))
+    return FALSE;
+
+  if ((change & GTK_CSS_CHANGE_FIRST_CHILD) &&
+      gtk_css_node_is_first_child (node) != gtk_css_node_is_first_child (candidate))
+    return FALSE;
+
+  if ((change & GTK_CSS_CHANGE_LAST_CHILD) &&
+      gtk_css_node_is_last_child (node) != gtk_css_node_is_last_child (candidate))
+    return FALSE;
+
+  /* The parents have the same style, but may sit at different positions */
+  if (candidate->parent != node->parent &&
+      (change & (GTK_CSS_CHANGE_PARENT_POSITION | GTK_CSS_CHANGE_ANY_PARENT_SIBLING)))
+    return FALSE;
+
+  if (gtk_css_node_get_style_provider (candidate) != gtk_css_node_get_style_provider (node))
+    return FALSE;
+
+  if (!gtk_css_node_init_matcher (candidate, &matcher) ||
+      !matcher.klass->is_node)
+    return FALSE;
+
+  return TRUE;
+}
+
+static GtkCssStyle *
+gtk_css_node_share_style (GtkCssNode                  *node,
+                          const GtkCssNodeDeclaration *decl)
+{
+  GtkCssNode *candidate, *parent;
+  GtkCssStyle *style;
+  guint n_candidates, n_parents;
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (NO_CSS_CACHE))
+    return NULL;
+#endif
+
+  if (node->parent == NULL)
+    return NULL;
+
+  n_candidates = 0;
+
+  /* siblings */
+  for (candidate = node->previous_sibling;
+       candidate != NULL && n_candidates < STYLE_SHARING_MAX_CANDIDATES;
+       candidate = candidate->previous_sibling)
+    {
+      if (!candidate->visible)
+        continue;
+
+      n_candidates++;
+      if (may_share_style_with (node, decl, candidate))
+        goto found;
+    }
+
+  /* cousins */
+  n_parents = 0;
+  for (parent = node->parent->previous_sibling;
+       parent != NULL && n_parents < STYLE_SHARING_MAX_PARENTS && n_candidates < STYLE_SHARING_MAX_CANDIDATES;
+       parent = parent->previous_sibling)
+    {
+      if (!parent->visible)
+        continue;
+
+      n_parents++;
+      if (parent->style != node->parent->style)
+        continue;
+
+      for (candidate = parent->first_child;
+           candidate != NULL && n_candidates < STYLE_SHARING_MAX_CANDIDATES;
+           candidate = candidate->next_sibling)
+        {
+          if (!candidate->visible)
+            continue;
+
+          n_candidates++;
+          if (may_share_style_with (node, decl, candidate))
+            goto found;
+        }
+    }
+
+  return NULL;
+
+found:
+  style = candidate->style;
+  if (GTK_IS_CSS_ANIMATED_STYLE (style))
+    style = GTK_CSS_ANIMATED_STYLE (style)->style;
+
+  /* Also share the cache for our children, like a lookup in the
+   * global parent cache would have done. */
+  if (candidate->cache &&
+      gtk_css_node_style_cache_get_style (candidate->cache) == style &&
+      may_use_global_parent_cache (node) &&
+      gtk_css_node_is_first_child (node) == gtk_css_node_is_first_child (candidate) &&
+      gtk_css_node_is_last_child (node) == gtk_css_node_is_last_child (candidate))
+    {
+      g_assert (node->cache == NULL);
+      node->cache = gtk_css_node_style_cache_ref (candidate->cache);
+    }
+
+  n_style_shared++;
+
+  return g_object_ref (style);
+}
+
+/* Statistics for the inspector: how many styles were looked up and how
+ * many of those were found in the global parent cache or shared */
+void
+gtk_css_node_get_style_statistics (guint64 *n_lookups,
+                                   guint64 *n_cache_hits,
+                                   guint64 *n_shared)
+{
+  if (n_lookups)
+    *n_lookups = n_style_lookups;
+  if (n_cache_hits)
+    *n_cache_hits = n_style_cache_hits;
+  if (n_shared)
+    *n_shared = n_style_shared;
+}
+
 static GtkCssStyle *
 gtk_css_node_create_style (GtkCssNode *cssnode)
 {
@@ -363,14 +559,28 @@ gtk_css_node_create_style (GtkCssNode *cssnode)
   decl = gtk_css_node_get_declaration (cssnode);
   parent = cssnode->parent ? cssnode->parent->style : NULL;
 
+  n_style_lookups++;
+
   style = lookup_in_global_parent_cache (cssnode, decl);
   if (style)
-    return g_object_ref (style);
+    {
+      n_style_cache_hits++;
+      return g_object_ref (style);
+    }
 
   if (gtk_css_node_init_matcher (cssnode, &matcher))
-    style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
-                                              &matcher,
-                                              parent);
+    {
+      if (matcher.klass->is_node)
+        {
+          style = gtk_css_node_share_style (cssnode, decl);
+          if (style)
+            return style;
+        }
+
+      style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
+                                                &matcher,
+                                                parent);
+    }
   else
     style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
                                               NULL,
@@ -739,6 +949,8 @@ gtk_css_node_reposition (GtkCssNode *node,
   g_assert (! (new_parent == NULL && previous != NULL));
 
   old_parent = node->parent;
+  if (old_parent != new_parent)
+    gtk_css_node_invalidate_ancestor_filter ();
   /* Take a reference here so the whole function has a reference */
   g_object_ref (node);
 
@@ -772,7 +984,7 @@ gtk_css_node_reposition (GtkCssNode *node,
         }
 
       if (gtk_css_node_get_style_provider_or_null (node) == NULL)
-        gtk_css_node_invalidate_style_provider (node);
+        gtk_css_node_invalidate_style_provider (node, NULL);
       gtk_css_node_invalidate (node, GTK_CSS_CHANGE_TIMESTAMP | GTK_CSS_CHANGE_ANIMATIONS);
 
       if (new_parent)
@@ -1105,6 +1317,7 @@ gtk_css_node_set_name (GtkCssNode              *cssnode,
 {
   if (gtk_css_node_declaration_set_name (&cssnode->decl, name))
     {
+      gtk_css_node_invalidate_ancestor_filter ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_NAME);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_NAME]);
     }
@@ -1139,6 +1352,7 @@ gtk_css_node_set_id (GtkCssNode                *cssnode,
 {
   if (gtk_css_node_declaration_set_id (&cssnode->decl, id))
     {
+      gtk_css_node_invalidate_ancestor_filter ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_ID);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_ID]);
     }
@@ -1185,6 +1399,7 @@ gtk_css_node_clear_classes (GtkCssNode *cssnode)
 {
   if (gtk_css_node_declaration_clear_classes (&cssnode->decl))
     {
+      gtk_css_node_invalidate_ancestor_filter ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1236,6 +1451,7 @@ gtk_css_node_add_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_add_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_invalidate_ancestor_filter ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1247,6 +1463,7 @@ gtk_css_node_remove_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_remove_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_invalidate_ancestor_filter ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1302,19 +1519,62 @@ gtk_css_node_get_declaration (GtkCssNode *cssnode)
   return cssnode->decl;
 }
 
+/* Checks if @selectors match @cssnode or could match it after a change
+ * that the node would not be invalidated for otherwise.
+ */
+static gboolean
+gtk_css_node_is_affected_by (GtkCssNode               *cssnode,
+                             const GtkCssSelectorTree *selectors)
+{
+  GtkCssMatcher matcher;
+  GPtrArray *matches;
+
+  if (!gtk_css_node_init_matcher (cssnode, &matcher))
+    return TRUE;
+
+  matches = _gtk_css_selector_tree_match_all (selectors, &matcher);
+  if (matches)
+    {
+      g_ptr_array_free (matches, TRUE);
+      return TRUE;
+    }
+
+  return _gtk_css_selector_tree_get_change_all (selectors, &matcher) != 0;
+}
+
+/* Invalidates the nodes that use the default style provider. If
+ * @selectors is not %NULL, only nodes it may affect are invalidated.
+ */
 void
-gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
+gtk_css_node_invalidate_style_provider (GtkCssNode               *cssnode,
+                                        const GtkCssSelectorTree *selectors)
 {
   GtkCssNode *child;
 
-  gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
+  /* Cached styles of children may be outdated even if this node and
+   * its current children are not affected */
+  g_clear_pointer (&cssnode->cache, gtk_css_node_style_cache_unref);
+
+  if (selectors == NULL)
+    {
+      gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
+    }
+  else if (gtk_css_node_is_affected_by (cssnode, selectors))
+    {
+      /* The parent keeps its style, so make sure we don't find
+       * our old style in its cache */
+      if (cssnode->parent)
+        g_clear_pointer (&cssnode->parent->cache, gtk_css_node_style_cache_unref);
+
+      gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
+    }
 
   for (child = cssnode->first_child;
        child;
        child = child->next_sibling)
     {
       if (gtk_css_node_get_style_provider_or_null (child) == NULL)
-        gtk_css_node_invalidate_style_provider (child);
+        gtk_css_node_invalidate_style_provider (child, selectors);
     }
 }
 
@@ -1368,10 +1628,15 @@ gtk_css_node_invalidate (GtkCssNode   *cssnode,
   gtk_css_node_invalidate_style (cssnode);
 }
 
-void
-gtk_css_node_validate_internal (GtkCssNode *cssnode,
-                                gint64      timestamp)
-{
+static void
+gtk_css_node_validate_internal (GtkCssNode                 *cssnode,
+                                gint64                      timestamp,
+                                const GtkCssAncestorFilter *filter)
+{
+  GtkCssAncestorFilter child_filter;
+  GtkCssNode *saved_parent;
+  const GtkCssAncestorFilter *saved_filter;
+  guint saved_serial;
   GtkCssNode *child;
 
   if (!cssnode->invalid)
@@ -1386,23 +1651,87 @@ gtk_css_node_validate_internal (GtkCssNode *cssnode,
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->validate (cssnode);
 
+  if (cssnode->first_child == NULL)
+    return;
+
+  if (filter && ancestor_filter_current_serial == ancestor_filter_serial)
+    {
+      child_filter = *filter;
+      if (!_gtk_css_ancestor_filter_add_node (&child_filter, cssnode))
+        filter = NULL;
+    }
+  else
+    filter = NULL;
+
+  saved_parent = ancestor_filter_parent;
+  saved_filter = ancestor_filter;
+  saved_serial = ancestor_filter_serial;
+
+  ancestor_filter_serial = ancestor_filter_current_serial;
+
   for (child = gtk_css_node_get_first_child (cssnode);
        child;
        child = gtk_css_node_get_next_sibling (child))
     {
-      if (child->visible)
-        gtk_css_node_validate_internal (child, timestamp);
+      if (!child->visible)
+        continue;
+
+      /* Children may have changed the tree while we were validating
+       * their siblings, so reset the filter every time. */
+      ancestor_filter_parent = cssnode;
+      ancestor_filter = filter ? &child_filter : NULL;
+
+      gtk_css_node_validate_internal (child, timestamp, gtk_css_node_get_ancestor_filter (child));
     }
+
+  ancestor_filter_parent = saved_parent;
+  ancestor_filter = saved_filter;
+  ancestor_filter_serial = saved_serial;
 }
 
 void
 gtk_css_node_validate (GtkCssNode *cssnode)
 {
+  GtkCssAncestorFilter filter = { { 0, } };
+  GtkCssNode *saved_parent;
+  const GtkCssAncestorFilter *saved_filter;
+  guint saved_serial;
+  gboolean filter_usable;
+  GtkCssNode *node;
   gint64 timestamp;
 
   timestamp = gtk_css_node_get_timestamp (cssnode);
 
-  gtk_css_node_validate_internal (cssnode, timestamp);
+  filter_usable = TRUE;
+  for (node = cssnode->parent; node && filter_usable; node = node->parent)
+    filter_usable = _gtk_css_ancestor_filter_add_node (&filter, node);
+
+  saved_parent = ancestor_filter_parent;
+  saved_filter = ancestor_filter;
+  saved_serial = ancestor_filter_serial;
+
+  ancestor_filter_parent = cssnode->parent;
+  ancestor_filter = filter_usable ? &filter : NULL;
+  ancestor_filter_serial = ancestor_filter_current_serial;
+
+  gtk_css_node_validate_internal (cssnode, timestamp, gtk_css_node_get_ancestor_filter (cssnode));
+
+  ancestor_filter_parent = saved_parent;
+  ancestor_filter = saved_filter;
+  ancestor_filter_serial = saved_serial;
+}
+
+/* Returns the ancestor filter to use when matching @cssnode or
+ * %NULL if none is available. */
+const GtkCssAncestorFilter *
+gtk_css_node_get_ancestor_filter (GtkCssNode *cssnode)
+{
+  if (ancestor_filter == NULL ||
+      cssnode->parent != ancestor_filter_parent ||
+      ancestor_filter_serial != ancestor_filter_current_serial)
+    return NULL;
+
+  return ancestor_filter;
 }
 
 gboolean
@@ -18,8 +18,10 @@
 #ifndef __GTK_CSS_NODE_PRIVATE_H__
 #define __GTK_CSS_NODE_PRIVATE_H__
 
+#include "gtkcssmatcherprivate.h"
 #include "gtkcssnodedeclarationprivate.h"
 #include "gtkcssnodestylecacheprivate.h"
+#include "gtkcssselectorprivate.h"
 #include "gtkcssstylechangeprivate.h"
 #include "gtkbitmaskprivate.h"
 #include "gtkcsstypesprivate.h"
@@ -159,7 +161,8 @@ GtkCssStyle *           gtk_css_node_get_style          (GtkCssNode            *
 
 
 void                    gtk_css_node_invalidate_style_provider
-                                                        (GtkCssNode            *cssnode);
+                                                        (GtkCssNode            *cssnode,
+                                                         const GtkCssSelectorTree *selectors);
 void                    gtk_css_node_invalidate_frame_clock
                                                         (GtkCssNode            *cssnode,
                                                          gboolean               just_timestamp);
@@ -169,6 +172,11 @@ void                    gtk_css_node_validate           (GtkCssNode            *
 
 gboolean                gtk_css_node_init_matcher       (GtkCssNode            *cssnode,
                                                          GtkCssMatcher         *matcher);
+const GtkCssAncestorFilter *
+                        gtk_css_node_get_ancestor_filter (GtkCssNode           *cssnode);
+void                    gtk_css_node_get_style_statistics (guint64               *n_lookups,
+                                                           guint64               *n_cache_hits,
+                                                           guint64               *n_shared);
 GtkWidgetPath *         gtk_css_node_create_widget_path (GtkCssNode            *cssnode);
 const GtkWidgetPath *   gtk_css_node_get_widget_path    (GtkCssNode            *cssnode);
 GtkStyleProviderPrivate *gtk_css_node_get_style_provider(GtkCssNode            *cssnode);
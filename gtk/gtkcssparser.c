@@ -124,6 +124,14 @@ _gtk_css_parser_get_position (GtkCssParser *parser)
   return parser->data - parser->line_start;
 }
 
+const char *
+_gtk_css_parser_get_data (GtkCssParser *parser)
+{
+  g_return_val_if_fail (GTK_IS_CSS_PARSER (parser), NULL);
+
+  return parser->data;
+}
+
 static GFile *
 gtk_css_parser_get_base_file (GtkCssParser *parser)
 {
@@ -41,6 +41,7 @@
 #include "gtkstyleproviderprivate.h"
 #include "gtkwidgetpath.h"
 #include "gtkbindings.h"
+#include "gtkdebug.h"
 #include "gtkmarshalers.h"
 #include "gtkprivate.h"
 #include "gtkintl.h"
@@ -80,6 +81,7 @@
 
 typedef struct GtkCssRuleset GtkCssRuleset;
 typedef struct _GtkCssScanner GtkCssScanner;
+typedef struct _GtkCssCacheRecord GtkCssCacheRecord;
 typedef struct _PropertyValue PropertyValue;
 typedef struct _WidgetPropertyValue WidgetPropertyValue;
 typedef enum ParserScope ParserScope;
@@ -120,6 +122,27 @@ struct _GtkCssScanner
   GSList *state;
 };
 
+/* Records what is needed to write a theme cache while parsing.
+ * Parsed values are recorded serialized and interned in a value
+ * table, so equal values are only stored and restored once. Values
+ * that can't be serialized are recorded as the text they were parsed
+ * from, together with the file they came from, so that relative urls
+ * resolve the same way when the cache is loaded.
+ */
+struct _GtkCssCacheRecord
+{
+  GPtrArray *files;               /* all loaded files, the first one is the main file */
+  GPtrArray *values;              /* v of (sv) serialized value or (ssu) property, text, file */
+  GHashTable *value_ids;          /* data of a value => index + 1 */
+  GVariantBuilder *colors;        /* a(su) name, value */
+  GVariantBuilder *keyframes;     /* a(ssu) name, body, file */
+  GVariantBuilder *groups;        /* aa(su) declarations per parsed ruleset */
+  GVariantBuilder *declarations;  /* a(su) property, value of the current ruleset */
+  GHashTable *group_ids;          /* styles or widget_style of a ruleset => group + 1 */
+  guint n_groups;
+  guint cacheable : 1;
+};
+
 struct _GtkCssProviderPrivate
 {
   GScanner *scanner;
@@ -131,6 +154,10 @@ struct _GtkCssProviderPrivate
   GtkCssSelectorTree *tree;
   GResource *resource;
   gchar *path;
+
+  GtkCssCacheRecord *record;
+
+  guint keep_selectors : 1;
 };
 
 enum {
@@ -401,6 +428,38 @@ gtk_css_ruleset_add (GtkCssRuleset       *ruleset,
     ruleset->styles[i].section = NULL;
 }
 
+static void
+gtk_css_ruleset_add_value (GtkCssRuleset    *ruleset,
+                           GtkStyleProperty *property,
+                           GtkCssValue      *value,
+                           GtkCssSection    *section)
+{
+  if (GTK_IS_CSS_SHORTHAND_PROPERTY (property))
+    {
+      GtkCssShorthandProperty *shorthand = GTK_CSS_SHORTHAND_PROPERTY (property);
+      guint i;
+
+      for (i = 0; i < _gtk_css_shorthand_property_get_n_subproperties (shorthand); i++)
+        {
+          GtkCssStyleProperty *child = _gtk_css_shorthand_property_get_subproperty (shorthand, i);
+          GtkCssValue *sub = _gtk_css_array_value_get_nth (value, i);
+
+          gtk_css_ruleset_add (ruleset, child, _gtk_css_value_ref (sub), section);
+        }
+
+      _gtk_css_value_unref (value);
+    }
+  else if (GTK_IS_CSS_STYLE_PROPERTY (property))
+    {
+      gtk_css_ruleset_add (ruleset, GTK_CSS_STYLE_PROPERTY (property), value, section);
+    }
+  else
+    {
+      g_assert_not_reached ();
+      _gtk_css_value_unref (value);
+    }
+}
+
 static void
 gtk_css_scanner_destroy (GtkCssScanner *scanner)
 {
@@ -425,6 +484,10 @@ gtk_css_provider_emit_error (GtkCssProvider *provider,
                              GtkCssScanner  *scanner,
                              const GError   *error)
 {
+  /* Don't cache anything we'd have to warn about again */
+  if (provider->priv->record)
+    provider->priv->record->cacheable = FALSE;
+
   gtk_css_style_provider_emit_error (GTK_STYLE_PROVIDER_PRIVATE (provider),
                                      scanner ? scanner->section : NULL,
                                      error);
@@ -514,6 +577,22 @@ gtk_css_scanner_pop_section (GtkCssScanner *scanner,
   scanner->section = parent;
 }
 
+static GHashTable *
+gtk_css_provider_new_symbolic_colors (void)
+{
+  return g_hash_table_new_full (g_str_hash, g_str_equal,
+                                (GDestroyNotify) g_free,
+                                (GDestroyNotify) _gtk_css_value_unref);
+}
+
+static GHashTable *
+gtk_css_provider_new_keyframes (void)
+{
+  return g_hash_table_new_full (g_str_hash, g_str_equal,
+                                (GDestroyNotify) g_free,
+                                (GDestroyNotify) _gtk_css_keyframes_unref);
+}
+
 static void
 gtk_css_provider_init (GtkCssProvider *css_provider)
 {
@@ -523,12 +602,8 @@ gtk_css_provider_init (GtkCssProvider *css_provider)
 
   priv->rulesets = g_array_new (FALSE, FALSE, sizeof (GtkCssRuleset));
 
-  priv->symbolic_colors = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                 (GDestroyNotify) g_free,
-                                                 (GDestroyNotify) _gtk_css_value_unref);
-  priv->keyframes = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                           (GDestroyNotify) g_free,
-                                           (GDestroyNotify) _gtk_css_keyframes_unref);
+  priv->symbolic_colors = gtk_css_provider_new_symbolic_colors ();
+  priv->keyframes = gtk_css_provider_new_keyframes ();
 }
 
 static void
@@ -907,6 +982,221 @@ gtk_css_provider_invalid_token (GtkCssProvider *provider,
                           "expected %s", expected);
 }
 
+static GtkCssCacheRecord *
+gtk_css_cache_record_new (void)
+{
+  GtkCssCacheRecord *record;
+
+  record = g_slice_new0 (GtkCssCacheRecord);
+
+  record->files = g_ptr_array_new_with_free_func (g_object_unref);
+  record->values = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+  record->value_ids = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+                                             (GDestroyNotify) g_bytes_unref, NULL);
+  record->colors = g_variant_builder_new (G_VARIANT_TYPE ("a(su)"));
+  record->keyframes = g_variant_builder_new (G_VARIANT_TYPE ("a(ssu)"));
+  record->groups = g_variant_builder_new (G_VARIANT_TYPE ("aa(su)"));
+  record->declarations = g_variant_builder_new (G_VARIANT_TYPE ("a(su)"));
+  record->group_ids = g_hash_table_new (NULL, NULL);
+  record->cacheable = TRUE;
+
+  return record;
+}
+
+static void
+gtk_css_cache_record_free (GtkCssCacheRecord *record)
+{
+  g_ptr_array_unref (record->files);
+  g_ptr_array_unref (record->values);
+  g_hash_table_unref (record->value_ids);
+  g_variant_builder_unref (record->colors);
+  g_variant_builder_unref (record->keyframes);
+  g_variant_builder_unref (record->groups);
+  g_variant_builder_unref (record->declarations);
+  g_hash_table_unref (record->group_ids);
+
+  g_slice_free (GtkCssCacheRecord, record);
+}
+
+static guint
+gtk_css_cache_record_file (GtkCssCacheRecord *record,
+                           GFile             *file)
+{
+  guint i;
+
+  if (file == NULL)
+    return G_MAXUINT;
+
+  for (i = 0; i < record->files->len; i++)
+    {
+      if (g_file_equal (g_ptr_array_index (record->files, i), file))
+        return i;
+    }
+
+  g_ptr_array_add (record->files, g_object_ref (file));
+
+  return i;
+}
+
+/* Adds @entry to the value table unless an equal entry is in it
+ * already, and returns its index.
+ */
+static guint
+gtk_css_cache_record_value (GtkCssCacheRecord *record,
+                            GVariant          *entry)
+{
+  GVariant *value;
+  GBytes *data;
+  gpointer id;
+
+  value = g_variant_ref_sink (g_variant_new_variant (entry));
+  data = g_variant_get_data_as_bytes (value);
+
+  id = g_hash_table_lookup (record->value_ids, data);
+  if (id != NULL)
+    {
+      g_bytes_unref (data);
+      g_variant_unref (value);
+      return GPOINTER_TO_UINT (id) - 1;
+    }
+
+  g_ptr_array_add (record->values, value);
+  g_hash_table_insert (record->value_ids, data, GUINT_TO_POINTER (record->values->len));
+
+  return record->values->len - 1;
+}
+
+/* Records the text from @start up to the current position of @parser */
+static char *
+gtk_css_cache_record_get_text (const char   *start,
+                               GtkCssParser *parser)
+{
+  return g_strndup (start, _gtk_css_parser_get_data (parser) - start);
+}
+
+static void
+gtk_css_cache_record_text (GtkCssCacheRecord *record,
+                           GVariantBuilder   *builder,
+                           const char        *name,
+                           const char        *start,
+                           GtkCssParser      *parser)
+{
+  char *text;
+
+  text = gtk_css_cache_record_get_text (start, parser);
+  g_variant_builder_add (builder, "(ssu)",
+                         name, text,
+                         gtk_css_cache_record_file (record, _gtk_css_parser_get_file (parser)));
+  g_free (text);
+}
+
+static void
+gtk_css_cache_record_color (GtkCssCacheRecord *record,
+                            const char        *name,
+                            GtkCssValue       *color)
+{
+  GVariant *entry;
+
+  entry = _gtk_css_value_serialize (color);
+  if (entry == NULL)
+    {
+      record->cacheable = FALSE;
+      return;
+    }
+
+  g_variant_builder_add (record->colors, "(su)",
+                         name, gtk_css_cache_record_value (record, entry));
+}
+
+/* Shorthands are recorded as the values of their subproperties, so
+ * those can be shared with the longhand declarations.
+ */
+static void
+gtk_css_cache_record_declaration (GtkCssCacheRecord *record,
+                                  GtkStyleProperty  *property,
+                                  GtkCssValue       *value,
+                                  const char        *start,
+                                  GtkCssParser      *parser)
+{
+  GtkCssShorthandProperty *shorthand;
+  GVariant *entry, **entries;
+  char *text;
+  guint i, n;
+
+  if (GTK_IS_CSS_SHORTHAND_PROPERTY (property))
+    {
+      shorthand = GTK_CSS_SHORTHAND_PROPERTY (property);
+      n = _gtk_css_shorthand_property_get_n_subproperties (shorthand);
+      entries = g_newa (GVariant *, n);
+
+      for (i = 0; i < n; i++)
+        {
+          entries[i] = _gtk_css_value_serialize (_gtk_css_array_value_get_nth (value, i));
+          if (entries[i] == NULL)
+            break;
+        }
+
+      if (i == n)
+        {
+          for (i = 0; i < n; i++)
+            {
+              GtkCssStyleProperty *child = _gtk_css_shorthand_property_get_subproperty (shorthand, i);
+
+              g_variant_builder_add (record->declarations, "(su)",
+                                     _gtk_style_property_get_name (GTK_STYLE_PROPERTY (child)),
+                                     gtk_css_cache_record_value (record, entries[i]));
+            }
+          return;
+        }
+
+      while (i-- > 0)
+        g_variant_unref (g_variant_ref_sink (entries[i]));
+    }
+  else
+    {
+      entry = _gtk_css_value_serialize (value);
+      if (entry != NULL)
+        {
+          g_variant_builder_add (record->declarations, "(su)",
+                                 property->name,
+                                 gtk_css_cache_record_value (record, entry));
+          return;
+        }
+    }
+
+  text = gtk_css_cache_record_get_text (start, parser);
+  entry = g_variant_new ("(ssu)",
+                         property->name, text,
+                         gtk_css_cache_record_file (record, _gtk_css_parser_get_file (parser)));
+  g_variant_builder_add (record->declarations, "(su)",
+                         property->name,
+                         gtk_css_cache_record_value (record, entry));
+  g_free (text);
+}
+
+static void
+gtk_css_cache_record_ruleset (GtkCssCacheRecord *record,
+                              GtkCssRuleset     *ruleset)
+{
+  GVariant *declarations;
+  gpointer key;
+
+  declarations = g_variant_builder_end (record->declarations);
+  g_variant_builder_unref (record->declarations);
+  record->declarations = g_variant_builder_new (G_VARIANT_TYPE ("a(su)"));
+
+  /* All rulesets committed from one selector list share these */
+  key = ruleset->styles ? (gpointer) ruleset->styles : (gpointer) ruleset->widget_style;
+  if (key == NULL)
+    {
+      g_variant_unref (g_variant_ref_sink (declarations));
+      return;
+    }
+
+  g_variant_builder_add_value (record->groups, declarations);
+  g_hash_table_insert (record->group_ids, key, GUINT_TO_POINTER (++record->n_groups));
+}
+
 static void
 css_provider_commit (GtkCssProvider *css_provider,
                      GSList         *selectors,
@@ -917,6 +1207,9 @@ css_provider_commit (GtkCssProvider *css_provider,
 
   priv = css_provider->priv;
 
+  if (priv->record)
+    gtk_css_cache_record_ruleset (priv->record, ruleset);
+
   if (ruleset->styles == NULL && ruleset->widget_style == NULL)
     {
       g_slist_free_full (selectors, (GDestroyNotify) _gtk_css_selector_free);
@@ -1100,6 +1393,9 @@ parse_color_definition (GtkCssScanner *scanner)
       return TRUE;
     }
 
+  if (scanner->provider->priv->record)
+    gtk_css_cache_record_color (scanner->provider->priv->record, name, color);
+
   if (!_gtk_css_parser_try (scanner->parser, ";", TRUE))
     {
       g_free (name);
@@ -1135,6 +1431,10 @@ parse_binding_set (GtkCssScanner *scanner)
       return FALSE;
     }
 
+  /* Binding sets are global state, so they can't be restored from a cache */
+  if (scanner->provider->priv->record)
+    scanner->provider->priv->record->cacheable = FALSE;
+
   name = _gtk_css_parser_try_ident (scanner->parser, TRUE);
   if (name == NULL)
     {
@@ -1233,6 +1533,7 @@ static gboolean
 parse_keyframes (GtkCssScanner *scanner)
 {
   GtkCssKeyframes *keyframes;
+  const char *body_start;
   char *name;
 
   gtk_css_scanner_push_section (scanner, GTK_CSS_SECTION_KEYFRAMES);
@@ -1267,6 +1568,7 @@ parse_keyframes (GtkCssScanner *scanner)
       goto exit;
     }
 
+  body_start = _gtk_css_parser_get_data (scanner->parser);
   keyframes = _gtk_css_keyframes_parse (scanner->parser);
   if (keyframes == NULL)
     {
@@ -1275,6 +1577,13 @@ parse_keyframes (GtkCssScanner *scanner)
       goto exit;
     }
 
+  if (scanner->provider->priv->record)
+    gtk_css_cache_record_text (scanner->provider->priv->record,
+                               scanner->provider->priv->record->keyframes,
+                               name,
+                               body_start,
+                               scanner->parser);
+
   g_hash_table_insert (scanner->provider->priv->keyframes, name, keyframes);
 
   if (!_gtk_css_parser_try (scanner->parser, "}", TRUE))
@@ -1464,11 +1773,13 @@ parse_declaration (GtkCssScanner *scanner,
   if (property)
     {
       GtkCssValue *value;
+      const char *value_start;
 
       g_free (name);
 
       gtk_css_scanner_push_section (scanner, GTK_CSS_SECTION_VALUE);
 
+      value_start = _gtk_css_parser_get_data (scanner->parser);
       value = _gtk_style_property_parse_value (property,
                                                scanner->parser);
 
@@ -1495,31 +1806,14 @@ parse_declaration (GtkCssScanner *scanner,
           return;
         }
 
-      if (GTK_IS_CSS_SHORTHAND_PROPERTY (property))
-        {
-          GtkCssShorthandProperty *shorthand = GTK_CSS_SHORTHAND_PROPERTY (property);
-          guint i;
-
-          for (i = 0; i < _gtk_css_shorthand_property_get_n_subproperties (shorthand); i++)
-            {
-              GtkCssStyleProperty *child = _gtk_css_shorthand_property_get_subproperty (shorthand, i);
-              GtkCssValue *sub = _gtk_css_array_value_get_nth (value, i);
-              
-              gtk_css_ruleset_add (ruleset, child, _gtk_css_value_ref (sub), scanner->section);
-            }
-          
-            _gtk_css_value_unref (value);
-        }
-      else if (GTK_IS_CSS_STYLE_PROPERTY (property))
-        {
-          gtk_css_ruleset_add (ruleset, GTK_CSS_STYLE_PROPERTY (property), value, scanner->section);
-        }
-      else
-        {
-          g_assert_not_reached ();
-          _gtk_css_value_unref (value);
-        }
+      if (scanner->provider->priv->record)
+        gtk_css_cache_record_declaration (scanner->provider->priv->record,
+                                          property,
+                                          value,
+                                          value_start,
+                                          scanner->parser);
 
+      gtk_css_ruleset_add_value (ruleset, property, value, scanner->section);
 
       gtk_css_scanner_pop_section (scanner, GTK_CSS_SECTION_VALUE);
     }
@@ -1536,6 +1830,12 @@ parse_declaration (GtkCssScanner *scanner,
         {
           WidgetPropertyValue *val;
 
+          if (scanner->provider->priv->record)
+            g_variant_builder_add (scanner->provider->priv->record->declarations,
+                                   "(su)", name,
+                                   gtk_css_cache_record_value (scanner->provider->priv->record,
+                                                               g_variant_new ("(ssu)", name, value_str, G_MAXUINT)));
+
           val = widget_property_value_new (name, scanner->section);
 	  val->value = value_str;
 
@@ -1703,14 +2003,18 @@ gtk_css_provider_postprocess (GtkCssProvider *css_provider)
   _gtk_css_selector_tree_builder_free (builder);
 
 #ifndef VERIFY_TREE
-  for (i = 0; i < priv->rulesets->len; i++)
+  /* Reloads compare the selectors to find the rules that changed */
+  if (!priv->keep_selectors)
     {
-      GtkCssRuleset *ruleset;
+      for (i = 0; i < priv->rulesets->len; i++)
+        {
+          GtkCssRuleset *ruleset;
 
-      ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+          ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
 
-      _gtk_css_selector_free (ruleset->selector);
-      ruleset->selector = NULL;
+          _gtk_css_selector_free (ruleset->selector);
+          ruleset->selector = NULL;
+        }
     }
 #endif
 }
@@ -1743,6 +2047,9 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
                                 NULL, &load_error))
         {
           text = free_data;
+
+          if (css_provider->priv->record)
+            gtk_css_cache_record_file (css_provider->priv->record, file);
         }
       else
         {
@@ -1808,120 +2115,435 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
   return TRUE;
 }
 
-/**
- * gtk_css_provider_load_from_data:
- * @css_provider: a #GtkCssProvider
- * @data: (array length=length) (element-type guint8): CSS data loaded in memory
- * @length: the length of @data in bytes, or -1 for NUL terminated strings. If
- *   @length is not -1, the code will assume it is not NUL terminated and will
- *   potentially do a copy.
- * @error: (out) (allow-none): return location for a #GError, or %NULL
- *
- * Loads @data into @css_provider, and by doing so clears any previously loaded
- * information.
- *
- * Returns: %TRUE. The return value is deprecated and %FALSE will only be
- *     returned for backwards compatibility reasons if an @error is not 
- *     %NULL and a loading error occurred. To track errors while loading
- *     CSS, connect to the #GtkCssProvider::parsing-error signal.
- **/
-gboolean
-gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
-                                 const gchar     *data,
-                                 gssize           length,
-                                 GError         **error)
+/* INCREMENTAL RELOADS */
+
+/* The contents of a provider before it is reloaded. They are compared
+ * with the new contents, so that only nodes affected by rules that
+ * changed get restyled.
+ */
+typedef struct {
+  GArray *rulesets;
+  GtkCssSelectorTree *tree;
+  GHashTable *symbolic_colors;
+  GHashTable *keyframes;
+} GtkCssProviderSnapshot;
+
+static GtkCssProviderSnapshot *
+gtk_css_provider_take_snapshot (GtkCssProvider *provider)
 {
-  char *free_data;
-  gboolean ret;
+  GtkCssProviderPrivate *priv = provider->priv;
+  GtkCssProviderSnapshot *snapshot;
 
-  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
-  g_return_val_if_fail (data != NULL, FALSE);
+  snapshot = g_slice_new (GtkCssProviderSnapshot);
 
-  if (length < 0)
-    {
-      length = strlen (data);
-      free_data = NULL;
-    }
-  else
-    {
-      free_data = g_strndup (data, length);
-      data = free_data;
-    }
+  snapshot->rulesets = priv->rulesets;
+  snapshot->tree = priv->tree;
+  snapshot->symbolic_colors = priv->symbolic_colors;
+  snapshot->keyframes = priv->keyframes;
 
-  gtk_css_provider_reset (css_provider);
+  priv->rulesets = g_array_new (FALSE, FALSE, sizeof (GtkCssRuleset));
+  priv->tree = NULL;
+  priv->symbolic_colors = gtk_css_provider_new_symbolic_colors ();
+  priv->keyframes = gtk_css_provider_new_keyframes ();
 
-  ret = gtk_css_provider_load_internal (css_provider, NULL, NULL, data, error);
+  priv->keep_selectors = TRUE;
 
-  g_free (free_data);
+  return snapshot;
+}
 
-  _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (css_provider));
+static void
+gtk_css_provider_snapshot_free (GtkCssProviderSnapshot *snapshot)
+{
+  guint i;
 
-  return ret;
+  for (i = 0; i < snapshot->rulesets->len; i++)
+    gtk_css_ruleset_clear (&g_array_index (snapshot->rulesets, GtkCssRuleset, i));
+  g_array_free (snapshot->rulesets, TRUE);
+  _gtk_css_selector_tree_free (snapshot->tree);
+  g_hash_table_destroy (snapshot->symbolic_colors);
+  g_hash_table_destroy (snapshot->keyframes);
+
+  g_slice_free (GtkCssProviderSnapshot, snapshot);
 }
 
-/**
- * gtk_css_provider_load_from_file:
- * @css_provider: a #GtkCssProvider
- * @file: #GFile pointing to a file to load
- * @error: (out) (allow-none): return location for a #GError, or %NULL
- *
- * Loads the data contained in @file into @css_provider, making it
- * clear any previously loaded information.
- *
- * Returns: %TRUE. The return value is deprecated and %FALSE will only be
- *     returned for backwards compatibility reasons if an @error is not 
- *     %NULL and a loading error occurred. To track errors while loading
- *     CSS, connect to the #GtkCssProvider::parsing-error signal.
- **/
-gboolean
-gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
-                                 GFile           *file,
-                                 GError         **error)
+static gboolean
+gtk_css_ruleset_equal (const GtkCssRuleset *a,
+                       const GtkCssRuleset *b)
 {
-  gboolean success;
+  const WidgetPropertyValue *wa, *wb;
+  guint i;
 
-  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
-  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  if (!_gtk_css_selector_equal (a->selector, b->selector))
+    return FALSE;
 
-  gtk_css_provider_reset (css_provider);
+  if (a->n_styles != b->n_styles)
+    return FALSE;
 
-  success = gtk_css_provider_load_internal (css_provider, NULL, file, NULL, error);
+  for (i = 0; i < a->n_styles; i++)
+    {
+      if (a->styles[i].property != b->styles[i].property ||
+          !_gtk_css_value_equal (a->styles[i].value, b->styles[i].value))
+        return FALSE;
+    }
 
-  _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (css_provider));
+  for (wa = a->widget_style, wb = b->widget_style;
+       wa != NULL && wb != NULL;
+       wa = wa->next, wb = wb->next)
+    {
+      if (!g_str_equal (wa->name, wb->name) ||
+          !g_str_equal (wa->value, wb->value))
+        return FALSE;
+    }
 
-  return success;
+  return wa == wb;
 }
 
-/**
- * gtk_css_provider_load_from_path:
- * @css_provider: a #GtkCssProvider
- * @path: the path of a filename to load, in the GLib filename encoding
- * @error: (out) (allow-none): return location for a #GError, or %NULL
- *
- * Loads the data contained in @path into @css_provider, making it clear
- * any previously loaded information.
- *
- * Returns: %TRUE. The return value is deprecated and %FALSE will only be
- *     returned for backwards compatibility reasons if an @error is not 
- *     %NULL and a loading error occurred. To track errors while loading
- *     CSS, connect to the #GtkCssProvider::parsing-error signal.
- **/
-gboolean
-gtk_css_provider_load_from_path (GtkCssProvider  *css_provider,
-                                 const gchar     *path,
-                                 GError         **error)
+static gboolean
+gtk_css_provider_colors_equal (GHashTable *a,
+                               GHashTable *b)
 {
-  GFile *file;
-  gboolean result;
-
-  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
-  g_return_val_if_fail (path != NULL, FALSE);
+  GHashTableIter iter;
+  gpointer name, color, other;
 
-  file = g_file_new_for_path (path);
-  
-  result = gtk_css_provider_load_from_file (css_provider, file, error);
+  if (g_hash_table_size (a) != g_hash_table_size (b))
+    return FALSE;
 
-  g_object_unref (file);
+  g_hash_table_iter_init (&iter, a);
+  while (g_hash_table_iter_next (&iter, &name, &color))
+    {
+      other = g_hash_table_lookup (b, name);
+      if (other == NULL || !_gtk_css_value_equal (color, other))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_provider_keyframes_equal (GHashTable *a,
+                                  GHashTable *b)
+{
+  GHashTableIter iter;
+  gpointer name, keyframes, other;
+  GString *sa, *sb;
+  gboolean result;
+
+  if (g_hash_table_size (a) != g_hash_table_size (b))
+    return FALSE;
+
+  sa = g_string_new (NULL);
+  sb = g_string_new (NULL);
+  result = TRUE;
+
+  g_hash_table_iter_init (&iter, a);
+  while (result && g_hash_table_iter_next (&iter, &name, &keyframes))
+    {
+      other = g_hash_table_lookup (b, name);
+      if (other == NULL)
+        {
+          result = FALSE;
+          break;
+        }
+
+      g_string_truncate (sa, 0);
+      g_string_truncate (sb, 0);
+      _gtk_css_keyframes_print (keyframes, sa);
+      _gtk_css_keyframes_print (other, sb);
+      result = g_string_equal (sa, sb);
+    }
+
+  g_string_free (sa, TRUE);
+  g_string_free (sb, TRUE);
+
+  return result;
+}
+
+static guint
+gtk_css_provider_add_rulesets (GtkCssSelectorTreeBuilder *builder,
+                               GArray                    *rulesets,
+                               guint                      start,
+                               guint                      end)
+{
+  guint i;
+
+  for (i = start; i < end; i++)
+    {
+      GtkCssRuleset *ruleset = &g_array_index (rulesets, GtkCssRuleset, i);
+
+      _gtk_css_selector_tree_builder_add (builder, ruleset->selector, NULL, ruleset);
+    }
+
+  return end - start;
+}
+
+static guint
+gtk_css_provider_find_run_end (GArray *rulesets,
+                               guint   start)
+{
+  const GtkCssSelector *selector;
+  guint end;
+
+  selector = g_array_index (rulesets, GtkCssRuleset, start).selector;
+
+  for (end = start + 1; end < rulesets->len; end++)
+    {
+      if (_gtk_css_selector_compare (selector, g_array_index (rulesets, GtkCssRuleset, end).selector) != 0)
+        break;
+    }
+
+  return end;
+}
+
+/* Adds the selectors of all rulesets that are not in both @old and
+ * @new to @builder and returns how many there were.
+ *
+ * Rulesets are sorted by specificity and rulesets of equal specificity
+ * are applied in the order they were defined, so we only keep those
+ * at the start and the end of every run of equal specificity. A node
+ * that only matches kept rulesets gets the same rulesets applied in
+ * the same order as before.
+ */
+static guint
+gtk_css_provider_diff_rulesets (GArray                    *old,
+                                GArray                    *new,
+                                GtkCssSelectorTreeBuilder *builder)
+{
+  guint i, j, i_end, j_end, run_i_end, run_j_end;
+  guint n_changed;
+  int compare;
+
+#define OLD(n) (&g_array_index (old, GtkCssRuleset, (n)))
+#define NEW(n) (&g_array_index (new, GtkCssRuleset, (n)))
+
+  n_changed = 0;
+  i = j = 0;
+
+  while (i < old->len || j < new->len)
+    {
+      if (j >= new->len)
+        compare = -1;
+      else if (i >= old->len)
+        compare = 1;
+      else
+        compare = _gtk_css_selector_compare (OLD (i)->selector, NEW (j)->selector);
+
+      if (compare < 0)
+        {
+          run_i_end = gtk_css_provider_find_run_end (old, i);
+          n_changed += gtk_css_provider_add_rulesets (builder, old, i, run_i_end);
+          i = run_i_end;
+          continue;
+        }
+      else if (compare > 0)
+        {
+          run_j_end = gtk_css_provider_find_run_end (new, j);
+          n_changed += gtk_css_provider_add_rulesets (builder, new, j, run_j_end);
+          j = run_j_end;
+          continue;
+        }
+
+      run_i_end = i_end = gtk_css_provider_find_run_end (old, i);
+      run_j_end = j_end = gtk_css_provider_find_run_end (new, j);
+
+      while (i < i_end && j < j_end && gtk_css_ruleset_equal (OLD (i), NEW (j)))
+        {
+          i++;
+          j++;
+        }
+
+      while (i < i_end && j < j_end && gtk_css_ruleset_equal (OLD (i_end - 1), NEW (j_end - 1)))
+        {
+          i_end--;
+          j_end--;
+        }
+
+      n_changed += gtk_css_provider_add_rulesets (builder, old, i, i_end);
+      n_changed += gtk_css_provider_add_rulesets (builder, new, j, j_end);
+
+      i = run_i_end;
+      j = run_j_end;
+    }
+
+#undef OLD
+#undef NEW
+
+  return n_changed;
+}
+
+static gboolean
+gtk_css_provider_has_selectors (GArray *rulesets)
+{
+  guint i;
+
+  for (i = 0; i < rulesets->len; i++)
+    {
+      if (g_array_index (rulesets, GtkCssRuleset, i).selector == NULL)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Emits the change from @snapshot to the current contents. If only
+ * rulesets changed, handlers are told which selectors are affected.
+ */
+static void
+gtk_css_provider_emit_changes (GtkCssProvider         *provider,
+                               GtkCssProviderSnapshot *snapshot)
+{
+  GtkCssProviderPrivate *priv = provider->priv;
+  GtkCssSelectorTreeBuilder *builder;
+  GtkCssSelectorTree *tree;
+  guint n_changed;
+
+  /* The new selectors are kept for the next reload, loads that
+   * don't compare their rulesets don't need to keep theirs */
+  priv->keep_selectors = FALSE;
+
+  if (!gtk_css_provider_has_selectors (snapshot->rulesets) ||
+      !gtk_css_provider_has_selectors (priv->rulesets) ||
+      !gtk_css_provider_colors_equal (snapshot->symbolic_colors, priv->symbolic_colors) ||
+      !gtk_css_provider_keyframes_equal (snapshot->keyframes, priv->keyframes))
+    {
+      _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (provider));
+      return;
+    }
+
+  builder = _gtk_css_selector_tree_builder_new ();
+  n_changed = gtk_css_provider_diff_rulesets (snapshot->rulesets, priv->rulesets, builder);
+
+  if (n_changed > 0)
+    {
+      tree = _gtk_css_selector_tree_builder_build (builder);
+
+      _gtk_style_provider_private_changed_selectors (GTK_STYLE_PROVIDER_PRIVATE (provider), tree);
+
+      _gtk_css_selector_tree_free (tree);
+    }
+
+  _gtk_css_selector_tree_builder_free (builder);
+}
+
+/**
+ * gtk_css_provider_load_from_data:
+ * @css_provider: a #GtkCssProvider
+ * @data: (array length=length) (element-type guint8): CSS data loaded in memory
+ * @length: the length of @data in bytes, or -1 for NUL terminated strings. If
+ *   @length is not -1, the code will assume it is not NUL terminated and will
+ *   potentially do a copy.
+ * @error: (out) (allow-none): return location for a #GError, or %NULL
+ *
+ * Loads @data into @css_provider, and by doing so clears any previously loaded
+ * information.
+ *
+ * Returns: %TRUE. The return value is deprecated and %FALSE will only be
+ *     returned for backwards compatibility reasons if an @error is not 
+ *     %NULL and a loading error occurred. To track errors while loading
+ *     CSS, connect to the #GtkCssProvider::parsing-error signal.
+ **/
+gboolean
+gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
+                                 const gchar     *data,
+                                 gssize           length,
+                                 GError         **error)
+{
+  GtkCssProviderSnapshot *snapshot;
+  char *free_data;
+  gboolean ret;
+
+  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  if (length < 0)
+    {
+      length = strlen (data);
+      free_data = NULL;
+    }
+  else
+    {
+      free_data = g_strndup (data, length);
+      data = free_data;
+    }
+
+  snapshot = gtk_css_provider_take_snapshot (css_provider);
+  gtk_css_provider_reset (css_provider);
+
+  ret = gtk_css_provider_load_internal (css_provider, NULL, NULL, data, error);
+
+  g_free (free_data);
+
+  gtk_css_provider_emit_changes (css_provider, snapshot);
+  gtk_css_provider_snapshot_free (snapshot);
+
+  return ret;
+}
+
+/**
+ * gtk_css_provider_load_from_file:
+ * @css_provider: a #GtkCssProvider
+ * @file: #GFile pointing to a file to load
+ * @error: (out) (allow-none): return location for a #GError, or %NULL
+ *
+ * Loads the data contained in @file into @css_provider, making it
+ * clear any previously loaded information.
+ *
+ * Returns: %TRUE. The return value is deprecated and %FALSE will only be
+ *     returned for backwards compatibility reasons if an @error is not 
+ *     %NULL and a loading error occurred. To track errors while loading
+ *     CSS, connect to the #GtkCssProvider::parsing-error signal.
+ **/
+gboolean
+gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
+                                 GFile           *file,
+                                 GError         **error)
+{
+  GtkCssProviderSnapshot *snapshot;
+  gboolean success;
+
+  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+  snapshot = gtk_css_provider_take_snapshot (css_provider);
+  gtk_css_provider_reset (css_provider);
+
+  success = gtk_css_provider_load_internal (css_provider, NULL, file, NULL, error);
+
+  gtk_css_provider_emit_changes (css_provider, snapshot);
+  gtk_css_provider_snapshot_free (snapshot);
+
+  return success;
+}
+
+/**
+ * gtk_css_provider_load_from_path:
+ * @css_provider: a #GtkCssProvider
+ * @path: the path of a filename to load, in the GLib filename encoding
+ * @error: (out) (allow-none): return location for a #GError, or %NULL
+ *
+ * Loads the data contained in @path into @css_provider, making it clear
+ * any previously loaded information.
+ *
+ * Returns: %TRUE. The return value is deprecated and %FALSE will only be
+ *     returned for backwards compatibility reasons if an @error is not 
+ *     %NULL and a loading error occurred. To track errors while loading
+ *     CSS, connect to the #GtkCssProvider::parsing-error signal.
+ **/
+gboolean
+gtk_css_provider_load_from_path (GtkCssProvider  *css_provider,
+                                 const gchar     *path,
+                                 GError         **error)
+{
+  GFile *file;
+  gboolean result;
+
+  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
+  g_return_val_if_fail (path != NULL, FALSE);
+
+  file = g_file_new_for_path (path);
+  
+  result = gtk_css_provider_load_from_file (css_provider, file, error);
+
+  g_object_unref (file);
 
   return result;
 }
@@ -2103,6 +2725,652 @@ _gtk_css_find_theme (const gchar *name,
   return path;
 }
 
+/* THEME CACHE */
+
+/* Themes loaded by name are cached in the user's cache directory.
+ * The cache contains the serialized values of all declarations and
+ * colors, so they can be restored without going through the whole
+ * theme, and the prebuilt selector tree. Each distinct value is only
+ * stored once and restored once, rulesets using it share it.
+ * Keyframes and values that can't be serialized are stored as text
+ * and parsed again.
+ *
+ * The cache is only used if all the files the theme was loaded from
+ * are unchanged. Files on disk are checked by their modification time
+ * and size. Resources are checked by their size only, as the ones in
+ * GTK itself are covered by the GTK version and the ones of a theme
+ * by the theme's gtk.gresource file being recorded, too.
+ */
+#define GTK_CSS_CACHE_MAGIC "GtkCssProviderCache"
+#define GTK_CSS_CACHE_VERSION 1
+#define GTK_CSS_CACHE_GTK_VERSION ((GTK_MAJOR_VERSION << 16) | (GTK_MINOR_VERSION << 8) | GTK_MICRO_VERSION)
+#define GTK_CSS_CACHE_ARCH ((guint32) sizeof (gpointer) | (G_BYTE_ORDER << 8))
+#define GTK_CSS_CACHE_FORMAT "(&suuu@a(sxt)@av@a(su)@a(ssu)@aa(su)@au@(ayas))"
+#define GTK_CSS_CACHE_TYPE "(suuua(sxt)ava(su)a(ssu)aa(su)au(ayas))"
+
+typedef struct {
+  GVariant *entries;      /* the value table of the cache */
+  GtkCssValue **values;   /* entries restored so far */
+  gsize n_values;
+  GFile **files;
+  gsize n_files;
+} GtkCssCacheValues;
+
+static gboolean
+gtk_css_provider_cache_enabled (void)
+{
+#ifdef VERIFY_TREE
+  /* Verifying needs the selectors, which we don't cache */
+  return FALSE;
+#else
+  return !gtk_keep_css_sections && !GTK_DEBUG_CHECK (NO_CSS_CACHE);
+#endif
+}
+
+static gchar *
+gtk_css_provider_get_cache_path (GFile *file)
+{
+  gchar *uri, *basename, *path;
+
+  uri = g_file_get_uri (file);
+  basename = g_strdup_printf ("%08x.cache", g_str_hash (uri));
+  path = g_build_filename (g_get_user_cache_dir (), "gtk-3.0", "css", basename, NULL);
+
+  g_free (basename);
+  g_free (uri);
+
+  return path;
+}
+
+static gboolean
+gtk_css_cache_get_file_stamp (GFile   *file,
+                              gint64  *mtime,
+                              guint64 *size)
+{
+  GFileInfo *info;
+
+  if (g_file_is_native (file))
+    {
+      info = g_file_query_info (file,
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                                G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                G_FILE_QUERY_INFO_NONE,
+                                NULL, NULL);
+      if (info == NULL)
+        return FALSE;
+
+      *mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+               + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+      *size = g_file_info_get_size (info);
+
+      g_object_unref (info);
+    }
+  else if (g_file_has_uri_scheme (file, "resource"))
+    {
+      gchar *uri, *path;
+      gsize length;
+      gboolean found;
+
+      uri = g_file_get_uri (file);
+      path = g_uri_unescape_string (uri + strlen ("resource://"), NULL);
+      found = path != NULL && g_resources_get_info (path, 0, &length, NULL, NULL);
+      g_free (path);
+      g_free (uri);
+
+      if (!found)
+        return FALSE;
+
+      *mtime = 0;
+      *size = length;
+    }
+  else
+    {
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_css_cache_parser_error (GtkCssParser *parser,
+                            const GError *error,
+                            gpointer      user_data)
+{
+  gboolean *failed = user_data;
+
+  *failed = TRUE;
+}
+
+static GtkCssParser *
+gtk_css_cache_parser_new (const char  *text,
+                          guint        file_index,
+                          GFile      **files,
+                          gsize        n_files,
+                          gboolean    *failed)
+{
+  GFile *file;
+
+  if (file_index == G_MAXUINT)
+    file = NULL;
+  else if (file_index < n_files)
+    file = files[file_index];
+  else
+    return NULL;
+
+  *failed = FALSE;
+
+  return _gtk_css_parser_new (text, file, gtk_css_cache_parser_error, failed);
+}
+
+static guint
+gtk_css_provider_cache_match_index (gpointer match,
+                                    gpointer data)
+{
+  GArray *rulesets = data;
+
+  return (GtkCssRuleset *) match - (GtkCssRuleset *) rulesets->data;
+}
+
+static gpointer
+gtk_css_provider_cache_match (guint                     index,
+                              const GtkCssSelectorTree *tree,
+                              gpointer                  data)
+{
+  GArray *rulesets = data;
+  GtkCssRuleset *ruleset;
+
+  if (index >= rulesets->len)
+    return NULL;
+
+  ruleset = &g_array_index (rulesets, GtkCssRuleset, index);
+  if (ruleset->selector_match != NULL)
+    return NULL;
+
+  ruleset->selector_match = (GtkCssSelectorTree *) tree;
+
+  return ruleset;
+}
+
+/* Returns the value at @index of the value table, restoring it the
+ * first time it is used.
+ */
+static GtkCssValue *
+gtk_css_cache_values_get (GtkCssCacheValues *values,
+                          guint              index)
+{
+  GtkStyleProperty *property;
+  GtkCssParser *parser;
+  GtkCssValue *value;
+  GVariant *entry;
+  const char *name, *text;
+  guint file_index;
+  gboolean failed;
+
+  if (index >= values->n_values)
+    return NULL;
+
+  if (values->values[index] != NULL)
+    return values->values[index];
+
+  g_variant_get_child (values->entries, index, "v", &entry);
+
+  value = NULL;
+  if (g_variant_is_of_type (entry, G_VARIANT_TYPE ("(ssu)")))
+    {
+      g_variant_get (entry, "(&s&su)", &name, &text, &file_index);
+
+      property = _gtk_style_property_lookup (name);
+      if (property != NULL)
+        parser = gtk_css_cache_parser_new (text, file_index, values->files, values->n_files, &failed);
+      else
+        parser = NULL;
+
+      if (parser != NULL)
+        {
+          value = _gtk_style_property_parse_value (property, parser);
+          failed |= !_gtk_css_parser_is_eof (parser);
+          _gtk_css_parser_free (parser);
+
+          if (value != NULL && failed)
+            g_clear_pointer (&value, _gtk_css_value_unref);
+        }
+    }
+  else
+    {
+      value = _gtk_css_value_deserialize (entry);
+    }
+
+  g_variant_unref (entry);
+
+  values->values[index] = value;
+
+  return value;
+}
+
+/* Returns the text of a widget style property at @index of the value table */
+static char *
+gtk_css_cache_values_get_text (GtkCssCacheValues *values,
+                               guint              index)
+{
+  GVariant *entry;
+  char *text;
+
+  if (index >= values->n_values)
+    return NULL;
+
+  g_variant_get_child (values->entries, index, "v", &entry);
+
+  if (g_variant_is_of_type (entry, G_VARIANT_TYPE ("(ssu)")))
+    g_variant_get (entry, "(&ssu)", NULL, &text, NULL);
+  else
+    text = NULL;
+
+  g_variant_unref (entry);
+
+  return text;
+}
+
+static gboolean
+gtk_css_provider_load_cache_colors (GtkCssProvider    *provider,
+                                    GVariant          *colors,
+                                    GtkCssCacheValues *values)
+{
+  GtkCssValue *color;
+  GVariantIter iter;
+  const char *name;
+  guint index;
+
+  g_variant_iter_init (&iter, colors);
+  while (g_variant_iter_next (&iter, "(&su)", &name, &index))
+    {
+      color = gtk_css_cache_values_get (values, index);
+      if (color == NULL)
+        return FALSE;
+
+      g_hash_table_insert (provider->priv->symbolic_colors, g_strdup (name), _gtk_css_value_ref (color));
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_provider_load_cache_keyframes (GtkCssProvider  *provider,
+                                       GVariant        *keyframes,
+                                       GFile          **files,
+                                       gsize            n_files)
+{
+  GtkCssParser *parser;
+  GtkCssKeyframes *parsed;
+  GVariantIter iter;
+  const char *name, *body;
+  char *text;
+  guint file_index;
+  gboolean failed;
+
+  g_variant_iter_init (&iter, keyframes);
+  while (g_variant_iter_next (&iter, "(&s&su)", &name, &body, &file_index))
+    {
+      /* The parser stops at the closing brace */
+      text = g_strconcat (body, "}", NULL);
+      parser = gtk_css_cache_parser_new (text, file_index, files, n_files, &failed);
+      if (parser == NULL)
+        {
+          g_free (text);
+          return FALSE;
+        }
+
+      parsed = _gtk_css_keyframes_parse (parser);
+      failed |= !_gtk_css_parser_begins_with (parser, '}');
+      _gtk_css_parser_free (parser);
+      g_free (text);
+
+      if (parsed == NULL)
+        return FALSE;
+      if (failed)
+        {
+          _gtk_css_keyframes_unref (parsed);
+          return FALSE;
+        }
+
+      g_hash_table_insert (provider->priv->keyframes, g_strdup (name), parsed);
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_provider_load_cache_group (GtkCssRuleset     *ruleset,
+                                   GVariant          *declarations,
+                                   GtkCssCacheValues *values)
+{
+  GtkStyleProperty *property;
+  GtkCssValue *value;
+  WidgetPropertyValue *val;
+  GVariantIter iter;
+  const char *name;
+  char *text;
+  guint index;
+
+  g_variant_iter_init (&iter, declarations);
+  while (g_variant_iter_next (&iter, "(&su)", &name, &index))
+    {
+      property = _gtk_style_property_lookup (name);
+      if (property == NULL)
+        {
+          text = gtk_css_cache_values_get_text (values, index);
+          if (text == NULL)
+            return FALSE;
+
+          val = widget_property_value_new (g_strdup (name), NULL);
+          val->value = text;
+          gtk_css_ruleset_add_style (ruleset, val->name, val);
+          continue;
+        }
+
+      value = gtk_css_cache_values_get (values, index);
+      if (value == NULL)
+        return FALSE;
+
+      gtk_css_ruleset_add_value (ruleset, property, _gtk_css_value_ref (value), NULL);
+    }
+
+  return ruleset->styles != NULL || ruleset->widget_style != NULL;
+}
+
+static gboolean
+gtk_css_provider_load_cache_variant (GtkCssProvider *provider,
+                                     GFile          *file,
+                                     GVariant       *cache)
+{
+  GtkCssProviderPrivate *priv = provider->priv;
+  GVariant *deps, *entries, *colors, *keyframes, *groups, *indexes, *tree;
+  GtkCssCacheValues values = { NULL, };
+  GtkCssRuleset *group_rulesets;
+  const guint32 *group_ids;
+  const char *magic, *uri;
+  guint32 version, gtk_version, arch;
+  GFile **files;
+  gsize i, n_files, n_groups, n_rulesets;
+  gint64 mtime, current_mtime;
+  guint64 size, current_size;
+  gboolean result;
+
+  g_variant_get (cache, GTK_CSS_CACHE_FORMAT,
+                 &magic, &version, &gtk_version, &arch,
+                 &deps, &entries, &colors, &keyframes, &groups, &indexes, &tree);
+
+  result = FALSE;
+  files = NULL;
+  n_files = 0;
+  group_rulesets = NULL;
+  n_groups = 0;
+
+  if (!g_str_equal (magic, GTK_CSS_CACHE_MAGIC) ||
+      version != GTK_CSS_CACHE_VERSION ||
+      gtk_version != GTK_CSS_CACHE_GTK_VERSION ||
+      arch != GTK_CSS_CACHE_ARCH)
+    goto out;
+
+  n_files = g_variant_n_children (deps);
+  if (n_files == 0)
+    goto out;
+
+  files = g_new0 (GFile *, n_files);
+  for (i = 0; i < n_files; i++)
+    {
+      g_variant_get_child (deps, i, "(&sxt)", &uri, &mtime, &size);
+      files[i] = g_file_new_for_uri (uri);
+
+      /* The first file is the theme itself, this catches hash collisions */
+      if (i == 0 && !g_file_equal (files[i], file))
+        goto out;
+
+      if (!gtk_css_cache_get_file_stamp (files[i], &current_mtime, &current_size) ||
+          current_mtime != mtime ||
+          current_size != size)
+        goto out;
+    }
+
+  values.entries = entries;
+  values.n_values = g_variant_n_children (entries);
+  values.values = g_new0 (GtkCssValue *, values.n_values);
+  values.files = files;
+  values.n_files = n_files;
+
+  if (!gtk_css_provider_load_cache_colors (provider, colors, &values) ||
+      !gtk_css_provider_load_cache_keyframes (provider, keyframes, files, n_files))
+    goto out;
+
+  n_groups = g_variant_n_children (groups);
+  group_rulesets = g_new0 (GtkCssRuleset, n_groups);
+  for (i = 0; i < n_groups; i++)
+    {
+      GVariant *declarations = g_variant_get_child_value (groups, i);
+      gboolean loaded;
+
+      loaded = gtk_css_provider_load_cache_group (&group_rulesets[i], declarations, &values);
+      g_variant_unref (declarations);
+
+      if (!loaded)
+        goto out;
+    }
+
+  /* Rulesets reference the styles of their group the same way
+   * css_provider_commit() does it, so the first copy owns them.
+   */
+  group_ids = g_variant_get_fixed_array (indexes, &n_rulesets, sizeof (guint32));
+  g_array_set_size (priv->rulesets, n_rulesets);
+  if (n_rulesets > 0)
+    memset (priv->rulesets->data, 0, n_rulesets * sizeof (GtkCssRuleset));
+  for (i = 0; i < n_rulesets; i++)
+    {
+      if (group_ids[i] >= n_groups)
+        goto out;
+
+      gtk_css_ruleset_init_copy (&g_array_index (priv->rulesets, GtkCssRuleset, i),
+                                 &group_rulesets[group_ids[i]],
+                                 NULL);
+    }
+
+  if (!_gtk_css_selector_tree_deserialize (tree,
+                                           gtk_css_provider_cache_match,
+                                           priv->rulesets,
+                                           &priv->tree))
+    goto out;
+
+  for (i = 0; i < n_rulesets; i++)
+    {
+      if (g_array_index (priv->rulesets, GtkCssRuleset, i).selector_match == NULL)
+        goto out;
+    }
+
+  result = TRUE;
+
+out:
+  for (i = 0; i < n_groups; i++)
+    gtk_css_ruleset_clear (&group_rulesets[i]);
+  g_free (group_rulesets);
+  for (i = 0; i < values.n_values; i++)
+    g_clear_pointer (&values.values[i], _gtk_css_value_unref);
+  g_free (values.values);
+  for (i = 0; i < n_files; i++)
+    g_clear_object (&files[i]);
+  g_free (files);
+
+  g_variant_unref (deps);
+  g_variant_unref (entries);
+  g_variant_unref (colors);
+  g_variant_unref (keyframes);
+  g_variant_unref (groups);
+  g_variant_unref (indexes);
+  g_variant_unref (tree);
+
+  return result;
+}
+
+static gboolean
+gtk_css_provider_load_cache (GtkCssProvider *provider,
+                             GFile          *file)
+{
+  GMappedFile *mapped;
+  GVariant *cache;
+  GBytes *bytes;
+  gchar *path;
+  gboolean result;
+
+  path = gtk_css_provider_get_cache_path (file);
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  if (mapped == NULL)
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  g_mapped_file_unref (mapped);
+
+  cache = g_variant_new_from_bytes (G_VARIANT_TYPE (GTK_CSS_CACHE_TYPE), bytes, FALSE);
+  g_variant_ref_sink (cache);
+  g_bytes_unref (bytes);
+
+  result = gtk_css_provider_load_cache_variant (provider, file, cache);
+  if (!result)
+    {
+      GTK_NOTE (MISC, g_message ("Not using outdated theme cache %s", path));
+      gtk_css_provider_reset (provider);
+    }
+
+  g_variant_unref (cache);
+  g_free (path);
+
+  return result;
+}
+
+static GVariant *
+gtk_css_provider_serialize_cache (GtkCssProvider *provider)
+{
+  GtkCssProviderPrivate *priv = provider->priv;
+  GtkCssCacheRecord *record = priv->record;
+  GVariantBuilder deps, indexes;
+  gint64 mtime;
+  guint64 size;
+  gchar *uri;
+  guint i;
+
+  g_variant_builder_init (&deps, G_VARIANT_TYPE ("a(sxt)"));
+  for (i = 0; i < record->files->len; i++)
+    {
+      GFile *file = g_ptr_array_index (record->files, i);
+
+      if (!gtk_css_cache_get_file_stamp (file, &mtime, &size))
+        {
+          g_variant_builder_clear (&deps);
+          return NULL;
+        }
+
+      uri = g_file_get_uri (file);
+      g_variant_builder_add (&deps, "(sxt)", uri, mtime, size);
+      g_free (uri);
+    }
+
+  g_variant_builder_init (&indexes, G_VARIANT_TYPE ("au"));
+  for (i = 0; i < priv->rulesets->len; i++)
+    {
+      GtkCssRuleset *ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+      gpointer key;
+
+      key = ruleset->styles ? (gpointer) ruleset->styles : (gpointer) ruleset->widget_style;
+      g_variant_builder_add (&indexes, "u",
+                             GPOINTER_TO_UINT (g_hash_table_lookup (record->group_ids, key)) - 1);
+    }
+
+  return g_variant_new ("(suuua(sxt)@ava(su)a(ssu)aa(su)au@(ayas))",
+                        GTK_CSS_CACHE_MAGIC,
+                        GTK_CSS_CACHE_VERSION,
+                        GTK_CSS_CACHE_GTK_VERSION,
+                        GTK_CSS_CACHE_ARCH,
+                        &deps,
+                        g_variant_new_array (G_VARIANT_TYPE_VARIANT,
+                                             (GVariant **) record->values->pdata,
+                                             record->values->len),
+                        record->colors,
+                        record->keyframes,
+                        record->groups,
+                        &indexes,
+                        _gtk_css_selector_tree_serialize (priv->tree,
+                                                          gtk_css_provider_cache_match_index,
+                                                          priv->rulesets));
+}
+
+static void
+gtk_css_provider_save_cache (GtkCssProvider *provider,
+                             GFile          *file)
+{
+  GVariant *cache;
+  GError *error = NULL;
+  gchar *path, *dir;
+
+  cache = gtk_css_provider_serialize_cache (provider);
+  if (cache == NULL)
+    return;
+
+  g_variant_ref_sink (cache);
+
+  path = gtk_css_provider_get_cache_path (file);
+  dir = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dir, 0755) != 0)
+    g_warning ("Failed to mkdir %s", dir);
+  else if (!g_file_set_contents (path,
+                                 g_variant_get_data (cache),
+                                 g_variant_get_size (cache),
+                                 &error))
+    {
+      g_warning ("Failed to save theme cache %s: %s", path, error->message);
+      g_error_free (error);
+    }
+
+  g_free (dir);
+  g_free (path);
+  g_variant_unref (cache);
+}
+
+/* Like gtk_css_provider_load_from_file(), but uses the theme cache.
+ * @resource_file is the theme's gtk.gresource, if it has one.
+ */
+static void
+gtk_css_provider_load_theme_file (GtkCssProvider *provider,
+                                  GFile          *file,
+                                  GFile          *resource_file)
+{
+  GtkCssProviderPrivate *priv = provider->priv;
+
+  gtk_css_provider_reset (provider);
+
+  if (!gtk_css_provider_cache_enabled ())
+    {
+      gtk_css_provider_load_internal (provider, NULL, file, NULL, NULL);
+    }
+  else if (!gtk_css_provider_load_cache (provider, file))
+    {
+      priv->record = gtk_css_cache_record_new ();
+      gtk_css_cache_record_file (priv->record, file);
+      if (resource_file)
+        gtk_css_cache_record_file (priv->record, resource_file);
+
+      gtk_css_provider_load_internal (provider, NULL, file, NULL, NULL);
+
+      if (priv->record->cacheable)
+        gtk_css_provider_save_cache (provider, file);
+
+      g_clear_pointer (&priv->record, gtk_css_cache_record_free);
+    }
+
+  _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (provider));
+}
+
 /**
  * _gtk_css_provider_load_named:
  * @provider: a #GtkCssProvider
@@ -2138,7 +3406,19 @@ _gtk_css_provider_load_named (GtkCssProvider *provider,
 
   if (g_resources_get_info (resource_path, 0, NULL, NULL, NULL))
     {
-      gtk_css_provider_load_from_resource (provider, resource_path);
+      gchar *escaped, *uri;
+      GFile *file;
+
+      escaped = g_uri_escape_string (resource_path,
+                                     G_URI_RESERVED_CHARS_ALLOWED_IN_PATH, FALSE);
+      uri = g_strconcat ("resource://", escaped, NULL);
+      file = g_file_new_for_uri (uri);
+
+      gtk_css_provider_load_theme_file (provider, file, NULL);
+
+      g_object_unref (file);
+      g_free (uri);
+      g_free (escaped);
       g_free (resource_path);
       return;
     }
@@ -2148,20 +3428,29 @@ _gtk_css_provider_load_named (GtkCssProvider *provider,
   path = _gtk_css_find_theme (name, variant);
   if (path)
     {
-      char *dir, *resource_file;
+      char *dir, *resource_path;
       GResource *resource;
+      GFile *file, *resource_file;
 
       dir = g_path_get_dirname (path);
-      resource_file = g_build_filename (dir, "gtk.gresource", NULL);
-      resource = g_resource_load (resource_file, NULL);
-      g_free (resource_file);
+      resource_path = g_build_filename (dir, "gtk.gresource", NULL);
+      resource = g_resource_load (resource_path, NULL);
 
       if (resource != NULL)
-        g_resources_register (resource);
+        {
+          g_resources_register (resource);
+          resource_file = g_file_new_for_path (resource_path);
+        }
+      else
+        resource_file = NULL;
+      g_free (resource_path);
 
-      gtk_css_provider_load_from_path (provider, path, NULL);
+      file = g_file_new_for_path (path);
+      gtk_css_provider_load_theme_file (provider, file, resource_file);
+      g_object_unref (file);
+      g_clear_object (&resource_file);
 
-      /* Only set this after load, as load_from_path will clear it */
+      /* Only set this after load, as loading will clear it */
       provider->priv->resource = resource;
       provider->priv->path = dir;
 
@@ -113,8 +113,13 @@ struct _GtkCssSelectorTree
   gint32 previous_offset;
   gint32 sibling_offset;
   gint32 matches_offset; /* pointers that we return as matches if selector matches */
+  gint32 ancestor_filter_offset; /* GtkCssAncestorFilter the ancestors must contain for a match */
 };
 
+/* Statistics about how often the ancestor filter helped */
+static guint64 n_rejected_by_ancestor_filter;
+static guint64 n_matched;
+
 static gboolean
 gtk_css_selector_equal (const GtkCssSelector *a,
 			const GtkCssSelector *b)
@@ -139,6 +144,15 @@ gtk_css_selector_tree_get_matches (const GtkCssSelectorTree *tree)
   return (gpointer *) ((guint8 *)tree + tree->matches_offset);
 }
 
+static const GtkCssAncestorFilter *
+gtk_css_selector_tree_get_ancestor_filter (const GtkCssSelectorTree *tree)
+{
+  if (tree->ancestor_filter_offset == GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+    return NULL;
+
+  return (const GtkCssAncestorFilter *) ((guint8 *)tree + tree->ancestor_filter_offset);
+}
+
 static void
 g_ptr_array_insert_sorted (GPtrArray *array,
                            gpointer   data)
@@ -172,6 +186,8 @@ gtk_css_selector_tree_found_match (const GtkCssSelectorTree  *tree,
 
       for (i = 0; matches[i] != NULL; i++)
         g_ptr_array_insert_sorted (*array, matches[i]);
+
+      n_matched += i;
     }
 }
 
@@ -1428,6 +1444,22 @@ _gtk_css_selector_compare (const GtkCssSelector *a,
   return a_elements - b_elements;
 }
 
+gboolean
+_gtk_css_selector_equal (const GtkCssSelector *a,
+                         const GtkCssSelector *b)
+{
+  while (a && b)
+    {
+      if (!gtk_css_selector_equal (a, b))
+        return FALSE;
+
+      a = gtk_css_selector_previous (a);
+      b = gtk_css_selector_previous (b);
+    }
+
+  return a == b;
+}
+
 GtkCssChange
 _gtk_css_selector_get_change (const GtkCssSelector *selector)
 {
@@ -1507,6 +1539,26 @@ gtk_css_selectors_skip_initial_selector (GtkCssSelector *selector, const GtkCssS
   return (GtkCssSelector *)gtk_css_selector_previous (selector);
 }
 
+/* Checks if the ancestors of @matcher can possibly match the
+ * subtree of selectors starting at @tree. */
+static gboolean
+gtk_css_selector_tree_ancestors_may_match (const GtkCssSelectorTree   *tree,
+                                           const GtkCssAncestorFilter *filter)
+{
+  const GtkCssAncestorFilter *required;
+
+  if (filter == NULL)
+    return TRUE;
+
+  required = gtk_css_selector_tree_get_ancestor_filter (tree);
+  if (required == NULL ||
+      _gtk_css_ancestor_filter_contains (filter, required))
+    return TRUE;
+
+  n_rejected_by_ancestor_filter++;
+  return FALSE;
+}
+
 static gboolean
 gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
                                      const GtkCssMatcher  *matcher,
@@ -1514,16 +1566,22 @@ gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
 {
   const GtkCssSelectorTree *tree = (const GtkCssSelectorTree *) selector;
   const GtkCssSelectorTree *prev;
+  const GtkCssAncestorFilter *filter;
 
   if (!gtk_css_selector_match (selector, matcher))
     return FALSE;
 
   gtk_css_selector_tree_found_match (tree, res);
 
+  filter = _gtk_css_matcher_get_ancestor_filter (matcher);
+
   for (prev = gtk_css_selector_tree_get_previous (tree);
        prev != NULL;
        prev = gtk_css_selector_tree_get_sibling (prev))
-    gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    {
+      if (gtk_css_selector_tree_ancestors_may_match (prev, filter))
+        gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    }
 
   return FALSE;
 }
@@ -1532,15 +1590,33 @@ GPtrArray *
 _gtk_css_selector_tree_match_all (const GtkCssSelectorTree *tree,
 				  const GtkCssMatcher *matcher)
 {
+  const GtkCssAncestorFilter *filter;
   GPtrArray *array = NULL;
 
+  filter = _gtk_css_matcher_get_ancestor_filter (matcher);
+
   for (; tree != NULL;
        tree = gtk_css_selector_tree_get_sibling (tree))
-    gtk_css_selector_foreach (&tree->selector, matcher, gtk_css_selector_tree_match_foreach, &array);
+    {
+      if (gtk_css_selector_tree_ancestors_may_match (tree, filter))
+        gtk_css_selector_foreach (&tree->selector, matcher, gtk_css_selector_tree_match_foreach, &array);
+    }
 
   return array;
 }
 
+/* Returns how many selector subtrees were skipped because the
+ * ancestor filter ruled them out and how many rulesets matched */
+void
+_gtk_css_selector_tree_get_match_statistics (guint64 *n_rejected,
+                                             guint64 *n_matches)
+{
+  if (n_rejected)
+    *n_rejected = n_rejected_by_ancestor_filter;
+  if (n_matches)
+    *n_matches = n_matched;
+}
+
 /* When checking for changes via the tree we need to know if a rule further
    down the tree matched, because if so we need to add "our bit" to the
    Change. For instance in a a match like *.class:active we'll
@@ -1728,6 +1804,8 @@ alloc_tree (GByteArray *array, gint32 *offset)
 {
   GtkCssSelectorTree tree = { { NULL} };
 
+  tree.ancestor_filter_offset = GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+
   *offset = array->len;
   g_byte_array_append (array, (guint8 *)&tree, sizeof (GtkCssSelectorTree));
   return get_tree (array, *offset);
@@ -1837,6 +1915,125 @@ subdivide_infos (GByteArray *array, GList *infos, gint32 parent_offset)
   return tree_offset;
 }
 
+/* The hashes an element must provide for @selector to match it */
+static void
+gtk_css_selector_add_own_hashes (const GtkCssSelector *selector,
+                                 GtkCssAncestorFilter *filter)
+{
+  if (selector->class == &GTK_CSS_SELECTOR_NAME)
+    _gtk_css_ancestor_filter_add_hash (filter, _gtk_css_ancestor_filter_hash_name (selector->name.name));
+  else if (selector->class == &GTK_CSS_SELECTOR_CLASS)
+    _gtk_css_ancestor_filter_add_hash (filter, _gtk_css_ancestor_filter_hash_class (selector->style_class.style_class));
+  else if (selector->class == &GTK_CSS_SELECTOR_ID)
+    _gtk_css_ancestor_filter_add_hash (filter, _gtk_css_ancestor_filter_hash_id (selector->id.name));
+}
+
+static void
+gtk_css_ancestor_filter_intersect (GtkCssAncestorFilter       *filter,
+                                   const GtkCssAncestorFilter *other)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_ANCESTOR_FILTER_WORDS; i++)
+    filter->bits[i] &= other->bits[i];
+}
+
+/* Computes the hashes that the ancestors of the matcher passed to
+ * gtk_css_selector_foreach() must contain for any match in the
+ * subtree starting at @offset, and stores them with the tree.
+ * @element_required is set to the hashes that the matched element
+ * or its ancestors must contain.
+ *
+ * Sibling combinators are treated as requiring nothing, as the
+ * previous sibling may not be matched by a node matcher.
+ */
+static void
+compute_ancestor_filters (GByteArray           *array,
+                          gint32                offset,
+                          GtkCssAncestorFilter *element_required)
+{
+  GtkCssAncestorFilter prev_ancestors, prev_element;
+  GtkCssAncestorFilter ancestors, element;
+  GtkCssSelectorTree *tree;
+  const GtkCssSelectorClass *class;
+  gint32 prev;
+  gboolean first;
+
+  memset (&prev_ancestors, 0, sizeof (GtkCssAncestorFilter));
+  memset (&prev_element, 0, sizeof (GtkCssAncestorFilter));
+
+  first = TRUE;
+  for (prev = get_tree (array, offset)->previous_offset;
+       prev != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+       prev = get_tree (array, prev)->sibling_offset)
+    {
+      compute_ancestor_filters (array, prev, &element);
+
+      if (get_tree (array, prev)->ancestor_filter_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        ancestors = *(GtkCssAncestorFilter *) (array->data + get_tree (array, prev)->ancestor_filter_offset);
+      else
+        memset (&ancestors, 0, sizeof (GtkCssAncestorFilter));
+
+      if (first)
+        {
+          prev_ancestors = ancestors;
+          prev_element = element;
+          first = FALSE;
+        }
+      else
+        {
+          gtk_css_ancestor_filter_intersect (&prev_ancestors, &ancestors);
+          gtk_css_ancestor_filter_intersect (&prev_element, &element);
+        }
+    }
+
+  tree = get_tree (array, offset);
+  class = tree->selector.class;
+
+  /* A match at this node requires nothing from the previous ones */
+  if (tree->matches_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+    {
+      memset (&prev_ancestors, 0, sizeof (GtkCssAncestorFilter));
+      memset (&prev_element, 0, sizeof (GtkCssAncestorFilter));
+    }
+
+  if (class == &GTK_CSS_SELECTOR_DESCENDANT ||
+      class == &GTK_CSS_SELECTOR_CHILD)
+    {
+      /* previous selectors match on an ancestor */
+      ancestors = prev_element;
+      element = prev_element;
+    }
+  else if (class == &GTK_CSS_SELECTOR_SIBLING ||
+           class == &GTK_CSS_SELECTOR_ADJACENT)
+    {
+      memset (&ancestors, 0, sizeof (GtkCssAncestorFilter));
+      memset (&element, 0, sizeof (GtkCssAncestorFilter));
+    }
+  else
+    {
+      ancestors = prev_ancestors;
+      element = prev_element;
+      gtk_css_selector_add_own_hashes (&tree->selector, &element);
+    }
+
+  if (!_gtk_css_ancestor_filter_is_empty (&ancestors))
+    {
+      static const guint8 padding[sizeof (guint64)] = { 0, };
+      gint32 filter_offset;
+
+      /* keep the filter aligned */
+      if (array->len % sizeof (guint64))
+        g_byte_array_append (array, padding, sizeof (guint64) - array->len % sizeof (guint64));
+
+      filter_offset = array->len;
+      g_byte_array_append (array, (guint8 *)&ancestors, sizeof (GtkCssAncestorFilter));
+      get_tree (array, offset)->ancestor_filter_offset = filter_offset;
+    }
+
+  *element_required = element;
+}
+
 struct _GtkCssSelectorTreeBuilder {
   GList  *infos;
 };
@@ -1886,6 +2083,9 @@ fixup_offsets (GtkCssSelectorTree *tree, guint8 *data)
       if (tree->matches_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
 	tree->matches_offset -= ((guint8 *)tree - data);
 
+      if (tree->ancestor_filter_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+	tree->ancestor_filter_offset -= ((guint8 *)tree - data);
+
       fixup_offsets ((GtkCssSelectorTree *)gtk_css_selector_tree_get_previous (tree), data);
 
       tree = (GtkCssSelectorTree *)gtk_css_selector_tree_get_sibling (tree);
@@ -1901,10 +2101,17 @@ _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder)
   guint len;
   GList *l;
   GtkCssSelectorRuleSetInfo *info;
+  GtkCssAncestorFilter unused;
+  gint32 offset;
 
   array = g_byte_array_new ();
   subdivide_infos (array, builder->infos, GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET);
 
+  for (offset = array->len > 0 ? 0 : GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+       offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+       offset = get_tree (array, offset)->sibling_offset)
+    compute_ancestor_filters (array, offset, &unused);
+
   len = array->len;
   data = g_byte_array_free (array, FALSE);
 
@@ -1934,3 +2141,359 @@ _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder)
 
   return tree;
 }
+
+/* SERIALIZATION */
+
+/* The serialized form of a tree is a copy of its memory with all
+ * pointers replaced by indexes: selector classes index into
+ * selector_classes, names, ids and style classes index into a string
+ * array and matches are replaced by their index plus one, so that
+ * the match arrays stay %NULL-terminated.
+ */
+static const GtkCssSelectorClass *selector_classes[] = {
+  &GTK_CSS_SELECTOR_DESCENDANT,
+  &GTK_CSS_SELECTOR_CHILD,
+  &GTK_CSS_SELECTOR_SIBLING,
+  &GTK_CSS_SELECTOR_ADJACENT,
+  &GTK_CSS_SELECTOR_ANY,
+  &GTK_CSS_SELECTOR_NOT_ANY,
+  &GTK_CSS_SELECTOR_NAME,
+  &GTK_CSS_SELECTOR_NOT_NAME,
+  &GTK_CSS_SELECTOR_CLASS,
+  &GTK_CSS_SELECTOR_NOT_CLASS,
+  &GTK_CSS_SELECTOR_ID,
+  &GTK_CSS_SELECTOR_NOT_ID,
+  &GTK_CSS_SELECTOR_PSEUDOCLASS_STATE,
+  &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_STATE,
+  &GTK_CSS_SELECTOR_PSEUDOCLASS_POSITION,
+  &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_POSITION
+};
+
+typedef struct {
+  GtkCssSelectorTreeMatchIndexFunc func;
+  gpointer data;
+  GHashTable *string_ids;
+  GPtrArray *strings;
+} SerializeData;
+
+typedef struct {
+  GtkCssSelectorTreeMatchFunc func;
+  gpointer data;
+  const char **strings;
+  gsize n_strings;
+} DeserializeData;
+
+static gsize
+gtk_css_selector_tree_get_extent (const GtkCssSelectorTree *tree,
+                                  const guint8             *data)
+{
+  gpointer *matches;
+  gsize extent, end;
+  guint i;
+
+  extent = 0;
+
+  for (; tree != NULL; tree = gtk_css_selector_tree_get_sibling (tree))
+    {
+      end = (const guint8 *) tree - data + sizeof (GtkCssSelectorTree);
+      extent = MAX (extent, end);
+
+      matches = gtk_css_selector_tree_get_matches (tree);
+      if (matches)
+        {
+          for (i = 0; matches[i] != NULL; i++)
+            ;
+          end = (const guint8 *) &matches[i + 1] - data;
+          extent = MAX (extent, end);
+        }
+
+      if (tree->ancestor_filter_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        {
+          end = (const guint8 *) gtk_css_selector_tree_get_ancestor_filter (tree) - data + sizeof (GtkCssAncestorFilter);
+          extent = MAX (extent, end);
+        }
+
+      end = gtk_css_selector_tree_get_extent (gtk_css_selector_tree_get_previous (tree), data);
+      extent = MAX (extent, end);
+    }
+
+  return extent;
+}
+
+static gsize
+serialize_string (SerializeData *sd,
+                  const char    *string)
+{
+  gpointer id;
+
+  if (g_hash_table_lookup_extended (sd->string_ids, string, NULL, &id))
+    return GPOINTER_TO_SIZE (id);
+
+  id = GSIZE_TO_POINTER (sd->strings->len);
+  g_ptr_array_add (sd->strings, (gpointer) string);
+  g_hash_table_insert (sd->string_ids, (gpointer) string, id);
+
+  return GPOINTER_TO_SIZE (id);
+}
+
+static void
+gtk_css_selector_tree_serialize_node (GtkCssSelectorTree *tree,
+                                      SerializeData      *sd)
+{
+  const GtkCssSelectorClass *class;
+  gpointer *matches;
+  guint i;
+
+  for (; tree != NULL; tree = (GtkCssSelectorTree *) gtk_css_selector_tree_get_sibling (tree))
+    {
+      class = tree->selector.class;
+
+      if (class == &GTK_CSS_SELECTOR_NAME || class == &GTK_CSS_SELECTOR_NOT_NAME)
+        tree->selector.name.name = GSIZE_TO_POINTER (serialize_string (sd, tree->selector.name.name));
+      else if (class == &GTK_CSS_SELECTOR_ID || class == &GTK_CSS_SELECTOR_NOT_ID)
+        tree->selector.id.name = GSIZE_TO_POINTER (serialize_string (sd, tree->selector.id.name));
+      else if (class == &GTK_CSS_SELECTOR_CLASS || class == &GTK_CSS_SELECTOR_NOT_CLASS)
+        tree->selector.style_class.style_class = serialize_string (sd, g_quark_to_string (tree->selector.style_class.style_class));
+
+      for (i = 0; i < G_N_ELEMENTS (selector_classes); i++)
+        {
+          if (selector_classes[i] == class)
+            break;
+        }
+      g_assert (i < G_N_ELEMENTS (selector_classes));
+      tree->selector.class = GSIZE_TO_POINTER (i);
+
+      matches = gtk_css_selector_tree_get_matches (tree);
+      if (matches)
+        {
+          for (i = 0; matches[i] != NULL; i++)
+            matches[i] = GSIZE_TO_POINTER ((gsize) sd->func (matches[i], sd->data) + 1);
+        }
+
+      gtk_css_selector_tree_serialize_node ((GtkCssSelectorTree *) gtk_css_selector_tree_get_previous (tree), sd);
+    }
+}
+
+/**
+ * _gtk_css_selector_tree_serialize:
+ * @tree: (allow-none): the tree to serialize
+ * @func: function returning the index of a match
+ * @data: data to pass to @func
+ *
+ * Serializes @tree into a #GVariant of type "(ayas)" that can be
+ * turned back into a tree with _gtk_css_selector_tree_deserialize().
+ * The serialized form is only valid for the running GTK+ version
+ * and architecture.
+ *
+ * Returns: (transfer floating): the serialized tree
+ */
+GVariant *
+_gtk_css_selector_tree_serialize (const GtkCssSelectorTree         *tree,
+                                  GtkCssSelectorTreeMatchIndexFunc  func,
+                                  gpointer                          data)
+{
+  SerializeData sd;
+  GVariant *result;
+  guint8 *copy;
+  gsize size;
+
+  size = gtk_css_selector_tree_get_extent (tree, (const guint8 *) tree);
+  copy = g_memdup (tree, size);
+
+  sd.func = func;
+  sd.data = data;
+  sd.string_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  sd.strings = g_ptr_array_new ();
+
+  if (size > 0)
+    gtk_css_selector_tree_serialize_node ((GtkCssSelectorTree *) copy, &sd);
+
+  result = g_variant_new ("(@ay^as)",
+                          g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, copy, size, 1),
+                          (const char * const *) sd.strings->pdata,
+                          (gssize) sd.strings->len);
+
+  g_ptr_array_free (sd.strings, TRUE);
+  g_hash_table_unref (sd.string_ids);
+  g_free (copy);
+
+  return result;
+}
+
+static gboolean
+gtk_css_selector_tree_offset_is_valid (gsize  offset,
+                                       gint32 relative,
+                                       gsize  length,
+                                       gsize  alignment,
+                                       gsize  size)
+{
+  /* Everything but the parent is stored after the node itself */
+  if (relative <= 0)
+    return FALSE;
+
+  offset += relative;
+
+  return offset % alignment == 0 &&
+         offset <= size &&
+         length <= size - offset;
+}
+
+static gboolean
+gtk_css_selector_tree_deserialize_node (guint8          *data,
+                                        gsize            size,
+                                        gsize            offset,
+                                        DeserializeData *dd)
+{
+  GtkCssSelectorTree *tree;
+  const GtkCssSelectorClass *class;
+  gpointer *matches;
+  gsize index, i;
+
+  while (TRUE)
+    {
+      if (offset % G_ALIGNOF (GtkCssSelectorTree) != 0 ||
+          offset > size ||
+          sizeof (GtkCssSelectorTree) > size - offset)
+        return FALSE;
+
+      tree = (GtkCssSelectorTree *) (data + offset);
+
+      index = GPOINTER_TO_SIZE (tree->selector.class);
+      if (index >= G_N_ELEMENTS (selector_classes))
+        return FALSE;
+      class = selector_classes[index];
+      tree->selector.class = class;
+
+      if (class == &GTK_CSS_SELECTOR_NAME || class == &GTK_CSS_SELECTOR_NOT_NAME)
+        {
+          index = GPOINTER_TO_SIZE (tree->selector.name.name);
+          if (index >= dd->n_strings)
+            return FALSE;
+          tree->selector.name.name = dd->strings[index];
+        }
+      else if (class == &GTK_CSS_SELECTOR_ID || class == &GTK_CSS_SELECTOR_NOT_ID)
+        {
+          index = GPOINTER_TO_SIZE (tree->selector.id.name);
+          if (index >= dd->n_strings)
+            return FALSE;
+          tree->selector.id.name = dd->strings[index];
+        }
+      else if (class == &GTK_CSS_SELECTOR_CLASS || class == &GTK_CSS_SELECTOR_NOT_CLASS)
+        {
+          index = tree->selector.style_class.style_class;
+          if (index >= dd->n_strings)
+            return FALSE;
+          tree->selector.style_class.style_class = g_quark_from_string (dd->strings[index]);
+        }
+
+      if (tree->parent_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET &&
+          (tree->parent_offset >= 0 || (gsize) -(gssize) tree->parent_offset > offset))
+        return FALSE;
+
+      if (tree->matches_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        {
+          if (!gtk_css_selector_tree_offset_is_valid (offset, tree->matches_offset,
+                                                      sizeof (gpointer), G_ALIGNOF (gpointer), size))
+            return FALSE;
+
+          matches = gtk_css_selector_tree_get_matches (tree);
+          for (i = 0; ; i++)
+            {
+              if (!gtk_css_selector_tree_offset_is_valid (offset, tree->matches_offset + i * sizeof (gpointer),
+                                                          sizeof (gpointer), G_ALIGNOF (gpointer), size))
+                return FALSE;
+
+              index = GPOINTER_TO_SIZE (matches[i]);
+              if (index == 0)
+                break;
+
+              matches[i] = dd->func (index - 1, tree, dd->data);
+              if (matches[i] == NULL)
+                return FALSE;
+            }
+        }
+
+      if (tree->ancestor_filter_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET &&
+          !gtk_css_selector_tree_offset_is_valid (offset, tree->ancestor_filter_offset,
+                                                  sizeof (GtkCssAncestorFilter), sizeof (guint64), size))
+        return FALSE;
+
+      if (tree->previous_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        {
+          if (tree->previous_offset <= 0 ||
+              !gtk_css_selector_tree_deserialize_node (data, size, offset + tree->previous_offset, dd))
+            return FALSE;
+        }
+
+      if (tree->sibling_offset == GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        return TRUE;
+
+      if (tree->sibling_offset <= 0)
+        return FALSE;
+
+      offset += tree->sibling_offset;
+    }
+}
+
+/**
+ * _gtk_css_selector_tree_deserialize:
+ * @variant: a #GVariant created by _gtk_css_selector_tree_serialize()
+ * @func: function returning the match for an index
+ * @data: data to pass to @func
+ * @out_tree: (out): return location for the tree
+ *
+ * Recreates a tree from its serialized form. @func is called for
+ * every match in the tree together with the tree node the match
+ * belongs to, so callers can set up their selector matches.
+ *
+ * Returns: %FALSE if @variant was not a valid tree
+ */
+gboolean
+_gtk_css_selector_tree_deserialize (GVariant                     *variant,
+                                    GtkCssSelectorTreeMatchFunc   func,
+                                    gpointer                      data,
+                                    GtkCssSelectorTree          **out_tree)
+{
+  DeserializeData dd;
+  GVariant *bytes;
+  const char **strings;
+  const guint8 *blob;
+  guint8 *copy;
+  gsize size, i;
+  gboolean result;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("(ayas)")))
+    return FALSE;
+
+  g_variant_get (variant, "(@ay^a&s)", &bytes, &strings);
+
+  blob = g_variant_get_fixed_array (bytes, &size, 1);
+
+  dd.func = func;
+  dd.data = data;
+  dd.n_strings = g_strv_length ((char **) strings);
+  dd.strings = g_new (const char *, dd.n_strings);
+  for (i = 0; i < dd.n_strings; i++)
+    dd.strings[i] = g_intern_string (strings[i]);
+
+  if (size > 0)
+    {
+      copy = g_memdup (blob, size);
+      result = gtk_css_selector_tree_deserialize_node (copy, size, 0, &dd);
+      if (!result)
+        g_clear_pointer (&copy, g_free);
+    }
+  else
+    {
+      copy = NULL;
+      result = TRUE;
+    }
+
+  *out_tree = (GtkCssSelectorTree *) copy;
+
+  g_free (dd.strings);
+  g_free (strings);
+  g_variant_unref (bytes);
+
+  return result;
+}
@@ -27,6 +27,12 @@ typedef union _GtkCssSelector GtkCssSelector;
 typedef struct _GtkCssSelectorTree GtkCssSelectorTree;
 typedef struct _GtkCssSelectorTreeBuilder GtkCssSelectorTreeBuilder;
 
+typedef guint    (* GtkCssSelectorTreeMatchIndexFunc) (gpointer                  match,
+                                                       gpointer                  data);
+typedef gpointer (* GtkCssSelectorTreeMatchFunc)      (guint                     index,
+                                                       const GtkCssSelectorTree *tree,
+                                                       gpointer                  data);
+
 GtkCssSelector *  _gtk_css_selector_parse           (GtkCssParser           *parser);
 void              _gtk_css_selector_free            (GtkCssSelector         *selector);
 
@@ -39,6 +45,8 @@ gboolean          _gtk_css_selector_matches         (const GtkCssSelector   *sel
 GtkCssChange      _gtk_css_selector_get_change      (const GtkCssSelector   *selector);
 int               _gtk_css_selector_compare         (const GtkCssSelector   *a,
                                                      const GtkCssSelector   *b);
+gboolean          _gtk_css_selector_equal           (const GtkCssSelector   *a,
+                                                     const GtkCssSelector   *b);
 
 void         _gtk_css_selector_tree_free             (GtkCssSelectorTree       *tree);
 GPtrArray *  _gtk_css_selector_tree_match_all        (const GtkCssSelectorTree *tree,
@@ -47,6 +55,16 @@ GtkCssChange _gtk_css_selector_tree_get_change_all   (const GtkCssSelectorTree *
 						      const GtkCssMatcher *matcher);
 void         _gtk_css_selector_tree_match_print      (const GtkCssSelectorTree *tree,
 						      GString                  *str);
+void         _gtk_css_selector_tree_get_match_statistics (guint64              *n_rejected,
+                                                          guint64              *n_matches);
+
+GVariant *   _gtk_css_selector_tree_serialize        (const GtkCssSelectorTree *tree,
+                                                      GtkCssSelectorTreeMatchIndexFunc func,
+                                                      gpointer                  data);
+gboolean     _gtk_css_selector_tree_deserialize      (GVariant                 *variant,
+                                                      GtkCssSelectorTreeMatchFunc func,
+                                                      gpointer                  data,
+                                                      GtkCssSelectorTree      **out_tree);
 
 
 GtkCssSelectorTreeBuilder *_gtk_css_selector_tree_builder_new   (void);
@@ -199,12 +199,25 @@ gtk_css_value_shadows_print (const GtkCssValue *value,
     }
 }
 
+static GVariant *
+gtk_css_value_shadows_serialize (const GtkCssValue *value)
+{
+  GVariant *array;
+
+  array = _gtk_css_value_serialize_array (value->values, value->len);
+  if (array == NULL)
+    return NULL;
+
+  return g_variant_new ("(sv)", "shadows", array);
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_SHADOWS = {
   gtk_css_value_shadows_free,
   gtk_css_value_shadows_compute,
   gtk_css_value_shadows_equal,
   gtk_css_value_shadows_transition,
-  gtk_css_value_shadows_print
+  gtk_css_value_shadows_print,
+  gtk_css_value_shadows_serialize
 };
 
 static GtkCssValue none_singleton = { &GTK_CSS_VALUE_SHADOWS, 1, 0, { NULL } };
@@ -231,6 +244,27 @@ gtk_css_shadows_value_new (GtkCssValue **values,
   return result;
 }
 
+GtkCssValue *
+gtk_css_shadows_value_deserialize (GVariant *variant)
+{
+  GtkCssValue **values;
+  GtkCssValue *result;
+  guint len;
+
+  if (g_variant_is_of_type (variant, G_VARIANT_TYPE ("av")) &&
+      g_variant_n_children (variant) == 0)
+    return _gtk_css_shadows_value_new_none ();
+
+  values = _gtk_css_value_deserialize_array (variant, &len);
+  if (values == NULL)
+    return NULL;
+
+  result = gtk_css_shadows_value_new (values, len);
+  g_free (values);
+
+  return result;
+}
+
 GtkCssValue *
 _gtk_css_shadows_value_parse (GtkCssParser *parser,
                               gboolean      box_shadow_mode)
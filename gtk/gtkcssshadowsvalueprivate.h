@@ -31,6 +31,7 @@
 G_BEGIN_DECLS
 
 GtkCssValue *   _gtk_css_shadows_value_new_none       (void);
+GtkCssValue *   gtk_css_shadows_value_deserialize     (GVariant                 *variant);
 GtkCssValue *   _gtk_css_shadows_value_parse          (GtkCssParser             *parser,
                                                        gboolean                  box_shadow_mode);
 
@@ -30,6 +30,7 @@
 #include "gtkpango.h"
 
 #include <math.h>
+#include <string.h>
 
 struct _GtkCssValue {
   GTK_CSS_VALUE_BASE
@@ -152,12 +153,26 @@ gtk_css_value_shadow_print (const GtkCssValue *shadow,
 
 }
 
+static GVariant *
+gtk_css_value_shadow_serialize (const GtkCssValue *shadow)
+{
+  GtkCssValue *values[5] = { shadow->hoffset, shadow->voffset, shadow->radius, shadow->spread, shadow->color };
+  GVariant *array;
+
+  array = _gtk_css_value_serialize_array (values, 5);
+  if (array == NULL)
+    return NULL;
+
+  return g_variant_new ("(sv)", "shadow", g_variant_new ("(b@av)", shadow->inset, array));
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_SHADOW = {
   gtk_css_value_shadow_free,
   gtk_css_value_shadow_compute,
   gtk_css_value_shadow_equal,
   gtk_css_value_shadow_transition,
-  gtk_css_value_shadow_print
+  gtk_css_value_shadow_print,
+  gtk_css_value_shadow_serialize
 };
 
 static GtkCssValue *
@@ -197,6 +212,38 @@ _gtk_css_shadow_value_new_for_transition (GtkCssValue *target)
                                    _gtk_css_rgba_value_new_from_rgba (&transparent));
 }
 
+GtkCssValue *
+gtk_css_shadow_value_deserialize (GVariant *variant)
+{
+  GtkCssValue **values;
+  GtkCssValue *result;
+  GVariant *array;
+  gboolean inset;
+  guint n_values;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("(bav)")))
+    return NULL;
+
+  g_variant_get (variant, "(b@av)", &inset, &array);
+  values = _gtk_css_value_deserialize_array (array, &n_values);
+  g_variant_unref (array);
+  if (values == NULL)
+    return NULL;
+
+  if (n_values != 5)
+    {
+      while (n_values-- > 0)
+        _gtk_css_value_unref (values[n_values]);
+      g_free (values);
+      return NULL;
+    }
+
+  result = gtk_css_shadow_value_new (values[0], values[1], values[2], values[3], inset, values[4]);
+  g_free (values);
+
+  return result;
+}
+
 static gboolean
 value_is_done_parsing (GtkCssParser *parser)
 {
@@ -662,27 +709,160 @@ draw_shadow (const GtkCssValue   *shadow,
     gtk_css_shadow_value_finish_drawing (shadow, shadow_cr, blur_flags);
 }
 
+/* Blurred masks for the corners and sides of box shadows only depend
+ * on a few parameters, so we keep the ones we rendered around instead
+ * of blurring them again for every frame. The cache is shared by all
+ * shadows and bounded in size, the least recently used masks are
+ * dropped first.
+ */
+#define SHADOW_MASK_CACHE_MAX_SIZE (4 * 1024 * 1024)
+
+typedef enum {
+  SHADOW_MASK_CORNER,
+  SHADOW_MASK_SIDE_HORIZONTAL,
+  SHADOW_MASK_SIDE_VERTICAL
+} ShadowMaskKind;
+
 typedef struct {
+  ShadowMaskKind kind;
+  guint inset : 1;
+  int scale;
   double radius;
-  GtkRoundedBoxCorner corner;
-} CornerMask;
+  /* For corners, the horizontal and vertical corner radius.
+   * For sides, the edges of the box and, for inset shadows,
+   * the clip box, relative to the start of the mask. */
+  double p[4];
+} ShadowMaskKey;
+
+typedef struct {
+  ShadowMaskKey key;
+  GList link;
+  cairo_surface_t *surface;
+  gsize size;
+} ShadowMask;
+
+static GHashTable *shadow_mask_cache = NULL;
+static GQueue shadow_mask_lru = G_QUEUE_INIT;
+static gsize shadow_mask_cache_size = 0;
 
 static guint
-corner_mask_hash (CornerMask *mask)
+shadow_mask_key_hash (gconstpointer data)
 {
-  return ((guint)mask->radius << 24) ^
-    ((guint)(mask->corner.horizontal*4)) << 12 ^
-    ((guint)(mask->corner.vertical*4)) << 0;
+  const ShadowMaskKey *key = data;
+  guint hash;
+  int i;
+
+  hash = key->kind | (key->inset << 2) | (key->scale << 3);
+  hash = hash * 31 + (guint) (key->radius * 4);
+  for (i = 0; i < G_N_ELEMENTS (key->p); i++)
+    hash = hash * 31 + (guint) (key->p[i] * 4);
+
+  return hash;
 }
 
 static gboolean
-corner_mask_equal (CornerMask *mask1,
-                   CornerMask *mask2)
+shadow_mask_key_equal (gconstpointer data1,
+                       gconstpointer data2)
+{
+  const ShadowMaskKey *key1 = data1;
+  const ShadowMaskKey *key2 = data2;
+
+  return key1->kind == key2->kind &&
+         key1->inset == key2->inset &&
+         key1->scale == key2->scale &&
+         key1->radius == key2->radius &&
+         key1->p[0] == key2->p[0] &&
+         key1->p[1] == key2->p[1] &&
+         key1->p[2] == key2->p[2] &&
+         key1->p[3] == key2->p[3];
+}
+
+static void
+shadow_mask_free (gpointer data)
+{
+  ShadowMask *mask = data;
+
+  cairo_surface_destroy (mask->surface);
+  g_slice_free (ShadowMask, mask);
+}
+
+static cairo_surface_t *
+shadow_mask_cache_lookup (const ShadowMaskKey *key)
+{
+  ShadowMask *mask;
+
+  if (shadow_mask_cache == NULL)
+    return NULL;
+
+  mask = g_hash_table_lookup (shadow_mask_cache, key);
+  if (mask == NULL)
+    return NULL;
+
+  g_queue_unlink (&shadow_mask_lru, &mask->link);
+  g_queue_push_head_link (&shadow_mask_lru, &mask->link);
+
+  return mask->surface;
+}
+
+/* Takes ownership of surface */
+static void
+shadow_mask_cache_insert (const ShadowMaskKey *key,
+                          cairo_surface_t     *surface)
+{
+  ShadowMask *mask;
+
+  if (shadow_mask_cache == NULL)
+    shadow_mask_cache = g_hash_table_new_full (shadow_mask_key_hash,
+                                               shadow_mask_key_equal,
+                                               NULL, shadow_mask_free);
+
+  mask = g_slice_new0 (ShadowMask);
+  mask->key = *key;
+  mask->link.data = mask;
+  mask->surface = surface;
+  mask->size = cairo_image_surface_get_stride (surface) * cairo_image_surface_get_height (surface);
+
+  /* Make room, but never evict the mask we are about to use */
+  while (shadow_mask_lru.length > 0 &&
+         shadow_mask_cache_size + mask->size > SHADOW_MASK_CACHE_MAX_SIZE)
+    {
+      ShadowMask *old = shadow_mask_lru.tail->data;
+
+      g_queue_unlink (&shadow_mask_lru, &old->link);
+      shadow_mask_cache_size -= old->size;
+      g_hash_table_remove (shadow_mask_cache, &old->key);
+    }
+
+  g_hash_table_insert (shadow_mask_cache, &mask->key, mask);
+  g_queue_push_head_link (&shadow_mask_lru, &mask->link);
+  shadow_mask_cache_size += mask->size;
+}
+
+static int
+get_device_scale (cairo_t *cr)
 {
-  return
-    mask1->radius == mask2->radius &&
-    mask1->corner.horizontal == mask2->corner.horizontal &&
-    mask1->corner.vertical == mask2->corner.vertical;
+  double x_scale = 1;
+
+  cairo_surface_get_device_scale (cairo_get_target (cr), &x_scale, NULL);
+
+  return MAX (1, (int) x_scale);
+}
+
+/* Creates an A8 surface of the given size in user space,
+ * with enough pixels for the device scale */
+static cairo_surface_t *
+create_mask_surface (cairo_t *cr,
+                     int      width,
+                     int      height,
+                     int      scale)
+{
+  cairo_surface_t *surface;
+
+  surface = cairo_surface_create_similar_image (cairo_get_target (cr), CAIRO_FORMAT_A8,
+                                                width * scale, height * scale);
+  cairo_surface_set_device_scale (surface, scale, scale);
+
+  return surface;
 }
 
 static void
@@ -701,10 +881,10 @@ draw_shadow_corner (const GtkCssValue   *shadow,
   cairo_pattern_t *pattern;
   cairo_matrix_t matrix;
   double sx, sy;
-  static GHashTable *corner_mask_cache = NULL;
   double max_other;
-  CornerMask key;
+  ShadowMaskKey key;
   gboolean overlapped;
+  int scale;
 
   radius = _gtk_css_number_value_get (shadow->radius, 0);
   clip_radius = _gtk_cairo_blur_compute_pixels (radius);
@@ -787,31 +967,33 @@ draw_shadow_corner (const GtkCssValue   *shadow,
    * The the horizontal and vertical corner radius
    *
    * We apply the first position and orientation when drawing the
-   * mask, so we cache rendered masks based on the blur radius and the
-   * corner radius.
+   * mask, so we cache rendered masks based on the blur radius, the
+   * corner radius and the device scale we render at.
    */
-  if (corner_mask_cache == NULL)
-    corner_mask_cache = g_hash_table_new_full ((GHashFunc)corner_mask_hash,
-                                               (GEqualFunc)corner_mask_equal,
-                                               g_free, (GDestroyNotify)cairo_surface_destroy);
+  scale = get_device_scale (cr);
 
+  memset (&key, 0, sizeof (key));
+  key.kind = SHADOW_MASK_CORNER;
+  key.scale = scale;
   key.radius = radius;
-  key.corner = box->corner[corner];
+  key.p[0] = box->corner[corner].horizontal;
+  key.p[1] = box->corner[corner].vertical;
 
-  mask = g_hash_table_lookup (corner_mask_cache, &key);
+  mask = shadow_mask_cache_lookup (&key);
   if (mask == NULL)
     {
-      mask = cairo_surface_create_similar_image (cairo_get_target (cr), CAIRO_FORMAT_A8,
-                                                 drawn_rect->width + clip_radius,
-                                                 drawn_rect->height + clip_radius);
+      mask = create_mask_surface (cr,
+                                  drawn_rect->width + clip_radius,
+                                  drawn_rect->height + clip_radius,
+                                  scale);
       mask_cr = cairo_create (mask);
       _gtk_rounded_box_init_rect (&corner_box, clip_radius, clip_radius, 2*drawn_rect->width, 2*drawn_rect->height);
       corner_box.corner[0] = box->corner[corner];
       _gtk_rounded_box_path (&corner_box, mask_cr);
       cairo_fill (mask_cr);
-      _gtk_cairo_blur_surface (mask, radius, GTK_BLUR_X | GTK_BLUR_Y);
+      _gtk_cairo_blur_surface (mask, radius * scale, GTK_BLUR_X | GTK_BLUR_Y);
       cairo_destroy (mask_cr);
-      g_hash_table_insert (corner_mask_cache, g_memdup (&key, sizeof (key)), mask);
+      shadow_mask_cache_insert (&key, mask);
     }
 
   gdk_cairo_set_source_rgba (cr, _gtk_css_rgba_value_get_rgba (shadow->color));
@@ -835,6 +1017,13 @@ draw_shadow_side (const GtkCssValue   *shadow,
   GtkBlurFlags blur_flags = GTK_BLUR_REPEAT;
   gdouble radius, clip_radius;
   int x1, x2, y1, y2;
+  double start, length, box_start, box_end, clip_start, clip_end;
+  cairo_surface_t *mask;
+  cairo_pattern_t *pattern;
+  cairo_matrix_t matrix;
+  cairo_t *mask_cr;
+  ShadowMaskKey key;
+  int scale;
 
   radius = _gtk_css_number_value_get (shadow->radius, 0);
   clip_radius = _gtk_cairo_blur_compute_pixels (radius);
@@ -880,7 +1069,87 @@ draw_shadow_side (const GtkCssValue   *shadow,
 
   cairo_rectangle (cr, x1, y1, x2 - x1, y2 - y1);
   cairo_clip (cr);
-  draw_shadow (shadow, cr, box, clip_box, blur_flags);
+
+  if (has_empty_clip (cr))
+    return;
+
+  /* Between the corners, the box edges are straight, so the blurred
+   * shadow is the same along the side. We render a one pixel thick
+   * profile across the side, padded so the blur sees everything
+   * within its reach, and repeat it along the side. The profile only
+   * depends on where the box (and, for inset shadows, the clip box)
+   * edges are relative to it, which is what we cache it by. */
+  scale = get_device_scale (cr);
+  if (blur_flags & GTK_BLUR_Y)
+    {
+      start = y1 - clip_radius;
+      length = y2 - y1 + 2 * clip_radius;
+      box_start = box->box.y;
+      box_end = box->box.y + box->box.height;
+      clip_start = clip_box->box.y;
+      clip_end = clip_box->box.y + clip_box->box.height;
+    }
+  else
+    {
+      start = x1 - clip_radius;
+      length = x2 - x1 + 2 * clip_radius;
+      box_start = box->box.x;
+      box_end = box->box.x + box->box.width;
+      clip_start = clip_box->box.x;
+      clip_end = clip_box->box.x + clip_box->box.width;
+    }
+
+  memset (&key, 0, sizeof (key));
+  key.kind = (blur_flags & GTK_BLUR_Y) ? SHADOW_MASK_SIDE_VERTICAL : SHADOW_MASK_SIDE_HORIZONTAL;
+  key.inset = shadow->inset;
+  key.scale = scale;
+  key.radius = radius;
+  key.p[0] = CLAMP (box_start - start, 0, length);
+  key.p[1] = CLAMP (box_end - start, 0, length);
+  if (shadow->inset)
+    {
+      key.p[2] = CLAMP (clip_start - start, 0, length);
+      key.p[3] = CLAMP (clip_end - start, 0, length);
+    }
+
+  mask = shadow_mask_cache_lookup (&key);
+  if (mask == NULL)
+    {
+      if (blur_flags & GTK_BLUR_Y)
+        mask = create_mask_surface (cr, 1, length, scale);
+      else
+        mask = create_mask_surface (cr, length, 1, scale);
+
+      mask_cr = cairo_create (mask);
+      cairo_set_fill_rule (mask_cr, CAIRO_FILL_RULE_EVEN_ODD);
+      if (blur_flags & GTK_BLUR_Y)
+        {
+          cairo_rectangle (mask_cr, 0, key.p[0], 1, key.p[1] - key.p[0]);
+          if (shadow->inset)
+            cairo_rectangle (mask_cr, 0, key.p[2], 1, key.p[3] - key.p[2]);
+        }
+      else
+        {
+          cairo_rectangle (mask_cr, key.p[0], 0, key.p[1] - key.p[0], 1);
+          if (shadow->inset)
+            cairo_rectangle (mask_cr, key.p[2], 0, key.p[3] - key.p[2], 1);
+        }
+      cairo_fill (mask_cr);
+      cairo_destroy (mask_cr);
+      _gtk_cairo_blur_surface (mask, radius * scale, blur_flags & (GTK_BLUR_X | GTK_BLUR_Y));
+      shadow_mask_cache_insert (&key, mask);
+    }
+
+  gdk_cairo_set_source_rgba (cr, _gtk_css_rgba_value_get_rgba (shadow->color));
+  pattern = cairo_pattern_create_for_surface (mask);
+  cairo_pattern_set_extend (pattern, CAIRO_EXTEND_REPEAT);
+  if (blur_flags & GTK_BLUR_Y)
+    cairo_matrix_init_translate (&matrix, 0, -start);
+  else
+    cairo_matrix_init_translate (&matrix, -start, 0);
+  cairo_pattern_set_matrix (pattern, &matrix);
+  cairo_mask (cr, pattern);
+  cairo_pattern_destroy (pattern);
 }
 
 void
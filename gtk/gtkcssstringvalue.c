@@ -116,12 +116,25 @@ out:
   ;
 }
 
+static GVariant *
+gtk_css_value_string_serialize (const GtkCssValue *value)
+{
+  return g_variant_new ("(sv)", "string", g_variant_new ("ms", value->string));
+}
+
+static GVariant *
+gtk_css_value_ident_serialize (const GtkCssValue *value)
+{
+  return g_variant_new ("(sv)", "ident", g_variant_new ("ms", value->string));
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_STRING = {
   gtk_css_value_string_free,
   gtk_css_value_string_compute,
   gtk_css_value_string_equal,
   gtk_css_value_string_transition,
-  gtk_css_value_string_print
+  gtk_css_value_string_print,
+  gtk_css_value_string_serialize
 };
 
 static const GtkCssValueClass GTK_CSS_VALUE_IDENT = {
@@ -129,7 +142,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_IDENT = {
   gtk_css_value_string_compute,
   gtk_css_value_string_equal,
   gtk_css_value_string_transition,
-  gtk_css_value_ident_print
+  gtk_css_value_ident_print,
+  gtk_css_value_ident_serialize
 };
 
 GtkCssValue *
@@ -212,3 +226,28 @@ _gtk_css_ident_value_get (const GtkCssValue *value)
   return value->string;
 }
 
+GtkCssValue *
+gtk_css_string_value_deserialize (GVariant *variant)
+{
+  char *string;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("ms")))
+    return NULL;
+
+  g_variant_get (variant, "ms", &string);
+
+  return _gtk_css_string_value_new_take (string);
+}
+
+GtkCssValue *
+gtk_css_ident_value_deserialize (GVariant *variant)
+{
+  char *ident;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("ms")))
+    return NULL;
+
+  g_variant_get (variant, "ms", &ident);
+
+  return _gtk_css_ident_value_new_take (ident);
+}
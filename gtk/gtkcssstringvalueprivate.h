@@ -38,6 +38,9 @@ GtkCssValue *   _gtk_css_string_value_parse         (GtkCssParser           *par
 
 const char *    _gtk_css_string_value_get           (const GtkCssValue      *string);
 
+GtkCssValue *   gtk_css_string_value_deserialize    (GVariant               *variant);
+GtkCssValue *   gtk_css_ident_value_deserialize     (GVariant               *variant);
+
 
 G_END_DECLS
 
@@ -81,12 +81,19 @@ gtk_css_value_unset_print (const GtkCssValue *value,
   g_string_append (string, "unset");
 }
 
+static GVariant *
+gtk_css_value_unset_serialize (const GtkCssValue *value)
+{
+  return g_variant_new ("(sv)", "unset", g_variant_new ("()"));
+}
+
 static const GtkCssValueClass GTK_CSS_VALUE_UNSET = {
   gtk_css_value_unset_free,
   gtk_css_value_unset_compute,
   gtk_css_value_unset_equal,
   gtk_css_value_unset_transition,
-  gtk_css_value_unset_print
+  gtk_css_value_unset_print,
+  gtk_css_value_unset_serialize
 };
 
 static GtkCssValue unset = { &GTK_CSS_VALUE_UNSET, 1 };
@@ -96,3 +103,12 @@ _gtk_css_unset_value_new (void)
 {
   return _gtk_css_value_ref (&unset);
 }
+
+GtkCssValue *
+gtk_css_unset_value_deserialize (GVariant *variant)
+{
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE_UNIT))
+    return NULL;
+
+  return _gtk_css_unset_value_new ();
+}
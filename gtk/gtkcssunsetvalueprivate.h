@@ -25,6 +25,7 @@
 G_BEGIN_DECLS
 
 GtkCssValue *   _gtk_css_unset_value_new            (void);
+GtkCssValue *   gtk_css_unset_value_deserialize     (GVariant *variant);
 
 G_END_DECLS
 
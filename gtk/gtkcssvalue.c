@@ -20,7 +20,18 @@
 #include "gtkprivate.h"
 #include "gtkcssvalueprivate.h"
 
+#include "gtkcssarrayvalueprivate.h"
+#include "gtkcsscolorvalueprivate.h"
+#include "gtkcsscornervalueprivate.h"
+#include "gtkcssdimensionvalueprivate.h"
+#include "gtkcssenumvalueprivate.h"
+#include "gtkcssinheritvalueprivate.h"
+#include "gtkcssinitialvalueprivate.h"
+#include "gtkcssshadowsvalueprivate.h"
+#include "gtkcssshadowvalueprivate.h"
+#include "gtkcssstringvalueprivate.h"
 #include "gtkcssstyleprivate.h"
+#include "gtkcssunsetvalueprivate.h"
 #include "gtkstyleproviderprivate.h"
 
 struct _GtkCssValue {
@@ -175,3 +186,146 @@ _gtk_css_value_print (const GtkCssValue *value,
   value->class->print (value, string);
 }
 
+/**
+ * _gtk_css_value_serialize:
+ * @value: a #GtkCssValue
+ *
+ * Serializes @value so it can be stored, for example in the theme
+ * cache, and restored with _gtk_css_value_deserialize() without
+ * going through the parser again. Only the values themes commonly
+ * use can be serialized.
+ *
+ * Returns: (nullable): a floating #GVariant of type (sv), or %NULL
+ *     if @value can't be serialized
+ */
+GVariant *
+_gtk_css_value_serialize (const GtkCssValue *value)
+{
+  gtk_internal_return_val_if_fail (value != NULL, NULL);
+
+  if (value->class->serialize == NULL)
+    return NULL;
+
+  return value->class->serialize (value);
+}
+
+static const struct {
+  const char *name;
+  GtkCssValue * (* deserialize) (GVariant *variant);
+} deserializers[] = {
+  { "array", gtk_css_array_value_deserialize },
+  { "color", gtk_css_color_value_deserialize },
+  { "corner", gtk_css_corner_value_deserialize },
+  { "dimension", gtk_css_dimension_value_deserialize },
+  { "enum", gtk_css_enum_value_deserialize },
+  { "ident", gtk_css_ident_value_deserialize },
+  { "inherit", gtk_css_inherit_value_deserialize },
+  { "initial", gtk_css_initial_value_deserialize },
+  { "shadow", gtk_css_shadow_value_deserialize },
+  { "shadows", gtk_css_shadows_value_deserialize },
+  { "string", gtk_css_string_value_deserialize },
+  { "unset", gtk_css_unset_value_deserialize }
+};
+
+/**
+ * _gtk_css_value_deserialize:
+ * @variant: a #GVariant returned by _gtk_css_value_serialize()
+ *
+ * Restores a value serialized with _gtk_css_value_serialize().
+ *
+ * Returns: (nullable): the value, or %NULL if @variant is invalid
+ */
+GtkCssValue *
+_gtk_css_value_deserialize (GVariant *variant)
+{
+  GVariant *payload;
+  GtkCssValue *value;
+  const char *name;
+  guint i;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("(sv)")))
+    return NULL;
+
+  g_variant_get (variant, "(&sv)", &name, &payload);
+
+  value = NULL;
+  for (i = 0; i < G_N_ELEMENTS (deserializers); i++)
+    {
+      if (g_str_equal (name, deserializers[i].name))
+        {
+          value = deserializers[i].deserialize (payload);
+          break;
+        }
+    }
+
+  g_variant_unref (payload);
+
+  return value;
+}
+
+/* Serializes @values as an array of type av. Returns %NULL if any
+ * of the values can't be serialized.
+ */
+GVariant *
+_gtk_css_value_serialize_array (GtkCssValue * const *values,
+                                guint                n_values)
+{
+  GVariantBuilder builder;
+  GVariant *child;
+  guint i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("av"));
+  for (i = 0; i < n_values; i++)
+    {
+      child = _gtk_css_value_serialize (values[i]);
+      if (child == NULL)
+        {
+          g_variant_builder_clear (&builder);
+          return NULL;
+        }
+
+      g_variant_builder_add (&builder, "v", child);
+    }
+
+  return g_variant_builder_end (&builder);
+}
+
+/* The counterpart of _gtk_css_value_serialize_array(). Returns a
+ * newly allocated array of values, or %NULL if @variant is invalid
+ * or empty.
+ */
+GtkCssValue **
+_gtk_css_value_deserialize_array (GVariant *variant,
+                                  guint    *n_values)
+{
+  GtkCssValue **values;
+  GVariant *child;
+  guint i, n;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("av")))
+    return NULL;
+
+  n = g_variant_n_children (variant);
+  if (n == 0)
+    return NULL;
+
+  values = g_new (GtkCssValue *, n);
+  for (i = 0; i < n; i++)
+    {
+      g_variant_get_child (variant, i, "v", &child);
+      values[i] = _gtk_css_value_deserialize (child);
+      g_variant_unref (child);
+
+      if (values[i] == NULL)
+        {
+          while (i-- > 0)
+            _gtk_css_value_unref (values[i]);
+          g_free (values);
+          return NULL;
+        }
+    }
+
+  *n_values = n;
+
+  return values;
+}
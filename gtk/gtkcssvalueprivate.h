@@ -53,6 +53,8 @@ struct _GtkCssValueClass {
                                                        double                      progress);
   void          (* print)                             (const GtkCssValue          *value,
                                                        GString                    *string);
+  /* optional, see _gtk_css_value_serialize() */
+  GVariant *    (* serialize)                         (const GtkCssValue          *value);
 };
 
 GType        _gtk_css_value_get_type                  (void) G_GNUC_CONST;
@@ -82,6 +84,13 @@ char *       _gtk_css_value_to_string                 (const GtkCssValue
 void         _gtk_css_value_print                     (const GtkCssValue          *value,
                                                        GString                    *string);
 
+GVariant *   _gtk_css_value_serialize                 (const GtkCssValue          *value);
+GtkCssValue *_gtk_css_value_deserialize               (GVariant                   *variant);
+GVariant *   _gtk_css_value_serialize_array           (GtkCssValue * const        *values,
+                                                       guint                       n_values);
+GtkCssValue **_gtk_css_value_deserialize_array        (GVariant                   *variant,
+                                                       guint                      *n_values);
+
 G_END_DECLS
 
 #endif /* __GTK_CSS_VALUE_PRIVATE_H__ */
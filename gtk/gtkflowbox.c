@@ -110,6 +110,11 @@ static void gtk_flow_box_bound_model_changed (GListModel *list,
                                               gpointer    user_data);
 
 static void gtk_flow_box_check_model_compat  (GtkFlowBox *box);
+static void gtk_flow_box_update_recycled_children (GtkFlowBox *box);
+static guint gtk_flow_box_get_first_position      (GtkFlowBox *box);
+static void gtk_flow_box_queue_update_children    (GtkFlowBox *box);
+static void gtk_flow_box_adjustment_changed       (GtkFlowBox *box);
+static void gtk_flow_box_clear_recycled_children  (GtkFlowBox *box);
 
 static void
 get_current_selection_modifiers (GtkWidget *widget,
@@ -265,6 +270,7 @@ struct _GtkFlowBoxChildPrivate
 {
   GSequenceIter *iter;
   GtkCssGadget  *gadget;
+  GObject       *item;
   gboolean       selected;
 };
 
@@ -583,6 +589,7 @@ static void
 gtk_flow_box_child_finalize (GObject *object)
 {
   g_clear_object (&CHILD_PRIV (GTK_FLOW_BOX_CHILD (object))->gadget);
+  g_clear_object (&CHILD_PRIV (GTK_FLOW_BOX_CHILD (object))->item);
 
   G_OBJECT_CLASS (gtk_flow_box_child_parent_class)->finalize (object);
 }
@@ -686,7 +693,12 @@ gtk_flow_box_child_get_index (GtkFlowBoxChild *child)
   priv = CHILD_PRIV (child);
 
   if (priv->iter != NULL)
-    return g_sequence_iter_get_position (priv->iter);
+    {
+      GtkFlowBox *box = gtk_flow_box_child_get_box (child);
+      gint offset = box ? gtk_flow_box_get_first_position (box) : 0;
+
+      return offset + g_sequence_iter_get_position (priv->iter);
+    }
 
   return -1;
 }
@@ -759,6 +771,16 @@ gtk_flow_box_child_changed (GtkFlowBoxChild *child)
 #define AUTOSCROLL_FACTOR 20
 #define AUTOSCROLL_FACTOR_FAST 10
 
+/* Lines of children that are created beyond the viewport in the
+ * virtualized mode, at the start and at the end, in units of the
+ * viewport size
+ */
+#define RECYCLE_MARGIN 0.5
+/* Children created in the virtualized mode before their size is known */
+#define RECYCLE_INITIAL_CHILDREN 64
+/* Unused children kept around for reuse */
+#define RECYCLE_MAX_UNUSED_CHILDREN 128
+
 /* GObject boilerplate {{{2 */
 
 enum {
@@ -843,6 +865,17 @@ struct _GtkFlowBoxPrivate {
   GtkFlowBoxCreateWidgetFunc  create_widget_func;
   gpointer                    create_widget_func_data;
   GDestroyNotify              create_widget_func_data_destroy;
+
+  /* Only set in the virtualized mode, see gtk_flow_box_bind_model_recycled() */
+  GtkFlowBoxBindWidgetFunc    bind_widget_func;
+  guint                       first_position;
+  gint                        virtual_line_length;
+  gint                        virtual_line_size;
+  GSList                     *recycled_children;
+  guint                       n_recycled_children;
+  GHashTable                 *selected_items;
+  guint                       update_children_id;
+  gboolean                    wrap_children;
 };
 
 #define BOX_PRIV(box) ((GtkFlowBoxPrivate*)gtk_flow_box_get_instance_private ((GtkFlowBox*)(box)))
@@ -893,6 +926,36 @@ get_visible_children (GtkFlowBox *box)
   return i;
 }
 
+static guint
+gtk_flow_box_get_first_position (GtkFlowBox *box)
+{
+  return BOX_PRIV (box)->first_position;
+}
+
+/* Returns the number of items the layout has to make room for.
+ * In the virtualized mode, most items have no child.
+ */
+static gint
+get_n_items (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->bind_widget_func != NULL)
+    return g_list_model_get_n_items (priv->bound_model);
+
+  return get_visible_children (box);
+}
+
+/* The virtualized mode lays out all items as if the box was
+ * homogeneous, with the size of the existing children as
+ * estimate for the size of all items.
+ */
+static inline gboolean
+is_homogeneous (GtkFlowBox *box)
+{
+  return BOX_PRIV (box)->homogeneous || BOX_PRIV (box)->bind_widget_func != NULL;
+}
+
 static void
 gtk_flow_box_update_active (GtkFlowBox      *box,
                             GtkFlowBoxChild *child)
@@ -992,6 +1055,13 @@ gtk_flow_box_unselect_all_internal (GtkFlowBox *box)
       dirty |= gtk_flow_box_child_set_selected (child, FALSE);
     }
 
+  if (BOX_PRIV (box)->selected_items != NULL &&
+      g_hash_table_size (BOX_PRIV (box)->selected_items) > 0)
+    {
+      g_hash_table_remove_all (BOX_PRIV (box)->selected_items);
+      dirty = TRUE;
+    }
+
   return dirty;
 }
 
@@ -1630,7 +1700,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
   gint line_offset, item_offset, n_children, n_lines, line_count;
   gint extra_pixels = 0, extra_per_item = 0, extra_extra = 0;
   gint extra_line_pixels = 0, extra_per_line = 0, extra_line_extra = 0;
-  gint i, this_line_size;
+  gint i, first_index, this_line_size;
   GSequenceIter *iter;
 
   min_items = MAX (1, priv->min_children_per_line);
@@ -1653,7 +1723,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
   line_align = OPPOSING_ORIENTATION_ALIGN (box);
 
   /* Get how many lines we'll be needing to flow */
-  n_children = get_visible_children (box);
+  n_children = get_n_items (box);
   if (n_children <= 0)
     return;
 
@@ -1680,7 +1750,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
   /* Here we just use the largest height-for-width and use that for the height
    * of all lines
    */
-  if (priv->homogeneous)
+  if (is_homogeneous (box))
     {
       n_lines = n_children / line_length;
       if ((n_children % line_length) > 0)
@@ -1821,7 +1891,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
   line_offset += get_offset_pixels (line_align, extra_line_pixels);
 
   /* Get the allocation size for the first line */
-  if (priv->homogeneous)
+  if (is_homogeneous (box))
     this_line_size = line_size;
   else
     {
@@ -1836,8 +1906,30 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
         }
     }
 
-  i = 0;
+  first_index = 0;
   line_count = 0;
+
+  /* When recycling, the children only cover a window of the model;
+   * skip the lines and items in front of it.
+   */
+  if (priv->bind_widget_func != NULL)
+    {
+      first_index = priv->first_position;
+      line_count = first_index / line_length;
+
+      line_offset += line_count * (line_size + line_spacing);
+      item_offset += (first_index % line_length) * (item_size + item_spacing);
+
+      if (priv->virtual_line_length != line_length ||
+          priv->virtual_line_size != line_size)
+        {
+          priv->virtual_line_length = line_length;
+          priv->virtual_line_size = line_size;
+          gtk_flow_box_queue_update_children (box);
+        }
+    }
+
+  i = first_index;
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -1855,7 +1947,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
       position = i % line_length;
 
       /* adjust the line_offset/count at the beginning of each new line */
-      if (i > 0 && position == 0)
+      if (i > first_index && position == 0)
         {
           /* Push the line_offset */
           line_offset += this_line_size + line_spacing;
@@ -1863,7 +1955,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
           line_count++;
 
           /* Get the new line size */
-          if (priv->homogeneous)
+          if (is_homogeneous (box))
             this_line_size = line_size;
           else
             {
@@ -1894,7 +1986,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
                 {
                   gint extra_items = n_children % line_length;
 
-                  if (priv->homogeneous)
+                  if (is_homogeneous (box))
                     {
                       item_offset += item_size * (line_length - extra_items);
                       item_offset += item_spacing * (line_length - extra_items);
@@ -1921,7 +2013,7 @@ gtk_flow_box_allocate (GtkCssGadget        *gadget,
           position += line_length - extra_items;
         }
 
-      if (priv->homogeneous)
+      if (is_homogeneous (box))
         this_item_size = item_size;
       else
         this_item_size = item_sizes[position].minimum_size;
@@ -2125,7 +2217,7 @@ gtk_flow_box_measure (GtkCssGadget   *gadget,
             {
               min_width = nat_width = 0;
 
-              if (!priv->homogeneous)
+              if (!is_homogeneous (box))
                 {
                   /* When not homogeneous; horizontally oriented boxes
                    * need enough width for the widest row
@@ -2221,7 +2313,7 @@ gtk_flow_box_measure (GtkCssGadget   *gadget,
               gint line_length;
               gint item_size, extra_pixels;
 
-              n_children = get_visible_children (box);
+              n_children = get_n_items (box);
               if (n_children <= 0)
                 goto out_width;
 
@@ -2264,7 +2356,7 @@ gtk_flow_box_measure (GtkCssGadget   *gadget,
                 /* Collect the extra pixels for expand children */
                 extra_pixels = (avail_size - (line_length - 1) * priv->row_spacing) % line_length;
 
-              if (priv->homogeneous)
+              if (is_homogeneous (box))
                 {
                   gint min_item_width, nat_item_width;
                   gint lines;
@@ -2279,7 +2371,7 @@ gtk_flow_box_measure (GtkCssGadget   *gadget,
                                                              &nat_item_width);
 
                   /* Round up how many lines we need to allocate for */
-                  n_children = get_visible_children (box);
+                  n_children = get_n_items (box);
                   lines = n_children / line_length;
                   if ((n_children % line_length) > 0)
                     lines++;
@@ -2383,7 +2475,7 @@ gtk_flow_box_measure (GtkCssGadget   *gadget,
             {
               min_height = nat_height = 0;
 
-              if (! priv->homogeneous)
+              if (!is_homogeneous (box))
                 {
                   /* When not homogeneous; vertically oriented boxes
                    * need enough height for the tallest column
@@ -2457,7 +2549,7 @@ gtk_flow_box_measure (GtkCssGadget   *gadget,
               gint line_length;
               gint item_size, extra_pixels;
 
-              n_children = get_visible_children (box);
+              n_children = get_n_items (box);
               if (n_children <= 0)
                 goto out_height;
 
@@ -2502,7 +2594,7 @@ gtk_flow_box_measure (GtkCssGadget   *gadget,
                 /* Collect the extra pixels for expand children */
                 extra_pixels = (avail_size - (line_length - 1) * priv->column_spacing) % line_length;
 
-              if (priv->homogeneous)
+              if (is_homogeneous (box))
                 {
                   gint min_item_height, nat_item_height;
                   gint lines;
@@ -3731,6 +3823,10 @@ gtk_flow_box_finalize (GObject *obj)
     priv->sort_destroy (priv->sort_data);
 
   g_sequence_free (priv->children);
+  if (priv->hadjustment)
+    g_signal_handlers_disconnect_by_func (priv->hadjustment, gtk_flow_box_adjustment_changed, obj);
+  if (priv->vadjustment)
+    g_signal_handlers_disconnect_by_func (priv->vadjustment, gtk_flow_box_adjustment_changed, obj);
   g_clear_object (&priv->hadjustment);
   g_clear_object (&priv->vadjustment);
 
@@ -3746,6 +3842,8 @@ gtk_flow_box_finalize (GObject *obj)
       g_clear_object (&priv->bound_model);
     }
 
+  gtk_flow_box_clear_recycled_children (GTK_FLOW_BOX (obj));
+
   g_clear_object (&priv->gadget);
 
   G_OBJECT_CLASS (gtk_flow_box_parent_class)->finalize (obj);
@@ -4140,6 +4238,309 @@ gtk_flow_box_init (GtkFlowBox *box)
                                                      NULL);
 }
 
+/* Removes @child from @box and keeps it around for reuse by
+ * gtk_flow_box_insert_recycled_child(). The selection state is
+ * remembered per item so it can be restored when the item gets
+ * a child again.
+ */
+static void
+gtk_flow_box_recycle_child (GtkFlowBox      *box,
+                            GtkFlowBoxChild *child)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  if (CHILD_PRIV (child)->selected)
+    {
+      g_hash_table_add (priv->selected_items, g_object_ref (CHILD_PRIV (child)->item));
+      gtk_flow_box_child_set_selected (child, FALSE);
+    }
+
+  if (priv->cursor_child == child)
+    priv->cursor_child = NULL;
+  if (priv->rubberband_first == child)
+    priv->rubberband_first = NULL;
+  if (priv->rubberband_last == child)
+    priv->rubberband_last = NULL;
+
+  g_object_ref (child);
+  gtk_container_remove (GTK_CONTAINER (box), GTK_WIDGET (child));
+  CHILD_PRIV (child)->iter = NULL;
+
+  if (priv->n_recycled_children < RECYCLE_MAX_UNUSED_CHILDREN)
+    {
+      priv->recycled_children = g_slist_prepend (priv->recycled_children, child);
+      priv->n_recycled_children++;
+    }
+  else
+    {
+      gtk_widget_destroy (GTK_WIDGET (child));
+      g_object_unref (child);
+    }
+}
+
+static void
+gtk_flow_box_insert_recycled_child (GtkFlowBox *box,
+                                    guint       position,
+                                    gint        index)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GtkFlowBoxChild *child;
+  GObject *item;
+
+  item = g_list_model_get_item (priv->bound_model, position);
+
+  if (priv->recycled_children != NULL)
+    {
+      GtkWidget *widget;
+
+      child = priv->recycled_children->data;
+      priv->recycled_children = g_slist_delete_link (priv->recycled_children, priv->recycled_children);
+      priv->n_recycled_children--;
+
+      if (priv->wrap_children)
+        widget = gtk_bin_get_child (GTK_BIN (child));
+      else
+        widget = GTK_WIDGET (child);
+
+      priv->bind_widget_func (item, widget, priv->create_widget_func_data);
+      gtk_flow_box_insert (box, GTK_WIDGET (child), index);
+      g_object_unref (child);
+    }
+  else
+    {
+      GtkWidget *widget;
+
+      widget = priv->create_widget_func (item, priv->create_widget_func_data);
+      if (g_object_is_floating (widget))
+        g_object_ref_sink (widget);
+
+      priv->wrap_children = !GTK_IS_FLOW_BOX_CHILD (widget);
+
+      gtk_widget_show (widget);
+      gtk_flow_box_insert (box, widget, index);
+
+      if (priv->wrap_children)
+        child = GTK_FLOW_BOX_CHILD (gtk_widget_get_parent (widget));
+      else
+        child = GTK_FLOW_BOX_CHILD (widget);
+
+      g_object_unref (widget);
+    }
+
+  g_clear_object (&CHILD_PRIV (child)->item);
+  CHILD_PRIV (child)->item = item;
+
+  if (g_hash_table_remove (priv->selected_items, item))
+    gtk_flow_box_child_set_selected (child, TRUE);
+}
+
+/* Makes sure that exactly the items on the lines in and around
+ * the viewport have children. All other children are recycled.
+ */
+static void
+gtk_flow_box_update_recycled_children (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  guint n_items, n_children;
+  guint first, last;
+
+  n_items = g_list_model_get_n_items (priv->bound_model);
+  n_children = g_sequence_get_length (priv->children);
+
+  if (priv->virtual_line_length <= 0 || priv->virtual_line_size <= 0)
+    {
+      first = 0;
+      last = MIN (n_items, RECYCLE_INITIAL_CHILDREN);
+    }
+  else
+    {
+      GtkAdjustment *adjustment;
+      GtkAllocation allocation;
+      gdouble top, height, margin;
+      gint stride;
+      guint first_line, last_line;
+
+      gtk_widget_get_allocation (GTK_WIDGET (box), &allocation);
+
+      /* Lines are stacked along the opposite orientation */
+      if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
+        {
+          adjustment = priv->vadjustment;
+          top = - allocation.y;
+          stride = priv->virtual_line_size + priv->row_spacing;
+        }
+      else
+        {
+          adjustment = priv->hadjustment;
+          top = - allocation.x;
+          stride = priv->virtual_line_size + priv->column_spacing;
+        }
+
+      if (adjustment != NULL &&
+          gtk_adjustment_get_page_size (adjustment) > 0)
+        {
+          top += gtk_adjustment_get_value (adjustment);
+          height = gtk_adjustment_get_page_size (adjustment);
+        }
+      else
+        {
+          top = 0;
+          height = (RECYCLE_INITIAL_CHILDREN / priv->virtual_line_length + 1) * stride;
+        }
+
+      margin = height * RECYCLE_MARGIN;
+
+      first_line = MAX (top - margin, 0) / stride;
+      last_line = MAX (top + height + margin, 0) / stride + 1;
+
+      first = MIN (first_line * priv->virtual_line_length, n_items);
+      first -= first % priv->virtual_line_length;
+      last = CLAMP (last_line * priv->virtual_line_length, first, n_items);
+    }
+
+  while (n_children > 0 && priv->first_position < first)
+    {
+      gtk_flow_box_recycle_child (box, g_sequence_get (g_sequence_get_begin_iter (priv->children)));
+      priv->first_position++;
+      n_children--;
+    }
+
+  while (n_children > 0 && priv->first_position + n_children > last)
+    {
+      gtk_flow_box_recycle_child (box, g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter (priv->children))));
+      n_children--;
+    }
+
+  if (n_children == 0)
+    priv->first_position = first;
+
+  while (priv->first_position > first)
+    {
+      priv->first_position--;
+      gtk_flow_box_insert_recycled_child (box, priv->first_position, 0);
+      n_children++;
+    }
+
+  while (priv->first_position + n_children < last)
+    {
+      gtk_flow_box_insert_recycled_child (box, priv->first_position + n_children, -1);
+      n_children++;
+    }
+}
+
+static gboolean
+gtk_flow_box_update_children_idle (gpointer data)
+{
+  GtkFlowBox *box = data;
+
+  BOX_PRIV (box)->update_children_id = 0;
+  gtk_flow_box_update_recycled_children (box);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Adjustments change and lines get their size while our parent
+ * is allocated, so we can't add and remove children right away.
+ * Do it before the next layout.
+ */
+static void
+gtk_flow_box_queue_update_children (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->bind_widget_func == NULL || priv->update_children_id != 0)
+    return;
+
+  priv->update_children_id = gdk_threads_add_idle_full (GTK_PRIORITY_RESIZE - 1,
+                                                        gtk_flow_box_update_children_idle,
+                                                        box, NULL);
+  g_source_set_name_by_id (priv->update_children_id, "[gtk+] gtk_flow_box_update_children_idle");
+}
+
+static void
+gtk_flow_box_adjustment_changed (GtkFlowBox *box)
+{
+  gtk_flow_box_queue_update_children (box);
+}
+
+static void
+gtk_flow_box_recycled_model_changed (GtkFlowBox *box,
+                                     guint       position,
+                                     guint       removed,
+                                     guint       added)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  guint n_children;
+
+  n_children = g_sequence_get_length (priv->children);
+
+  if (position + removed <= priv->first_position)
+    {
+      /* All our children just move. Unless the change was a multiple
+       * of the line length, that leaves the window in the middle of a
+       * line, so bring back the items in front of it on that line.
+       */
+      priv->first_position = priv->first_position - removed + added;
+
+      if (priv->virtual_line_length > 0)
+        {
+          while (n_children > 0 &&
+                 priv->first_position % priv->virtual_line_length != 0)
+            {
+              priv->first_position--;
+              gtk_flow_box_insert_recycled_child (box, priv->first_position, 0);
+              n_children++;
+            }
+        }
+    }
+  else if (position < priv->first_position + n_children)
+    {
+      guint keep;
+
+      /* Keep the children in front of the change and let
+       * gtk_flow_box_update_recycled_children() rebind the rest
+       */
+      keep = position > priv->first_position ? position - priv->first_position : 0;
+      while (n_children > keep)
+        {
+          gtk_flow_box_recycle_child (box, g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter (priv->children))));
+          n_children--;
+        }
+    }
+
+  gtk_flow_box_update_recycled_children (box);
+  gtk_widget_queue_resize (GTK_WIDGET (box));
+}
+
+static void
+gtk_flow_box_clear_recycled_children (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GSList *l;
+
+  for (l = priv->recycled_children; l; l = l->next)
+    {
+      gtk_widget_destroy (l->data);
+      g_object_unref (l->data);
+    }
+  g_slist_free (priv->recycled_children);
+  priv->recycled_children = NULL;
+  priv->n_recycled_children = 0;
+
+  g_clear_pointer (&priv->selected_items, g_hash_table_unref);
+
+  if (priv->update_children_id != 0)
+    {
+      g_source_remove (priv->update_children_id);
+      priv->update_children_id = 0;
+    }
+
+  priv->bind_widget_func = NULL;
+  priv->first_position = 0;
+  priv->virtual_line_length = 0;
+  priv->virtual_line_size = 0;
+}
+
 static void
 gtk_flow_box_bound_model_changed (GListModel *list,
                                   guint       position,
@@ -4151,6 +4552,12 @@ gtk_flow_box_bound_model_changed (GListModel *list,
   GtkFlowBoxPrivate *priv = BOX_PRIV (box);
   gint i;
 
+  if (priv->bind_widget_func != NULL)
+    {
+      gtk_flow_box_recycled_model_changed (box, position, removed, added);
+      return;
+    }
+
   while (removed--)
     {
       GtkFlowBoxChild *child;
@@ -4304,6 +4711,11 @@ gtk_flow_box_get_child_at_index (GtkFlowBox *box,
 
   g_return_val_if_fail (GTK_IS_FLOW_BOX (box), NULL);
 
+  /* When recycling children, only children near the viewport exist */
+  idx -= BOX_PRIV (box)->first_position;
+  if (idx < 0)
+    return NULL;
+
   iter = g_sequence_get_iter_at_pos (BOX_PRIV (box)->children, idx);
   if (!g_sequence_iter_is_end (iter))
     return g_sequence_get (iter);
@@ -4382,9 +4794,19 @@ gtk_flow_box_set_hadjustment (GtkFlowBox    *box,
 
   g_object_ref (adjustment);
   if (priv->hadjustment)
-    g_object_unref (priv->hadjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->hadjustment, gtk_flow_box_adjustment_changed, box);
+      g_object_unref (priv->hadjustment);
+    }
   priv->hadjustment = adjustment;
   gtk_container_set_focus_hadjustment (GTK_CONTAINER (box), adjustment);
+
+  g_signal_connect_swapped (adjustment, "value-changed",
+                            G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+  g_signal_connect_swapped (adjustment, "changed",
+                            G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+
+  gtk_flow_box_adjustment_changed (box);
 }
 
 /**
@@ -4419,9 +4841,19 @@ gtk_flow_box_set_vadjustment (GtkFlowBox    *box,
 
   g_object_ref (adjustment);
   if (priv->vadjustment)
-    g_object_unref (priv->vadjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment, gtk_flow_box_adjustment_changed, box);
+      g_object_unref (priv->vadjustment);
+    }
   priv->vadjustment = adjustment;
   gtk_container_set_focus_vadjustment (GTK_CONTAINER (box), adjustment);
+
+  g_signal_connect_swapped (adjustment, "value-changed",
+                            G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+  g_signal_connect_swapped (adjustment, "changed",
+                            G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+
+  gtk_flow_box_adjustment_changed (box);
 }
 
 static void
@@ -4434,6 +4866,52 @@ gtk_flow_box_check_model_compat (GtkFlowBox *box)
     g_warning ("GtkFlowBox with a model will ignore sort and filter functions");
 }
 
+static void
+gtk_flow_box_bind_model_internal (GtkFlowBox                 *box,
+                                  GListModel                 *model,
+                                  GtkFlowBoxCreateWidgetFunc  create_widget_func,
+                                  GtkFlowBoxBindWidgetFunc    bind_widget_func,
+                                  gpointer                    user_data,
+                                  GDestroyNotify              user_data_free_func)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->bound_model)
+    {
+      if (priv->create_widget_func_data_destroy)
+        priv->create_widget_func_data_destroy (priv->create_widget_func_data);
+
+      g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_flow_box_bound_model_changed, box);
+      g_clear_object (&priv->bound_model);
+    }
+
+  gtk_flow_box_forall (GTK_CONTAINER (box), FALSE, (GtkCallback) gtk_widget_destroy, NULL);
+  gtk_flow_box_clear_recycled_children (box);
+
+  if (model == NULL)
+    return;
+
+  priv->bound_model = g_object_ref (model);
+  priv->create_widget_func = create_widget_func;
+  priv->create_widget_func_data = user_data;
+  priv->create_widget_func_data_destroy = user_data_free_func;
+
+  if (bind_widget_func != NULL)
+    {
+      priv->bind_widget_func = bind_widget_func;
+      priv->selected_items = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+    }
+
+  gtk_flow_box_check_model_compat (box);
+
+  g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_flow_box_bound_model_changed), box);
+
+  if (priv->bind_widget_func != NULL)
+    gtk_flow_box_update_recycled_children (box);
+  else
+    gtk_flow_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
+}
+
 /**
  * gtk_flow_box_bind_model:
  * @box: a #GtkFlowBox
@@ -4468,35 +4946,66 @@ gtk_flow_box_bind_model (GtkFlowBox                 *box,
                          gpointer                    user_data,
                          GDestroyNotify              user_data_free_func)
 {
-  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
-
   g_return_if_fail (GTK_IS_FLOW_BOX (box));
   g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
   g_return_if_fail (model == NULL || create_widget_func != NULL);
 
-  if (priv->bound_model)
-    {
-      if (priv->create_widget_func_data_destroy)
-        priv->create_widget_func_data_destroy (priv->create_widget_func_data);
-
-      g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_flow_box_bound_model_changed, box);
-      g_clear_object (&priv->bound_model);
-    }
-
-  gtk_flow_box_forall (GTK_CONTAINER (box), FALSE, (GtkCallback) gtk_widget_destroy, NULL);
-
-  if (model == NULL)
-    return;
-
-  priv->bound_model = g_object_ref (model);
-  priv->create_widget_func = create_widget_func;
-  priv->create_widget_func_data = user_data;
-  priv->create_widget_func_data_destroy = user_data_free_func;
+  gtk_flow_box_bind_model_internal (box, model,
+                                    create_widget_func, NULL,
+                                    user_data, user_data_free_func);
+}
 
-  gtk_flow_box_check_model_compat (box);
+/**
+ * gtk_flow_box_bind_model_recycled:
+ * @box: a #GtkFlowBox
+ * @model: (nullable): the #GListModel to be bound to @box
+ * @create_widget_func: (nullable): a function that creates widgets for items
+ *   or %NULL in case you also passed %NULL as @model
+ * @bind_widget_func: (nullable): a function that makes a widget created by
+ *   @create_widget_func represent another item, or %NULL in case you also
+ *   passed %NULL as @model
+ * @user_data: user data passed to @create_widget_func and @bind_widget_func
+ * @user_data_free_func: function for freeing @user_data
+ *
+ * Binds @model to @box like gtk_flow_box_bind_model(), but only creates
+ * children for the items that are on the lines in or close to the visible
+ * part of @box. This requires @box to be placed inside a #GtkScrolledWindow,
+ * and the adjustment of the scrolled window along which lines are stacked
+ * to be set with gtk_flow_box_set_vadjustment() (or
+ * gtk_flow_box_set_hadjustment() for a vertical @box).
+ *
+ * As @box is scrolled, children that move out of view are reused for the
+ * items that come into view by calling @bind_widget_func on them, so the
+ * number of children stays proportional to the size of the viewport and
+ * not to the number of items in @model.
+ *
+ * @box is always laid out as if #GtkFlowBox:homogeneous was set, with the
+ * size of all items estimated from the children that exist.
+ *
+ * Since children only exist for some items, functions like
+ * gtk_flow_box_get_child_at_index() return %NULL for items that are not
+ * close to the viewport, and gtk_flow_box_get_selected_children() only
+ * returns the selected children that exist. Selection is kept when a
+ * child is reused, and restored when the item comes into view again.
+ *
+ * Since: 3.24
+ */
+void
+gtk_flow_box_bind_model_recycled (GtkFlowBox                 *box,
+                                  GListModel                 *model,
+                                  GtkFlowBoxCreateWidgetFunc  create_widget_func,
+                                  GtkFlowBoxBindWidgetFunc    bind_widget_func,
+                                  gpointer                    user_data,
+                                  GDestroyNotify              user_data_free_func)
+{
+  g_return_if_fail (GTK_IS_FLOW_BOX (box));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+  g_return_if_fail (model == NULL || create_widget_func != NULL);
+  g_return_if_fail (model == NULL || bind_widget_func != NULL);
 
-  g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_flow_box_bound_model_changed), box);
-  gtk_flow_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
+  gtk_flow_box_bind_model_internal (box, model,
+                                    create_widget_func, bind_widget_func,
+                                    user_data, user_data_free_func);
 }
 
 /* Setters and getters {{{2 */
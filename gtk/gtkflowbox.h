@@ -114,6 +114,24 @@ struct _GtkFlowBoxChildClass
 typedef GtkWidget * (*GtkFlowBoxCreateWidgetFunc) (gpointer item,
                                                    gpointer  user_data);
 
+/**
+ * GtkFlowBoxBindWidgetFunc:
+ * @item: (type GObject): the item from the model that @widget should represent
+ * @widget: a widget previously returned by the #GtkFlowBoxCreateWidgetFunc
+ * @user_data: (closure): user data
+ *
+ * Called for flow boxes that are bound to a #GListModel with
+ * gtk_flow_box_bind_model_recycled() when a widget that was used
+ * for a child that scrolled out of view is reused for @item.
+ *
+ * The function should update @widget so that it represents @item.
+ *
+ * Since: 3.24
+ */
+typedef void (*GtkFlowBoxBindWidgetFunc) (gpointer   item,
+                                          GtkWidget *widget,
+                                          gpointer   user_data);
+
 GDK_AVAILABLE_IN_3_12
 GType                 gtk_flow_box_child_get_type            (void) G_GNUC_CONST;
 GDK_AVAILABLE_IN_3_12
@@ -138,6 +156,13 @@ void                  gtk_flow_box_bind_model                (GtkFlowBox
                                                               GtkFlowBoxCreateWidgetFunc  create_widget_func,
                                                               gpointer                    user_data,
                                                               GDestroyNotify              user_data_free_func);
+GDK_AVAILABLE_IN_3_24
+void                  gtk_flow_box_bind_model_recycled       (GtkFlowBox                 *box,
+                                                              GListModel                 *model,
+                                                              GtkFlowBoxCreateWidgetFunc  create_widget_func,
+                                                              GtkFlowBoxBindWidgetFunc    bind_widget_func,
+                                                              gpointer                    user_data,
+                                                              GDestroyNotify              user_data_free_func);
 
 GDK_AVAILABLE_IN_3_12
 void                  gtk_flow_box_set_homogeneous           (GtkFlowBox           *box,
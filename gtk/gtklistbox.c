@@ -120,6 +120,17 @@ typedef struct
   GtkListBoxCreateWidgetFunc create_widget_func;
   gpointer create_widget_func_data;
   GDestroyNotify create_widget_func_data_destroy;
+
+  /* Only set when rows are recycled, see gtk_list_box_bind_model_recycled() */
+  GtkListBoxBindWidgetFunc bind_widget_func;
+  guint first_position;
+  gint estimated_row_height;
+  gint measured_row_height;
+  GSList *recycled_rows;
+  guint n_recycled_rows;
+  GHashTable *selected_items;
+  guint update_rows_id;
+  gboolean wrap_rows;
 } GtkListBoxPrivate;
 
 typedef struct
@@ -127,6 +138,7 @@ typedef struct
   GSequenceIter *iter;
   GtkWidget *header;
   GtkCssGadget *gadget;
+  GObject *item;
   gint y;
   gint height;
   guint visible     :1;
@@ -166,6 +178,15 @@ enum {
   LAST_ROW_PROPERTY
 };
 
+/* Rows that are created beyond the viewport when recycling, at the
+ * start and at the end, in units of the viewport height.
+ */
+#define RECYCLE_MARGIN 0.5
+/* Rows that are created when recycling before the row height is known */
+#define RECYCLE_INITIAL_ROWS 32
+/* Unused rows kept around for reuse */
+#define RECYCLE_MAX_UNUSED_ROWS 64
+
 #define BOX_PRIV(box) ((GtkListBoxPrivate*)gtk_list_box_get_instance_private ((GtkListBox*)(box)))
 #define ROW_PRIV(row) ((GtkListBoxRowPrivate*)gtk_list_box_row_get_instance_private ((GtkListBoxRow*)(row)))
 
@@ -287,6 +308,10 @@ static void                 gtk_list_box_bound_model_changed            (GListMo
                                                                          gpointer             user_data);
 
 static void                 gtk_list_box_check_model_compat             (GtkListBox          *box);
+static void                 gtk_list_box_update_recycled_rows           (GtkListBox          *box);
+static void                 gtk_list_box_adjustment_changed             (GtkListBox          *box);
+static void                 gtk_list_box_queue_update_rows              (GtkListBox          *box);
+static void                 gtk_list_box_clear_recycled_rows            (GtkListBox          *box);
 
 static void     gtk_list_box_measure    (GtkCssGadget        *gadget,
                                           GtkOrientation       orientation,
@@ -387,6 +412,8 @@ gtk_list_box_finalize (GObject *obj)
   if (priv->update_header_func_target_destroy_notify != NULL)
     priv->update_header_func_target_destroy_notify (priv->update_header_func_target);
 
+  if (priv->adjustment)
+    g_signal_handlers_disconnect_by_func (priv->adjustment, gtk_list_box_adjustment_changed, obj);
   g_clear_object (&priv->adjustment);
   g_clear_object (&priv->drag_highlighted_row);
   g_clear_object (&priv->multipress_gesture);
@@ -403,6 +430,8 @@ gtk_list_box_finalize (GObject *obj)
       g_clear_object (&priv->bound_model);
     }
 
+  gtk_list_box_clear_recycled_rows (GTK_LIST_BOX (obj));
+
   g_clear_object (&priv->gadget);
 
   G_OBJECT_CLASS (gtk_list_box_parent_class)->finalize (obj);
@@ -712,6 +741,11 @@ gtk_list_box_get_row_at_index (GtkListBox *box,
 
   g_return_val_if_fail (GTK_IS_LIST_BOX (box), NULL);
 
+  /* When recycling rows, only rows near the viewport exist */
+  index_ -= BOX_PRIV (box)->first_position;
+  if (index_ < 0)
+    return NULL;
+
   iter = g_sequence_get_iter_at_pos (BOX_PRIV (box)->children, index_);
   if (!g_sequence_iter_is_end (iter))
     return g_sequence_get (iter);
@@ -984,6 +1018,40 @@ gtk_list_box_set_placeholder (GtkListBox *box,
 }
 
 
+static gboolean
+gtk_list_box_update_rows_idle (gpointer data)
+{
+  GtkListBox *box = data;
+
+  BOX_PRIV (box)->update_rows_id = 0;
+  gtk_list_box_update_recycled_rows (box);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Adjustments change while our parent is allocated, so we can't
+ * add and remove rows right away. Do it before the next layout.
+ */
+static void
+gtk_list_box_queue_update_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->bind_widget_func == NULL || priv->update_rows_id != 0)
+    return;
+
+  priv->update_rows_id = gdk_threads_add_idle_full (GTK_PRIORITY_RESIZE - 1,
+                                                    gtk_list_box_update_rows_idle,
+                                                    box, NULL);
+  g_source_set_name_by_id (priv->update_rows_id, "[gtk+] gtk_list_box_update_rows_idle");
+}
+
+static void
+gtk_list_box_adjustment_changed (GtkListBox *box)
+{
+  gtk_list_box_queue_update_rows (box);
+}
+
 /**
  * gtk_list_box_set_adjustment:
  * @box: a #GtkListBox
@@ -1012,8 +1080,21 @@ gtk_list_box_set_adjustment (GtkListBox    *box,
   if (adjustment)
     g_object_ref_sink (adjustment);
   if (priv->adjustment)
-    g_object_unref (priv->adjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->adjustment, gtk_list_box_adjustment_changed, box);
+      g_object_unref (priv->adjustment);
+    }
   priv->adjustment = adjustment;
+
+  if (adjustment)
+    {
+      g_signal_connect_swapped (adjustment, "value-changed",
+                                G_CALLBACK (gtk_list_box_adjustment_changed), box);
+      g_signal_connect_swapped (adjustment, "changed",
+                                G_CALLBACK (gtk_list_box_adjustment_changed), box);
+    }
+
+  gtk_list_box_adjustment_changed (box);
 }
 
 /**
@@ -1587,6 +1668,13 @@ gtk_list_box_unselect_all_internal (GtkListBox *box)
       dirty |= gtk_list_box_row_set_selected (row, FALSE);
     }
 
+  if (BOX_PRIV (box)->selected_items != NULL &&
+      g_hash_table_size (BOX_PRIV (box)->selected_items) > 0)
+    {
+      g_hash_table_remove_all (BOX_PRIV (box)->selected_items);
+      dirty = TRUE;
+    }
+
   BOX_PRIV (box)->selected_row = NULL;
 
   return dirty;
@@ -2677,6 +2765,9 @@ gtk_list_box_measure (GtkCssGadget   *gadget,
     }
   else
     {
+      gint rows_height = 0;
+      gint n_rows = 0;
+
       if (for_size < 0)
         gtk_css_gadget_get_preferred_size (priv->gadget,
                                            GTK_ORIENTATION_HORIZONTAL,
@@ -2704,10 +2795,34 @@ gtk_list_box_measure (GtkCssGadget   *gadget,
           if (ROW_PRIV (row)->header != NULL)
             {
               gtk_widget_get_preferred_height_for_width (ROW_PRIV (row)->header, for_size, &row_min, NULL);
-              *minimum += row_min;
+              rows_height += row_min;
             }
           gtk_widget_get_preferred_height_for_width (GTK_WIDGET (row), for_size, &row_min, NULL);
-          *minimum += row_min;
+          rows_height += row_min;
+          n_rows++;
+        }
+
+      *minimum += rows_height;
+
+      if (priv->bind_widget_func != NULL)
+        {
+          guint n_items, n_children, n_missing;
+
+          /* Items that have no row are assumed to be as high as the
+           * rows we have. The average is kept for gtk_list_box_allocate(),
+           * so the rows are not measured again there.
+           */
+          if (n_rows > 0)
+            priv->measured_row_height = (rows_height + n_rows / 2) / n_rows;
+          else
+            priv->measured_row_height = priv->estimated_row_height;
+
+          n_items = g_list_model_get_n_items (priv->bound_model);
+          n_children = g_sequence_get_length (priv->children);
+          n_missing = n_items > n_children ? n_items - n_children : 0;
+
+          *minimum += MIN ((gint64) priv->measured_row_height * n_missing,
+                           G_MAXINT - *minimum);
         }
 
       /* We always allocate the minimum height, since handling expanding rows
@@ -2783,6 +2898,18 @@ gtk_list_box_allocate (GtkCssGadget        *gadget,
       child_allocation.y += child_min;
     }
 
+  if (priv->bind_widget_func != NULL)
+    {
+      if (priv->measured_row_height != priv->estimated_row_height)
+        {
+          /* The range of rows we need depends on the estimate */
+          priv->estimated_row_height = priv->measured_row_height;
+          gtk_list_box_queue_update_rows (GTK_LIST_BOX (widget));
+        }
+
+      child_allocation.y += priv->first_position * priv->estimated_row_height;
+    }
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -3517,7 +3644,12 @@ gtk_list_box_row_get_index (GtkListBoxRow *row)
   priv = ROW_PRIV (row);
 
   if (priv->iter != NULL)
-    return g_sequence_iter_get_position (priv->iter);
+    {
+      GtkListBox *box = gtk_list_box_row_get_box (row);
+      gint offset = box ? BOX_PRIV (box)->first_position : 0;
+
+      return offset + g_sequence_iter_get_position (priv->iter);
+    }
 
   return -1;
 }
@@ -3718,6 +3850,7 @@ gtk_list_box_row_finalize (GObject *obj)
 {
   g_clear_object (&ROW_PRIV (GTK_LIST_BOX_ROW (obj))->header);
   g_clear_object (&ROW_PRIV (GTK_LIST_BOX_ROW (obj))->gadget);
+  g_clear_object (&ROW_PRIV (GTK_LIST_BOX_ROW (obj))->item);
 
   G_OBJECT_CLASS (gtk_list_box_row_parent_class)->finalize (obj);
 }
@@ -3845,6 +3978,235 @@ gtk_list_box_buildable_interface_init (GtkBuildableIface *iface)
   iface->add_child = gtk_list_box_buildable_add_child;
 }
 
+/* Removes @row from @box and keeps it around for reuse by
+ * gtk_list_box_insert_recycled_row(). The selection state is
+ * remembered per item so it can be restored when the item gets
+ * a row again.
+ */
+static void
+gtk_list_box_recycle_row (GtkListBox    *box,
+                          GtkListBoxRow *row)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (ROW_PRIV (row)->selected)
+    {
+      g_hash_table_add (priv->selected_items, g_object_ref (ROW_PRIV (row)->item));
+      gtk_list_box_row_set_selected (row, FALSE);
+      if (priv->selected_row == row)
+        priv->selected_row = NULL;
+    }
+
+  g_object_ref (row);
+  gtk_container_remove (GTK_CONTAINER (box), GTK_WIDGET (row));
+  ROW_PRIV (row)->iter = NULL;
+
+  if (priv->n_recycled_rows < RECYCLE_MAX_UNUSED_ROWS)
+    {
+      priv->recycled_rows = g_slist_prepend (priv->recycled_rows, row);
+      priv->n_recycled_rows++;
+    }
+  else
+    {
+      gtk_widget_destroy (GTK_WIDGET (row));
+      g_object_unref (row);
+    }
+}
+
+static void
+gtk_list_box_insert_recycled_row (GtkListBox *box,
+                                  guint       position,
+                                  gint        index)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkListBoxRow *row;
+  GObject *item;
+
+  item = g_list_model_get_item (priv->bound_model, position);
+
+  if (priv->recycled_rows != NULL)
+    {
+      GtkWidget *widget;
+
+      row = priv->recycled_rows->data;
+      priv->recycled_rows = g_slist_delete_link (priv->recycled_rows, priv->recycled_rows);
+      priv->n_recycled_rows--;
+
+      if (priv->wrap_rows)
+        widget = gtk_bin_get_child (GTK_BIN (row));
+      else
+        widget = GTK_WIDGET (row);
+
+      priv->bind_widget_func (item, widget, priv->create_widget_func_data);
+      gtk_list_box_insert (box, GTK_WIDGET (row), index);
+      g_object_unref (row);
+    }
+  else
+    {
+      GtkWidget *widget;
+
+      widget = priv->create_widget_func (item, priv->create_widget_func_data);
+      if (g_object_is_floating (widget))
+        g_object_ref_sink (widget);
+
+      priv->wrap_rows = !GTK_IS_LIST_BOX_ROW (widget);
+
+      gtk_widget_show (widget);
+      gtk_list_box_insert (box, widget, index);
+
+      if (priv->wrap_rows)
+        row = GTK_LIST_BOX_ROW (gtk_widget_get_parent (widget));
+      else
+        row = GTK_LIST_BOX_ROW (widget);
+
+      g_object_unref (widget);
+    }
+
+  g_clear_object (&ROW_PRIV (row)->item);
+  ROW_PRIV (row)->item = item;
+
+  if (g_hash_table_remove (priv->selected_items, item) &&
+      gtk_list_box_row_set_selected (row, TRUE))
+    priv->selected_row = row;
+}
+
+/* Makes sure that exactly the items in and around the viewport
+ * have rows. All other rows are recycled.
+ */
+static void
+gtk_list_box_update_recycled_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint n_items, n_rows;
+  guint first, last;
+
+  n_items = g_list_model_get_n_items (priv->bound_model);
+  n_rows = g_sequence_get_length (priv->children);
+
+  if (priv->estimated_row_height <= 0)
+    {
+      first = 0;
+      last = MIN (n_items, RECYCLE_INITIAL_ROWS);
+    }
+  else
+    {
+      GtkAllocation allocation;
+      gdouble top, height, margin;
+
+      gtk_widget_get_allocation (GTK_WIDGET (box), &allocation);
+
+      if (priv->adjustment != NULL &&
+          gtk_adjustment_get_page_size (priv->adjustment) > 0)
+        {
+          top = gtk_adjustment_get_value (priv->adjustment) - allocation.y;
+          height = gtk_adjustment_get_page_size (priv->adjustment);
+        }
+      else
+        {
+          top = 0;
+          height = RECYCLE_INITIAL_ROWS * priv->estimated_row_height;
+        }
+
+      margin = height * RECYCLE_MARGIN;
+
+      first = CLAMP ((top - margin) / priv->estimated_row_height, 0, n_items);
+      last = CLAMP ((top + height + margin) / priv->estimated_row_height + 1, first, n_items);
+    }
+
+  while (n_rows > 0 && priv->first_position < first)
+    {
+      gtk_list_box_recycle_row (box, g_sequence_get (g_sequence_get_begin_iter (priv->children)));
+      priv->first_position++;
+      n_rows--;
+    }
+
+  while (n_rows > 0 && priv->first_position + n_rows > last)
+    {
+      gtk_list_box_recycle_row (box, g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter (priv->children))));
+      n_rows--;
+    }
+
+  if (n_rows == 0)
+    priv->first_position = first;
+
+  while (priv->first_position > first)
+    {
+      priv->first_position--;
+      gtk_list_box_insert_recycled_row (box, priv->first_position, 0);
+      n_rows++;
+    }
+
+  while (priv->first_position + n_rows < last)
+    {
+      gtk_list_box_insert_recycled_row (box, priv->first_position + n_rows, -1);
+      n_rows++;
+    }
+}
+
+static void
+gtk_list_box_recycled_model_changed (GtkListBox *box,
+                                     guint       position,
+                                     guint       removed,
+                                     guint       added)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint n_rows;
+
+  n_rows = g_sequence_get_length (priv->children);
+
+  if (position + removed <= priv->first_position)
+    {
+      /* All our rows just move */
+      priv->first_position = priv->first_position - removed + added;
+    }
+  else if (position < priv->first_position + n_rows)
+    {
+      guint keep;
+
+      /* Keep the rows in front of the change and let
+       * gtk_list_box_update_recycled_rows() rebind the rest
+       */
+      keep = position > priv->first_position ? position - priv->first_position : 0;
+      while (n_rows > keep)
+        {
+          gtk_list_box_recycle_row (box, g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter (priv->children))));
+          n_rows--;
+        }
+    }
+
+  gtk_list_box_update_recycled_rows (box);
+  gtk_widget_queue_resize (GTK_WIDGET (box));
+}
+
+static void
+gtk_list_box_clear_recycled_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GSList *l;
+
+  for (l = priv->recycled_rows; l; l = l->next)
+    {
+      gtk_widget_destroy (l->data);
+      g_object_unref (l->data);
+    }
+  g_slist_free (priv->recycled_rows);
+  priv->recycled_rows = NULL;
+  priv->n_recycled_rows = 0;
+
+  g_clear_pointer (&priv->selected_items, g_hash_table_unref);
+
+  if (priv->update_rows_id != 0)
+    {
+      g_source_remove (priv->update_rows_id);
+      priv->update_rows_id = 0;
+    }
+
+  priv->bind_widget_func = NULL;
+  priv->first_position = 0;
+  priv->estimated_row_height = 0;
+  priv->measured_row_height = 0;
+}
+
 static void
 gtk_list_box_bound_model_changed (GListModel *list,
                                   guint       position,
@@ -3856,6 +4218,12 @@ gtk_list_box_bound_model_changed (GListModel *list,
   GtkListBoxPrivate *priv = BOX_PRIV (user_data);
   guint i;
 
+  if (priv->bind_widget_func != NULL)
+    {
+      gtk_list_box_recycled_model_changed (box, position, removed, added);
+      return;
+    }
+
   while (removed--)
     {
       GtkListBoxRow *row;
@@ -3900,6 +4268,52 @@ gtk_list_box_check_model_compat (GtkListBox *box)
     g_warning ("GtkListBox with a model will ignore sort and filter functions");
 }
 
+static void
+gtk_list_box_bind_model_internal (GtkListBox                 *box,
+                                  GListModel                 *model,
+                                  GtkListBoxCreateWidgetFunc  create_widget_func,
+                                  GtkListBoxBindWidgetFunc    bind_widget_func,
+                                  gpointer                    user_data,
+                                  GDestroyNotify              user_data_free_func)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->bound_model)
+    {
+      if (priv->create_widget_func_data_destroy)
+        priv->create_widget_func_data_destroy (priv->create_widget_func_data);
+
+      g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_list_box_bound_model_changed, box);
+      g_clear_object (&priv->bound_model);
+    }
+
+  gtk_list_box_forall (GTK_CONTAINER (box), FALSE, (GtkCallback) gtk_widget_destroy, NULL);
+  gtk_list_box_clear_recycled_rows (box);
+
+  if (model == NULL)
+    return;
+
+  priv->bound_model = g_object_ref (model);
+  priv->create_widget_func = create_widget_func;
+  priv->create_widget_func_data = user_data;
+  priv->create_widget_func_data_destroy = user_data_free_func;
+
+  if (bind_widget_func != NULL)
+    {
+      priv->bind_widget_func = bind_widget_func;
+      priv->selected_items = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+    }
+
+  gtk_list_box_check_model_compat (box);
+
+  g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_list_box_bound_model_changed), box);
+
+  if (priv->bind_widget_func != NULL)
+    gtk_list_box_update_recycled_rows (box);
+  else
+    gtk_list_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
+}
+
 /**
  * gtk_list_box_bind_model:
  * @box: a #GtkListBox
@@ -3935,33 +4349,60 @@ gtk_list_box_bind_model (GtkListBox                 *box,
                          gpointer                    user_data,
                          GDestroyNotify              user_data_free_func)
 {
-  GtkListBoxPrivate *priv = BOX_PRIV (box);
-
   g_return_if_fail (GTK_IS_LIST_BOX (box));
   g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
   g_return_if_fail (model == NULL || create_widget_func != NULL);
 
-  if (priv->bound_model)
-    {
-      if (priv->create_widget_func_data_destroy)
-        priv->create_widget_func_data_destroy (priv->create_widget_func_data);
-
-      g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_list_box_bound_model_changed, box);
-      g_clear_object (&priv->bound_model);
-    }
-
-  gtk_list_box_forall (GTK_CONTAINER (box), FALSE, (GtkCallback) gtk_widget_destroy, NULL);
-
-  if (model == NULL)
-    return;
-
-  priv->bound_model = g_object_ref (model);
-  priv->create_widget_func = create_widget_func;
-  priv->create_widget_func_data = user_data;
-  priv->create_widget_func_data_destroy = user_data_free_func;
+  gtk_list_box_bind_model_internal (box, model,
+                                    create_widget_func, NULL,
+                                    user_data, user_data_free_func);
+}
 
-  gtk_list_box_check_model_compat (box);
+/**
+ * gtk_list_box_bind_model_recycled:
+ * @box: a #GtkListBox
+ * @model: (nullable): the #GListModel to be bound to @box
+ * @create_widget_func: (nullable): a function that creates widgets for items
+ *   or %NULL in case you also passed %NULL as @model
+ * @bind_widget_func: (nullable): a function that makes a widget created by
+ *   @create_widget_func represent another item, or %NULL in case you also
+ *   passed %NULL as @model
+ * @user_data: user data passed to @create_widget_func and @bind_widget_func
+ * @user_data_free_func: function for freeing @user_data
+ *
+ * Binds @model to @box like gtk_list_box_bind_model(), but only creates
+ * rows for the items that are in or close to the visible part of @box.
+ * This requires @box to be placed inside a #GtkScrolledWindow.
+ *
+ * As @box is scrolled, rows that move out of view are reused for the
+ * items that come into view by calling @bind_widget_func on them, so
+ * the number of rows stays proportional to the height of the viewport
+ * and not to the number of items in @model. The height of items that
+ * have no row is estimated from the rows that exist, so the scrollbar
+ * is only approximate for lists with rows of varying height.
+ *
+ * Since rows only exist for some items, functions like
+ * gtk_list_box_get_row_at_index() return %NULL for items that are not
+ * close to the viewport, and gtk_list_box_get_selected_rows() only
+ * returns the selected rows that exist. Selection is kept when a row
+ * is reused, and restored when the item comes into view again.
+ *
+ * Since: 3.24
+ */
+void
+gtk_list_box_bind_model_recycled (GtkListBox                 *box,
+                                  GListModel                 *model,
+                                  GtkListBoxCreateWidgetFunc  create_widget_func,
+                                  GtkListBoxBindWidgetFunc    bind_widget_func,
+                                  gpointer                    user_data,
+                                  GDestroyNotify              user_data_free_func)
+{
+  g_return_if_fail (GTK_IS_LIST_BOX (box));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+  g_return_if_fail (model == NULL || create_widget_func != NULL);
+  g_return_if_fail (model == NULL || bind_widget_func != NULL);
 
-  g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_list_box_bound_model_changed), box);
-  gtk_list_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
+  gtk_list_box_bind_model_internal (box, model,
+                                    create_widget_func, bind_widget_func,
+                                    user_data, user_data_free_func);
 }
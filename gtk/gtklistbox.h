@@ -189,6 +189,24 @@ typedef void (*GtkListBoxUpdateHeaderFunc) (GtkListBoxRow *row,
 typedef GtkWidget * (*GtkListBoxCreateWidgetFunc) (gpointer item,
                                                    gpointer user_data);
 
+/**
+ * GtkListBoxBindWidgetFunc:
+ * @item: (type GObject): the item from the model that @widget should represent
+ * @widget: a widget previously returned by the #GtkListBoxCreateWidgetFunc
+ * @user_data: (closure): user data
+ *
+ * Called for list boxes that are bound to a #GListModel with
+ * gtk_list_box_bind_model_recycled() when a widget that was used
+ * for a row that scrolled out of view is reused for @item.
+ *
+ * The function should update @widget so that it represents @item.
+ *
+ * Since: 3.24
+ */
+typedef void (*GtkListBoxBindWidgetFunc) (gpointer   item,
+                                          GtkWidget *widget,
+                                          gpointer   user_data);
+
 GDK_AVAILABLE_IN_3_10
 GType      gtk_list_box_row_get_type      (void) G_GNUC_CONST;
 GDK_AVAILABLE_IN_3_10
@@ -312,6 +330,13 @@ void           gtk_list_box_bind_model                   (GtkListBox
                                                           GtkListBoxCreateWidgetFunc    create_widget_func,
                                                           gpointer                      user_data,
                                                           GDestroyNotify                user_data_free_func);
+GDK_AVAILABLE_IN_3_24
+void           gtk_list_box_bind_model_recycled          (GtkListBox                   *box,
+                                                          GListModel                   *model,
+                                                          GtkListBoxCreateWidgetFunc    create_widget_func,
+                                                          GtkListBoxBindWidgetFunc      bind_widget_func,
+                                                          gpointer                      user_data,
+                                                          GDestroyNotify                user_data_free_func);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkListBox, g_object_unref)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkListBoxRow, g_object_unref)
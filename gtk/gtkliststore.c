@@ -2314,6 +2314,209 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_insert_rows_with_valuesv:
+ * @list_store: A #GtkListStore
+ * @position: position to insert the new rows, or -1 to append after
+ *     existing rows
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_values × @n_rows GValues
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows new rows at @position and fills them with @values.
+ * The values are given column by column: the value for column
+ * @columns`[i]` of the new row @j is @values`[i * n_rows + j]`.
+ *
+ * Unless @list_store is sorted, this emits a single
+ * #GtkTreeModel::rows-inserted signal for all the new rows, which
+ * is considerably faster than inserting the rows one by one when
+ * many rows are added to a model that is shown in a #GtkTreeView.
+ * If @list_store is sorted, @position is ignored and the rows are
+ * inserted like gtk_list_store_insert_with_valuesv() does.
+ *
+ * Since: 3.24
+ */
+void
+gtk_list_store_insert_rows_with_valuesv (GtkListStore *list_store,
+                                         gint          position,
+                                         gint          n_rows,
+                                         gint         *columns,
+                                         GValue       *values,
+                                         gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GtkTreePath *path;
+  GSequence *seq;
+  GSequenceIter *ptr;
+  GtkTreeIter iter;
+  GtkTreeIter first;
+  gint length;
+  gint row, i;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  priv = list_store->priv;
+
+  if (n_rows == 0)
+    return;
+
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    {
+      GValue *row_values;
+
+      /* The rows end up all over the place */
+      row_values = g_new (GValue, MAX (n_values, 1));
+      for (row = 0; row < n_rows; row++)
+        {
+          for (i = 0; i < n_values; i++)
+            row_values[i] = values[i * n_rows + row];
+
+          gtk_list_store_insert_with_valuesv (list_store, NULL, -1,
+                                              columns, row_values, n_values);
+        }
+      g_free (row_values);
+
+      return;
+    }
+
+  priv->columns_dirty = TRUE;
+
+  seq = priv->seq;
+
+  length = g_sequence_get_length (seq);
+  if (position > length || position < 0)
+    position = length;
+
+  ptr = g_sequence_get_iter_at_pos (seq, position);
+
+  iter.stamp = priv->stamp;
+  for (row = 0; row < n_rows; row++)
+    {
+      iter.user_data = g_sequence_insert_before (ptr, NULL);
+      if (row == 0)
+        first = iter;
+
+      for (i = 0; i < n_values; i++)
+        gtk_list_store_real_set_value (list_store, &iter, columns[i],
+                                       &values[i * n_rows + row], FALSE);
+    }
+
+  priv->length += n_rows;
+
+  g_assert (iter_is_valid (&first, list_store));
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (list_store), path, &first, n_rows);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_list_store_set_rows_valuesv:
+ * @list_store: A #GtkListStore
+ * @position: position of the first row to change
+ * @n_rows: the number of rows to change
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_values × @n_rows GValues
+ * @n_values: the length of the @columns array
+ *
+ * Replaces the values of the @n_rows rows starting at @position,
+ * which must all exist. The values are given column by column, like
+ * for gtk_list_store_insert_rows_with_valuesv().
+ *
+ * This has the same effect as calling gtk_list_store_set_valuesv()
+ * for each of the rows, but avoids looking the rows up one by one.
+ * Unless the store is sorted, the change is announced with a single
+ * #GtkTreeModel::rows-changed signal.
+ *
+ * Since: 3.24
+ */
+void
+gtk_list_store_set_rows_valuesv (GtkListStore *list_store,
+                                 gint          position,
+                                 gint          n_rows,
+                                 gint         *columns,
+                                 GValue       *values,
+                                 gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GSequenceIter **ptrs;
+  GSequenceIter *ptr;
+  GValue *row_values;
+  GtkTreeIter iter;
+  gint row, i;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (position >= 0 && n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  priv = list_store->priv;
+
+  g_return_if_fail (position + n_rows <= g_sequence_get_length (priv->seq));
+
+  if (n_rows == 0)
+    return;
+
+  /* Rows may move around if the store is sorted,
+   * so find all of them before changing any
+   */
+  ptrs = g_new (GSequenceIter *, n_rows);
+  ptr = g_sequence_get_iter_at_pos (priv->seq, position);
+  for (row = 0; row < n_rows; row++)
+    {
+      ptrs[row] = ptr;
+      ptr = g_sequence_iter_next (ptr);
+    }
+
+  row_values = g_new (GValue, MAX (n_values, 1));
+  iter.stamp = priv->stamp;
+
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    {
+      for (row = 0; row < n_rows; row++)
+        {
+          for (i = 0; i < n_values; i++)
+            row_values[i] = values[i * n_rows + row];
+
+          iter.user_data = ptrs[row];
+          gtk_list_store_set_valuesv (list_store, &iter, columns, row_values, n_values);
+        }
+    }
+  else
+    {
+      gboolean emit_signal = FALSE;
+      gboolean maybe_need_sort = FALSE;
+
+      for (row = 0; row < n_rows; row++)
+        {
+          for (i = 0; i < n_values; i++)
+            row_values[i] = values[i * n_rows + row];
+
+          iter.user_data = ptrs[row];
+          gtk_list_store_set_vector_internal (list_store, &iter,
+                                              &emit_signal,
+                                              &maybe_need_sort,
+                                              columns, row_values, n_values);
+        }
+
+      if (emit_signal)
+        {
+          GtkTreePath *path;
+
+          iter.user_data = ptrs[0];
+          path = gtk_tree_path_new_from_indices (position, -1);
+          gtk_tree_model_rows_changed (GTK_TREE_MODEL (list_store),
+                                       path, &iter, n_rows);
+          gtk_tree_path_free (path);
+        }
+    }
+
+  g_free (row_values);
+  g_free (ptrs);
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
@@ -122,6 +122,20 @@ void          gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
 						  gint         *columns,
 						  GValue       *values,
 						  gint          n_values);
+GDK_AVAILABLE_IN_3_24
+void          gtk_list_store_insert_rows_with_valuesv (GtkListStore *list_store,
+                                                       gint          position,
+                                                       gint          n_rows,
+                                                       gint         *columns,
+                                                       GValue       *values,
+                                                       gint          n_values);
+GDK_AVAILABLE_IN_3_24
+void          gtk_list_store_set_rows_valuesv    (GtkListStore *list_store,
+                                                  gint          position,
+                                                  gint          n_rows,
+                                                  gint         *columns,
+                                                  GValue       *values,
+                                                  gint          n_values);
 GDK_AVAILABLE_IN_ALL
 void          gtk_list_store_prepend          (GtkListStore *list_store,
 					       GtkTreeIter  *iter);
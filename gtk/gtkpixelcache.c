@@ -25,28 +25,46 @@
 
 #define BLOW_CACHE_TIMEOUT_SEC 20
 
-/* The extra size of the offscreen surface we allocate
-   to make scrolling more efficient */
+/* The extra size of the offscreen area we keep rendered
+   around the view to make scrolling more efficient */
 #define DEFAULT_EXTRA_SIZE 64
 
-/* When resizing viewport we allow this extra
-   size to avoid constantly reallocating when resizing */
-#define ALLOW_SMALLER_SIZE_FACTOR 0.5
-#define ALLOW_LARGER_SIZE_FACTOR  1.25
+/* The cache is split into square tiles at fixed positions in
+ * canvas coordinates, so scrolling never has to move pixels
+ * around. Each tile tracks its dirty area as a bitmap with one
+ * bit per TILE_CELL_SIZE x TILE_CELL_SIZE cell.
+ */
+#define TILE_SIZE 256
+#define TILE_CELLS 8
+#define TILE_CELL_SIZE (TILE_SIZE / TILE_CELLS)
+#define TILE_ALL_DIRTY G_MAXUINT64
+
+/* How much memory we keep around in tiles that are not needed
+ * for the current frame. Tiles that are needed are never evicted. */
+#define MEMORY_BUDGET (16 * 1024 * 1024)
+
+typedef struct _GtkPixelCacheTile GtkPixelCacheTile;
+
+struct _GtkPixelCacheTile {
+  GList link;           /* in cache->lru, most recently used first */
+  gint64 key;
+  int x;                /* position in canvas coordinates */
+  int y;
+  cairo_surface_t *surface;
+  guint64 dirty;        /* one bit per cell, row-major */
+};
 
 struct _GtkPixelCache {
-  cairo_surface_t *surface;
-  cairo_content_t content;
+  GHashTable *tiles;    /* tile key => GtkPixelCacheTile */
+  GQueue lru;
 
-  /* Valid if surface != NULL */
-  int surface_x;
-  int surface_y;
-  int surface_w;
-  int surface_h;
-  double surface_scale;
+  cairo_content_t content;
 
-  /* may be null if not dirty */
-  cairo_region_t *surface_dirty;
+  /* Valid if there are tiles */
+  cairo_content_t tile_content;
+  int tile_scale;
+  int canvas_w;
+  int canvas_h;
 
   GSource *timeout_source;
 
@@ -57,12 +75,125 @@ struct _GtkPixelCache {
   guint is_opaque : 1;
 };
 
+static inline int
+floor_div (int a,
+           int b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static inline gint64
+tile_key (int tx,
+          int ty)
+{
+  return ((gint64) ty << 32) | (guint32) tx;
+}
+
+static void
+gtk_pixel_cache_tile_free (gpointer data)
+{
+  GtkPixelCacheTile *tile = data;
+
+  cairo_surface_destroy (tile->surface);
+  g_slice_free (GtkPixelCacheTile, tile);
+}
+
+static void
+gtk_pixel_cache_clear_tiles (GtkPixelCache *cache)
+{
+  g_queue_init (&cache->lru);
+  g_hash_table_remove_all (cache->tiles);
+}
+
+static void
+gtk_pixel_cache_drop_tile (GtkPixelCache     *cache,
+                           GtkPixelCacheTile *tile)
+{
+  g_queue_unlink (&cache->lru, &tile->link);
+  g_hash_table_remove (cache->tiles, &tile->key);
+}
+
+/* Returns the cells of a tile that intersect @rect, which is
+ * given in canvas coordinates */
+static guint64
+gtk_pixel_cache_tile_get_mask (GtkPixelCacheTile           *tile,
+                               const cairo_rectangle_int_t *rect)
+{
+  int x0, y0, x1, y1, cy;
+  guint64 row, mask;
+
+  x0 = MAX (rect->x - tile->x, 0);
+  y0 = MAX (rect->y - tile->y, 0);
+  x1 = MIN (rect->x + rect->width - tile->x, TILE_SIZE);
+  y1 = MIN (rect->y + rect->height - tile->y, TILE_SIZE);
+
+  if (x0 >= x1 || y0 >= y1)
+    return 0;
+
+  x0 /= TILE_CELL_SIZE;
+  y0 /= TILE_CELL_SIZE;
+  x1 = (x1 - 1) / TILE_CELL_SIZE;
+  y1 = (y1 - 1) / TILE_CELL_SIZE;
+
+  row = ((G_GUINT64_CONSTANT (1) << (x1 - x0 + 1)) - 1) << x0;
+  mask = 0;
+  for (cy = y0; cy <= y1; cy++)
+    mask |= row << (cy * TILE_CELLS);
+
+  return mask;
+}
+
+/* Converts a cell mask into a region in tile coordinates */
+static cairo_region_t *
+gtk_pixel_cache_tile_mask_to_region (guint64 mask)
+{
+  cairo_region_t *region;
+  cairo_rectangle_int_t r;
+  int cx, cy;
+
+  region = cairo_region_create ();
+  r.height = TILE_CELL_SIZE;
+
+  for (cy = 0; cy < TILE_CELLS; cy++)
+    {
+      guint row = (mask >> (cy * TILE_CELLS)) & ((1 << TILE_CELLS) - 1);
+
+      cx = 0;
+      while (row)
+        {
+          int start;
+
+          while ((row & 1) == 0)
+            {
+              row >>= 1;
+              cx++;
+            }
+          start = cx;
+          while (row & 1)
+            {
+              row >>= 1;
+              cx++;
+            }
+
+          r.x = start * TILE_CELL_SIZE;
+          r.y = cy * TILE_CELL_SIZE;
+          r.width = (cx - start) * TILE_CELL_SIZE;
+          cairo_region_union_rectangle (region, &r);
+        }
+    }
+
+  return region;
+}
+
 GtkPixelCache *
 _gtk_pixel_cache_new ()
 {
   GtkPixelCache *cache;
 
   cache = g_new0 (GtkPixelCache, 1);
+  cache->tiles = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                        NULL, gtk_pixel_cache_tile_free);
+  g_queue_init (&cache->lru);
   cache->extra_width = DEFAULT_EXTRA_SIZE;
   cache->extra_height = DEFAULT_EXTRA_SIZE;
 
@@ -76,16 +207,16 @@ _gtk_pixel_cache_free (GtkPixelCache *cache)
     return;
 
   if (cache->timeout_source ||
-      cache->surface ||
-      cache->surface_dirty)
+      g_hash_table_size (cache->tiles) > 0)
     {
-      g_warning ("pixel cache freed that wasn't unmapped: tag %u surface %p dirty %p",
-                 g_source_get_id (cache->timeout_source), cache->surface, cache->surface_dirty);
+      g_warning ("pixel cache freed that wasn't unmapped: tag %u tiles %u",
+                 cache->timeout_source ? g_source_get_id (cache->timeout_source) : 0,
+                 g_hash_table_size (cache->tiles));
     }
 
   g_clear_pointer (&cache->timeout_source, g_source_destroy);
-  g_clear_pointer (&cache->surface, cairo_surface_destroy);
-  g_clear_pointer (&cache->surface_dirty, cairo_region_destroy);
+  gtk_pixel_cache_clear_tiles (cache);
+  g_hash_table_unref (cache->tiles);
 
   g_free (cache);
 }
@@ -119,72 +250,97 @@ _gtk_pixel_cache_set_content (GtkPixelCache   *cache,
   _gtk_pixel_cache_invalidate (cache, NULL);
 }
 
+static void
+gtk_pixel_cache_invalidate_rect (GtkPixelCache               *cache,
+                                 const cairo_rectangle_int_t *rect)
+{
+  GList *l;
+
+  for (l = cache->lru.head; l; l = l->next)
+    {
+      GtkPixelCacheTile *tile = l->data;
+
+      tile->dirty |= gtk_pixel_cache_tile_get_mask (tile, rect);
+    }
+}
+
 /* Region is in canvas coordinates */
 void
 _gtk_pixel_cache_invalidate (GtkPixelCache  *cache,
                              cairo_region_t *region)
 {
   cairo_rectangle_int_t r;
-  cairo_region_t *free_region = NULL;
+  GList *l;
+  int i, n;
 
-  if (cache->surface == NULL ||
+  if (cache->lru.length == 0 ||
       (region != NULL && cairo_region_is_empty (region)))
     return;
 
   if (region == NULL)
     {
-      r.x = cache->surface_x;
-      r.y = cache->surface_y;
-      r.width = cache->surface_w;
-      r.height = cache->surface_h;
+      for (l = cache->lru.head; l; l = l->next)
+        {
+          GtkPixelCacheTile *tile = l->data;
 
-      free_region = region =
-        cairo_region_create_rectangle (&r);
+          tile->dirty = TILE_ALL_DIRTY;
+        }
+      return;
     }
 
-  if (cache->surface_dirty == NULL)
+  n = cairo_region_num_rectangles (region);
+  for (i = 0; i < n; i++)
     {
-      cache->surface_dirty = cairo_region_copy (region);
-      cairo_region_translate (cache->surface_dirty,
-                              -cache->surface_x,
-                              -cache->surface_y);
+      cairo_region_get_rectangle (region, i, &r);
+      gtk_pixel_cache_invalidate_rect (cache, &r);
     }
-  else
+}
+
+/* Parts of edge tiles that were outside the canvas may have
+ * been left unpainted, so when the canvas grows or shrinks
+ * we have to repaint the strips in between. */
+static void
+gtk_pixel_cache_set_canvas_size (GtkPixelCache *cache,
+                                 int            width,
+                                 int            height)
+{
+  cairo_rectangle_int_t r;
+
+  if (width != cache->canvas_w)
     {
-      cairo_region_translate (region,
-                              -cache->surface_x,
-                              -cache->surface_y);
-      cairo_region_union (cache->surface_dirty, region);
-      cairo_region_translate (region,
-                              cache->surface_x,
-                              cache->surface_y);
+      r.x = MIN (width, cache->canvas_w);
+      r.y = 0;
+      r.width = MAX (width, cache->canvas_w) - r.x;
+      r.height = MAX (height, cache->canvas_h);
+      gtk_pixel_cache_invalidate_rect (cache, &r);
     }
 
-  if (free_region)
-    cairo_region_destroy (free_region);
-
-  r.x = 0;
-  r.y = 0;
-  r.width = cache->surface_w;
-  r.height = cache->surface_h;
+  if (height != cache->canvas_h)
+    {
+      r.x = 0;
+      r.y = MIN (height, cache->canvas_h);
+      r.width = MAX (width, cache->canvas_w);
+      r.height = MAX (height, cache->canvas_h) - r.y;
+      gtk_pixel_cache_invalidate_rect (cache, &r);
+    }
 
-  cairo_region_intersect_rectangle (cache->surface_dirty, &r);
+  cache->canvas_w = width;
+  cache->canvas_h = height;
 }
 
-static void
-_gtk_pixel_cache_create_surface_if_needed (GtkPixelCache         *cache,
-                                           GdkWindow             *window,
-                                           cairo_rectangle_int_t *view_rect,
-                                           cairo_rectangle_int_t *canvas_rect)
+/* Makes sure all tiles intersecting @needed exist and moves them
+ * to the front of the LRU list, then evicts old tiles that exceed
+ * the memory budget. Returns the number of needed tiles, which are
+ * the first ones in cache->lru afterwards. */
+static guint
+gtk_pixel_cache_ensure_tiles (GtkPixelCache         *cache,
+                              GdkWindow             *window,
+                              cairo_rectangle_int_t *needed)
 {
-  cairo_rectangle_int_t rect;
-  int surface_w, surface_h;
   cairo_content_t content;
-
-#ifdef G_ENABLE_DEBUG
-  if (GTK_DISPLAY_DEBUG_CHECK (gdk_window_get_display (window), NO_PIXEL_CACHE))
-    return;
-#endif
+  int scale, tx, ty, tx0, ty0, tx1, ty1;
+  gsize tile_bytes;
+  guint n_needed, max_tiles;
 
   content = cache->content;
   if (!content)
@@ -194,133 +350,116 @@ _gtk_pixel_cache_create_surface_if_needed (GtkPixelCache         *cache,
       else
         content = CAIRO_CONTENT_COLOR_ALPHA;
     }
+  scale = gdk_window_get_scale_factor (window);
 
-  surface_w = view_rect->width;
-  if (canvas_rect->width > surface_w)
-    surface_w = MIN (surface_w + cache->extra_width, canvas_rect->width);
-
-  surface_h = view_rect->height;
-  if (canvas_rect->height > surface_h)
-    surface_h = MIN (surface_h + cache->extra_height, canvas_rect->height);
-
-  /* If current surface can't fit view_rect or is too large, kill it */
-  if (cache->surface != NULL &&
-      (cairo_surface_get_content (cache->surface) != content ||
-       cache->surface_w < MAX(view_rect->width, surface_w * ALLOW_SMALLER_SIZE_FACTOR) ||
-       cache->surface_w > surface_w * ALLOW_LARGER_SIZE_FACTOR ||
-       cache->surface_h < MAX(view_rect->height, surface_h * ALLOW_SMALLER_SIZE_FACTOR) ||
-       cache->surface_h > surface_h * ALLOW_LARGER_SIZE_FACTOR ||
-       cache->surface_scale != gdk_window_get_scale_factor (window)))
-    {
-      cairo_surface_destroy (cache->surface);
-      cache->surface = NULL;
-      if (cache->surface_dirty)
-        cairo_region_destroy (cache->surface_dirty);
-      cache->surface_dirty = NULL;
-    }
+  if (cache->lru.length > 0 &&
+      (cache->tile_content != content ||
+       cache->tile_scale != scale))
+    gtk_pixel_cache_clear_tiles (cache);
 
-  /* Don't allocate a surface if view >= canvas, as we won't
-   * be scrolling then anyway, unless the widget requested it.
-   */
-  if (cache->surface == NULL &&
-      (cache->always_cache ||
-       (view_rect->width < canvas_rect->width ||
-        view_rect->height < canvas_rect->height)))
+  cache->tile_content = content;
+  cache->tile_scale = scale;
+
+  tx0 = floor_div (needed->x, TILE_SIZE);
+  ty0 = floor_div (needed->y, TILE_SIZE);
+  tx1 = floor_div (needed->x + needed->width - 1, TILE_SIZE);
+  ty1 = floor_div (needed->y + needed->height - 1, TILE_SIZE);
+
+  n_needed = 0;
+  for (ty = ty0; ty <= ty1; ty++)
     {
-      cache->surface_x = -canvas_rect->x;
-      cache->surface_y = -canvas_rect->y;
-      cache->surface_w = surface_w;
-      cache->surface_h = surface_h;
-      cache->surface_scale = gdk_window_get_scale_factor (window);
-
-      cache->surface =
-        gdk_window_create_similar_surface (window, content,
-                                           surface_w, surface_h);
-      rect.x = 0;
-      rect.y = 0;
-      rect.width = surface_w;
-      rect.height = surface_h;
-      cache->surface_dirty =
-        cairo_region_create_rectangle (&rect);
+      for (tx = tx0; tx <= tx1; tx++)
+        {
+          GtkPixelCacheTile *tile;
+          gint64 key = tile_key (tx, ty);
+
+          tile = g_hash_table_lookup (cache->tiles, &key);
+          if (tile == NULL)
+            {
+              tile = g_slice_new0 (GtkPixelCacheTile);
+              tile->link.data = tile;
+              tile->key = key;
+              tile->x = tx * TILE_SIZE;
+              tile->y = ty * TILE_SIZE;
+              tile->surface = gdk_window_create_similar_surface (window, content,
+                                                                 TILE_SIZE, TILE_SIZE);
+              tile->dirty = TILE_ALL_DIRTY;
+              g_hash_table_insert (cache->tiles, &tile->key, tile);
+            }
+          else
+            g_queue_unlink (&cache->lru, &tile->link);
+
+          g_queue_push_head_link (&cache->lru, &tile->link);
+          n_needed++;
+        }
     }
+
+  tile_bytes = (gsize) TILE_SIZE * TILE_SIZE * scale * scale * 4;
+  max_tiles = MAX (n_needed, MEMORY_BUDGET / tile_bytes);
+
+  while (cache->lru.length > max_tiles)
+    gtk_pixel_cache_drop_tile (cache, cache->lru.tail->data);
+
+  return n_needed;
 }
 
 static void
-_gtk_pixel_cache_set_position (GtkPixelCache         *cache,
-                               cairo_rectangle_int_t *view_rect,
-                               cairo_rectangle_int_t *canvas_rect)
+gtk_pixel_cache_repaint_tile (GtkPixelCache         *cache,
+                              GtkPixelCacheTile     *tile,
+                              GdkWindow             *window,
+                              GtkPixelCacheDrawFunc  draw,
+                              cairo_rectangle_int_t *view_rect,
+                              cairo_rectangle_int_t *canvas_rect,
+                              guint64                mask,
+                              gpointer               user_data)
 {
-  cairo_rectangle_int_t r, view_pos;
-  cairo_region_t *copy_region;
-  int new_surf_x, new_surf_y;
+  cairo_region_t *region;
   cairo_t *backing_cr;
 
-  if (cache->surface == NULL)
-    return;
+  region = gtk_pixel_cache_tile_mask_to_region (mask);
 
-  /* Position of view inside canvas */
-  view_pos.x = -canvas_rect->x;
-  view_pos.y = -canvas_rect->y;
-  view_pos.width = view_rect->width;
-  view_pos.height = view_rect->height;
+  backing_cr = cairo_create (tile->surface);
+  gdk_cairo_region (backing_cr, region);
+  cairo_clip (backing_cr);
+  cairo_rectangle (backing_cr, -tile->x, -tile->y, cache->canvas_w, cache->canvas_h);
+  cairo_clip (backing_cr);
+  cairo_translate (backing_cr,
+                   -tile->x - canvas_rect->x - view_rect->x,
+                   -tile->y - canvas_rect->y - view_rect->y);
 
-  /* Reposition so all is visible */
-  if (view_pos.x < cache->surface_x ||
-      view_pos.x + view_pos.width > cache->surface_x + cache->surface_w ||
-      view_pos.y < cache->surface_y ||
-      view_pos.y + view_pos.height > cache->surface_y + cache->surface_h)
-    {
-      new_surf_x = cache->surface_x;
-      if (view_pos.x < cache->surface_x)
-        new_surf_x = MAX (view_pos.x + view_pos.width - cache->surface_w, 0);
-      else if (view_pos.x + view_pos.width >
-               cache->surface_x + cache->surface_w)
-        new_surf_x = MIN (view_pos.x, canvas_rect->width - cache->surface_w);
-
-      new_surf_y = cache->surface_y;
-      if (view_pos.y < cache->surface_y)
-        new_surf_y = MAX (view_pos.y + view_pos.height - cache->surface_h, 0);
-      else if (view_pos.y + view_pos.height >
-               cache->surface_y + cache->surface_h)
-        new_surf_y = MIN (view_pos.y, canvas_rect->height - cache->surface_h);
+  cairo_save (backing_cr);
+  cairo_set_source_rgba (backing_cr,
+                         0.0, 0, 0, 0.0);
+  cairo_set_operator (backing_cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint (backing_cr);
+  cairo_restore (backing_cr);
 
-      r.x = 0;
-      r.y = 0;
-      r.width = cache->surface_w;
-      r.height = cache->surface_h;
-      copy_region = cairo_region_create_rectangle (&r);
-
-      if (cache->surface_dirty)
-        {
-          cairo_region_subtract (copy_region, cache->surface_dirty);
-          cairo_region_destroy (cache->surface_dirty);
-          cache->surface_dirty = NULL;
-        }
+  cairo_save (backing_cr);
+  draw (backing_cr, user_data);
+  cairo_restore (backing_cr);
 
-      cairo_region_translate (copy_region,
-                              cache->surface_x - new_surf_x,
-                              cache->surface_y - new_surf_y);
-      cairo_region_intersect_rectangle (copy_region, &r);
-
-      backing_cr = cairo_create (cache->surface);
-      gdk_cairo_region (backing_cr, copy_region);
-      cairo_set_operator (backing_cr, CAIRO_OPERATOR_SOURCE);
-      cairo_clip (backing_cr);
-      cairo_push_group (backing_cr);
-      cairo_set_source_surface (backing_cr, cache->surface,
-                                cache->surface_x - new_surf_x,
-                                cache->surface_y - new_surf_y);
-      cairo_paint (backing_cr);
-      cairo_pop_group_to_source (backing_cr);
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DISPLAY_DEBUG_CHECK (gdk_window_get_display (window), PIXEL_CACHE))
+    {
+      GdkRGBA colors[] = {
+        { 1, 0, 0, 0.08},
+        { 0, 1, 0, 0.08},
+        { 0, 0, 1, 0.08},
+        { 1, 0, 1, 0.08},
+        { 1, 1, 0, 0.08},
+        { 0, 1, 1, 0.08},
+      };
+      static int current_color = 0;
+
+      gdk_cairo_set_source_rgba (backing_cr, &colors[(current_color++) % G_N_ELEMENTS (colors)]);
       cairo_paint (backing_cr);
-      cairo_destroy (backing_cr);
+    }
+#endif
 
-      cache->surface_x = new_surf_x;
-      cache->surface_y = new_surf_y;
+  cairo_destroy (backing_cr);
+  cairo_region_destroy (region);
 
-      cairo_region_xor_rectangle (copy_region, &r);
-      cache->surface_dirty = copy_region;
-    }
+  tile->dirty &= ~mask;
 }
 
 static void
@@ -329,65 +468,33 @@ _gtk_pixel_cache_repaint (GtkPixelCache         *cache,
                           GtkPixelCacheDrawFunc  draw,
                           cairo_rectangle_int_t *view_rect,
                           cairo_rectangle_int_t *canvas_rect,
+                          cairo_rectangle_int_t *needed,
+                          guint                  n_needed,
                           gpointer               user_data)
 {
-  cairo_t *backing_cr;
-  cairo_region_t *region_dirty = cache->surface_dirty;
-  cache->surface_dirty = NULL;
+  GList *l;
+  guint i;
 
-  if (cache->surface &&
-      region_dirty &&
-      !cairo_region_is_empty (region_dirty))
+  for (l = cache->lru.head, i = 0; i < n_needed; l = l->next, i++)
     {
-      backing_cr = cairo_create (cache->surface);
-      gdk_cairo_region (backing_cr, region_dirty);
-      cairo_clip (backing_cr);
-      cairo_translate (backing_cr,
-                       -cache->surface_x - canvas_rect->x - view_rect->x,
-                       -cache->surface_y - canvas_rect->y - view_rect->y);
-
-      cairo_save (backing_cr);
-      cairo_set_source_rgba (backing_cr,
-                             0.0, 0, 0, 0.0);
-      cairo_set_operator (backing_cr, CAIRO_OPERATOR_SOURCE);
-      cairo_paint (backing_cr);
-      cairo_restore (backing_cr);
+      GtkPixelCacheTile *tile = l->data;
+      guint64 mask;
 
-      cairo_save (backing_cr);
-      draw (backing_cr, user_data);
-      cairo_restore (backing_cr);
+      mask = tile->dirty & gtk_pixel_cache_tile_get_mask (tile, needed);
+      if (mask == 0)
+        continue;
 
-#ifdef G_ENABLE_DEBUG
-      if (GTK_DISPLAY_DEBUG_CHECK (gdk_window_get_display (window), PIXEL_CACHE))
-        {
-          GdkRGBA colors[] = {
-            { 1, 0, 0, 0.08},
-            { 0, 1, 0, 0.08},
-            { 0, 0, 1, 0.08},
-            { 1, 0, 1, 0.08},
-            { 1, 1, 0, 0.08},
-            { 0, 1, 1, 0.08},
-          };
-          static int current_color = 0;
-
-          gdk_cairo_set_source_rgba (backing_cr, &colors[(current_color++) % G_N_ELEMENTS (colors)]);
-          cairo_paint (backing_cr);
-        }
-#endif
-
-      cairo_destroy (backing_cr);
+      gtk_pixel_cache_repaint_tile (cache, tile, window, draw,
+                                    view_rect, canvas_rect,
+                                    mask, user_data);
     }
-
-  if (region_dirty)
-    cairo_region_destroy (region_dirty);
 }
 
 static void
 gtk_pixel_cache_blow_cache (GtkPixelCache *cache)
 {
   g_clear_pointer (&cache->timeout_source, g_source_destroy);
-  g_clear_pointer (&cache->surface, cairo_surface_destroy);
-  g_clear_pointer (&cache->surface_dirty, cairo_region_destroy);
+  gtk_pixel_cache_clear_tiles (cache);
 }
 
 static gboolean
@@ -415,6 +522,24 @@ context_is_unscaled (cairo_t *cr)
   return x == 1 && y == 1;
 }
 
+static gboolean
+gtk_pixel_cache_should_cache (GtkPixelCache         *cache,
+                              GdkWindow             *window,
+                              cairo_rectangle_int_t *view_rect,
+                              cairo_rectangle_int_t *canvas_rect)
+{
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DISPLAY_DEBUG_CHECK (gdk_window_get_display (window), NO_PIXEL_CACHE))
+    return FALSE;
+#endif
+
+  /* Don't cache if view >= canvas, as we won't
+   * be scrolling then anyway, unless the widget requested it.
+   */
+  return cache->always_cache ||
+         view_rect->width < canvas_rect->width ||
+         view_rect->height < canvas_rect->height;
+}
 
 void
 _gtk_pixel_cache_draw (GtkPixelCache         *cache,
@@ -425,6 +550,11 @@ _gtk_pixel_cache_draw (GtkPixelCache         *cache,
                        GtkPixelCacheDrawFunc  draw,
                        gpointer               user_data)
 {
+  cairo_rectangle_int_t view_pos, needed, canvas;
+  guint n_needed;
+  GList *l;
+  guint i;
+
   if (cache->timeout_source)
     {
       gint64 deadline;
@@ -441,23 +571,80 @@ _gtk_pixel_cache_draw (GtkPixelCache         *cache,
       g_source_set_name (cache->timeout_source, "[gtk+] blow_cache_cb");
     }
 
-  _gtk_pixel_cache_create_surface_if_needed (cache, window,
-                                             view_rect, canvas_rect);
-  _gtk_pixel_cache_set_position (cache, view_rect, canvas_rect);
-  _gtk_pixel_cache_repaint (cache, window, draw, view_rect, canvas_rect, user_data);
+  if (!gtk_pixel_cache_should_cache (cache, window, view_rect, canvas_rect))
+    {
+      gtk_pixel_cache_clear_tiles (cache);
+
+      cairo_rectangle (cr,
+                       view_rect->x, view_rect->y,
+                       view_rect->width, view_rect->height);
+      cairo_clip (cr);
+      draw (cr, user_data);
+      return;
+    }
+
+  gtk_pixel_cache_set_canvas_size (cache, canvas_rect->width, canvas_rect->height);
 
-  if (cache->surface && context_is_unscaled (cr) &&
+  /* Position of view inside canvas */
+  view_pos.x = -canvas_rect->x;
+  view_pos.y = -canvas_rect->y;
+  view_pos.width = view_rect->width;
+  view_pos.height = view_rect->height;
+
+  /* The area we keep rendered: the view plus the extra size,
+   * split evenly on both sides, limited to the canvas and
+   * rounded out to whole cells */
+  needed.x = view_pos.x - (int) cache->extra_width / 2;
+  needed.y = view_pos.y - (int) cache->extra_height / 2;
+  needed.width = view_pos.width + cache->extra_width;
+  needed.height = view_pos.height + cache->extra_height;
+
+  canvas.x = 0;
+  canvas.y = 0;
+  canvas.width = canvas_rect->width;
+  canvas.height = canvas_rect->height;
+  if (!gdk_rectangle_intersect (&needed, &canvas, &needed))
+    needed = view_pos;
+
+  needed.width = needed.x + needed.width;
+  needed.height = needed.y + needed.height;
+  needed.x = floor_div (needed.x, TILE_CELL_SIZE) * TILE_CELL_SIZE;
+  needed.y = floor_div (needed.y, TILE_CELL_SIZE) * TILE_CELL_SIZE;
+  needed.width = floor_div (needed.width + TILE_CELL_SIZE - 1, TILE_CELL_SIZE) * TILE_CELL_SIZE - needed.x;
+  needed.height = floor_div (needed.height + TILE_CELL_SIZE - 1, TILE_CELL_SIZE) * TILE_CELL_SIZE - needed.y;
+
+  n_needed = gtk_pixel_cache_ensure_tiles (cache, window, &needed);
+  _gtk_pixel_cache_repaint (cache, window, draw, view_rect, canvas_rect,
+                            &needed, n_needed, user_data);
+
+  if (n_needed > 0 && context_is_unscaled (cr) &&
       /* Don't use backing surface if rendering elsewhere */
-      cairo_surface_get_type (cache->surface) == cairo_surface_get_type (cairo_get_target (cr)))
+      cairo_surface_get_type (((GtkPixelCacheTile *) cache->lru.head->data)->surface) ==
+      cairo_surface_get_type (cairo_get_target (cr)))
     {
-      cairo_save (cr);
-      cairo_set_source_surface (cr, cache->surface,
-                                cache->surface_x + view_rect->x + canvas_rect->x,
-                                cache->surface_y + view_rect->y + canvas_rect->y);
-      cairo_rectangle (cr, view_rect->x, view_rect->y,
-                       view_rect->width, view_rect->height);
-      cairo_fill (cr);
-      cairo_restore (cr);
+      for (l = cache->lru.head, i = 0; i < n_needed; l = l->next, i++)
+        {
+          GtkPixelCacheTile *tile = l->data;
+          cairo_rectangle_int_t tile_rect, r;
+
+          tile_rect.x = tile->x;
+          tile_rect.y = tile->y;
+          tile_rect.width = TILE_SIZE;
+          tile_rect.height = TILE_SIZE;
+          if (!gdk_rectangle_intersect (&tile_rect, &view_pos, &r))
+            continue;
+
+          cairo_save (cr);
+          cairo_set_source_surface (cr, tile->surface,
+                                    tile->x + view_rect->x + canvas_rect->x,
+                                    tile->y + view_rect->y + canvas_rect->y);
+          cairo_rectangle (cr,
+                           r.x + view_rect->x + canvas_rect->x,
+                           r.y + view_rect->y + canvas_rect->y,
+                           r.width, r.height);
+          cairo_fill (cr);
+          cairo_restore (cr);
+        }
     }
   else
     {
@@ -148,6 +148,7 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
   gint min_baseline = -1;
   gint nat_baseline = -1;
   gboolean found_in_cache;
+  gboolean evicted = FALSE;
 
   gtk_widget_ensure_resize (widget);
 
@@ -317,15 +318,18 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
 						   &nat_baseline);
 	}
 
-      _gtk_size_request_cache_commit (cache,
-                                      orientation,
-                                      for_size,
-                                      min_size,
-                                      nat_size,
-				      min_baseline,
-				      nat_baseline);
+      evicted = _gtk_size_request_cache_commit (cache,
+                                                orientation,
+                                                for_size,
+                                                min_size,
+                                                nat_size,
+                                                min_baseline,
+                                                nat_baseline);
     }
 
+  if (for_size >= 0 && _gtk_size_request_cache_get_collect_statistics ())
+    _gtk_size_request_cache_count (G_OBJECT_TYPE (widget), found_in_cache, evicted);
+
   if (minimum_size)
     *minimum_size = min_size;
 
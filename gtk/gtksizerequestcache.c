@@ -25,51 +25,173 @@
 
 #include <string.h>
 
+/* Number of slots handed out beyond GTK_SIZE_REQUEST_CACHED_SIZES,
+ * summed over all caches. Bounds the memory adaptive growth can use.
+ */
+static guint n_extra_sizes = 0;
+
+static gboolean collect_statistics = FALSE;
+static GHashTable *statistics = NULL;
+static SizeRequestCacheStats totals;
+
 void
 _gtk_size_request_cache_init (SizeRequestCache *cache)
 {
   memset (cache, 0, sizeof (SizeRequestCache));
+
+  cache->flags[GTK_ORIENTATION_HORIZONTAL].max_cached_requests = GTK_SIZE_REQUEST_CACHED_SIZES;
+  cache->flags[GTK_ORIENTATION_VERTICAL].max_cached_requests = GTK_SIZE_REQUEST_CACHED_SIZES;
 }
 
 static void
-free_sizes_x (SizeRequestX **sizes)
+free_sizes_x (SizeRequestX **sizes,
+              guint          n_sizes)
 {
-  gint i;
+  guint i;
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
+  for (i = 0; i < n_sizes && sizes[i] != NULL; i++)
     g_slice_free (SizeRequestX, sizes[i]);
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  g_slice_free1 (sizeof (SizeRequestX *) * n_sizes, sizes);
 }
 
 static void
-free_sizes_y (SizeRequestY **sizes)
+free_sizes_y (SizeRequestY **sizes,
+              guint          n_sizes)
 {
-  gint i;
+  guint i;
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
+  for (i = 0; i < n_sizes && sizes[i] != NULL; i++)
     g_slice_free (SizeRequestY, sizes[i]);
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  g_slice_free1 (sizeof (SizeRequestY *) * n_sizes, sizes);
 }
 
-void
-_gtk_size_request_cache_free (SizeRequestCache *cache)
+static void
+free_requests (SizeRequestCache *cache)
 {
   if (cache->requests_x)
-    free_sizes_x (cache->requests_x);
+    free_sizes_x (cache->requests_x, cache->flags[GTK_ORIENTATION_HORIZONTAL].max_cached_requests);
   if (cache->requests_y)
-    free_sizes_y (cache->requests_y);
+    free_sizes_y (cache->requests_y, cache->flags[GTK_ORIENTATION_VERTICAL].max_cached_requests);
 }
 
 void
-_gtk_size_request_cache_clear (SizeRequestCache *cache)
+_gtk_size_request_cache_free (SizeRequestCache *cache)
 {
-  _gtk_size_request_cache_free (cache);
-  _gtk_size_request_cache_init (cache);
+  free_requests (cache);
+
+  n_extra_sizes -= cache->flags[GTK_ORIENTATION_HORIZONTAL].max_cached_requests - GTK_SIZE_REQUEST_CACHED_SIZES;
+  n_extra_sizes -= cache->flags[GTK_ORIENTATION_VERTICAL].max_cached_requests - GTK_SIZE_REQUEST_CACHED_SIZES;
 }
 
 void
+_gtk_size_request_cache_clear (SizeRequestCache *cache)
+{
+  guint max_x, max_y, evictions_x, evictions_y;
+
+  /* The cache size a widget has grown to is a property of the
+   * widget, not of its current contents, so keep it around.
+   */
+  max_x = cache->flags[GTK_ORIENTATION_HORIZONTAL].max_cached_requests;
+  max_y = cache->flags[GTK_ORIENTATION_VERTICAL].max_cached_requests;
+  evictions_x = cache->flags[GTK_ORIENTATION_HORIZONTAL].n_evictions;
+  evictions_y = cache->flags[GTK_ORIENTATION_VERTICAL].n_evictions;
+
+  free_requests (cache);
+  memset (cache, 0, sizeof (SizeRequestCache));
+
+  cache->flags[GTK_ORIENTATION_HORIZONTAL].max_cached_requests = max_x;
+  cache->flags[GTK_ORIENTATION_VERTICAL].max_cached_requests = max_y;
+  cache->flags[GTK_ORIENTATION_HORIZONTAL].n_evictions = evictions_x;
+  cache->flags[GTK_ORIENTATION_VERTICAL].n_evictions = evictions_y;
+}
+
+/* Called when an entry is about to be evicted. Once a cache has
+ * evicted as many entries as it can hold, its working set clearly
+ * does not fit, so give it twice the room if the global budget
+ * allows.
+ *
+ * Returns: %TRUE if the cache was grown and the new entry can be
+ *     appended instead of evicting one
+ */
+static gboolean
+maybe_grow_cache (SizeRequestCache *cache,
+                  GtkOrientation    orientation)
+{
+  gpointer *requests, *new_requests;
+  guint n_sizes, new_n_sizes;
+
+  n_sizes = cache->flags[orientation].max_cached_requests;
+
+  if (++cache->flags[orientation].n_evictions < n_sizes)
+    return FALSE;
+
+  cache->flags[orientation].n_evictions = 0;
+
+  new_n_sizes = MIN (n_sizes * 2, GTK_SIZE_REQUEST_MAX_CACHED_SIZES);
+  if (new_n_sizes == n_sizes ||
+      n_extra_sizes + new_n_sizes - n_sizes > GTK_SIZE_REQUEST_MAX_EXTRA_SIZES)
+    return FALSE;
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    requests = (gpointer *) cache->requests_x;
+  else
+    requests = (gpointer *) cache->requests_y;
+
+  new_requests = g_slice_alloc0 (sizeof (gpointer) * new_n_sizes);
+  memcpy (new_requests, requests, sizeof (gpointer) * n_sizes);
+  g_slice_free1 (sizeof (gpointer) * n_sizes, requests);
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    cache->requests_x = (SizeRequestX **) new_requests;
+  else
+    cache->requests_y = (SizeRequestY **) new_requests;
+
+  cache->flags[orientation].max_cached_requests = new_n_sizes;
+  n_extra_sizes += new_n_sizes - n_sizes;
+
+  return TRUE;
+}
+
+/* Picks the slot for a new entry, growing the cache or evicting
+ * the oldest entry as needed.
+ *
+ * Returns: %TRUE if an entry was evicted
+ */
+static gboolean
+next_cached_request (SizeRequestCache *cache,
+                     GtkOrientation    orientation)
+{
+  guint n_sizes, max_sizes;
+
+  n_sizes = cache->flags[orientation].n_cached_requests;
+  max_sizes = cache->flags[orientation].max_cached_requests;
+
+  if (n_sizes == max_sizes && maybe_grow_cache (cache, orientation))
+    max_sizes = cache->flags[orientation].max_cached_requests;
+
+  /* The returned size cache will immediately be used to cache the
+   * new computed size so we go ahead and increment the
+   * last_cached_request right away */
+  if (n_sizes < max_sizes)
+    {
+      cache->flags[orientation].n_cached_requests++;
+      cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
+      return FALSE;
+    }
+  else
+    {
+      if (++cache->flags[orientation].last_cached_request == max_sizes)
+        cache->flags[orientation].last_cached_request = 0;
+      return TRUE;
+    }
+}
+
+/* Returns: %TRUE if a cached entry had to be evicted to make
+ *     room for the new one
+ */
+gboolean
 _gtk_size_request_cache_commit (SizeRequestCache *cache,
                                 GtkOrientation    orientation,
                                 gint              for_size,
@@ -79,6 +201,7 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 				gint              natural_baseline)
 {
   guint         i, n_sizes;
+  gboolean      evicted;
 
   if (orientation == GTK_ORIENTATION_HORIZONTAL)
     {
@@ -103,7 +226,7 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	}
 
       cache->flags[orientation].cached_size_valid = TRUE;
-      return;
+      return FALSE;
     }
 
   /* Check if the minimum_size and natural_size is already
@@ -126,26 +249,15 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	    {
 	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
 	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
-	      return;
+	      return FALSE;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
-
       if (cache->requests_x == NULL)
-	cache->requests_x = g_slice_alloc0 (sizeof (SizeRequestX *) * GTK_SIZE_REQUEST_CACHED_SIZES);
+	cache->requests_x = g_slice_alloc0 (sizeof (SizeRequestX *) * cache->flags[orientation].max_cached_requests);
+
+      /* If not found, pull a new size from the cache */
+      evicted = next_cached_request (cache, orientation);
 
       if (cache->requests_x[cache->flags[orientation].last_cached_request] == NULL)
 	cache->requests_x[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestX);
@@ -171,26 +283,15 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	    {
 	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
 	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
-	      return;
+	      return FALSE;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
-
       if (cache->requests_y == NULL)
-	cache->requests_y = g_slice_alloc0 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES);
+	cache->requests_y = g_slice_alloc0 (sizeof (SizeRequestY *) * cache->flags[orientation].max_cached_requests);
+
+      /* If not found, pull a new size from the cache */
+      evicted = next_cached_request (cache, orientation);
 
       if (cache->requests_y[cache->flags[orientation].last_cached_request] == NULL)
 	cache->requests_y[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestY);
@@ -203,6 +304,8 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
       cached_size->cached_size.minimum_baseline = minimum_baseline;
       cached_size->cached_size.natural_baseline = natural_baseline;
     }
+
+  return evicted;
 }
 
 /* looks for a cached size request for this for_size.
@@ -297,3 +400,78 @@ _gtk_size_request_cache_lookup (SizeRequestCache *cache,
     }
 }
 
+
+/* Per widget type statistics, collected while the inspector
+ * shows them.
+ */
+void
+_gtk_size_request_cache_set_collect_statistics (gboolean collect)
+{
+  collect_statistics = collect;
+}
+
+gboolean
+_gtk_size_request_cache_get_collect_statistics (void)
+{
+  return collect_statistics;
+}
+
+void
+_gtk_size_request_cache_count (GType    type,
+                               gboolean hit,
+                               gboolean evicted)
+{
+  SizeRequestCacheStats *stats;
+
+  if (G_UNLIKELY (statistics == NULL))
+    statistics = g_hash_table_new (NULL, NULL);
+
+  stats = g_hash_table_lookup (statistics, GSIZE_TO_POINTER (type));
+  if (stats == NULL)
+    {
+      stats = g_new0 (SizeRequestCacheStats, 1);
+      stats->type = type;
+      g_hash_table_insert (statistics, GSIZE_TO_POINTER (type), stats);
+    }
+
+  if (hit)
+    {
+      stats->n_hits++;
+      totals.n_hits++;
+    }
+  else
+    {
+      stats->n_misses++;
+      totals.n_misses++;
+    }
+
+  if (evicted)
+    {
+      stats->n_evictions++;
+      totals.n_evictions++;
+    }
+}
+
+/* Returns: (transfer container) (element-type SizeRequestCacheStats):
+ *     the statistics for all widget types that have been counted
+ */
+GList *
+_gtk_size_request_cache_get_statistics (void)
+{
+  if (statistics == NULL)
+    return NULL;
+
+  return g_hash_table_get_values (statistics);
+}
+
+void
+_gtk_size_request_cache_get_totals (guint64 *n_hits,
+                                    guint64 *n_misses,
+                                    guint64 *n_evictions,
+                                    guint   *n_extra)
+{
+  *n_hits = totals.n_hits;
+  *n_misses = totals.n_misses;
+  *n_evictions = totals.n_evictions;
+  *n_extra = n_extra_sizes;
+}
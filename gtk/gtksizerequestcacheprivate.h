@@ -35,8 +35,16 @@ G_BEGIN_DECLS
  * for a said widget to have, if a label can
  * only wrap to 3 lines, only 3 caches will
  * ever be allocated for it.
+ *
+ * Widgets start out with GTK_SIZE_REQUEST_CACHED_SIZES
+ * slots; widgets that keep evicting entries get their
+ * cache doubled up to GTK_SIZE_REQUEST_MAX_CACHED_SIZES,
+ * as long as the total number of extra slots handed out
+ * stays below GTK_SIZE_REQUEST_MAX_EXTRA_SIZES.
  */
-#define GTK_SIZE_REQUEST_CACHED_SIZES   (5)
+#define GTK_SIZE_REQUEST_CACHED_SIZES       (5)
+#define GTK_SIZE_REQUEST_MAX_CACHED_SIZES   (40)
+#define GTK_SIZE_REQUEST_MAX_EXTRA_SIZES    (16384)
 
 typedef struct {
   gint minimum_size;
@@ -74,17 +82,26 @@ typedef struct {
   GtkSizeRequestMode request_mode   : 3;
   guint       request_mode_valid    : 1;
   struct {
-    guint       n_cached_requests   : 3;
-    guint       last_cached_request : 3;
+    guint       n_cached_requests   : 6;
+    guint       last_cached_request : 6;
+    guint       max_cached_requests : 6;
+    guint       n_evictions         : 6;
     guint       cached_size_valid   : 1;
   }           flags[2];
 } SizeRequestCache;
 
+typedef struct {
+  GType       type;
+  guint64     n_hits;
+  guint64     n_misses;
+  guint64     n_evictions;
+} SizeRequestCacheStats;
+
 void            _gtk_size_request_cache_init                    (SizeRequestCache       *cache);
 void            _gtk_size_request_cache_free                    (SizeRequestCache       *cache);
 
 void            _gtk_size_request_cache_clear                   (SizeRequestCache       *cache);
-void            _gtk_size_request_cache_commit                  (SizeRequestCache       *cache,
+gboolean        _gtk_size_request_cache_commit                  (SizeRequestCache       *cache,
                                                                  GtkOrientation          orientation,
                                                                  gint                    for_size,
                                                                  gint                    minimum_size,
@@ -99,6 +116,17 @@ gboolean        _gtk_size_request_cache_lookup                  (SizeRequestCach
                                                                  gint                   *minimum_baseline,
                                                                  gint                   *natural_baseline);
 
+void            _gtk_size_request_cache_set_collect_statistics  (gboolean                collect);
+gboolean        _gtk_size_request_cache_get_collect_statistics  (void);
+void            _gtk_size_request_cache_count                   (GType                   type,
+                                                                 gboolean                hit,
+                                                                 gboolean                evicted);
+GList *         _gtk_size_request_cache_get_statistics          (void);
+void            _gtk_size_request_cache_get_totals              (guint64                *n_hits,
+                                                                 guint64                *n_misses,
+                                                                 guint64                *n_evictions,
+                                                                 guint                  *n_extra_sizes);
+
 G_END_DECLS
 
 #endif /* __GTK_SIZE_REQUEST_CACHE_PRIVATE_H__ */
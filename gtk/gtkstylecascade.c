@@ -333,14 +333,14 @@ _gtk_style_cascade_set_parent (GtkStyleCascade *cascade,
       g_object_ref (parent);
       g_signal_connect_swapped (parent,
                                 "-gtk-private-changed",
-                                G_CALLBACK (_gtk_style_provider_private_changed),
+                                G_CALLBACK (_gtk_style_provider_private_changed_selectors),
                                 cascade);
     }
 
   if (cascade->parent)
     {
       g_signal_handlers_disconnect_by_func (cascade->parent, 
-                                            _gtk_style_provider_private_changed,
+                                            _gtk_style_provider_private_changed_selectors,
                                             cascade);
       g_object_unref (cascade->parent);
     }
@@ -364,7 +364,7 @@ _gtk_style_cascade_add_provider (GtkStyleCascade  *cascade,
   data.priority = priority;
   data.changed_signal_id = g_signal_connect_swapped (provider,
                                                      "-gtk-private-changed",
-                                                     G_CALLBACK (_gtk_style_provider_private_changed),
+                                                     G_CALLBACK (_gtk_style_provider_private_changed_selectors),
                                                      cascade);
 
   /* ensure it gets removed first */
@@ -40,8 +40,8 @@ _gtk_style_provider_private_default_init (GtkStyleProviderPrivateInterface *ifac
                                    G_SIGNAL_RUN_LAST,
                                    G_STRUCT_OFFSET (GtkStyleProviderPrivateInterface, changed),
                                    NULL, NULL,
-                                   g_cclosure_marshal_VOID__VOID,
-                                   G_TYPE_NONE, 0);
+                                   g_cclosure_marshal_VOID__POINTER,
+                                   G_TYPE_NONE, 1, G_TYPE_POINTER);
 
 }
 
@@ -110,7 +110,26 @@ _gtk_style_provider_private_changed (GtkStyleProviderPrivate *provider)
 {
   gtk_internal_return_if_fail (GTK_IS_STYLE_PROVIDER_PRIVATE (provider));
 
-  g_signal_emit (provider, signals[CHANGED], 0);
+  g_signal_emit (provider, signals[CHANGED], 0, NULL);
+}
+
+/**
+ * _gtk_style_provider_private_changed_selectors:
+ * @provider: the provider that changed
+ * @selectors: (allow-none): the selectors of all rules that were added,
+ *     removed or modified, or %NULL if every node may be affected
+ *
+ * Like _gtk_style_provider_private_changed(), but lets handlers know
+ * that only nodes matched by @selectors may need a new style. The
+ * selectors are passed to the handlers of the changed signal.
+ */
+void
+_gtk_style_provider_private_changed_selectors (GtkStyleProviderPrivate  *provider,
+                                               const GtkCssSelectorTree *selectors)
+{
+  gtk_internal_return_if_fail (GTK_IS_STYLE_PROVIDER_PRIVATE (provider));
+
+  g_signal_emit (provider, signals[CHANGED], 0, selectors);
 }
 
 GtkSettings *
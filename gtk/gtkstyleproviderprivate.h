@@ -22,6 +22,7 @@
 #include "gtk/gtkcsskeyframesprivate.h"
 #include "gtk/gtkcsslookupprivate.h"
 #include "gtk/gtkcssmatcherprivate.h"
+#include "gtk/gtkcssselectorprivate.h"
 #include "gtk/gtkcssvalueprivate.h"
 #include <gtk/gtktypes.h>
 
@@ -53,7 +54,8 @@ struct _GtkStyleProviderPrivateInterface
                                                  GtkCssSection           *section,
                                                  const GError            *error);
   /* signal */
-  void                  (* changed)             (GtkStyleProviderPrivate *provider);
+  void                  (* changed)             (GtkStyleProviderPrivate *provider,
+                                                 const GtkCssSelectorTree *selectors);
 };
 
 GType                   _gtk_style_provider_private_get_type     (void) G_GNUC_CONST;
@@ -70,6 +72,9 @@ void                    _gtk_style_provider_private_lookup       (GtkStyleProvid
                                                                   GtkCssChange            *out_change);
 
 void                    _gtk_style_provider_private_changed      (GtkStyleProviderPrivate *provider);
+void                    _gtk_style_provider_private_changed_selectors
+                                                                 (GtkStyleProviderPrivate *provider,
+                                                                  const GtkCssSelectorTree *selectors);
 
 void                    _gtk_style_provider_private_emit_error   (GtkStyleProviderPrivate *provider,
                                                                   GtkCssSection           *section,
@@ -62,7 +62,7 @@
 #include "gtktexttag.h"
 #include "gtktexttagprivate.h"
 #include "gtktexttagtable.h"
-#include "gtktextlayout.h"
+#include "gtktextlayoutprivate.h"
 #include "gtktextiterprivate.h"
 #include "gtkdebug.h"
 #include "gtktextmarkprivate.h"
@@ -105,6 +105,11 @@ struct _NodeData {
   gint height;
   signed int width : 24;
 
+  /* Number of lines below this node whose height is known. The
+   * other lines count with the estimated line height of the view.
+   */
+  gint n_sized;
+
   /* boolean indicating whether the lines below this node are in need of validation.
    * However, width/height should always represent the current total width and
    * max height for lines below this node; the valid flag indicates whether the
@@ -169,8 +174,21 @@ struct _BTreeView {
   GtkTextLayout *layout;
   BTreeView *next;
   BTreeView *prev;
+
+  /* Height of lines that were never measured */
+  gint estimated_line_height;
 };
 
+static inline gint
+line_data_get_height (GtkTextLineData *ld,
+                      BTreeView       *view)
+{
+  if (ld && ld->sized)
+    return ld->height;
+
+  return view->estimated_line_height;
+}
+
 /*
  * And the tree itself
  */
@@ -215,6 +233,9 @@ struct _GtkTextBTree {
   guint end_iter_segment_stamp;
   
   GHashTable *child_anchor_table;
+
+  /* Inserted text is allocated from here */
+  GtkTextCharArena *char_arena;
 };
 
 
@@ -307,7 +328,7 @@ static NodeData         *    gtk_text_btree_node_ensure_data         (GtkTextBTr
 static void                  gtk_text_btree_node_remove_data         (GtkTextBTreeNode *node,
                                                                       gpointer          view_id);
 static void                  gtk_text_btree_node_get_size            (GtkTextBTreeNode *node,
-                                                                      gpointer          view_id,
+                                                                      BTreeView        *view,
                                                                       gint             *width,
                                                                       gint             *height);
 static GtkTextBTreeNode *    gtk_text_btree_node_common_parent       (GtkTextBTreeNode *node1,
@@ -430,6 +451,8 @@ _gtk_text_btree_new (GtkTextTagTable *table,
   tree->end_iter_line = NULL;
   tree->end_iter_segment_byte_index = 0;
   tree->end_iter_segment_char_offset = 0;
+
+  tree->char_arena = _gtk_char_arena_new ();
   
   g_object_ref (tree->table);
 
@@ -528,6 +551,9 @@ _gtk_text_btree_unref (GtkTextBTree *tree)
       g_object_unref (tree->selection_bound_mark);
       tree->selection_bound_mark = NULL;
 
+      _gtk_char_arena_free (tree->char_arena);
+      tree->char_arena = NULL;
+
       g_slice_free (GtkTextBTree, tree);
     }
 }
@@ -1001,6 +1027,7 @@ _gtk_text_btree_delete (GtkTextIter *start,
 
           gint deleted_width = 0;
           gint deleted_height = 0;
+          gboolean deleted_sized = FALSE;
 
           line = deleted_lines;
           while (line)
@@ -1012,6 +1039,7 @@ _gtk_text_btree_delete (GtkTextIter *start,
                 {
                   deleted_width = MAX (deleted_width, ld->width);
                   deleted_height += ld->height;
+                  deleted_sized |= ld->sized;
                 }
 
               line = next_line;
@@ -1038,6 +1066,10 @@ _gtk_text_btree_delete (GtkTextIter *start,
               ld->width = MAX (deleted_width, ld->width);
               ld->height += deleted_height;
               ld->valid = FALSE;
+
+              /* Unmeasured lines keep counting with the estimate */
+              if (deleted_sized)
+                ld->sized = TRUE;
             }
 
           gtk_text_btree_node_check_valid_downward (ancestor_node, view->view_id);
@@ -1092,6 +1124,164 @@ _gtk_text_btree_delete (GtkTextIter *start,
   gtk_text_btree_resolve_bidi (start, end);
 }
 
+/**
+ * _gtk_text_btree_delete_first_lines:
+ * @tree: a #GtkTextBTree
+ * @n_lines: number of lines to delete
+ *
+ * Deletes the first @n_lines lines of @tree, which must leave at
+ * least one line. Unlike _gtk_text_btree_delete(), this unlinks the
+ * lines as a whole instead of joining the first and the last line
+ * of the range, so the remaining lines keep their size in the views
+ * and nothing needs to be revalidated. Marks in the deleted lines
+ * move to the start of the new first line, and so do the toggles
+ * of tags that are still on there.
+ */
+void
+_gtk_text_btree_delete_first_lines (GtkTextBTree *tree,
+                                    gint          n_lines)
+{
+  GtkTextLineSegment *carried = NULL;       /* Segments refusing to die */
+  GtkTextLineSegment **carried_tail = &carried;
+  GtkTextLineSegment *seg, *next, **prev_p;
+  GtkTextBTreeNode *curnode, *node;
+  GtkTextLine *first_line;
+  GtkTextLine *line, *next_line;
+  GtkTextLine *deleted_lines = NULL;
+  BTreeView *view;
+  gint *heights;
+  gint n_views;
+  gint i;
+
+  g_return_if_fail (tree != NULL);
+  g_return_if_fail (n_lines < _gtk_text_btree_line_count (tree));
+
+  if (n_lines <= 0)
+    return;
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (TEXT))
+    _gtk_text_btree_check (tree);
+#endif
+
+  first_line = _gtk_text_btree_get_line (tree, n_lines, NULL);
+
+  /* The deleted lines take up everything above the new first line */
+  n_views = 0;
+  for (view = tree->views; view != NULL; view = view->next)
+    n_views++;
+
+  heights = g_newa (gint, n_views);
+  for (view = tree->views, i = 0; view != NULL; view = view->next, i++)
+    heights[i] = _gtk_text_btree_find_line_top (tree, first_line, view->view_id);
+
+  line = _gtk_text_btree_get_line (tree, 0, NULL);
+  while (line != first_line)
+    {
+      gint char_count = 0;
+
+      next_line = _gtk_text_line_next (line);
+      curnode = line->parent;
+
+      for (seg = line->segments; seg != NULL; seg = next)
+        {
+          next = seg->next;
+          char_count += seg->char_count;
+
+          if ((*seg->type->deleteFunc) (seg, line, FALSE) == 0)
+            continue;
+
+          /* A toggle-off cancels the toggle-on carried along for its
+           * tag, so only tags that are still on reach the new first
+           * line.
+           */
+          if (seg->type == &gtk_text_toggle_off_type)
+            {
+              for (prev_p = &carried; *prev_p != NULL; prev_p = &(*prev_p)->next)
+                {
+                  if ((*prev_p)->type == &gtk_text_toggle_on_type &&
+                      (*prev_p)->body.toggle.info == seg->body.toggle.info)
+                    break;
+                }
+
+              if (*prev_p != NULL)
+                {
+                  GtkTextLineSegment *on = *prev_p;
+
+                  *prev_p = on->next;
+                  if (carried_tail == &on->next)
+                    carried_tail = prev_p;
+
+                  _gtk_toggle_segment_free (on);
+                  _gtk_toggle_segment_free (seg);
+                  continue;
+                }
+            }
+
+          seg->next = NULL;
+          *carried_tail = seg;
+          carried_tail = &seg->next;
+        }
+      line->segments = NULL;
+
+      /* Deleted lines are always the first child of their node */
+      g_assert (curnode->children.line == line);
+      curnode->children.line = line->next;
+      curnode->num_children--;
+
+      for (node = curnode; node != NULL; node = node->parent)
+        {
+          node->num_chars -= char_count;
+          node->num_lines--;
+        }
+
+      while (curnode->num_children == 0)
+        {
+          GtkTextBTreeNode *parent = curnode->parent;
+
+          g_assert (parent->children.node == curnode);
+          parent->children.node = curnode->next;
+          parent->num_children--;
+          gtk_text_btree_node_free_empty (tree, curnode);
+          curnode = parent;
+        }
+
+      line->next = deleted_lines;
+      deleted_lines = line;
+      line = next_line;
+    }
+
+  if (carried != NULL)
+    {
+      *carried_tail = first_line->segments;
+      first_line->segments = carried;
+    }
+
+  cleanup_line (first_line);
+
+  chars_changed (tree);
+  segments_changed (tree);
+
+  for (view = tree->views; view != NULL; view = view->next)
+    gtk_text_btree_node_check_valid_upward (first_line->parent, view->view_id);
+
+  gtk_text_btree_rebalance (tree, first_line->parent);
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (TEXT))
+    _gtk_text_btree_check (tree);
+#endif
+
+  for (view = tree->views, i = 0; view != NULL; view = view->next, i++)
+    _gtk_text_layout_first_lines_deleted (view->layout, deleted_lines, heights[i]);
+
+  for (line = deleted_lines; line != NULL; line = next_line)
+    {
+      next_line = line->next;
+      gtk_text_line_destroy (tree, line);
+    }
+}
+
 void
 _gtk_text_btree_insert (GtkTextIter *iter,
                         const gchar *text,
@@ -1121,6 +1311,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   int char_count_delta;                /* change to number of chars */
   GtkTextBTree *tree;
   gint start_byte_index;
+  gint end_byte_index;
   GtkTextLine *start_line;
 
   g_return_if_fail (text != NULL);
@@ -1158,6 +1349,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   sol = 0;
   line_count_delta = 0;
   char_count_delta = 0;
+  end_byte_index = start_byte_index;
   while (eol < len)
     {
       sol = eol;
@@ -1180,19 +1372,34 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       chunk_len = eol - sol;
 
       g_assert (g_utf8_validate (&text[sol], chunk_len, NULL));
-      seg = _gtk_char_segment_new (&text[sol], chunk_len);
-
-      char_count_delta += seg->char_count;
+      end_byte_index += chunk_len;
 
-      if (cur_seg == NULL)
+      /* Appending to the segment in front of the insertion point
+       * saves splitting and merging it again in cleanup_line()
+       */
+      if (cur_seg != NULL &&
+          cur_seg->type == &gtk_text_char_type &&
+          _gtk_char_segment_append (cur_seg, &text[sol], chunk_len))
         {
-          seg->next = line->segments;
-          line->segments = seg;
+          seg = cur_seg;
+          char_count_delta += g_utf8_strlen (&text[sol], chunk_len);
         }
       else
         {
-          seg->next = cur_seg->next;
-          cur_seg->next = seg;
+          seg = _gtk_char_segment_new_in_arena (tree->char_arena,
+                                                &text[sol], chunk_len);
+          char_count_delta += seg->char_count;
+
+          if (cur_seg == NULL)
+            {
+              seg->next = line->segments;
+              line->segments = seg;
+            }
+          else
+            {
+              seg->next = cur_seg->next;
+              cur_seg->next = seg;
+            }
         }
 
       if (delim == eol)
@@ -1215,6 +1422,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       seg->next = NULL;
       line = newline;
       cur_seg = NULL;
+      end_byte_index = 0;
       line_count_delta++;
     }
 
@@ -1242,12 +1450,10 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                       &start,
                                       start_line,
                                       start_byte_index);
-    end = start;
-
-    /* We could almost certainly be more efficient here
-       by saving the information from the insertion loop
-       above. FIXME */
-    gtk_text_iter_forward_chars (&end, char_count_delta);
+    _gtk_text_btree_get_iter_at_line (tree,
+                                      &end,
+                                      line,
+                                      end_byte_index);
 
     DV (g_print ("invalidating due to inserting some text (%s)\n", G_STRLOC));
     _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
@@ -1379,16 +1585,16 @@ find_line_by_y (GtkTextBTree *tree, BTreeView *view,
         {
           GtkTextLineData *ld;
 
+          gint height;
+
           ld = _gtk_text_line_get_data (line, view->view_id);
+          height = line_data_get_height (ld, view);
 
-          if (ld)
-            {
-              if (y < (current_y + ld->height))
-                return line;
+          if (y < (current_y + height))
+            return line;
 
-              current_y += ld->height;
-              *line_top += ld->height;
-            }
+          current_y += height;
+          *line_top += height;
 
           line = line->next;
         }
@@ -1405,7 +1611,7 @@ find_line_by_y (GtkTextBTree *tree, BTreeView *view,
           gint width;
           gint height;
 
-          gtk_text_btree_node_get_size (child, view->view_id,
+          gtk_text_btree_node_get_size (child, view,
                                         &width, &height);
 
           if (y < (current_y + height))
@@ -1463,8 +1669,7 @@ find_line_top_in_line_list (GtkTextBTree *tree,
         return y;
 
       ld = _gtk_text_line_get_data (line, view->view_id);
-      if (ld)
-        y += ld->height;
+      y += line_data_get_height (ld, view);
 
       line = line->next;
     }
@@ -1529,7 +1734,7 @@ _gtk_text_btree_find_line_top (GtkTextBTree *tree,
                 break;
               else
                 {
-                  gtk_text_btree_node_get_size (child, view->view_id,
+                  gtk_text_btree_node_get_size (child, view,
                                                 &width, &height);
                   y += height;
                 }
@@ -1560,6 +1765,7 @@ _gtk_text_btree_add_view (GtkTextBTree *tree,
 
   view->view_id = layout;
   view->layout = layout;
+  view->estimated_line_height = 0;
 
   view->next = tree->views;
   view->prev = NULL;
@@ -1584,6 +1790,7 @@ _gtk_text_btree_add_view (GtkTextBTree *tree,
   line_data->width = 0;
   line_data->height = 0;
   line_data->valid = TRUE;
+  line_data->sized = TRUE;
 
   _gtk_text_line_add_data (last_line, line_data);
 }
@@ -1661,13 +1868,102 @@ _gtk_text_btree_get_view_size (GtkTextBTree *tree,
                               gint *width,
                               gint *height)
 {
+  BTreeView *view;
+
   g_return_if_fail (tree != NULL);
   g_return_if_fail (view_id != NULL);
 
-  gtk_text_btree_node_get_size (tree->root_node, view_id,
+  view = gtk_text_btree_get_view (tree, view_id);
+  g_return_if_fail (view != NULL);
+
+  gtk_text_btree_node_get_size (tree->root_node, view,
                                 width, height);
 }
 
+/**
+ * _gtk_text_btree_get_line_height:
+ * @tree: a #GtkTextBTree
+ * @line: a #GtkTextLine
+ * @view_id: view ID for the view
+ *
+ * Returns the height of @line in the view, which is the estimated
+ * line height of the view if the line was never measured.
+ *
+ * Returns: the height of @line
+ **/
+gint
+_gtk_text_btree_get_line_height (GtkTextBTree *tree,
+                                 GtkTextLine  *line,
+                                 gpointer      view_id)
+{
+  BTreeView *view;
+
+  g_return_val_if_fail (tree != NULL, 0);
+  g_return_val_if_fail (line != NULL, 0);
+
+  view = gtk_text_btree_get_view (tree, view_id);
+  g_return_val_if_fail (view != NULL, 0);
+
+  return line_data_get_height (_gtk_text_line_get_data (line, view_id), view);
+}
+
+/**
+ * _gtk_text_btree_set_estimated_line_height:
+ * @tree: a #GtkTextBTree
+ * @view_id: view ID for the view
+ * @height: the height to use for lines that were never measured
+ *
+ * Sets the height that lines count with in the view until they are
+ * measured. This changes the size of the view and the position of
+ * lines after unmeasured ones, but doesn’t emit any signals.
+ **/
+void
+_gtk_text_btree_set_estimated_line_height (GtkTextBTree *tree,
+                                           gpointer      view_id,
+                                           gint          height)
+{
+  BTreeView *view;
+
+  g_return_if_fail (tree != NULL);
+  g_return_if_fail (height >= 0);
+
+  view = gtk_text_btree_get_view (tree, view_id);
+  g_return_if_fail (view != NULL);
+
+  view->estimated_line_height = height;
+}
+
+/**
+ * _gtk_text_btree_get_mean_line_height:
+ * @tree: a #GtkTextBTree
+ * @view_id: view ID for the view
+ *
+ * Computes the mean height of the lines that were measured in
+ * the view.
+ *
+ * Returns: the mean line height, or 0 if no line was measured yet
+ **/
+gint
+_gtk_text_btree_get_mean_line_height (GtkTextBTree *tree,
+                                      gpointer      view_id)
+{
+  NodeData *nd;
+  gint n_lines;
+
+  g_return_val_if_fail (tree != NULL, 0);
+
+  nd = node_data_find (tree->root_node->node_data, view_id);
+  if (nd == NULL)
+    return 0;
+
+  /* The last line always has an empty size */
+  n_lines = nd->n_sized - 1;
+  if (n_lines <= 0)
+    return 0;
+
+  return (nd->height + n_lines / 2) / n_lines;
+}
+
 /*
  * Tag
  */
@@ -2655,8 +2951,9 @@ redisplay_region (GtkTextBTree      *tree,
         start_y -= ld->top_ink;
 
       ld = _gtk_text_line_get_data (end_line, view->view_id);
+      end_y += line_data_get_height (ld, view);
       if (ld)
-        end_y += ld->height + ld->bottom_ink;
+        end_y += ld->bottom_ink;
 
       if (cursors_only)
 	gtk_text_layout_cursors_changed (view->layout, start_y,
@@ -3623,6 +3920,7 @@ _gtk_text_line_data_new (GtkTextLayout *layout,
   line_data->top_ink = 0;
   line_data->bottom_ink = 0;
   line_data->valid = FALSE;
+  line_data->sized = FALSE;
 
   return line_data;
 }
@@ -4843,6 +5141,7 @@ node_data_new (gpointer view_id)
   nd->next = NULL;
   nd->width = 0;
   nd->height = 0;
+  nd->n_sized = 0;
   nd->valid = FALSE;
 
   return nd;
@@ -5082,6 +5381,7 @@ gtk_text_btree_node_validate (BTreeView         *view,
   gint node_valid = TRUE;
   gint node_width = 0;
   gint node_height = 0;
+  gint node_n_sized = 0;
 
   NodeData *nd = gtk_text_btree_node_ensure_data (node, view_id);
   g_return_if_fail (!nd->valid);
@@ -5108,6 +5408,7 @@ gtk_text_btree_node_validate (BTreeView         *view,
               state->y += ld->height;
               node_width = MAX (ld->width, node_width);
               node_height += ld->height;
+              node_n_sized++;
             }
 
           line = line->next;
@@ -5124,13 +5425,13 @@ gtk_text_btree_node_validate (BTreeView         *view,
             break;
           else
             {
-              if (ld)
-                state->old_height += ld->height;
+              state->old_height += line_data_get_height (ld, view);
               ld = gtk_text_layout_wrap (view->layout, line, ld);
               state->new_height += ld->height;
 
               node_width = MAX (ld->width, node_width);
               node_height += ld->height;
+              node_n_sized++;
 
               state->remaining_pixels -= ld->height;
               if (state->remaining_pixels <= 0)
@@ -5156,6 +5457,8 @@ gtk_text_btree_node_validate (BTreeView         *view,
             {
               node_width = MAX (ld->width, node_width);
               node_height += ld->height;
+              if (ld->sized)
+                node_n_sized++;
             }
 
           line = line->next;
@@ -5185,6 +5488,7 @@ gtk_text_btree_node_validate (BTreeView         *view,
               state->y += child_nd->height;
               node_width = MAX (node_width, child_nd->width);
               node_height += child_nd->height;
+              node_n_sized += child_nd->n_sized;
             }
 
           child = child->next;
@@ -5205,6 +5509,7 @@ gtk_text_btree_node_validate (BTreeView         *view,
                 node_valid = FALSE;
               node_width = MAX (node_width, child_nd->width);
               node_height += child_nd->height;
+              node_n_sized += child_nd->n_sized;
 
               if (!state->in_validation || state->remaining_pixels <= 0)
                 {
@@ -5227,6 +5532,7 @@ gtk_text_btree_node_validate (BTreeView         *view,
 
           node_width = MAX (child_nd->width, node_width);
           node_height += child_nd->height;
+          node_n_sized += child_nd->n_sized;
 
           child = child->next;
         }
@@ -5234,6 +5540,7 @@ gtk_text_btree_node_validate (BTreeView         *view,
 
   nd->width = node_width;
   nd->height = node_height;
+  nd->n_sized = node_n_sized;
   nd->valid = node_valid;
 }
 
@@ -5305,10 +5612,12 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
                                              gpointer          view_id,
                                              gint             *width_out,
                                              gint             *height_out,
+                                             gint             *n_sized_out,
                                              gboolean         *valid_out)
 {
   gint width = 0;
   gint height = 0;
+  gint n_sized = 0;
   gboolean valid = TRUE;
 
   if (node->level == 0)
@@ -5326,6 +5635,8 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
             {
               width = MAX (ld->width, width);
               height += ld->height;
+              if (ld->sized)
+                n_sized++;
             }
 
           line = line->next;
@@ -5346,6 +5657,7 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
             {
               width = MAX (child_nd->width, width);
               height += child_nd->height;
+              n_sized += child_nd->n_sized;
             }
 
           child = child->next;
@@ -5354,6 +5666,7 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
 
   *width_out = width;
   *height_out = height;
+  *n_sized_out = n_sized;
   *valid_out = valid;
 }
 
@@ -5369,11 +5682,14 @@ gtk_text_btree_node_check_valid (GtkTextBTreeNode *node,
   gboolean valid;
   gint width;
   gint height;
+  gint n_sized;
 
   gtk_text_btree_node_compute_view_aggregates (node, view_id,
-                                               &width, &height, &valid);
+                                               &width, &height, &n_sized,
+                                               &valid);
   nd->width = width;
   nd->height = height;
+  nd->n_sized = n_sized;
   nd->valid = valid;
 
   return nd;
@@ -5407,6 +5723,7 @@ gtk_text_btree_node_check_valid_downward (GtkTextBTreeNode *node,
       nd->valid = TRUE;
       nd->width = 0;
       nd->height = 0;
+      nd->n_sized = 0;
 
       while (child)
         {
@@ -5416,6 +5733,7 @@ gtk_text_btree_node_check_valid_downward (GtkTextBTreeNode *node,
             nd->valid = FALSE;
           nd->width = MAX (child_nd->width, nd->width);
           nd->height += child_nd->height;
+          nd->n_sized += child_nd->n_sized;
 
           child = child->next;
         }
@@ -5457,6 +5775,96 @@ _gtk_text_btree_validate_line (GtkTextBTree     *tree,
     }
 }
 
+/**
+ * _gtk_text_btree_update_line_sizes:
+ * @tree: a #GtkTextBTree
+ * @view_id: view ID for the view
+ * @lines: lines whose line data was updated
+ * @n_lines: number of lines
+ *
+ * Propagate sizes and validity that were stored directly in the
+ * line data of @lines up through the tree. This is used when lines
+ * are validated without going through gtk_text_layout_wrap().
+ **/
+void
+_gtk_text_btree_update_line_sizes (GtkTextBTree  *tree,
+                                   gpointer       view_id,
+                                   GtkTextLine  **lines,
+                                   guint          n_lines)
+{
+  GtkTextBTreeNode *parent = NULL;
+  guint i;
+
+  g_return_if_fail (tree != NULL);
+
+  for (i = 0; i < n_lines; i++)
+    {
+      /* Lines of a batch are mostly consecutive */
+      if (lines[i]->parent == parent)
+        continue;
+
+      parent = lines[i]->parent;
+      gtk_text_btree_node_check_valid_upward (parent, view_id);
+    }
+}
+
+static GtkTextLine *
+gtk_text_btree_node_find_invalid_line (GtkTextBTreeNode *node,
+                                       gpointer          view_id)
+{
+  NodeData *nd;
+
+  nd = node_data_find (node->node_data, view_id);
+  if (nd != NULL && nd->valid)
+    return NULL;
+
+  if (node->level == 0)
+    {
+      GtkTextLine *line;
+
+      for (line = node->children.line; line != NULL; line = line->next)
+        {
+          GtkTextLineData *ld = _gtk_text_line_get_data (line, view_id);
+
+          if (ld == NULL || !ld->valid)
+            return line;
+        }
+    }
+  else
+    {
+      GtkTextBTreeNode *child;
+
+      for (child = node->children.node; child != NULL; child = child->next)
+        {
+          GtkTextLine *line = gtk_text_btree_node_find_invalid_line (child, view_id);
+
+          if (line != NULL)
+            return line;
+        }
+    }
+
+  return NULL;
+}
+
+/**
+ * _gtk_text_btree_get_first_invalid_line:
+ * @tree: a #GtkTextBTree
+ * @view_id: view ID for the view
+ *
+ * Finds the first line that is not valid for the given view.
+ *
+ * Returns: the first invalid line, or %NULL if the whole
+ *     tree is valid
+ **/
+GtkTextLine *
+_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                        gpointer      view_id)
+{
+  g_return_val_if_fail (tree != NULL, NULL);
+
+  return gtk_text_btree_node_find_invalid_line (tree->root_node, view_id);
+}
+
 static void
 gtk_text_btree_node_remove_view (BTreeView *view, GtkTextBTreeNode *node, gpointer view_id)
 {
@@ -5603,7 +6011,7 @@ gtk_text_btree_node_remove_data (GtkTextBTreeNode *node, gpointer view_id)
 }
 
 static void
-gtk_text_btree_node_get_size (GtkTextBTreeNode *node, gpointer view_id,
+gtk_text_btree_node_get_size (GtkTextBTreeNode *node, BTreeView *view,
                               gint *width, gint *height)
 {
   NodeData *nd;
@@ -5611,12 +6019,13 @@ gtk_text_btree_node_get_size (GtkTextBTreeNode *node, gpointer view_id,
   g_return_if_fail (width != NULL);
   g_return_if_fail (height != NULL);
 
-  nd = gtk_text_btree_node_ensure_data (node, view_id);
+  nd = gtk_text_btree_node_ensure_data (node, view->view_id);
 
   if (width)
     *width = nd->width;
   if (height)
-    *height = nd->height;
+    *height = nd->height +
+              (node->num_lines - nd->n_sized) * view->estimated_line_height;
 }
 
 /* Find the closest common ancestor of the two nodes. FIXME: The interface
@@ -6661,6 +7070,7 @@ gtk_text_btree_node_view_check_consistency (GtkTextBTree     *tree,
 {
   gint width;
   gint height;
+  gint n_sized;
   gboolean valid;
   BTreeView *view;
   
@@ -6679,7 +7089,8 @@ gtk_text_btree_node_view_check_consistency (GtkTextBTree     *tree,
              nd->view_id);
   
   gtk_text_btree_node_compute_view_aggregates (node, nd->view_id,
-                                               &width, &height, &valid);
+                                               &width, &height, &n_sized,
+                                               &valid);
 
   /* valid aggregate not checked the same as width/height, because on
    * btree rebalance we can have invalid nodes where all lines below
@@ -6693,13 +7104,14 @@ gtk_text_btree_node_view_check_consistency (GtkTextBTree     *tree,
   
   if (nd->width != width ||
       nd->height != height ||
+      nd->n_sized != n_sized ||
       (nd->valid && !valid))
     {
       g_error ("Node aggregates for view %p are invalid:\n"
-               "Are (%d,%d,%s), should be (%d,%d,%s)",
+               "Are (%d,%d,%d,%s), should be (%d,%d,%d,%s)",
                nd->view_id,
-               nd->width, nd->height, nd->valid ? "TRUE" : "FALSE",
-               width, height, valid ? "TRUE" : "FALSE");
+               nd->width, nd->height, nd->n_sized, nd->valid ? "TRUE" : "FALSE",
+               width, height, n_sized, valid ? "TRUE" : "FALSE");
     }
 }
 
@@ -65,6 +65,8 @@ gboolean _gtk_text_btree_is_end (GtkTextBTree       *tree,
 
 void _gtk_text_btree_delete        (GtkTextIter *start,
                                     GtkTextIter *end);
+void _gtk_text_btree_delete_first_lines (GtkTextBTree *tree,
+                                         gint          n_lines);
 void _gtk_text_btree_insert        (GtkTextIter *iter,
                                     const gchar *text,
                                     gint         len);
@@ -96,6 +98,14 @@ void         _gtk_text_btree_get_view_size     (GtkTextBTree      *tree,
                                                 gpointer           view_id,
                                                 gint              *width,
                                                 gint              *height);
+gint         _gtk_text_btree_get_line_height   (GtkTextBTree      *tree,
+                                                GtkTextLine       *line,
+                                                gpointer           view_id);
+void         _gtk_text_btree_set_estimated_line_height (GtkTextBTree *tree,
+                                                        gpointer      view_id,
+                                                        gint          height);
+gint         _gtk_text_btree_get_mean_line_height      (GtkTextBTree *tree,
+                                                        gpointer      view_id);
 gboolean     _gtk_text_btree_is_valid          (GtkTextBTree      *tree,
                                                 gpointer           view_id);
 gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
@@ -107,6 +117,12 @@ gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
 void         _gtk_text_btree_validate_line     (GtkTextBTree      *tree,
                                                 GtkTextLine       *line,
                                                 gpointer           view_id);
+void         _gtk_text_btree_update_line_sizes (GtkTextBTree      *tree,
+                                                gpointer           view_id,
+                                                GtkTextLine      **lines,
+                                                guint              n_lines);
+GtkTextLine *_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                                     gpointer      view_id);
 
 /* Tag */
 
@@ -223,7 +239,8 @@ struct _GtkTextLineData {
   gint top_ink : 16;
   gint bottom_ink : 16;
   signed int width : 24;
-  guint valid : 8;		/* Actually a boolean */
+  guint valid : 1;
+  guint sized : 1;              /* height was measured, even if no longer valid */
 };
 
 /*
@@ -75,9 +75,18 @@ struct _GtkTextBufferPrivate
 
   guint user_action_count;
 
+  gint max_lines;
+
+  /* Lines are only dropped once the outermost insertion that
+   * still needs its offsets, or the outermost user action, is done
+   */
+  guint trim_freeze_count;
+
   /* Whether the buffer has been modified since last save */
   guint modified : 1;
   guint has_selection : 1;
+  guint trim_pending : 1;
+  guint trimming : 1;
 };
 
 typedef struct _ClipboardRequest ClipboardRequest;
@@ -119,6 +128,7 @@ enum {
   PROP_CURSOR_POSITION,
   PROP_COPY_TARGET_LIST,
   PROP_PASTE_TARGET_LIST,
+  PROP_MAX_LINES,
   LAST_PROP
 };
 
@@ -155,6 +165,13 @@ static void          free_log_attr_cache (GtkTextLogAttrCache *cache);
 
 static void remove_all_selection_clipboards       (GtkTextBuffer *buffer);
 static void update_selection_clipboards           (GtkTextBuffer *buffer);
+static void gtk_text_buffer_end_user_action_at_iter (GtkTextBuffer *buffer,
+                                                     GtkTextIter   *iter);
+static void gtk_text_buffer_freeze_trim           (GtkTextBuffer *buffer);
+static void gtk_text_buffer_thaw_trim             (GtkTextBuffer *buffer,
+                                                   GtkTextIter   *iter);
+static void gtk_text_buffer_trim_lines            (GtkTextBuffer *buffer,
+                                                   GtkTextIter   *iter);
 
 static GtkTextBuffer *create_clipboard_contents_buffer (GtkTextBuffer *buffer);
 
@@ -281,6 +298,22 @@ gtk_text_buffer_class_init (GtkTextBufferClass *klass)
                           GTK_TYPE_TARGET_LIST,
                           GTK_PARAM_READABLE);
 
+  /**
+   * GtkTextBuffer:max-lines:
+   *
+   * The maximum number of lines the buffer holds, or 0 for no limit.
+   * See gtk_text_buffer_set_max_lines().
+   *
+   * Since: 3.24
+   */
+  text_buffer_props[PROP_MAX_LINES] =
+      g_param_spec_int ("max-lines",
+                        P_("Maximum lines"),
+                        P_("The maximum number of lines in the buffer, or 0 for no limit"),
+                        0, G_MAXINT,
+                        0,
+                        GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (object_class, LAST_PROP, text_buffer_props);
 
   /**
@@ -705,6 +738,10 @@ gtk_text_buffer_set_property (GObject         *object,
 				g_value_get_string (value), -1);
       break;
 
+    case PROP_MAX_LINES:
+      gtk_text_buffer_set_max_lines (text_buffer, g_value_get_int (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -759,6 +796,10 @@ gtk_text_buffer_get_property (GObject         *object,
       g_value_set_boxed (value, gtk_text_buffer_get_paste_target_list (text_buffer));
       break;
 
+    case PROP_MAX_LINES:
+      g_value_set_int (value, text_buffer->priv->max_lines);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -935,6 +976,14 @@ gtk_text_buffer_emit_insert (GtkTextBuffer *buffer,
     {
       g_signal_emit (buffer, signals[INSERT_TEXT], 0,
                      iter, text, len);
+
+      /* Only once all handlers have seen the inserted text, and
+       * callers are done with offsets from before the insertion
+       */
+      if (buffer->priv->trim_freeze_count > 0)
+        buffer->priv->trim_pending = TRUE;
+      else
+        gtk_text_buffer_trim_lines (buffer, iter);
     }
 }
 
@@ -1026,7 +1075,7 @@ gtk_text_buffer_insert_interactive (GtkTextBuffer *buffer,
     {
       gtk_text_buffer_begin_user_action (buffer);
       gtk_text_buffer_emit_insert (buffer, iter, text, len);
-      gtk_text_buffer_end_user_action (buffer);
+      gtk_text_buffer_end_user_action_at_iter (buffer, iter);
       return TRUE;
     }
   else
@@ -1371,8 +1420,11 @@ gtk_text_buffer_real_insert_range (GtkTextBuffer     *buffer,
   if (gtk_text_iter_equal (orig_start, orig_end))
     return;
 
+  /* Tags are applied by offsets from before each insertion */
   if (interactive)
     gtk_text_buffer_begin_user_action (buffer);
+  else
+    gtk_text_buffer_freeze_trim (buffer);
   
   src_buffer = gtk_text_iter_get_buffer (orig_start);
   
@@ -1413,7 +1465,9 @@ gtk_text_buffer_real_insert_range (GtkTextBuffer     *buffer,
     }
   
   if (interactive)
-    gtk_text_buffer_end_user_action (buffer);
+    gtk_text_buffer_end_user_action_at_iter (buffer, iter);
+  else
+    gtk_text_buffer_thaw_trim (buffer, iter);
 }
 
 /**
@@ -1527,10 +1581,9 @@ gtk_text_buffer_insert_with_tags (GtkTextBuffer *buffer,
   
   start_offset = gtk_text_iter_get_offset (iter);
 
-  gtk_text_buffer_insert (buffer, iter, text, len);
+  gtk_text_buffer_freeze_trim (buffer);
 
-  if (first_tag == NULL)
-    return;
+  gtk_text_buffer_insert (buffer, iter, text, len);
 
   gtk_text_buffer_get_iter_at_offset (buffer, &start, start_offset);
 
@@ -1544,6 +1597,8 @@ gtk_text_buffer_insert_with_tags (GtkTextBuffer *buffer,
     }
 
   va_end (args);
+
+  gtk_text_buffer_thaw_trim (buffer, iter);
 }
 
 /**
@@ -1578,10 +1633,9 @@ gtk_text_buffer_insert_with_tags_by_name  (GtkTextBuffer *buffer,
   
   start_offset = gtk_text_iter_get_offset (iter);
 
-  gtk_text_buffer_insert (buffer, iter, text, len);
+  gtk_text_buffer_freeze_trim (buffer);
 
-  if (first_tag_name == NULL)
-    return;
+  gtk_text_buffer_insert (buffer, iter, text, len);
 
   gtk_text_buffer_get_iter_at_offset (buffer, &start, start_offset);
 
@@ -1597,8 +1651,7 @@ gtk_text_buffer_insert_with_tags_by_name  (GtkTextBuffer *buffer,
       if (tag == NULL)
         {
           g_warning ("%s: no tag with name '%s'!", G_STRLOC, tag_name);
-          va_end (args);
-          return;
+          break;
         }
 
       gtk_text_buffer_apply_tag (buffer, tag, &start, iter);
@@ -1607,6 +1660,8 @@ gtk_text_buffer_insert_with_tags_by_name  (GtkTextBuffer *buffer,
     }
 
   va_end (args);
+
+  gtk_text_buffer_thaw_trim (buffer, iter);
 }
 
 
@@ -1625,7 +1680,22 @@ gtk_text_buffer_real_delete_range (GtkTextBuffer *buffer,
   g_return_if_fail (start != NULL);
   g_return_if_fail (end != NULL);
 
-  _gtk_text_btree_delete (start, end);
+  /* Dropping whole lines at the start of the buffer for max-lines
+   * leaves the remaining lines alone, so views don't have to lay
+   * them out again
+   */
+  if (buffer->priv->trimming &&
+      gtk_text_iter_is_start (start) &&
+      gtk_text_iter_starts_line (end) &&
+      gtk_text_iter_get_line (end) > 0)
+    {
+      _gtk_text_btree_delete_first_lines (get_btree (buffer),
+                                          gtk_text_iter_get_line (end));
+      gtk_text_buffer_get_start_iter (buffer, start);
+      *end = *start;
+    }
+  else
+    _gtk_text_btree_delete (start, end);
 
   /* may have deleted the selection... */
   update_selection_clipboards (buffer);
@@ -3182,6 +3252,157 @@ gtk_text_buffer_get_char_count (GtkTextBuffer *buffer)
   return _gtk_text_btree_char_count (get_btree (buffer));
 }
 
+/* Drops lines from the start of the buffer when it holds more than
+ * max_lines lines, and keeps @iter pointing at the same text if it
+ * is not dropped along with them.
+ */
+static void
+gtk_text_buffer_freeze_trim (GtkTextBuffer *buffer)
+{
+  buffer->priv->trim_freeze_count++;
+}
+
+static void
+gtk_text_buffer_thaw_trim (GtkTextBuffer *buffer,
+                           GtkTextIter   *iter)
+{
+  GtkTextBufferPrivate *priv = buffer->priv;
+
+  g_assert (priv->trim_freeze_count > 0);
+
+  /* Still frozen while trimming, so that insertions done by
+   * ::delete-range handlers don't trim recursively
+   */
+  if (priv->trim_freeze_count == 1 && priv->trim_pending)
+    {
+      priv->trim_pending = FALSE;
+      gtk_text_buffer_trim_lines (buffer, iter);
+    }
+
+  priv->trim_freeze_count--;
+}
+
+static void
+gtk_text_buffer_trim_lines (GtkTextBuffer *buffer,
+                            GtkTextIter   *iter)
+{
+  GtkTextBufferPrivate *priv = buffer->priv;
+  GtkTextIter start, end;
+  gint n_lines;
+  gint n_deleted;
+  gint line = 0;
+  gint line_index = 0;
+
+  if (priv->max_lines == 0)
+    return;
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  if (n_lines <= priv->max_lines)
+    return;
+
+  /* Delete a few more lines than needed, so that lines
+   * are dropped in batches instead of one per insertion
+   */
+  n_deleted = n_lines - priv->max_lines + priv->max_lines / 16;
+  n_deleted = MIN (n_deleted, n_lines - 1);
+
+  if (iter)
+    {
+      line = gtk_text_iter_get_line (iter);
+      line_index = gtk_text_iter_get_line_index (iter);
+    }
+
+  /* The default handler of ::delete-range takes the fast path
+   * for whole lines at the start of the buffer
+   */
+  gtk_text_buffer_get_start_iter (buffer, &start);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, n_deleted);
+  priv->trimming = TRUE;
+  gtk_text_buffer_emit_delete (buffer, &start, &end);
+  priv->trimming = FALSE;
+
+  if (iter)
+    {
+      /* Handlers may have prevented or changed the deletion */
+      n_deleted = n_lines - gtk_text_buffer_get_line_count (buffer);
+
+      if (line >= n_deleted)
+        gtk_text_buffer_get_iter_at_line_index (buffer, iter,
+                                                line - n_deleted, line_index);
+      else
+        gtk_text_buffer_get_start_iter (buffer, iter);
+    }
+}
+
+/**
+ * gtk_text_buffer_set_max_lines:
+ * @buffer: a #GtkTextBuffer
+ * @max_lines: the maximum number of lines, or 0 for no limit
+ *
+ * Limits the number of lines in @buffer, as returned by
+ * gtk_text_buffer_get_line_count(), to @max_lines. This is meant
+ * for logs and terminal-like output that only keep the most recent
+ * lines.
+ *
+ * When an insertion makes the buffer grow beyond @max_lines lines,
+ * whole lines are dropped from its start, after the
+ * #GtkTextBuffer::insert-text signal has been emitted. Functions
+ * that do more than insert text, such as
+ * gtk_text_buffer_insert_with_tags(), only drop them once they are
+ * done, and inside a user action they are dropped when the outermost
+ * gtk_text_buffer_end_user_action() is called. Lines are dropped in
+ * batches, so the buffer may hold somewhat fewer than @max_lines
+ * lines afterwards. Dropping lines emits
+ * #GtkTextBuffer::delete-range like any other deletion, but the
+ * remaining lines don’t need to be laid out again by the views of
+ * the buffer. Marks in the dropped lines move to the start of the
+ * buffer.
+ *
+ * Since: 3.24
+ */
+void
+gtk_text_buffer_set_max_lines (GtkTextBuffer *buffer,
+                               gint           max_lines)
+{
+  GtkTextBufferPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (max_lines >= 0);
+
+  priv = buffer->priv;
+
+  if (priv->max_lines == max_lines)
+    return;
+
+  priv->max_lines = max_lines;
+
+  if (priv->trim_freeze_count > 0)
+    priv->trim_pending = TRUE;
+  else
+    gtk_text_buffer_trim_lines (buffer, NULL);
+
+  g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_MAX_LINES]);
+}
+
+/**
+ * gtk_text_buffer_get_max_lines:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Returns the maximum number of lines set with
+ * gtk_text_buffer_set_max_lines().
+ *
+ * Returns: the maximum number of lines, or 0 for no limit
+ *
+ * Since: 3.24
+ */
+gint
+gtk_text_buffer_get_max_lines (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), 0);
+
+  return buffer->priv->max_lines;
+}
+
 /* Called when we lose the primary selection.
  */
 static void
@@ -4157,6 +4378,7 @@ gtk_text_buffer_begin_user_action (GtkTextBuffer *buffer)
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
 
   buffer->priv->user_action_count += 1;
+  gtk_text_buffer_freeze_trim (buffer);
   
   if (buffer->priv->user_action_count == 1)
     {
@@ -4177,7 +4399,20 @@ gtk_text_buffer_end_user_action (GtkTextBuffer *buffer)
 {
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (buffer->priv->user_action_count > 0);
-  
+
+  gtk_text_buffer_end_user_action_at_iter (buffer, NULL);
+}
+
+/* Like gtk_text_buffer_end_user_action(), but keeps @iter valid
+ * if lines are dropped for max-lines when the action ends.
+ */
+static void
+gtk_text_buffer_end_user_action_at_iter (GtkTextBuffer *buffer,
+                                         GtkTextIter   *iter)
+{
+  /* Dropped lines are part of the action */
+  gtk_text_buffer_thaw_trim (buffer, iter);
+
   buffer->priv->user_action_count -= 1;
   
   if (buffer->priv->user_action_count == 0)
@@ -4919,6 +5154,8 @@ gtk_text_buffer_insert_with_attributes (GtkTextBuffer *buffer,
       return;
     }
 
+  gtk_text_buffer_freeze_trim (buffer);
+
   /* create mark with right gravity */
   mark = gtk_text_buffer_create_mark (buffer, NULL, iter, FALSE);
   attr = pango_attr_list_get_iterator (attributes);
@@ -4945,6 +5182,8 @@ gtk_text_buffer_insert_with_attributes (GtkTextBuffer *buffer,
   
   gtk_text_buffer_delete_mark (buffer, mark);
   pango_attr_iterator_destroy (attr);
+
+  gtk_text_buffer_thaw_trim (buffer, iter);
 } 
 
 /**
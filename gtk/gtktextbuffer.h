@@ -174,6 +174,11 @@ GDK_AVAILABLE_IN_ALL
 gint           gtk_text_buffer_get_line_count (GtkTextBuffer   *buffer);
 GDK_AVAILABLE_IN_ALL
 gint           gtk_text_buffer_get_char_count (GtkTextBuffer   *buffer);
+GDK_AVAILABLE_IN_3_24
+void           gtk_text_buffer_set_max_lines  (GtkTextBuffer   *buffer,
+                                               gint             max_lines);
+GDK_AVAILABLE_IN_3_24
+gint           gtk_text_buffer_get_max_lines  (GtkTextBuffer   *buffer);
 
 
 GDK_AVAILABLE_IN_ALL
@@ -78,7 +78,7 @@
 #define GTK_TEXT_USE_INTERNAL_UNSUPPORTED_API
 #include "config.h"
 #include "gtkmarshalers.h"
-#include "gtktextlayout.h"
+#include "gtktextlayoutprivate.h"
 #include "gtktextbtree.h"
 #include "gtktextbufferprivate.h"
 #include "gtktextiterprivate.h"
@@ -91,6 +91,12 @@
 
 #define GTK_TEXT_LAYOUT_GET_PRIVATE(o)  ((GtkTextLayoutPrivate *) gtk_text_layout_get_instance_private ((o)))
 
+/* Number of line displays kept per layout. This should be more
+ * than the number of lines visible at once, so that redrawing a
+ * view that didn't change doesn't lay out any text.
+ */
+#define DISPLAY_CACHE_SIZE 256
+
 typedef struct _GtkTextLayoutPrivate GtkTextLayoutPrivate;
 
 struct _GtkTextLayoutPrivate
@@ -99,6 +105,22 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* Recently used line displays, mapping lines to links in
+   * display_lru, most recently used first. Only displays created
+   * for drawing are kept here; size-only displays go into
+   * one_display_cache, so that validating the buffer doesn't
+   * push out the lines on screen.
+   */
+  GHashTable *display_cache;
+  GQueue display_lru;
+
+  /* Lines being validated in the background, mapped to their batch */
+  GHashTable *background_lines;
+
+  /* Height that lines which were never measured count with */
+  gint estimated_line_height;
+  guint estimate_line_heights : 1;
 };
 
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
@@ -129,6 +151,8 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
 
+static void display_cache_clear (GtkTextLayout *layout);
+
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
 static void gtk_text_layout_mark_set_handler    (GtkTextBuffer     *buffer,
@@ -195,12 +219,7 @@ gtk_text_layout_dispose (GObject *object)
   g_clear_object (&layout->ltr_context);
   g_clear_object (&layout->rtl_context);
 
-  if (layout->one_display_cache)
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  display_cache_clear (layout);
 
   if (layout->preedit_attrs != NULL)
     {
@@ -220,6 +239,9 @@ gtk_text_layout_finalize (GObject *object)
 
   g_free (layout->preedit_string);
 
+  g_hash_table_unref (GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->display_cache);
+  g_hash_table_unref (GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->background_lines);
+
   G_OBJECT_CLASS (gtk_text_layout_parent_class)->finalize (object);
 }
 
@@ -278,7 +300,13 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  priv->display_cache = g_hash_table_new (NULL, NULL);
+  g_queue_init (&priv->display_lru);
+  priv->background_lines = g_hash_table_new (NULL, NULL);
 }
 
 GtkTextLayout*
@@ -305,13 +333,20 @@ void
 gtk_text_layout_set_buffer (GtkTextLayout *layout,
                             GtkTextBuffer *buffer)
 {
+  GtkTextLayoutPrivate *priv;
+
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (buffer == NULL || GTK_IS_TEXT_BUFFER (buffer));
 
   if (layout->buffer == buffer)
     return;
 
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
   free_style_cache (layout);
+  display_cache_clear (layout);
+  g_hash_table_remove_all (priv->background_lines);
+  priv->estimated_line_height = 0;
 
   if (layout->buffer)
     {
@@ -468,7 +503,7 @@ gtk_text_layout_set_keyboard_direction (GtkTextLayout   *layout,
   if (keyboard_dir != layout->keyboard_direction)
     {
       layout->keyboard_direction = keyboard_dir;
-      gtk_text_layout_invalidate_cursor_line (layout, TRUE);
+      gtk_text_layout_invalidate_cursor_line (layout, FALSE);
     }
 }
 
@@ -630,6 +665,125 @@ gtk_text_layout_emit_changed (GtkTextLayout *layout,
   g_signal_emit (layout, signals[CHANGED], 0, y, old_height, new_height);
 }
 
+static void
+line_display_free (GtkTextLineDisplay *display)
+{
+  if (display->layout)
+    g_object_unref (display->layout);
+
+  if (display->cursors)
+    g_array_free (display->cursors, TRUE);
+
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+  if (display->pg_bg_color)
+    gdk_color_free (display->pg_bg_color);
+G_GNUC_END_IGNORE_DEPRECATIONS
+
+  if (display->pg_bg_rgba)
+    gdk_rgba_free (display->pg_bg_rgba);
+
+  g_slice_free (GtkTextLineDisplay, display);
+}
+
+static void
+line_display_invalidate_cursors (GtkTextLineDisplay *display)
+{
+  if (display->cursors)
+    g_array_free (display->cursors, TRUE);
+  display->cursors = NULL;
+  display->cursors_invalid = TRUE;
+  display->has_block_cursor = FALSE;
+}
+
+static GtkTextLineDisplay *
+display_cache_lookup (GtkTextLayout *layout,
+                      GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache, line);
+  if (link == NULL)
+    return NULL;
+
+  g_queue_unlink (&priv->display_lru, link);
+  g_queue_push_head_link (&priv->display_lru, link);
+
+  return link->data;
+}
+
+static gboolean
+display_cache_contains (GtkTextLayout      *layout,
+                        GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache, display->line);
+
+  return link != NULL && link->data == display;
+}
+
+static void
+display_cache_remove (GtkTextLayout *layout,
+                      GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache, line);
+  if (link == NULL)
+    return;
+
+  g_hash_table_remove (priv->display_cache, line);
+  g_queue_unlink (&priv->display_lru, link);
+
+  line_display_free (link->data);
+  g_list_free_1 (link);
+}
+
+static void
+display_cache_insert (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  if (priv->display_lru.length >= DISPLAY_CACHE_SIZE)
+    {
+      GtkTextLineDisplay *oldest = priv->display_lru.tail->data;
+
+      display_cache_remove (layout, oldest->line);
+    }
+
+  link = g_list_alloc ();
+  link->data = display;
+  g_queue_push_head_link (&priv->display_lru, link);
+  g_hash_table_insert (priv->display_cache, display->line, link);
+}
+
+static void
+display_cache_clear (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  if (layout->one_display_cache)
+    {
+      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
+      layout->one_display_cache = NULL;
+      gtk_text_layout_free_line_display (layout, tmp_display);
+    }
+
+  while ((link = g_queue_pop_head_link (&priv->display_lru)) != NULL)
+    {
+      line_display_free (link->data);
+      g_list_free_1 (link);
+    }
+
+  g_hash_table_remove_all (priv->display_cache);
+}
+
 static void
 text_layout_changed (GtkTextLayout *layout,
                      gint           y,
@@ -637,20 +791,43 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  GList *l, *next;
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
   if (layout->one_display_cache)
     {
       GtkTextLine *line = layout->one_display_cache->line;
-      gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
-						    line, layout);
+      gint cache_y = _gtk_text_btree_find_line_top (btree, line, layout);
       gint cache_height = layout->one_display_cache->height;
 
       if (cache_y + cache_height > y && cache_y < y + old_height)
 	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
     }
 
+  if (!cursors_only && y <= 0 && y + old_height >= layout->height)
+    {
+      /* Tags changing only colors and the like redraw everything */
+      display_cache_clear (layout);
+    }
+  else
+    {
+      for (l = priv->display_lru.head; l != NULL; l = next)
+        {
+          GtkTextLineDisplay *display = l->data;
+          gint cache_y;
+
+          next = l->next;
+
+          cache_y = _gtk_text_btree_find_line_top (btree, display->line, layout);
+          if (cache_y + display->height > y && cache_y < y + old_height)
+            gtk_text_layout_invalidate_cache (layout, display->line, cursors_only);
+        }
+    }
+
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
 }
 
@@ -810,6 +987,8 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   if (layout->buffer == NULL)
     return;
 
+  display_cache_clear (layout);
+
   gtk_text_buffer_get_bounds (layout->buffer, &start, &end);
 
   gtk_text_layout_invalidate (layout, &start, &end);
@@ -820,24 +999,33 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
   if (layout->one_display_cache && line == layout->one_display_cache->line)
     {
       GtkTextLineDisplay *display = layout->one_display_cache;
 
       if (cursors_only)
-	{
-          if (display->cursors)
-            g_array_free (display->cursors, TRUE);
-	  display->cursors = NULL;
-	  display->cursors_invalid = TRUE;
-	  display->has_block_cursor = FALSE;
-	}
+        line_display_invalidate_cursors (display);
       else
 	{
 	  layout->one_display_cache = NULL;
 	  gtk_text_layout_free_line_display (layout, display);
 	}
     }
+
+  if (cursors_only)
+    {
+      GList *link = g_hash_table_lookup (priv->display_cache, line);
+
+      if (link)
+        line_display_invalidate_cursors (link->data);
+    }
+  else
+    {
+      display_cache_remove (layout, line);
+      g_hash_table_remove (priv->background_lines, line);
+    }
 }
 
 /* Now invalidate the paragraph containing the cursor
@@ -852,16 +1040,13 @@ gtk_text_layout_invalidate_cursor_line (GtkTextLayout *layout,
   if (priv->cursor_line == NULL)
     return;
 
+  gtk_text_layout_invalidate_cache (layout, priv->cursor_line, cursors_only);
+
   line_data = _gtk_text_line_get_data (priv->cursor_line, layout);
   if (line_data)
     {
-      if (cursors_only)
-	  gtk_text_layout_invalidate_cache (layout, priv->cursor_line, TRUE);
-      else
-	{
-	  gtk_text_layout_invalidate_cache (layout, priv->cursor_line, FALSE);
-	  _gtk_text_line_invalidate_wrap (priv->cursor_line, line_data);
-	}
+      if (!cursors_only)
+	_gtk_text_line_invalidate_wrap (priv->cursor_line, line_data);
 
       gtk_text_layout_invalidated (layout);
     }
@@ -872,11 +1057,34 @@ gtk_text_layout_update_cursor_line(GtkTextLayout *layout)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextIter iter;
+  GtkTextLine *line;
 
   gtk_text_buffer_get_iter_at_mark (layout->buffer, &iter,
                                     gtk_text_buffer_get_insert (layout->buffer));
 
-  priv->cursor_line = _gtk_text_iter_get_text_line (&iter);
+  line = _gtk_text_iter_get_text_line (&iter);
+  if (line == priv->cursor_line)
+    return;
+
+  /* The line holding the cursor shows the preedit string, and
+   * takes its direction from the keyboard if it has no strong
+   * direction of its own. The old cursor line may be gone, so
+   * only look at it if it is still cached.
+   */
+  if (priv->cursor_line != NULL)
+    {
+      GtkTextLineDisplay *display = display_cache_lookup (layout, priv->cursor_line);
+
+      if (display != NULL &&
+          (layout->preedit_len > 0 ||
+           display->line->dir_strong == PANGO_DIRECTION_NEUTRAL))
+        display_cache_remove (layout, display->line);
+    }
+
+  if (layout->preedit_len > 0 || line->dir_strong == PANGO_DIRECTION_NEUTRAL)
+    display_cache_remove (layout, line);
+
+  priv->cursor_line = line;
 }
 
 static void
@@ -928,32 +1136,55 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  gint start_line, end_line;
+
+  if (gtk_text_iter_compare (start, end) > 0)
+    {
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
+
+  start_line = gtk_text_iter_get_line (start);
+  end_line = gtk_text_iter_get_line (end);
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so. Short ranges are
+   * walked line by line, long ones are checked against each
+   * cached line instead.
    */
-  if (layout->one_display_cache)
+  if (end_line - start_line < DISPLAY_CACHE_SIZE)
     {
-      GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLine *line = _gtk_text_iter_get_text_line (start);
+      gint i;
 
-      gtk_text_layout_get_iter_at_line (layout, &line_start, line, 0);
+      for (i = start_line; i <= end_line && line != NULL; i++)
+        {
+          gtk_text_layout_invalidate_cache (layout, line, TRUE);
+          line = _gtk_text_line_next (line);
+        }
+    }
+  else
+    {
+      GList *l;
+      gint n;
 
-      line_end = line_start;
-      if (!gtk_text_iter_ends_line (&line_end))
-	gtk_text_iter_forward_to_line_end (&line_end);
+      if (layout->one_display_cache)
+        {
+          n = _gtk_text_line_get_number (layout->one_display_cache->line);
+          if (n >= start_line && n <= end_line)
+            line_display_invalidate_cursors (layout->one_display_cache);
+        }
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
+      for (l = priv->display_lru.head; l != NULL; l = l->next)
+        {
+          GtkTextLineDisplay *display = l->data;
 
-      if (gtk_text_iter_compare (&line_start, end) <= 0 &&
-	  gtk_text_iter_compare (start, &line_end) <= 0)
-	{
-	  gtk_text_layout_invalidate_cache (layout, line, TRUE);
-	}
+          n = _gtk_text_line_get_number (display->line);
+          if (n >= start_line && n <= end_line)
+            line_display_invalidate_cursors (display);
+        }
     }
 
   gtk_text_layout_invalidated (layout);
@@ -986,9 +1217,45 @@ gtk_text_layout_is_valid (GtkTextLayout *layout)
                                   layout);
 }
 
+/* The estimated line height follows the mean height of the measured
+ * lines, once it has moved far enough. Lines after unmeasured ones
+ * move when it changes, so ::changed is emitted for the whole layout,
+ * which lets views keep the top of the screen in place.
+ */
+static void
+update_estimated_line_height (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  gint height, old_height;
+
+  if (priv->estimate_line_heights)
+    {
+      height = _gtk_text_btree_get_mean_line_height (btree, layout);
+      if (priv->estimated_line_height != 0 &&
+          ABS (height - priv->estimated_line_height) * 16 <= priv->estimated_line_height)
+        return;
+    }
+  else
+    height = 0;
+
+  if (height == priv->estimated_line_height)
+    return;
+
+  priv->estimated_line_height = height;
+  _gtk_text_btree_set_estimated_line_height (btree, layout, height);
+
+  old_height = layout->height;
+  _gtk_text_btree_get_view_size (btree, layout,
+                                 &layout->width, &layout->height);
+  gtk_text_layout_emit_changed (layout, 0, old_height, layout->height);
+}
+
 static void
 update_layout_size (GtkTextLayout *layout)
 {
+  update_estimated_line_height (layout);
+
   _gtk_text_btree_get_view_size (_gtk_text_buffer_get_btree (layout->buffer),
 				layout,
 				&layout->width, &layout->height);
@@ -1043,7 +1310,8 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
           gint old_height, new_height;
           gint top_ink, bottom_ink;
 	  
-	  old_height = line_data ? line_data->height : 0;
+	  old_height = _gtk_text_btree_get_line_height (_gtk_text_buffer_get_btree (layout->buffer),
+                                                        line, layout);
           top_ink = line_data ? line_data->top_ink : 0;
           bottom_ink = line_data ? line_data->bottom_ink : 0;
 
@@ -1084,7 +1352,8 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
           gint old_height, new_height;
           gint top_ink, bottom_ink;
 	  
-	  old_height = line_data ? line_data->height : 0;
+	  old_height = _gtk_text_btree_get_line_height (_gtk_text_buffer_get_btree (layout->buffer),
+                                                        line, layout);
           top_ink = line_data ? line_data->top_ink : 0;
           bottom_ink = line_data ? line_data->bottom_ink : 0;
 
@@ -1161,6 +1430,78 @@ gtk_text_layout_validate (GtkTextLayout *layout,
     }
 }
 
+/**
+ * _gtk_text_layout_set_estimate_line_heights:
+ * @layout: a #GtkTextLayout
+ * @estimate: whether to estimate the height of unmeasured lines
+ *
+ * Sets whether lines that were never validated count with the mean
+ * height of the validated lines, instead of not counting at all.
+ * This makes the size of the layout and the positions of lines
+ * close to their final values long before the whole buffer is
+ * validated.
+ */
+void
+_gtk_text_layout_set_estimate_line_heights (GtkTextLayout *layout,
+                                            gboolean       estimate)
+{
+  GtkTextLayoutPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  estimate = estimate != FALSE;
+
+  if (priv->estimate_line_heights == estimate)
+    return;
+
+  priv->estimate_line_heights = estimate;
+
+  if (layout->buffer)
+    update_layout_size (layout);
+}
+
+/**
+ * _gtk_text_layout_first_lines_deleted:
+ * @layout: a #GtkTextLayout
+ * @lines: the deleted lines, linked through their next pointers
+ * @height: the height the deleted lines had in @layout
+ *
+ * Called by the btree when whole lines were removed from the start
+ * of the buffer, before @lines are freed. The remaining lines keep
+ * their sizes and cached displays; they only move up by @height.
+ */
+void
+_gtk_text_layout_first_lines_deleted (GtkTextLayout *layout,
+                                      GtkTextLine   *lines,
+                                      gint           height)
+{
+  GtkTextLayoutPrivate *priv;
+  GtkTextLine *line;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  for (line = lines; line != NULL; line = line->next)
+    {
+      gtk_text_layout_invalidate_cache (layout, line, FALSE);
+
+      if (line == priv->cursor_line)
+        priv->cursor_line = NULL;
+    }
+
+  if (priv->cursor_line == NULL)
+    gtk_text_layout_update_cursor_line (layout);
+
+  update_layout_size (layout);
+
+  /* The remaining lines keep their sizes, so only the
+   * deleted range changed
+   */
+  gtk_text_layout_emit_changed (layout, 0, height, 0);
+}
+
 static GtkTextLineData*
 gtk_text_layout_real_wrap (GtkTextLayout   *layout,
                            GtkTextLine     *line,
@@ -1183,6 +1524,7 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
   line_data->width = display->width;
   line_data->height = display->height;
   line_data->valid = TRUE;
+  line_data->sized = TRUE;
   pango_layout_get_pixel_extents (display->layout, &ink_rect, &logical_rect);
   line_data->top_ink = MAX (0, logical_rect.x - ink_rect.x);
   line_data->bottom_ink = MAX (0, logical_rect.x + logical_rect.width - ink_rect.x - ink_rect.width);
@@ -2243,10 +2585,56 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
-GtkTextLineDisplay *
-gtk_text_layout_get_line_display (GtkTextLayout *layout,
-                                  GtkTextLine   *line,
-                                  gboolean       size_only)
+static void
+line_display_measure (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  PangoRectangle extents;
+  gint text_pixel_width;
+  gint h_margin;
+  gint h_padding;
+
+  pango_layout_get_extents (display->layout, NULL, &extents);
+
+  text_pixel_width = PIXEL_BOUND (extents.width);
+
+  h_margin = display->left_margin + display->right_margin;
+  h_padding = layout->left_padding + layout->right_padding;
+
+  display->width = text_pixel_width + h_margin + h_padding;
+  display->height += PANGO_PIXELS (extents.height);
+
+  /* If we aren't wrapping, we need to do the alignment of each
+   * paragraph ourselves.
+   */
+  if (pango_layout_get_width (display->layout) < 0)
+    {
+      gint excess = display->total_width - text_pixel_width;
+
+      switch (pango_layout_get_alignment (display->layout))
+	{
+	case PANGO_ALIGN_LEFT:
+	  break;
+	case PANGO_ALIGN_CENTER:
+	  display->x_offset += excess / 2;
+	  break;
+	case PANGO_ALIGN_RIGHT:
+	  display->x_offset += excess;
+	  break;
+	}
+    }
+}
+
+/* Creates the display for @line. If @measure is %FALSE, the text and
+ * attributes are set on the PangoLayout, but it is not laid out and
+ * the size of the display only includes its margins.
+ */
+static GtkTextLineDisplay *
+line_display_new (GtkTextLayout *layout,
+                  GtkTextLine   *line,
+                  gboolean       size_only,
+                  gboolean       measure,
+                  gboolean      *saw_widget_out)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
@@ -2254,10 +2642,8 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   GtkTextIter iter;
   GtkTextAttributes *style;
   gchar *text;
-  gint text_pixel_width;
   PangoAttrList *attrs;
   gint text_allocated, layout_byte_offset, buffer_byte_offset;
-  PangoRectangle extents;
   gboolean para_values_set = FALSE;
   GSList *cursor_byte_offsets = NULL;
   GSList *cursor_segs = NULL;
@@ -2266,29 +2652,10 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   PangoDirection base_dir;
   GPtrArray *tags;
   gboolean initial_toggle_segments;
-  gint h_margin;
-  gint h_padding;
-  
-  g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
-    {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
-	{
-	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
-	}
-      else
-        {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
-        }
-    }
+  DV (g_print ("creating line display (%s)\n", G_STRLOC));
 
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+  *saw_widget_out = FALSE;
 
   display = g_slice_new0 (GtkTextLineDisplay);
 
@@ -2573,37 +2940,9 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   g_slist_free (cursor_byte_offsets);
   g_slist_free (cursor_segs);
 
-  pango_layout_get_extents (display->layout, NULL, &extents);
-
-  text_pixel_width = PIXEL_BOUND (extents.width);
-  display->width = text_pixel_width + display->left_margin + display->right_margin;
-
-  h_margin = display->left_margin + display->right_margin;
-  h_padding = layout->left_padding + layout->right_padding;
-
-  display->width = text_pixel_width + h_margin + h_padding;
-  display->height += PANGO_PIXELS (extents.height);
-
-  /* If we aren't wrapping, we need to do the alignment of each
-   * paragraph ourselves.
-   */
-  if (pango_layout_get_width (display->layout) < 0)
-    {
-      gint excess = display->total_width - text_pixel_width;
+  if (measure)
+    line_display_measure (layout, display);
 
-      switch (pango_layout_get_alignment (display->layout))
-	{
-	case PANGO_ALIGN_LEFT:
-	  break;
-	case PANGO_ALIGN_CENTER:
-	  display->x_offset += excess / 2;
-	  break;
-	case PANGO_ALIGN_RIGHT:
-	  display->x_offset += excess;
-	  break;
-	}
-    }
-  
   /* Free this if we aren't in a loop */
   if (layout->wrap_loop_count == 0)
     invalidate_cached_style (layout);
@@ -2613,7 +2952,56 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   if (tags != NULL)
     g_ptr_array_free (tags, TRUE);
 
-  layout->one_display_cache = display;
+  *saw_widget_out = saw_widget;
+
+  return display;
+}
+
+GtkTextLineDisplay *
+gtk_text_layout_get_line_display (GtkTextLayout *layout,
+                                  GtkTextLine   *line,
+                                  gboolean       size_only)
+{
+  GtkTextLineDisplay *display;
+  gboolean saw_widget;
+
+  g_return_val_if_fail (line != NULL, NULL);
+
+  display = display_cache_lookup (layout, line);
+  if (display)
+    {
+      if (!size_only)
+        update_text_display_cursors (layout, line, display);
+      return display;
+    }
+
+  if (layout->one_display_cache && line == layout->one_display_cache->line)
+    {
+      if (size_only)
+        return layout->one_display_cache;
+      else
+        {
+          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
+          layout->one_display_cache = NULL;
+          gtk_text_layout_free_line_display (layout, tmp_display);
+        }
+    }
+
+  display = line_display_new (layout, line, size_only, TRUE, &saw_widget);
+
+  if (size_only)
+    {
+      if (layout->one_display_cache)
+        {
+          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
+          layout->one_display_cache = NULL;
+          gtk_text_layout_free_line_display (layout, tmp_display);
+        }
+
+      layout->one_display_cache = display;
+    }
+  else
+    display_cache_insert (layout, display);
 
   if (saw_widget)
     allocate_child_widgets (layout, display);
@@ -2625,24 +3013,500 @@ void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
+  if (display != layout->one_display_cache &&
+      !display_cache_contains (layout, display))
+    line_display_free (display);
+}
+
+/* Background validation
+ *
+ * Validating a line means laying out its paragraph, which is what
+ * keeps gtk_text_layout_validate() busy for large buffers. Instead,
+ * the main thread can take snapshots of the text, attributes and
+ * paragraph settings of a run of invalid lines, without laying them
+ * out, and a worker thread lays them out with its own PangoContext.
+ * The sizes are stored in the line data when the batch comes back.
+ *
+ * Lines that are invalidated while their batch is running are
+ * removed from background_lines, and their results are dropped.
+ */
+
+#define BACKGROUND_BATCH_LINES 500
+#define BACKGROUND_BATCH_BYTES (128 * 1024)
+
+typedef struct
+{
+  /* Only dereferenced on the main thread */
+  GtkTextLine *line;
+
+  /* Snapshot, or %NULL text if the size was computed right away */
+  gchar *text;
+  PangoAttrList *attrs;
+  PangoTabArray *tabs;
+  gint width;
+  PangoWrapMode wrap;
+  PangoAlignment alignment;
+  gint indent;
+  gint spacing;
+  guint justify : 1;
+  guint rtl : 1;
+  gint extra_width;
+  gint extra_height;
+
+  /* Results */
+  gint line_width;
+  gint line_height;
+  gint top_ink;
+  gint bottom_ink;
+  guint committed : 1;
+  gint old_height;
+} BackgroundLine;
+
+typedef struct
+{
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  cairo_font_options_t *font_options;
+  gdouble resolution;
+  GArray *lines;
+} BackgroundBatch;
+
+static void
+background_line_clear (BackgroundLine *bl)
+{
+  g_free (bl->text);
+  if (bl->attrs)
+    pango_attr_list_unref (bl->attrs);
+  if (bl->tabs)
+    pango_tab_array_free (bl->tabs);
+}
+
+static void
+background_batch_free (BackgroundBatch *batch)
+{
+  g_array_unref (batch->lines);
+  pango_font_description_free (batch->font_desc);
+  if (batch->font_options)
+    cairo_font_options_destroy (batch->font_options);
+  g_slice_free (BackgroundBatch, batch);
+}
+
+static gboolean
+background_validation_possible (GtkTextLayout *layout)
+{
+  PangoFontMap *font_map;
+
+  if (layout->buffer == NULL ||
+      layout->default_style == NULL ||
+      layout->ltr_context == NULL ||
+      layout->rtl_context == NULL)
+    return FALSE;
+
+  /* Workers use the default font map of their thread */
+  font_map = pango_cairo_font_map_get_default ();
+
+  return pango_context_get_font_map (layout->ltr_context) == font_map &&
+         pango_context_get_font_map (layout->rtl_context) == font_map;
+}
+
+static void
+background_line_init (GtkTextLayout  *layout,
+                      GtkTextLine    *line,
+                      BackgroundLine *bl)
+{
+  GtkTextLineDisplay *display;
+  GtkTextIter iter;
+  gboolean saw_widget;
+
+  memset (bl, 0, sizeof (BackgroundLine));
+  bl->line = line;
+
+  if (totally_invisible_line (layout, line, &iter))
+    return;
+
+  display = line_display_new (layout, line, TRUE, FALSE, &saw_widget);
+
+  if (saw_widget)
     {
-      if (display->layout)
-        g_object_unref (display->layout);
+      PangoRectangle ink_rect, logical_rect;
 
-      if (display->cursors)
-        g_array_free (display->cursors, TRUE);
+      /* Child widgets can only be measured and allocated on the
+       * main thread, as gtk_text_layout_get_line_display() does.
+       */
+      line_display_measure (layout, display);
+      allocate_child_widgets (layout, display);
+      pango_layout_get_pixel_extents (display->layout, &ink_rect, &logical_rect);
+
+      bl->line_width = display->width;
+      bl->line_height = display->height;
+      bl->top_ink = MAX (0, logical_rect.x - ink_rect.x);
+      bl->bottom_ink = MAX (0, logical_rect.x + logical_rect.width - ink_rect.x - ink_rect.width);
+    }
+  else
+    {
+      bl->text = g_strdup (pango_layout_get_text (display->layout));
+      bl->attrs = pango_layout_get_attributes (display->layout);
+      if (bl->attrs)
+        pango_attr_list_ref (bl->attrs);
+      bl->tabs = pango_layout_get_tabs (display->layout);
+      bl->width = pango_layout_get_width (display->layout);
+      bl->wrap = pango_layout_get_wrap (display->layout);
+      bl->alignment = pango_layout_get_alignment (display->layout);
+      bl->indent = pango_layout_get_indent (display->layout);
+      bl->spacing = pango_layout_get_spacing (display->layout);
+      bl->justify = pango_layout_get_justify (display->layout);
+      bl->rtl = display->direction == GTK_TEXT_DIR_RTL;
+      bl->extra_width = display->left_margin + display->right_margin +
+                        layout->left_padding + layout->right_padding;
+      bl->extra_height = display->height;
+    }
 
-G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-      if (display->pg_bg_color)
-        gdk_color_free (display->pg_bg_color);
-G_GNUC_END_IGNORE_DEPRECATIONS
+  line_display_free (display);
+}
+
+/* Called in a worker thread. Every thread has its own default
+ * font map, which is all that makes this work.
+ */
+static PangoContext *
+background_batch_create_context (BackgroundBatch *batch,
+                                 PangoDirection   base_dir)
+{
+  PangoContext *context;
+
+  context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+  pango_context_set_font_description (context, batch->font_desc);
+  pango_context_set_language (context, batch->language);
+  pango_context_set_base_dir (context, base_dir);
+  pango_cairo_context_set_resolution (context, batch->resolution);
+  pango_cairo_context_set_font_options (context, batch->font_options);
+
+  return context;
+}
+
+static void
+background_validate_thread (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  BackgroundBatch *batch = task_data;
+  PangoContext *contexts[2] = { NULL, NULL };
+  guint i;
+
+  for (i = 0; i < batch->lines->len; i++)
+    {
+      BackgroundLine *bl = &g_array_index (batch->lines, BackgroundLine, i);
+      PangoLayout *layout;
+      PangoRectangle extents, ink_rect, logical_rect;
+
+      if (bl->text == NULL)
+        continue;
+
+      if (i % 64 == 0 && g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if (contexts[bl->rtl] == NULL)
+        contexts[bl->rtl] = background_batch_create_context (batch,
+                                                             bl->rtl ? PANGO_DIRECTION_RTL
+                                                                     : PANGO_DIRECTION_LTR);
+
+      /* Same settings as set_para_values() */
+      layout = pango_layout_new (contexts[bl->rtl]);
+      pango_layout_set_alignment (layout, bl->alignment);
+      pango_layout_set_justify (layout, bl->justify);
+      pango_layout_set_spacing (layout, bl->spacing);
+      if (bl->tabs)
+        pango_layout_set_tabs (layout, bl->tabs);
+      pango_layout_set_indent (layout, bl->indent);
+      pango_layout_set_width (layout, bl->width);
+      pango_layout_set_wrap (layout, bl->wrap);
+      pango_layout_set_text (layout, bl->text, -1);
+      pango_layout_set_attributes (layout, bl->attrs);
+
+      /* Same computations as line_display_measure() and
+       * gtk_text_layout_real_wrap()
+       */
+      pango_layout_get_extents (layout, NULL, &extents);
+      pango_layout_get_pixel_extents (layout, &ink_rect, &logical_rect);
+
+      bl->line_width = PIXEL_BOUND (extents.width) + bl->extra_width;
+      bl->line_height = bl->extra_height + PANGO_PIXELS (extents.height);
+      bl->top_ink = MAX (0, logical_rect.x - ink_rect.x);
+      bl->bottom_ink = MAX (0, logical_rect.x + logical_rect.width - ink_rect.x - ink_rect.width);
+
+      g_object_unref (layout);
+    }
+
+  g_clear_object (&contexts[0]);
+  g_clear_object (&contexts[1]);
+
+  if (!g_task_return_error_if_cancelled (task))
+    g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * _gtk_text_layout_validate_async:
+ * @layout: a #GtkTextLayout
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: called when the batch is done
+ * @user_data: data for @callback
+ *
+ * Starts validating the next batch of invalid lines in a worker
+ * thread. @callback must call _gtk_text_layout_validate_finish(),
+ * which stores the results.
+ *
+ * Returns: %FALSE if there is nothing to validate in the background,
+ *     in which case @callback is not called
+ */
+gboolean
+_gtk_text_layout_validate_async (GtkTextLayout       *layout,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  BackgroundBatch *batch;
+  GtkTextLine *line;
+  const cairo_font_options_t *font_options;
+  gsize n_bytes = 0;
+  guint n_scanned = 0;
+  GTask *task;
+
+  g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), FALSE);
+  g_return_val_if_fail (layout->wrap_loop_count == 0, FALSE);
+
+  if (!background_validation_possible (layout))
+    return FALSE;
+
+  line = _gtk_text_btree_get_first_invalid_line (_gtk_text_buffer_get_btree (layout->buffer),
+                                                 layout);
+  if (line == NULL)
+    return FALSE;
+
+  batch = g_slice_new0 (BackgroundBatch);
+  batch->font_desc = pango_font_description_copy (pango_context_get_font_description (layout->ltr_context));
+  batch->language = pango_context_get_language (layout->ltr_context);
+  batch->resolution = pango_cairo_context_get_resolution (layout->ltr_context);
+  font_options = pango_cairo_context_get_font_options (layout->ltr_context);
+  if (font_options)
+    batch->font_options = cairo_font_options_copy (font_options);
+  batch->lines = g_array_new (FALSE, FALSE, sizeof (BackgroundLine));
+  g_array_set_clear_func (batch->lines, (GDestroyNotify) background_line_clear);
+
+  gtk_text_layout_wrap_loop_start (layout);
+
+  while (line != NULL &&
+         batch->lines->len < BACKGROUND_BATCH_LINES &&
+         n_bytes < BACKGROUND_BATCH_BYTES &&
+         n_scanned < 4 * BACKGROUND_BATCH_LINES)
+    {
+      GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
+
+      if ((line_data == NULL || !line_data->valid) &&
+          !g_hash_table_contains (priv->background_lines, line))
+        {
+          BackgroundLine bl;
+
+          /* Pending lines need line data, so that deleting them goes
+           * through gtk_text_layout_free_line_data() and they are
+           * forgotten.
+           */
+          if (line_data == NULL)
+            {
+              line_data = _gtk_text_line_data_new (layout, line);
+              _gtk_text_line_add_data (line, line_data);
+            }
+
+          background_line_init (layout, line, &bl);
+          if (bl.text)
+            n_bytes += strlen (bl.text);
+
+          g_array_append_val (batch->lines, bl);
+          g_hash_table_insert (priv->background_lines, line, batch);
+        }
+
+      n_scanned++;
+      line = _gtk_text_line_next_excluding_last (line);
+    }
+
+  gtk_text_layout_wrap_loop_end (layout);
+
+  if (batch->lines->len == 0)
+    {
+      background_batch_free (batch);
+      return FALSE;
+    }
+
+  task = g_task_new (layout, cancellable, callback, user_data);
+  g_task_set_source_tag (task, _gtk_text_layout_validate_async);
+  g_task_set_task_data (task, batch, (GDestroyNotify) background_batch_free);
+  g_task_run_in_thread (task, background_validate_thread);
+  g_object_unref (task);
+
+  return TRUE;
+}
+
+static void
+background_batch_commit (GtkTextLayout   *layout,
+                         BackgroundBatch *batch)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  GPtrArray *lines;
+  GtkTextLine *run_start = NULL;
+  GtkTextLine *run_end = NULL;
+  gint run_old_height = 0;
+  gint run_new_height = 0;
+  guint i;
+
+  lines = g_ptr_array_new ();
+
+  for (i = 0; i < batch->lines->len; i++)
+    {
+      BackgroundLine *bl = &g_array_index (batch->lines, BackgroundLine, i);
+      GtkTextLineData *line_data;
 
-      if (display->pg_bg_rgba)
-        gdk_rgba_free (display->pg_bg_rgba);
+      if (g_hash_table_lookup (priv->background_lines, bl->line) != batch)
+        continue;
 
-      g_slice_free (GtkTextLineDisplay, display);
+      g_hash_table_remove (priv->background_lines, bl->line);
+
+      line_data = _gtk_text_line_get_data (bl->line, layout);
+      if (line_data->valid)
+        continue;
+
+      bl->old_height = _gtk_text_btree_get_line_height (btree, bl->line, layout);
+      bl->committed = TRUE;
+
+      line_data->width = bl->line_width;
+      line_data->height = bl->line_height;
+      line_data->top_ink = bl->top_ink;
+      line_data->bottom_ink = bl->bottom_ink;
+      line_data->valid = TRUE;
+      line_data->sized = TRUE;
+
+      g_ptr_array_add (lines, bl->line);
+    }
+
+  if (lines->len > 0)
+    {
+      _gtk_text_btree_update_line_sizes (btree, layout,
+                                         (GtkTextLine **) lines->pdata, lines->len);
+      update_layout_size (layout);
+
+      /* Emit ::changed once per run of consecutive lines */
+      for (i = 0; i <= batch->lines->len; i++)
+        {
+          BackgroundLine *bl = NULL;
+
+          if (i < batch->lines->len)
+            {
+              bl = &g_array_index (batch->lines, BackgroundLine, i);
+              if (!bl->committed)
+                continue;
+            }
+
+          if (run_start != NULL &&
+              (bl == NULL || _gtk_text_line_next (run_end) != bl->line))
+            {
+              gtk_text_layout_emit_changed (layout,
+                                            _gtk_text_btree_find_line_top (btree, run_start, layout),
+                                            run_old_height,
+                                            run_new_height);
+              run_start = NULL;
+            }
+
+          if (bl == NULL)
+            break;
+
+          if (run_start == NULL)
+            {
+              run_start = bl->line;
+              run_old_height = 0;
+              run_new_height = 0;
+            }
+
+          run_end = bl->line;
+          run_old_height += bl->old_height;
+          run_new_height += bl->line_height;
+        }
     }
+
+  g_ptr_array_free (lines, TRUE);
+}
+
+/**
+ * _gtk_text_layout_validate_finish:
+ * @layout: a #GtkTextLayout
+ * @result: the #GAsyncResult
+ * @error: return location for an error
+ *
+ * Stores the sizes computed by a batch started with
+ * _gtk_text_layout_validate_async() for the lines that have not
+ * been invalidated since, and emits #GtkTextLayout::changed for
+ * them.
+ *
+ * Returns: %FALSE if the batch was cancelled
+ */
+gboolean
+_gtk_text_layout_validate_finish (GtkTextLayout  *layout,
+                                  GAsyncResult   *result,
+                                  GError        **error)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  BackgroundBatch *batch;
+  guint i;
+
+  g_return_val_if_fail (g_task_is_valid (result, layout), FALSE);
+
+  batch = g_task_get_task_data (G_TASK (result));
+
+  if (!g_task_propagate_boolean (G_TASK (result), error))
+    {
+      for (i = 0; i < batch->lines->len; i++)
+        {
+          GtkTextLine *line = g_array_index (batch->lines, BackgroundLine, i).line;
+
+          if (g_hash_table_lookup (priv->background_lines, line) == batch)
+            g_hash_table_remove (priv->background_lines, line);
+        }
+
+      return FALSE;
+    }
+
+  if (layout->buffer != NULL)
+    background_batch_commit (layout, batch);
+
+  return TRUE;
+}
+
+/**
+ * _gtk_text_layout_get_validation_progress:
+ * @layout: a #GtkTextLayout
+ *
+ * Returns the fraction of lines before the first invalid line.
+ * Validation proceeds from the start of the buffer, apart from
+ * the lines that get shown.
+ *
+ * Returns: the validation progress, between 0.0 and 1.0
+ */
+gdouble
+_gtk_text_layout_get_validation_progress (GtkTextLayout *layout)
+{
+  GtkTextBTree *btree;
+  GtkTextLine *line;
+
+  g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), 0.0);
+
+  if (layout->buffer == NULL)
+    return 1.0;
+
+  btree = _gtk_text_buffer_get_btree (layout->buffer);
+  line = _gtk_text_btree_get_first_invalid_line (btree, layout);
+  if (line == NULL)
+    return 1.0;
+
+  return (gdouble) _gtk_text_line_get_number (line) / _gtk_text_btree_line_count (btree);
 }
 
 /* Functions to convert iter <=> index for the line of a GtkTextLineDisplay
@@ -2984,11 +3848,8 @@ gtk_text_layout_get_line_yrange (GtkTextLayout     *layout,
                                        line, layout);
   if (height)
     {
-      GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
-      if (line_data)
-        *height = line_data->height;
-      else
-        *height = 0;
+      *height = _gtk_text_btree_get_line_height (_gtk_text_buffer_get_btree (layout->buffer),
+                                                 line, layout);
     }
 }
 
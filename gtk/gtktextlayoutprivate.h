@@ -0,0 +1,42 @@
+/* GTK - The GIMP Toolkit
+ * gtktextlayoutprivate.h Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_TEXT_LAYOUT_PRIVATE_H__
+#define __GTK_TEXT_LAYOUT_PRIVATE_H__
+
+#define GTK_TEXT_USE_INTERNAL_UNSUPPORTED_API
+#include "gtktextlayout.h"
+
+G_BEGIN_DECLS
+
+gboolean        _gtk_text_layout_validate_async          (GtkTextLayout       *layout,
+                                                          GCancellable        *cancellable,
+                                                          GAsyncReadyCallback  callback,
+                                                          gpointer             user_data);
+gboolean        _gtk_text_layout_validate_finish         (GtkTextLayout       *layout,
+                                                          GAsyncResult        *result,
+                                                          GError             **error);
+gdouble         _gtk_text_layout_get_validation_progress (GtkTextLayout       *layout);
+void            _gtk_text_layout_set_estimate_line_heights (GtkTextLayout     *layout,
+                                                            gboolean           estimate);
+void            _gtk_text_layout_first_lines_deleted     (GtkTextLayout       *layout,
+                                                          GtkTextLine         *lines,
+                                                          gint                 height);
+
+G_END_DECLS
+
+#endif /* __GTK_TEXT_LAYOUT_PRIVATE_H__ */
@@ -155,6 +155,40 @@ gtk_text_line_segment_split (const GtkTextIter *iter)
 
 #define CSEG_SIZE(chars) ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
         + 1 + (chars)))
+
+/*
+ * Character segments created by insertions are carved out of larger
+ * chunks instead of being allocated one by one. Every character
+ * segment is preceded by a pointer to its chunk, which is NULL for
+ * segments that were allocated on their own, and a chunk is freed
+ * together with its last segment.
+ *
+ * The text of a segment is never changed once other segments follow
+ * it in its chunk. The segment at the end of a chunk can grow and
+ * shrink in place though, which is what appending to a line and
+ * splitting off its newline mostly need.
+ */
+
+#define CHAR_CHUNK_SIZE 16384
+#define CHAR_CHUNK_MAX_SEGMENT (CHAR_CHUNK_SIZE / 4)
+
+typedef struct _CharChunk CharChunk;
+
+struct _CharChunk {
+  guint ref_count;                      /* Segments in the chunk, plus one
+                                         * while it is an arena's current
+                                         * chunk. */
+  guint used;                           /* Bytes of data in use. */
+  gchar data[1];
+};
+
+struct _GtkTextCharArena {
+  CharChunk *current;
+};
+
+#define CSEG_HEADER_SIZE (sizeof (CharChunk *))
+#define CSEG_CHUNK(seg) (*(CharChunk **) ((gchar *) (seg) - CSEG_HEADER_SIZE))
+#define CSEG_ALIGN(offset) (((offset) + sizeof (gpointer) - 1) & ~(sizeof (gpointer) - 1))
 #define TSEG_SIZE ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
         + sizeof (GtkTextToggleBody)))
 
@@ -187,6 +221,32 @@ char_segment_self_check (GtkTextLineSegment *seg)
     }
 }
 
+static GtkTextLineSegment *
+char_segment_alloc (guint len)
+{
+  gchar *block;
+
+  block = g_slice_alloc (CSEG_HEADER_SIZE + CSEG_SIZE (len));
+  *(CharChunk **) block = NULL;
+
+  return (GtkTextLineSegment *) (block + CSEG_HEADER_SIZE);
+}
+
+static void
+char_chunk_unref (CharChunk *chunk)
+{
+  chunk->ref_count--;
+  if (chunk->ref_count == 0)
+    g_free (chunk);
+}
+
+static inline gboolean
+char_segment_is_chunk_tail (GtkTextLineSegment *seg,
+                            CharChunk          *chunk)
+{
+  return (gchar *) seg + CSEG_SIZE (seg->byte_count) == chunk->data + chunk->used;
+}
+
 GtkTextLineSegment*
 _gtk_char_segment_new (const gchar *text, guint len)
 {
@@ -194,7 +254,7 @@ _gtk_char_segment_new (const gchar *text, guint len)
 
   g_assert (gtk_text_byte_begins_utf8_char (text));
 
-  seg = g_slice_alloc (CSEG_SIZE (len));
+  seg = char_segment_alloc (len);
   seg->type = (GtkTextLineSegmentClass *)&gtk_text_char_type;
   seg->next = NULL;
   seg->byte_count = len;
@@ -222,7 +282,7 @@ _gtk_char_segment_new_from_two_strings (const gchar *text1,
   g_assert (gtk_text_byte_begins_utf8_char (text1));
   g_assert (gtk_text_byte_begins_utf8_char (text2));
 
-  seg = g_slice_alloc (CSEG_SIZE (len1+len2));
+  seg = char_segment_alloc (len1 + len2);
   seg->type = &gtk_text_char_type;
   seg->next = NULL;
   seg->byte_count = len1 + len2;
@@ -241,12 +301,152 @@ _gtk_char_segment_new_from_two_strings (const gchar *text1,
 static void
 _gtk_char_segment_free (GtkTextLineSegment *seg)
 {
+  CharChunk *chunk;
+
   if (seg == NULL)
     return;
 
   g_assert (seg->type == &gtk_text_char_type);
 
-  g_slice_free1 (CSEG_SIZE (seg->byte_count), seg);
+  chunk = CSEG_CHUNK (seg);
+  if (chunk == NULL)
+    {
+      g_slice_free1 (CSEG_HEADER_SIZE + CSEG_SIZE (seg->byte_count),
+                     (gchar *) seg - CSEG_HEADER_SIZE);
+      return;
+    }
+
+  /* Give the space back if nothing was allocated after it */
+  if (char_segment_is_chunk_tail (seg, chunk))
+    chunk->used = (gchar *) seg - CSEG_HEADER_SIZE - chunk->data;
+
+  char_chunk_unref (chunk);
+}
+
+/* Appends to a segment at the end of its chunk without moving it */
+static gboolean
+char_segment_append (GtkTextLineSegment *seg,
+                     const gchar        *text,
+                     guint               len,
+                     guint               chars)
+{
+  CharChunk *chunk = CSEG_CHUNK (seg);
+
+  if (chunk == NULL ||
+      !char_segment_is_chunk_tail (seg, chunk) ||
+      chunk->used + len > CHAR_CHUNK_SIZE)
+    return FALSE;
+
+  memcpy (seg->body.chars + seg->byte_count, text, len);
+  seg->byte_count += len;
+  seg->char_count += chars;
+  seg->body.chars[seg->byte_count] = '\0';
+  chunk->used += len;
+
+  if (GTK_DEBUG_CHECK (TEXT))
+    char_segment_self_check (seg);
+
+  return TRUE;
+}
+
+GtkTextCharArena *
+_gtk_char_arena_new (void)
+{
+  return g_slice_new0 (GtkTextCharArena);
+}
+
+/* Segments that are still alive keep their chunk */
+void
+_gtk_char_arena_free (GtkTextCharArena *arena)
+{
+  if (arena->current)
+    char_chunk_unref (arena->current);
+
+  g_slice_free (GtkTextCharArena, arena);
+}
+
+/**
+ * _gtk_char_segment_new_in_arena:
+ * @arena: the arena to allocate from
+ * @text: text of the segment
+ * @len: length of @text in bytes
+ *
+ * Creates a character segment like _gtk_char_segment_new(), but
+ * allocated from the current chunk of @arena. Segments that are too
+ * large for chunks are allocated on their own.
+ *
+ * Returns: a new character segment
+ */
+GtkTextLineSegment *
+_gtk_char_segment_new_in_arena (GtkTextCharArena *arena,
+                                const gchar      *text,
+                                guint             len)
+{
+  GtkTextLineSegment *seg;
+  CharChunk *chunk;
+  guint offset;
+  guint size;
+
+  size = CSEG_HEADER_SIZE + CSEG_SIZE (len);
+  if (size > CHAR_CHUNK_MAX_SEGMENT)
+    return _gtk_char_segment_new (text, len);
+
+  g_assert (gtk_text_byte_begins_utf8_char (text));
+
+  chunk = arena->current;
+  offset = chunk ? CSEG_ALIGN (chunk->used) : 0;
+
+  if (chunk == NULL || offset + size > CHAR_CHUNK_SIZE)
+    {
+      if (chunk)
+        char_chunk_unref (chunk);
+
+      chunk = g_malloc (G_STRUCT_OFFSET (CharChunk, data) + CHAR_CHUNK_SIZE);
+      chunk->ref_count = 1;
+      chunk->used = 0;
+      arena->current = chunk;
+      offset = 0;
+    }
+
+  *(CharChunk **) (chunk->data + offset) = chunk;
+  seg = (GtkTextLineSegment *) (chunk->data + offset + CSEG_HEADER_SIZE);
+  chunk->ref_count++;
+  chunk->used = offset + size;
+
+  seg->type = &gtk_text_char_type;
+  seg->next = NULL;
+  seg->byte_count = len;
+  memcpy (seg->body.chars, text, len);
+  seg->body.chars[len] = '\0';
+
+  seg->char_count = g_utf8_strlen (seg->body.chars, seg->byte_count);
+
+  if (GTK_DEBUG_CHECK (TEXT))
+    char_segment_self_check (seg);
+
+  return seg;
+}
+
+/**
+ * _gtk_char_segment_append:
+ * @seg: a character segment
+ * @text: text to append
+ * @len: length of @text in bytes
+ *
+ * Appends @text to @seg in place, if @seg is at the end of the chunk
+ * it was allocated from and the chunk has room for @text.
+ *
+ * Returns: %TRUE if @text was appended
+ */
+gboolean
+_gtk_char_segment_append (GtkTextLineSegment *seg,
+                          const gchar        *text,
+                          guint               len)
+{
+  g_assert (seg->type == &gtk_text_char_type);
+  g_assert (gtk_text_byte_begins_utf8_char (text));
+
+  return char_segment_append (seg, text, len, g_utf8_strlen (text, len));
 }
 
 /*
@@ -279,6 +479,32 @@ char_segment_split_func (GtkTextLineSegment *seg, int index)
       char_segment_self_check (seg);
     }
 
+  if (CSEG_CHUNK (seg) != NULL)
+    {
+      CharChunk *chunk = CSEG_CHUNK (seg);
+      gboolean tail = char_segment_is_chunk_tail (seg, chunk);
+
+      /* Keep the head in place and copy the rest */
+      new2 = _gtk_char_segment_new (seg->body.chars + index, seg->byte_count - index);
+      new2->next = seg->next;
+
+      seg->byte_count = index;
+      seg->char_count -= new2->char_count;
+      seg->body.chars[index] = '\0';
+      seg->next = new2;
+
+      if (tail)
+        chunk->used = (gchar *) seg + CSEG_SIZE (index) - chunk->data;
+
+      if (GTK_DEBUG_CHECK (TEXT))
+        {
+          char_segment_self_check (seg);
+          char_segment_self_check (new2);
+        }
+
+      return seg;
+    }
+
   new1 = _gtk_char_segment_new (seg->body.chars, index);
   new2 = _gtk_char_segment_new (seg->body.chars + index, seg->byte_count - index);
 
@@ -338,6 +564,14 @@ char_segment_cleanup_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
       return segPtr;
     }
 
+  if (char_segment_append (segPtr, segPtr2->body.chars,
+                           segPtr2->byte_count, segPtr2->char_count))
+    {
+      segPtr->next = segPtr2->next;
+      _gtk_char_segment_free (segPtr2);
+      return segPtr;
+    }
+
   newPtr =
     _gtk_char_segment_new_from_two_strings (segPtr->body.chars, 
 					    segPtr->byte_count,
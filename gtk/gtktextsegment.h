@@ -164,6 +164,17 @@ GtkTextLineSegment *_gtk_char_segment_new_from_two_strings (const gchar    *text
 GtkTextLineSegment *_gtk_toggle_segment_new                (GtkTextTagInfo *info,
                                                             gboolean        on);
 
+typedef struct _GtkTextCharArena GtkTextCharArena;
+
+GtkTextCharArena   *_gtk_char_arena_new                    (void);
+void                _gtk_char_arena_free                   (GtkTextCharArena   *arena);
+GtkTextLineSegment *_gtk_char_segment_new_in_arena         (GtkTextCharArena   *arena,
+                                                            const gchar        *text,
+                                                            guint               len);
+gboolean            _gtk_char_segment_append               (GtkTextLineSegment *seg,
+                                                            const gchar        *text,
+                                                            guint               len);
+
 void                _gtk_toggle_segment_free               (GtkTextLineSegment *seg);
 
 G_END_DECLS
@@ -44,6 +44,7 @@
 #include "gtktextbufferrichtext.h"
 #include "gtktextdisplay.h"
 #include "gtktextiterprivate.h"
+#include "gtktextlayoutprivate.h"
 #include "gtktextview.h"
 #include "gtkimmulticontext.h"
 #include "gtkprivate.h"
@@ -226,6 +227,8 @@ struct _GtkTextViewPrivate
 
   guint first_validate_idle;        /* Idle to revalidate onscreen portion, runs before resize */
   guint incremental_validate_idle;  /* Idle to revalidate offscreen portions, runs after redraw */
+  GCancellable *validate_cancellable; /* Set while a batch is validated in a worker thread */
+  gdouble validation_progress;
 
   GtkTextMark *dnd_mark;
 
@@ -297,6 +300,9 @@ struct _GtkTextViewPrivate
 
   guint in_scroll : 1;
   guint handling_key_event : 1;
+
+  guint background_validation : 1;
+  guint estimate_line_heights : 1;
 };
 
 struct _GtkTextPendingScroll
@@ -363,7 +369,10 @@ enum
   PROP_INPUT_PURPOSE,
   PROP_INPUT_HINTS,
   PROP_POPULATE_ALL,
-  PROP_MONOSPACE
+  PROP_MONOSPACE,
+  PROP_BACKGROUND_VALIDATION,
+  PROP_VALIDATION_PROGRESS,
+  PROP_ESTIMATE_LINE_HEIGHTS
 };
 
 static GQuark quark_text_selection_data = 0;
@@ -1060,6 +1069,54 @@ gtk_text_view_class_init (GtkTextViewClass *klass)
                                                          FALSE,
                                                          GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY));
 
+  /**
+   * GtkTextView:background-validation:
+   *
+   * Whether lines that are not visible are laid out in worker threads.
+   * See gtk_text_view_set_background_validation().
+   *
+   * Since: 3.24
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_BACKGROUND_VALIDATION,
+                                   g_param_spec_boolean ("background-validation",
+                                                         P_("Background validation"),
+                                                         P_("Whether to lay out offscreen lines in worker threads"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY));
+
+  /**
+   * GtkTextView:validation-progress:
+   *
+   * The fraction of the buffer whose size is known.
+   * See gtk_text_view_get_validation_progress().
+   *
+   * Since: 3.24
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_VALIDATION_PROGRESS,
+                                   g_param_spec_double ("validation-progress",
+                                                        P_("Validation progress"),
+                                                        P_("The fraction of lines whose size is known"),
+                                                        0.0, 1.0, 1.0,
+                                                        GTK_PARAM_READABLE|G_PARAM_EXPLICIT_NOTIFY));
+
+  /**
+   * GtkTextView:estimate-line-heights:
+   *
+   * Whether lines that have not been laid out yet count with an
+   * estimated height. See gtk_text_view_set_estimate_line_heights().
+   *
+   * Since: 3.24
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_ESTIMATE_LINE_HEIGHTS,
+                                   g_param_spec_boolean ("estimate-line-heights",
+                                                         P_("Estimate line heights"),
+                                                         P_("Whether to estimate the height of lines that were not laid out yet"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY));
+
   
 
    /* GtkScrollable interface */
@@ -1699,6 +1756,7 @@ gtk_text_view_init (GtkTextView *text_view)
   priv->editable = TRUE;
 
   priv->scroll_after_paste = TRUE;
+  priv->validation_progress = 1.0;
 
   gtk_drag_dest_set (widget, 0, NULL, 0,
                      GDK_ACTION_COPY | GDK_ACTION_MOVE);
@@ -3618,6 +3676,15 @@ gtk_text_view_remove_validate_idles (GtkTextView *text_view)
       g_source_remove (priv->incremental_validate_idle);
       priv->incremental_validate_idle = 0;
     }
+
+  /* The callback of a batch that is still running won't touch
+   * text_view once it finds the batch cancelled.
+   */
+  if (priv->validate_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->validate_cancellable);
+      g_clear_object (&priv->validate_cancellable);
+    }
 }
 
 static void
@@ -3843,6 +3910,14 @@ gtk_text_view_set_property (GObject         *object,
       gtk_text_view_set_monospace (text_view, g_value_get_boolean (value));
       break;
 
+    case PROP_BACKGROUND_VALIDATION:
+      gtk_text_view_set_background_validation (text_view, g_value_get_boolean (value));
+      break;
+
+    case PROP_ESTIMATE_LINE_HEIGHTS:
+      gtk_text_view_set_estimate_line_heights (text_view, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3963,6 +4038,18 @@ gtk_text_view_get_property (GObject         *object,
       g_value_set_boolean (value, gtk_text_view_get_monospace (text_view));
       break;
 
+    case PROP_BACKGROUND_VALIDATION:
+      g_value_set_boolean (value, priv->background_validation);
+      break;
+
+    case PROP_VALIDATION_PROGRESS:
+      g_value_set_double (value, gtk_text_view_get_validation_progress (text_view));
+      break;
+
+    case PROP_ESTIMATE_LINE_HEIGHTS:
+      g_value_set_boolean (value, priv->estimate_line_heights);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4474,21 +4561,110 @@ first_validate_callback (gpointer data)
   return FALSE;
 }
 
+static void
+gtk_text_view_update_validation_progress (GtkTextView *text_view)
+{
+  GtkTextViewPrivate *priv = text_view->priv;
+  gdouble progress;
+
+  if (priv->layout)
+    progress = _gtk_text_layout_get_validation_progress (priv->layout);
+  else
+    progress = 1.0;
+
+  if (progress != priv->validation_progress)
+    {
+      priv->validation_progress = progress;
+      g_object_notify (G_OBJECT (text_view), "validation-progress");
+    }
+}
+
+static gboolean incremental_validate_callback (gpointer data);
+
+static void
+gtk_text_view_queue_incremental_validate (GtkTextView *text_view)
+{
+  GtkTextViewPrivate *priv = text_view->priv;
+
+  if (!priv->incremental_validate_idle)
+    {
+      priv->incremental_validate_idle = gdk_threads_add_idle_full (GTK_TEXT_VIEW_PRIORITY_VALIDATE, incremental_validate_callback, text_view, NULL);
+      g_source_set_name_by_id (priv->incremental_validate_idle, "[gtk+] incremental_validate_callback");
+      DV (g_print (G_STRLOC": adding incremental validate idle %d\n",
+                   priv->incremental_validate_idle));
+    }
+}
+
+static void
+background_validate_done (GObject      *source,
+                          GAsyncResult *result,
+                          gpointer      data)
+{
+  GtkTextView *text_view = data;
+  GtkTextViewPrivate *priv;
+  GError *error = NULL;
+
+  if (!_gtk_text_layout_validate_finish (GTK_TEXT_LAYOUT (source), result, &error))
+    {
+      /* Cancelled batches belong to views or layouts that are gone */
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_error_free (error);
+          return;
+        }
+
+      g_error_free (error);
+    }
+
+  priv = text_view->priv;
+  g_clear_object (&priv->validate_cancellable);
+
+  gtk_text_view_update_adjustments (text_view);
+  gtk_text_view_update_validation_progress (text_view);
+
+  if (!gtk_text_layout_is_valid (priv->layout))
+    gtk_text_view_queue_incremental_validate (text_view);
+}
+
 static gboolean
 incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
+  GtkTextViewPrivate *priv = text_view->priv;
   gboolean result = TRUE;
 
   DV(g_print(G_STRLOC"\n"));
-  
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
+
+  if (priv->background_validation)
+    {
+      /* The batch in flight requeues us when it is done */
+      if (priv->validate_cancellable != NULL)
+        {
+          priv->incremental_validate_idle = 0;
+          return FALSE;
+        }
+
+      priv->validate_cancellable = g_cancellable_new ();
+      if (_gtk_text_layout_validate_async (priv->layout,
+                                           priv->validate_cancellable,
+                                           background_validate_done,
+                                           text_view))
+        {
+          priv->incremental_validate_idle = 0;
+          return FALSE;
+        }
+
+      g_clear_object (&priv->validate_cancellable);
+    }
+
+  gtk_text_layout_validate (priv->layout, 2000);
 
   gtk_text_view_update_adjustments (text_view);
-  
-  if (gtk_text_layout_is_valid (text_view->priv->layout))
+  gtk_text_view_update_validation_progress (text_view);
+
+  if (gtk_text_layout_is_valid (priv->layout))
     {
-      text_view->priv->incremental_validate_idle = 0;
+      priv->incremental_validate_idle = 0;
       result = FALSE;
     }
 
@@ -4517,13 +4693,7 @@ gtk_text_view_invalidate (GtkTextView *text_view)
                    priv->first_validate_idle));
     }
       
-  if (!priv->incremental_validate_idle)
-    {
-      priv->incremental_validate_idle = gdk_threads_add_idle_full (GTK_TEXT_VIEW_PRIORITY_VALIDATE, incremental_validate_callback, text_view, NULL);
-      g_source_set_name_by_id (priv->incremental_validate_idle, "[gtk+] incremental_validate_callback");
-      DV (g_print (G_STRLOC": adding incremental validate idle %d\n",
-                   priv->incremental_validate_idle));
-    }
+  gtk_text_view_queue_incremental_validate (text_view);
 }
 
 static void
@@ -8001,6 +8171,8 @@ gtk_text_view_ensure_layout (GtkTextView *text_view)
 
       gtk_text_layout_set_overwrite_mode (priv->layout,
 					  priv->overwrite_mode && priv->editable);
+      _gtk_text_layout_set_estimate_line_heights (priv->layout,
+                                                  priv->estimate_line_heights);
 
       ltr_context = gtk_widget_create_pango_context (GTK_WIDGET (text_view));
       pango_context_set_base_dir (ltr_context, PANGO_DIRECTION_LTR);
@@ -11388,3 +11560,161 @@ gtk_text_view_get_monospace (GtkTextView *text_view)
   
   return gtk_style_context_has_class (context, GTK_STYLE_CLASS_MONOSPACE);
 }
+
+/**
+ * gtk_text_view_set_background_validation:
+ * @text_view: a #GtkTextView
+ * @enable: %TRUE to lay out offscreen lines in worker threads
+ *
+ * Enables or disables laying out offscreen lines in worker threads.
+ *
+ * #GtkTextView needs the height of every line to know the size of
+ * the scrollable area, so it lays out all lines of the buffer in idle
+ * handlers, which keeps the main loop busy for a long time with large
+ * buffers. With background validation, the main thread only collects
+ * the text and attributes of lines that are not visible, and worker
+ * threads lay them out. Lines with child widgets are still measured
+ * on the main thread.
+ *
+ * Background validation needs the text view to use the default
+ * #PangoCairoFontMap; otherwise lines are laid out on the main thread
+ * as usual.
+ *
+ * See gtk_text_view_get_validation_progress() to find out how far
+ * validation has come.
+ *
+ * Since: 3.24
+ */
+void
+gtk_text_view_set_background_validation (GtkTextView *text_view,
+                                         gboolean     enable)
+{
+  GtkTextViewPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_VIEW (text_view));
+
+  priv = text_view->priv;
+  enable = enable != FALSE;
+
+  if (priv->background_validation == enable)
+    return;
+
+  priv->background_validation = enable;
+
+  if (!enable && priv->validate_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->validate_cancellable);
+      g_clear_object (&priv->validate_cancellable);
+      if (priv->layout && !gtk_text_layout_is_valid (priv->layout))
+        gtk_text_view_queue_incremental_validate (text_view);
+    }
+
+  g_object_notify (G_OBJECT (text_view), "background-validation");
+}
+
+/**
+ * gtk_text_view_get_background_validation:
+ * @text_view: a #GtkTextView
+ *
+ * Returns whether offscreen lines are laid out in worker threads.
+ * See gtk_text_view_set_background_validation().
+ *
+ * Returns: %TRUE if background validation is enabled
+ *
+ * Since: 3.24
+ */
+gboolean
+gtk_text_view_get_background_validation (GtkTextView *text_view)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (text_view), FALSE);
+
+  return text_view->priv->background_validation;
+}
+
+/**
+ * gtk_text_view_get_validation_progress:
+ * @text_view: a #GtkTextView
+ *
+ * Returns the fraction of the buffer whose lines have been laid out.
+ * Until this reaches 1.0, the size of the scrollable area is an
+ * estimate. Lines are laid out from the start of the buffer, apart
+ * from the ones that get shown, so this is the fraction of lines
+ * before the first one that has not been laid out yet.
+ *
+ * Returns: the validation progress, between 0.0 and 1.0
+ *
+ * Since: 3.24
+ */
+gdouble
+gtk_text_view_get_validation_progress (GtkTextView *text_view)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (text_view), 1.0);
+
+  if (text_view->priv->layout)
+    return _gtk_text_layout_get_validation_progress (text_view->priv->layout);
+
+  return text_view->priv->validation_progress;
+}
+
+/**
+ * gtk_text_view_set_estimate_line_heights:
+ * @text_view: a #GtkTextView
+ * @estimate: %TRUE to estimate the height of lines that were not laid out
+ *
+ * Sets whether lines that have not been laid out yet count with an
+ * estimated height.
+ *
+ * #GtkTextView lays out the lines of its buffer in idle handlers, and
+ * lines that have not been laid out yet normally take no space. With
+ * large buffers, this makes the scrollable area grow for a long time,
+ * and the position of lines after the ones that have been laid out is
+ * far off. With this setting, such lines count with the mean height of
+ * the lines that have been laid out, so scrolling to any part of the
+ * buffer, including its end, is immediate. The size is corrected as
+ * lines are laid out, keeping the lines on screen in place.
+ *
+ * Since: 3.24
+ */
+void
+gtk_text_view_set_estimate_line_heights (GtkTextView *text_view,
+                                         gboolean     estimate)
+{
+  GtkTextViewPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_VIEW (text_view));
+
+  priv = text_view->priv;
+  estimate = estimate != FALSE;
+
+  if (priv->estimate_line_heights == estimate)
+    return;
+
+  priv->estimate_line_heights = estimate;
+
+  if (priv->layout)
+    {
+      _gtk_text_layout_set_estimate_line_heights (priv->layout, estimate);
+      gtk_text_view_update_adjustments (text_view);
+    }
+
+  g_object_notify (G_OBJECT (text_view), "estimate-line-heights");
+}
+
+/**
+ * gtk_text_view_get_estimate_line_heights:
+ * @text_view: a #GtkTextView
+ *
+ * Returns whether lines that have not been laid out yet count with
+ * an estimated height. See gtk_text_view_set_estimate_line_heights().
+ *
+ * Returns: %TRUE if line heights are estimated
+ *
+ * Since: 3.24
+ */
+gboolean
+gtk_text_view_get_estimate_line_heights (GtkTextView *text_view)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (text_view), FALSE);
+
+  return text_view->priv->estimate_line_heights;
+}
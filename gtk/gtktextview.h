@@ -458,6 +458,19 @@ void             gtk_text_view_set_monospace          (GtkTextView      *text_vi
 GDK_AVAILABLE_IN_3_16
 gboolean         gtk_text_view_get_monospace          (GtkTextView      *text_view);
 
+GDK_AVAILABLE_IN_3_24
+void             gtk_text_view_set_background_validation (GtkTextView   *text_view,
+                                                          gboolean       enable);
+GDK_AVAILABLE_IN_3_24
+gboolean         gtk_text_view_get_background_validation (GtkTextView   *text_view);
+GDK_AVAILABLE_IN_3_24
+gdouble          gtk_text_view_get_validation_progress   (GtkTextView   *text_view);
+GDK_AVAILABLE_IN_3_24
+void             gtk_text_view_set_estimate_line_heights (GtkTextView   *text_view,
+                                                          gboolean       estimate);
+GDK_AVAILABLE_IN_3_24
+gboolean         gtk_text_view_get_estimate_line_heights (GtkTextView   *text_view);
+
 G_END_DECLS
 
 #endif /* __GTK_TEXT_VIEW_H__ */
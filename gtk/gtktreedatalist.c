@@ -316,133 +316,128 @@ _gtk_tree_data_list_node_copy (GtkTreeDataList *list,
   return new_list;
 }
 
+/* Compares two values of @type the way _gtk_tree_data_list_compare_func()
+ * compares the rows holding them.
+ */
 gint
-_gtk_tree_data_list_compare_func (GtkTreeModel *model,
-				  GtkTreeIter  *a,
-				  GtkTreeIter  *b,
-				  gpointer      user_data)
+_gtk_tree_data_list_compare_values (GType         type,
+				    const GValue *a_value,
+				    const GValue *b_value)
 {
-  gint column = GPOINTER_TO_INT (user_data);
-  GType type = gtk_tree_model_get_column_type (model, column);
-  GValue a_value = G_VALUE_INIT;
-  GValue b_value = G_VALUE_INIT;
   gint retval;
   const gchar *stra, *strb;
 
-  gtk_tree_model_get_value (model, a, column, &a_value);
-  gtk_tree_model_get_value (model, b, column, &b_value);
-
   switch (get_fundamental_type (type))
     {
     case G_TYPE_BOOLEAN:
-      if (g_value_get_boolean (&a_value) < g_value_get_boolean (&b_value))
+      if (g_value_get_boolean (a_value) < g_value_get_boolean (b_value))
 	retval = -1;
-      else if (g_value_get_boolean (&a_value) == g_value_get_boolean (&b_value))
+      else if (g_value_get_boolean (a_value) == g_value_get_boolean (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_CHAR:
-      if (g_value_get_schar (&a_value) < g_value_get_schar (&b_value))
+      if (g_value_get_schar (a_value) < g_value_get_schar (b_value))
 	retval = -1;
-      else if (g_value_get_schar (&a_value) == g_value_get_schar (&b_value))
+      else if (g_value_get_schar (a_value) == g_value_get_schar (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_UCHAR:
-      if (g_value_get_uchar (&a_value) < g_value_get_uchar (&b_value))
+      if (g_value_get_uchar (a_value) < g_value_get_uchar (b_value))
 	retval = -1;
-      else if (g_value_get_uchar (&a_value) == g_value_get_uchar (&b_value))
+      else if (g_value_get_uchar (a_value) == g_value_get_uchar (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_INT:
-      if (g_value_get_int (&a_value) < g_value_get_int (&b_value))
+      if (g_value_get_int (a_value) < g_value_get_int (b_value))
 	retval = -1;
-      else if (g_value_get_int (&a_value) == g_value_get_int (&b_value))
+      else if (g_value_get_int (a_value) == g_value_get_int (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_UINT:
-      if (g_value_get_uint (&a_value) < g_value_get_uint (&b_value))
+      if (g_value_get_uint (a_value) < g_value_get_uint (b_value))
 	retval = -1;
-      else if (g_value_get_uint (&a_value) == g_value_get_uint (&b_value))
+      else if (g_value_get_uint (a_value) == g_value_get_uint (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_LONG:
-      if (g_value_get_long (&a_value) < g_value_get_long (&b_value))
+      if (g_value_get_long (a_value) < g_value_get_long (b_value))
 	retval = -1;
-      else if (g_value_get_long (&a_value) == g_value_get_long (&b_value))
+      else if (g_value_get_long (a_value) == g_value_get_long (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_ULONG:
-      if (g_value_get_ulong (&a_value) < g_value_get_ulong (&b_value))
+      if (g_value_get_ulong (a_value) < g_value_get_ulong (b_value))
 	retval = -1;
-      else if (g_value_get_ulong (&a_value) == g_value_get_ulong (&b_value))
+      else if (g_value_get_ulong (a_value) == g_value_get_ulong (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_INT64:
-      if (g_value_get_int64 (&a_value) < g_value_get_int64 (&b_value))
+      if (g_value_get_int64 (a_value) < g_value_get_int64 (b_value))
 	retval = -1;
-      else if (g_value_get_int64 (&a_value) == g_value_get_int64 (&b_value))
+      else if (g_value_get_int64 (a_value) == g_value_get_int64 (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_UINT64:
-      if (g_value_get_uint64 (&a_value) < g_value_get_uint64 (&b_value))
+      if (g_value_get_uint64 (a_value) < g_value_get_uint64 (b_value))
 	retval = -1;
-      else if (g_value_get_uint64 (&a_value) == g_value_get_uint64 (&b_value))
+      else if (g_value_get_uint64 (a_value) == g_value_get_uint64 (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_ENUM:
       /* this is somewhat bogus. */
-      if (g_value_get_enum (&a_value) < g_value_get_enum (&b_value))
+      if (g_value_get_enum (a_value) < g_value_get_enum (b_value))
 	retval = -1;
-      else if (g_value_get_enum (&a_value) == g_value_get_enum (&b_value))
+      else if (g_value_get_enum (a_value) == g_value_get_enum (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_FLAGS:
       /* this is even more bogus. */
-      if (g_value_get_flags (&a_value) < g_value_get_flags (&b_value))
+      if (g_value_get_flags (a_value) < g_value_get_flags (b_value))
 	retval = -1;
-      else if (g_value_get_flags (&a_value) == g_value_get_flags (&b_value))
+      else if (g_value_get_flags (a_value) == g_value_get_flags (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_FLOAT:
-      if (g_value_get_float (&a_value) < g_value_get_float (&b_value))
+      if (g_value_get_float (a_value) < g_value_get_float (b_value))
 	retval = -1;
-      else if (g_value_get_float (&a_value) == g_value_get_float (&b_value))
+      else if (g_value_get_float (a_value) == g_value_get_float (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_DOUBLE:
-      if (g_value_get_double (&a_value) < g_value_get_double (&b_value))
+      if (g_value_get_double (a_value) < g_value_get_double (b_value))
 	retval = -1;
-      else if (g_value_get_double (&a_value) == g_value_get_double (&b_value))
+      else if (g_value_get_double (a_value) == g_value_get_double (b_value))
 	retval = 0;
       else
 	retval = 1;
       break;
     case G_TYPE_STRING:
-      stra = g_value_get_string (&a_value);
-      strb = g_value_get_string (&b_value);
+      stra = g_value_get_string (a_value);
+      strb = g_value_get_string (b_value);
       if (stra == NULL) stra = "";
       if (strb == NULL) strb = "";
       retval = g_utf8_collate (stra, strb);
@@ -457,6 +452,26 @@ _gtk_tree_data_list_compare_func (GtkTreeModel *model,
       break;
     }
 
+  return retval;
+}
+
+gint
+_gtk_tree_data_list_compare_func (GtkTreeModel *model,
+				  GtkTreeIter  *a,
+				  GtkTreeIter  *b,
+				  gpointer      user_data)
+{
+  gint column = GPOINTER_TO_INT (user_data);
+  GType type = gtk_tree_model_get_column_type (model, column);
+  GValue a_value = G_VALUE_INIT;
+  GValue b_value = G_VALUE_INIT;
+  gint retval;
+
+  gtk_tree_model_get_value (model, a, column, &a_value);
+  gtk_tree_model_get_value (model, b, column, &b_value);
+
+  retval = _gtk_tree_data_list_compare_values (type, &a_value, &b_value);
+
   g_value_unset (&a_value);
   g_value_unset (&b_value);
 
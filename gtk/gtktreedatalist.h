@@ -63,6 +63,9 @@ GtkTreeDataList *_gtk_tree_data_list_node_copy      (GtkTreeDataList *list,
                                                      GType            type);
 
 /* Header code */
+gint                   _gtk_tree_data_list_compare_values (GType         type,
+							   const GValue *a_value,
+							   const GValue *b_value);
 gint                   _gtk_tree_data_list_compare_func (GtkTreeModel *model,
 							 GtkTreeIter  *a,
 							 GtkTreeIter  *b,
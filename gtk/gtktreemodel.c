@@ -24,6 +24,7 @@
 #include "gtktreemodel.h"
 #include "gtktreeview.h"
 #include "gtktreeprivate.h"
+#include "gtktreemodelprivate.h"
 #include "gtkmarshalers.h"
 #include "gtkintl.h"
 
@@ -247,10 +248,14 @@ enum {
   ROW_HAS_CHILD_TOGGLED,
   ROW_DELETED,
   ROWS_REORDERED,
+  ROWS_INSERTED,
+  ROWS_CHANGED,
+  ROWS_DELETED,
   LAST_SIGNAL
 };
 
 static guint tree_model_signals[LAST_SIGNAL] = { 0 };
+static GQuark range_row_quark = 0;
 
 struct _GtkTreePath
 {
@@ -285,6 +290,24 @@ static void      rows_reordered_marshal     (GClosure          *closure,
                                              const GValue      *param_values,
                                              gpointer           invocation_hint,
                                              gpointer           marshal_data);
+static void      rows_inserted_marshal      (GClosure          *closure,
+                                             GValue /* out */  *return_value,
+                                             guint              n_param_value,
+                                             const GValue      *param_values,
+                                             gpointer           invocation_hint,
+                                             gpointer           marshal_data);
+static void      rows_changed_marshal       (GClosure          *closure,
+                                             GValue /* out */  *return_value,
+                                             guint              n_param_value,
+                                             const GValue      *param_values,
+                                             gpointer           invocation_hint,
+                                             gpointer           marshal_data);
+static void      rows_deleted_marshal       (GClosure          *closure,
+                                             GValue /* out */  *return_value,
+                                             guint              n_param_value,
+                                             const GValue      *param_values,
+                                             gpointer           invocation_hint,
+                                             gpointer           marshal_data);
 
 static void      gtk_tree_row_ref_inserted  (RowRefList        *refs,
                                              GtkTreePath       *path,
@@ -337,6 +360,8 @@ gtk_tree_model_base_init (gpointer g_class)
       GType row_inserted_params[2];
       GType row_deleted_params[1];
       GType rows_reordered_params[3];
+      GType rows_inserted_params[3];
+      GType rows_deleted_params[2];
 
       row_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
       row_inserted_params[1] = GTK_TYPE_TREE_ITER;
@@ -347,6 +372,15 @@ gtk_tree_model_base_init (gpointer g_class)
       rows_reordered_params[1] = GTK_TYPE_TREE_ITER;
       rows_reordered_params[2] = G_TYPE_POINTER;
 
+      rows_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
+      rows_inserted_params[1] = GTK_TYPE_TREE_ITER;
+      rows_inserted_params[2] = G_TYPE_INT;
+
+      rows_deleted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
+      rows_deleted_params[1] = G_TYPE_INT;
+
+      range_row_quark = g_quark_from_static_string ("gtk-tree-model-range-row");
+
       /**
        * GtkTreeModel::row-changed:
        * @tree_model: the #GtkTreeModel on which the signal is emitted
@@ -479,6 +513,89 @@ gtk_tree_model_base_init (gpointer g_class)
                        _gtk_marshal_VOID__BOXED_BOXED_POINTER,
                        G_TYPE_NONE, 3,
                        rows_reordered_params);
+
+      /**
+       * GtkTreeModel::rows-inserted:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath-struct identifying the first new row
+       * @iter: a valid #GtkTreeIter-struct pointing to the first new row
+       * @n_rows: the number of new rows
+       *
+       * This signal is emitted when @n_rows consecutive rows have been
+       * inserted in the model at once, starting at @path.
+       *
+       * The default handler emits #GtkTreeModel::row-inserted for each
+       * of the new rows, so code that only handles single rows keeps
+       * working. Connect to this signal to handle the rows in one go.
+       *
+       * Since: 3.24
+       */
+      closure = g_closure_new_simple (sizeof (GClosure), NULL);
+      g_closure_set_marshal (closure, rows_inserted_marshal);
+      tree_model_signals[ROWS_INSERTED] =
+        g_signal_newv (I_("rows-inserted"),
+                       GTK_TYPE_TREE_MODEL,
+                       G_SIGNAL_RUN_LAST,
+                       closure,
+                       NULL, NULL,
+                       _gtk_marshal_VOID__BOXED_BOXED_INT,
+                       G_TYPE_NONE, 3,
+                       rows_inserted_params);
+
+      /**
+       * GtkTreeModel::rows-changed:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath-struct identifying the first changed row
+       * @iter: a valid #GtkTreeIter-struct pointing to the first changed row
+       * @n_rows: the number of changed rows
+       *
+       * This signal is emitted when @n_rows consecutive rows below the
+       * same parent have changed, starting at @path.
+       *
+       * The default handler emits #GtkTreeModel::row-changed for each
+       * of the rows.
+       *
+       * Since: 3.24
+       */
+      closure = g_closure_new_simple (sizeof (GClosure), NULL);
+      g_closure_set_marshal (closure, rows_changed_marshal);
+      tree_model_signals[ROWS_CHANGED] =
+        g_signal_newv (I_("rows-changed"),
+                       GTK_TYPE_TREE_MODEL,
+                       G_SIGNAL_RUN_LAST,
+                       closure,
+                       NULL, NULL,
+                       _gtk_marshal_VOID__BOXED_BOXED_INT,
+                       G_TYPE_NONE, 3,
+                       rows_inserted_params);
+
+      /**
+       * GtkTreeModel::rows-deleted:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath-struct identifying the first deleted row
+       * @n_rows: the number of deleted rows
+       *
+       * This signal is emitted when @n_rows consecutive rows below the
+       * same parent have been deleted at once. @path is the location
+       * the first of them previously was at.
+       *
+       * The default handler emits #GtkTreeModel::row-deleted for each
+       * of the rows, all with @path, which also takes care of row
+       * references.
+       *
+       * Since: 3.24
+       */
+      closure = g_closure_new_simple (sizeof (GClosure), NULL);
+      g_closure_set_marshal (closure, rows_deleted_marshal);
+      tree_model_signals[ROWS_DELETED] =
+        g_signal_newv (I_("rows-deleted"),
+                       GTK_TYPE_TREE_MODEL,
+                       G_SIGNAL_RUN_LAST,
+                       closure,
+                       NULL, NULL,
+                       _gtk_marshal_VOID__BOXED_INT,
+                       G_TYPE_NONE, 2,
+                       rows_deleted_params);
       initialized = TRUE;
     }
 }
@@ -579,6 +696,139 @@ rows_reordered_marshal (GClosure          *closure,
     rows_reordered_callback (GTK_TREE_MODEL (model), path, iter, new_order);
 }
 
+static void
+rows_inserted_marshal (GClosure          *closure,
+                       GValue /* out */  *return_value,
+                       guint              n_param_values,
+                       const GValue      *param_values,
+                       gpointer           invocation_hint,
+                       gpointer           marshal_data)
+{
+  GObject *model = g_value_get_object (param_values + 0);
+  GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
+  GtkTreeIter *iter = (GtkTreeIter *)g_value_get_boxed (param_values + 2);
+  gint n_rows = g_value_get_int (param_values + 3);
+  GtkTreePath *row_path;
+  GtkTreeIter row_iter;
+  gpointer old_row_path;
+  gint i;
+
+  /* Split the range up for everybody who only listens to
+   * ::row-inserted. This also takes care of the row references.
+   * Handlers that already dealt with the range can tell these
+   * emissions apart with _gtk_tree_model_is_range_row().
+   */
+  row_path = gtk_tree_path_copy (path);
+  row_iter = *iter;
+
+  old_row_path = g_object_get_qdata (model, range_row_quark);
+  g_object_set_qdata (model, range_row_quark, row_path);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0)
+        {
+          gtk_tree_path_next (row_path);
+          if (!gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &row_iter))
+            break;
+        }
+
+      g_signal_emit (model, tree_model_signals[ROW_INSERTED], 0, row_path, &row_iter);
+    }
+
+  g_object_set_qdata (model, range_row_quark, old_row_path);
+  gtk_tree_path_free (row_path);
+}
+
+static void
+rows_changed_marshal (GClosure          *closure,
+                      GValue /* out */  *return_value,
+                      guint              n_param_values,
+                      const GValue      *param_values,
+                      gpointer           invocation_hint,
+                      gpointer           marshal_data)
+{
+  GObject *model = g_value_get_object (param_values + 0);
+  GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
+  GtkTreeIter *iter = (GtkTreeIter *)g_value_get_boxed (param_values + 2);
+  gint n_rows = g_value_get_int (param_values + 3);
+  GtkTreePath *row_path;
+  GtkTreeIter row_iter;
+  gpointer old_row_path;
+  gint i;
+
+  /* Same as for ::rows-inserted */
+  row_path = gtk_tree_path_copy (path);
+  row_iter = *iter;
+
+  old_row_path = g_object_get_qdata (model, range_row_quark);
+  g_object_set_qdata (model, range_row_quark, row_path);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0)
+        {
+          gtk_tree_path_next (row_path);
+          if (!gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &row_iter))
+            break;
+        }
+
+      g_signal_emit (model, tree_model_signals[ROW_CHANGED], 0, row_path, &row_iter);
+    }
+
+  g_object_set_qdata (model, range_row_quark, old_row_path);
+  gtk_tree_path_free (row_path);
+}
+
+static void
+rows_deleted_marshal (GClosure          *closure,
+                      GValue /* out */  *return_value,
+                      guint              n_param_values,
+                      const GValue      *param_values,
+                      gpointer           invocation_hint,
+                      gpointer           marshal_data)
+{
+  GObject *model = g_value_get_object (param_values + 0);
+  GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
+  gint n_rows = g_value_get_int (param_values + 2);
+  GtkTreePath *row_path;
+  gpointer old_row_path;
+  gint i;
+
+  /* Every row that goes away leaves the next one at @path, so
+   * per-row listeners see @n_rows deletions of the same location.
+   */
+  row_path = gtk_tree_path_copy (path);
+
+  old_row_path = g_object_get_qdata (model, range_row_quark);
+  g_object_set_qdata (model, range_row_quark, row_path);
+
+  for (i = 0; i < n_rows; i++)
+    g_signal_emit (model, tree_model_signals[ROW_DELETED], 0, row_path);
+
+  g_object_set_qdata (model, range_row_quark, old_row_path);
+  gtk_tree_path_free (row_path);
+}
+
+/*
+ * _gtk_tree_model_is_range_row:
+ * @tree_model: a #GtkTreeModel
+ * @path: the path passed to a #GtkTreeModel::row-inserted,
+ *     #GtkTreeModel::row-changed or #GtkTreeModel::row-deleted handler
+ *
+ * Returns whether the current per-row emission is part of a
+ * #GtkTreeModel::rows-inserted, #GtkTreeModel::rows-changed or
+ * #GtkTreeModel::rows-deleted emission, i.e. whether handlers that
+ * also listen to the range signal have already seen the row.
+ */
+gboolean
+_gtk_tree_model_is_range_row (GtkTreeModel *tree_model,
+                              GtkTreePath  *path)
+{
+  return path != NULL &&
+         g_object_get_qdata (G_OBJECT (tree_model), range_row_quark) == path;
+}
+
 /**
  * gtk_tree_path_new:
  *
@@ -1855,6 +2105,70 @@ gtk_tree_model_row_inserted (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], 0, path, iter);
 }
 
+/**
+ * gtk_tree_model_rows_inserted:
+ * @tree_model: a #GtkTreeModel
+ * @path: a #GtkTreePath-struct pointing to the first inserted row
+ * @iter: a valid #GtkTreeIter-struct pointing to the first inserted row
+ * @n_rows: the number of inserted rows
+ *
+ * Emits the #GtkTreeModel::rows-inserted signal on @tree_model.
+ *
+ * This should be called by models after inserting @n_rows consecutive
+ * rows below the same parent, instead of calling
+ * gtk_tree_model_row_inserted() for each of them.
+ *
+ * Since: 3.24
+ */
+void
+gtk_tree_model_rows_inserted (GtkTreeModel *tree_model,
+                              GtkTreePath  *path,
+                              GtkTreeIter  *iter,
+                              gint          n_rows)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (n_rows >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  g_signal_emit (tree_model, tree_model_signals[ROWS_INSERTED], 0, path, iter, n_rows);
+}
+
+/**
+ * gtk_tree_model_rows_changed:
+ * @tree_model: a #GtkTreeModel
+ * @path: a #GtkTreePath-struct pointing to the first changed row
+ * @iter: a valid #GtkTreeIter-struct pointing to the first changed row
+ * @n_rows: the number of changed rows
+ *
+ * Emits the #GtkTreeModel::rows-changed signal on @tree_model.
+ *
+ * This should be called by models after changing @n_rows consecutive
+ * rows below the same parent, instead of calling
+ * gtk_tree_model_row_changed() for each of them.
+ *
+ * Since: 3.24
+ */
+void
+gtk_tree_model_rows_changed (GtkTreeModel *tree_model,
+                             GtkTreePath  *path,
+                             GtkTreeIter  *iter,
+                             gint          n_rows)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (n_rows >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  g_signal_emit (tree_model, tree_model_signals[ROWS_CHANGED], 0, path, iter, n_rows);
+}
+
 /**
  * gtk_tree_model_row_has_child_toggled:
  * @tree_model: a #GtkTreeModel
@@ -1902,6 +2216,36 @@ gtk_tree_model_row_deleted (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROW_DELETED], 0, path);
 }
 
+/**
+ * gtk_tree_model_rows_deleted:
+ * @tree_model: a #GtkTreeModel
+ * @path: a #GtkTreePath-struct pointing to the previous location of
+ *     the first deleted row
+ * @n_rows: the number of deleted rows
+ *
+ * Emits the #GtkTreeModel::rows-deleted signal on @tree_model.
+ *
+ * This should be called by models after removing @n_rows consecutive
+ * rows below the same parent, instead of calling
+ * gtk_tree_model_row_deleted() for each of them.
+ *
+ * Since: 3.24
+ */
+void
+gtk_tree_model_rows_deleted (GtkTreeModel *tree_model,
+                             GtkTreePath  *path,
+                             gint          n_rows)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (n_rows >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  g_signal_emit (tree_model, tree_model_signals[ROWS_DELETED], 0, path, n_rows);
+}
+
 /**
  * gtk_tree_model_rows_reordered: (skip)
  * @tree_model: a #GtkTreeModel
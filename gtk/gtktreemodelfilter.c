@@ -20,6 +20,7 @@
 #include "gtktreemodelfilter.h"
 #include "gtkintl.h"
 #include "gtktreednd.h"
+#include "gtktreemodelprivate.h"
 #include "gtkprivate.h"
 #include <string.h>
 
@@ -260,6 +261,27 @@ struct _FilterLevel
   FilterLevel *parent_level;
 };
 
+typedef enum
+{
+  FILTER_RUN_NONE,
+  FILTER_RUN_CHANGED,
+  FILTER_RUN_INSERTED,
+  FILTER_RUN_DELETED
+} FilterRunType;
+
+/* A run of adjacent rows of the root level whose visibility was
+ * re-evaluated in the same way, and which is announced with a single
+ * range signal.
+ */
+typedef struct
+{
+  FilterRunType type;
+  gint start;
+  gint n_rows;
+  FilterElt *first;
+  gboolean structure_changed;
+} FilterRun;
+
 
 struct _GtkTreeModelFilterPrivate
 {
@@ -283,6 +305,7 @@ struct _GtkTreeModelFilterPrivate
   gint modify_n_columns;
 
   guint visible_method_set   : 1;
+  guint visible_concurrent   : 1;
   guint modify_func_set      : 1;
 
   guint in_row_deleted       : 1;
@@ -291,8 +314,11 @@ struct _GtkTreeModelFilterPrivate
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
+  gulong rows_changed_id;
+  gulong rows_deleted_id;
   gulong reordered_id;
 };
 
@@ -304,6 +330,12 @@ enum
   PROP_VIRTUAL_ROOT
 };
 
+/* Refilters of fewer root level rows than this evaluate a concurrent
+ * visible function on the calling thread only.
+ */
+#define CONCURRENT_VISIBLE_MIN_ROWS 2048
+#define CONCURRENT_VISIBLE_MIN_CHUNK 256
+
 /* Set this to 0 to disable caching of child iterators.  This
  * allows for more stringent testing.  It is recommended to set this
  * to one when refactoring this code and running the unit tests to
@@ -347,13 +379,27 @@ static void         gtk_tree_model_filter_row_inserted                    (GtkTr
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_rows_inserted                   (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gint                    n_rows,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_row_has_child_toggled           (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_rows_changed                    (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gint                    n_rows,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_row_deleted                     (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_rows_deleted                    (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           gint                    n_rows,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_rows_reordered                  (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
@@ -430,6 +476,7 @@ static GtkTreePath *gtk_tree_model_filter_add_root                        (GtkTr
 static GtkTreePath *gtk_tree_model_filter_remove_root                     (GtkTreePath            *src,
                                                                            GtkTreePath            *root);
 
+static void         gtk_tree_model_filter_next_stamp                      (GtkTreeModelFilter     *filter);
 static void         gtk_tree_model_filter_increment_stamp                 (GtkTreeModelFilter     *filter);
 
 static void         gtk_tree_model_filter_real_modify                     (GtkTreeModelFilter     *self,
@@ -483,9 +530,15 @@ static FilterElt   *gtk_tree_model_filter_fetch_child                     (GtkTr
 static void         gtk_tree_model_filter_remove_elt_from_level           (GtkTreeModelFilter     *filter,
                                                                            FilterLevel            *level,
                                                                            FilterElt              *elt);
+static void         gtk_tree_model_filter_remove_elt_from_level_full      (GtkTreeModelFilter     *filter,
+                                                                           FilterLevel            *level,
+                                                                           FilterElt              *elt,
+                                                                           gboolean                emit_signals);
 static void         gtk_tree_model_filter_update_children                 (GtkTreeModelFilter     *filter,
                                                                            FilterLevel            *level,
                                                                            FilterElt              *elt);
+static void         gtk_tree_model_filter_refilter_children               (GtkTreeModelFilter     *filter,
+                                                                           GtkTreeIter            *c_parent);
 static void         gtk_tree_model_filter_emit_row_inserted_for_path      (GtkTreeModelFilter     *filter,
                                                                            GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
@@ -506,6 +559,7 @@ gtk_tree_model_filter_init (GtkTreeModelFilter *filter)
   filter->priv->visible_column = -1;
   filter->priv->zero_ref_count = 0;
   filter->priv->visible_method_set = FALSE;
+  filter->priv->visible_concurrent = FALSE;
   filter->priv->modify_func_set = FALSE;
   filter->priv->in_row_deleted = FALSE;
   filter->priv->virtual_root_deleted = FALSE;
@@ -1224,14 +1278,19 @@ gtk_tree_model_filter_remove_root (GtkTreePath *src,
 }
 
 static void
-gtk_tree_model_filter_increment_stamp (GtkTreeModelFilter *filter)
+gtk_tree_model_filter_next_stamp (GtkTreeModelFilter *filter)
 {
   do
     {
       filter->priv->stamp++;
     }
   while (filter->priv->stamp == 0);
+}
 
+static void
+gtk_tree_model_filter_increment_stamp (GtkTreeModelFilter *filter)
+{
+  gtk_tree_model_filter_next_stamp (filter);
   gtk_tree_model_filter_clear_cache (filter);
 }
 
@@ -1622,6 +1681,18 @@ static void
 gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
                                              FilterLevel        *level,
                                              FilterElt          *elt)
+{
+  gtk_tree_model_filter_remove_elt_from_level_full (filter, level, elt, TRUE);
+}
+
+/* With @emit_signals set to %FALSE, the caller takes care of
+ * incrementing the stamp and of announcing the removal.
+ */
+static void
+gtk_tree_model_filter_remove_elt_from_level_full (GtkTreeModelFilter *filter,
+                                                  FilterLevel        *level,
+                                                  FilterElt          *elt,
+                                                  gboolean            emit_signals)
 {
   FilterElt *parent;
   FilterLevel *parent_level;
@@ -1643,7 +1714,9 @@ gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
   parent = level->parent_elt;
   parent_level = level->parent_level;
 
-  if (!parent || orig_level_ext_ref_count > 0)
+  if (!emit_signals)
+    path = NULL;
+  else if (!parent || orig_level_ext_ref_count > 0)
     path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
   else
     /* If the level is not visible, the parent is potentially invisible
@@ -1664,7 +1737,8 @@ gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
    * row-has-child-toggled.
    */
 
-  if (level != filter->priv->root
+  if (emit_signals
+      && level != filter->priv->root
       && g_sequence_get_length (level->visible_seq) == 0
       && parent
       && parent->visible_siter)
@@ -1713,12 +1787,13 @@ gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
       lookup_elt_with_offset (level->seq, elt->offset, &siter);
       g_sequence_remove (siter);
 
-      gtk_tree_model_filter_increment_stamp (filter);
+      if (emit_signals)
+        gtk_tree_model_filter_increment_stamp (filter);
 
       /* Only if the node is in the root level (parent == NULL) or
        * the level is visible, a row-deleted signal is necessary.
        */
-      if (!parent || orig_level_ext_ref_count > 0)
+      if (path)
         gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
     }
   else
@@ -1777,11 +1852,12 @@ gtk_tree_model_filter_remove_elt_from_level (GtkTreeModelFilter *filter,
             }
         }
 
-      if (!parent || orig_level_ext_ref_count > 0)
+      if (path)
         gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
     }
 
-  gtk_tree_path_free (path);
+  if (path)
+    gtk_tree_path_free (path);
 
   if (emit_child_toggled && parent->ext_ref_count > 0)
     {
@@ -1999,6 +2075,10 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
 
   g_return_if_fail (c_path != NULL || c_iter != NULL);
 
+  /* Already handled in gtk_tree_model_filter_rows_changed() */
+  if (_gtk_tree_model_is_range_row (c_model, c_path))
+    return;
+
   if (!c_path)
     {
       c_path = gtk_tree_model_get_path (c_model, c_iter);
@@ -2105,6 +2185,424 @@ done:
     gtk_tree_path_free (c_path);
 }
 
+/* Concurrent evaluation of the visible function.
+ *
+ * The rows are split in chunks that are evaluated in a thread pool
+ * shared by all filters, while the calling thread evaluates the first
+ * one and waits for the others.  Only the results are collected; they
+ * are applied to the level on the calling thread afterwards.
+ */
+typedef struct
+{
+  GtkTreeModelFilter *filter;
+  GMutex mutex;
+  GCond cond;
+  gint pending;
+} VisibleJob;
+
+typedef struct
+{
+  VisibleJob *job;
+  GtkTreeIter c_iter;
+  gint n_rows;
+  guint8 *visible;
+} VisibleChunk;
+
+static GThreadPool *visible_pool = NULL;
+
+static void
+visible_chunk_evaluate (VisibleChunk *chunk)
+{
+  GtkTreeModelFilter *filter = chunk->job->filter;
+  GtkTreeIter c_iter = chunk->c_iter;
+  gint i;
+
+  for (i = 0; i < chunk->n_rows; i++)
+    {
+      if (i > 0 && !gtk_tree_model_iter_next (filter->priv->child_model, &c_iter))
+        break;
+
+      chunk->visible[i] = gtk_tree_model_filter_real_visible (filter,
+                                                              filter->priv->child_model,
+                                                              &c_iter);
+    }
+}
+
+static void
+visible_chunk_thread (gpointer data,
+                      gpointer user_data)
+{
+  VisibleChunk *chunk = data;
+  VisibleJob *job = chunk->job;
+
+  visible_chunk_evaluate (chunk);
+
+  g_mutex_lock (&job->mutex);
+  if (--job->pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+/* Returns the visibility of the @n_rows rows starting at @c_iter,
+ * or %NULL if they should be evaluated one by one.
+ */
+static guint8 *
+gtk_tree_model_filter_evaluate_visible (GtkTreeModelFilter *filter,
+                                        GtkTreeIter        *c_iter,
+                                        gint                n_rows)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  VisibleChunk *chunks;
+  VisibleJob job;
+  GtkTreeIter iter;
+  guint8 *visible;
+  gint n_threads, n_chunks, chunk_size;
+  gint i, k;
+
+  if (!filter->priv->visible_concurrent ||
+      n_rows < CONCURRENT_VISIBLE_MIN_ROWS ||
+      GTK_TREE_MODEL_FILTER_GET_CLASS (filter)->visible != gtk_tree_model_filter_real_visible)
+    return NULL;
+
+  n_threads = g_get_num_processors ();
+  if (n_threads < 2)
+    return NULL;
+
+  if (visible_pool == NULL)
+    {
+      visible_pool = g_thread_pool_new (visible_chunk_thread, NULL,
+                                        n_threads, FALSE, NULL);
+      if (visible_pool == NULL)
+        return NULL;
+    }
+
+  /* A few chunks per thread, so that rows that are more expensive
+   * to evaluate than others do not leave threads idle.
+   */
+  chunk_size = MAX (CONCURRENT_VISIBLE_MIN_CHUNK,
+                    (n_rows + 4 * n_threads - 1) / (4 * n_threads));
+  n_chunks = (n_rows + chunk_size - 1) / chunk_size;
+
+  visible = g_new0 (guint8, n_rows);
+  chunks = g_new (VisibleChunk, n_chunks);
+
+  job.filter = filter;
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+  job.pending = n_chunks - 1;
+
+  /* Finding the first row of each chunk is cheap compared to the
+   * visible function, and keeps the workers to iter_next().
+   */
+  iter = *c_iter;
+  for (k = 0, i = 0; k < n_chunks; k++)
+    {
+      for (; i < k * chunk_size; i++)
+        gtk_tree_model_iter_next (c_model, &iter);
+
+      chunks[k].job = &job;
+      chunks[k].c_iter = iter;
+      chunks[k].n_rows = MIN (chunk_size, n_rows - k * chunk_size);
+      chunks[k].visible = visible + k * chunk_size;
+    }
+
+  for (k = 1; k < n_chunks; k++)
+    g_thread_pool_push (visible_pool, &chunks[k], NULL);
+
+  visible_chunk_evaluate (&chunks[0]);
+
+  g_mutex_lock (&job.mutex);
+  while (job.pending > 0)
+    g_cond_wait (&job.cond, &job.mutex);
+  g_mutex_unlock (&job.mutex);
+
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
+  g_free (chunks);
+
+  return visible;
+}
+
+static void
+gtk_tree_model_filter_flush_run (GtkTreeModelFilter *filter,
+                                 FilterRun          *run)
+{
+  FilterLevel *level = FILTER_LEVEL (filter->priv->root);
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  if (run->n_rows == 0)
+    {
+      run->type = FILTER_RUN_NONE;
+      return;
+    }
+
+  path = gtk_tree_path_new_from_indices (run->start, -1);
+
+  iter.stamp = filter->priv->stamp;
+  iter.user_data = level;
+  iter.user_data2 = run->first;
+
+  switch (run->type)
+    {
+    case FILTER_RUN_CHANGED:
+      if (level->ext_ref_count > 0)
+        gtk_tree_model_rows_changed (GTK_TREE_MODEL (filter),
+                                     path, &iter, run->n_rows);
+      break;
+
+    case FILTER_RUN_INSERTED:
+      gtk_tree_model_filter_next_stamp (filter);
+      iter.stamp = filter->priv->stamp;
+
+      gtk_tree_model_rows_inserted (GTK_TREE_MODEL (filter),
+                                    path, &iter, run->n_rows);
+      run->structure_changed = TRUE;
+      break;
+
+    case FILTER_RUN_DELETED:
+      gtk_tree_model_filter_next_stamp (filter);
+
+      gtk_tree_model_rows_deleted (GTK_TREE_MODEL (filter),
+                                   path, run->n_rows);
+      run->structure_changed = TRUE;
+      break;
+
+    case FILTER_RUN_NONE:
+    default:
+      g_assert_not_reached ();
+    }
+
+  gtk_tree_path_free (path);
+
+  run->type = FILTER_RUN_NONE;
+  run->n_rows = 0;
+  run->first = NULL;
+}
+
+/* Re-evaluates the visibility of the @n_rows child rows starting at
+ * @offset in the root level, @c_iter pointing to the first of them.
+ * This does what gtk_tree_model_filter_row_changed() does for each
+ * of the rows, but adjacent rows that change in the same way are
+ * announced with a single range signal, and the stamp is only
+ * incremented once per range.  With @recurse, the descendants of each
+ * row are refiltered right after it, like gtk_tree_model_foreach()
+ * would visit them.  Only with @concurrent may a concurrent visible
+ * function be evaluated in the thread pool; ranges that come from the
+ * child model are evaluated on the calling thread, as documented for
+ * gtk_tree_model_filter_set_visible_func_concurrent().
+ *
+ * Signals are emitted in the same order as for the row by row code,
+ * so a pending run is flushed before anything else is emitted, i.e.
+ * for rows with children.
+ */
+static void
+gtk_tree_model_filter_refilter_root_range (GtkTreeModelFilter *filter,
+                                           GtkTreeIter        *c_iter,
+                                           gint                offset,
+                                           gint                n_rows,
+                                           gboolean            recurse,
+                                           gboolean            concurrent)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  FilterLevel *level = FILTER_LEVEL (filter->priv->root);
+  GSequenceIter *siter;
+  GtkTreeIter real_c_iter;
+  FilterElt dummy;
+  FilterRun run;
+  guint8 *visible;
+  gint pos;
+  gint i;
+
+  visible = NULL;
+  if (concurrent)
+    visible = gtk_tree_model_filter_evaluate_visible (filter, c_iter, n_rows);
+
+  /* The first cached row at or after offset, and the position of the
+   * first visible one, which is where the first change will show up.
+   */
+  dummy.offset = offset - 1;
+  siter = g_sequence_search (level->seq, &dummy, filter_elt_cmp, NULL);
+  pos = g_sequence_iter_get_position (g_sequence_search (level->visible_seq,
+                                                         &dummy,
+                                                         filter_elt_cmp,
+                                                         NULL));
+
+  run.type = FILTER_RUN_NONE;
+  run.start = pos;
+  run.n_rows = 0;
+  run.first = NULL;
+  run.structure_changed = FALSE;
+
+  real_c_iter = *c_iter;
+
+  for (i = 0; i < n_rows; i++)
+    {
+      FilterElt *elt = NULL;
+      FilterRunType type;
+      gboolean requested_state;
+      gboolean has_child;
+      gint index;
+
+      if (i > 0 && !gtk_tree_model_iter_next (c_model, &real_c_iter))
+        break;
+
+      if (!g_sequence_iter_is_end (siter) &&
+          GET_ELT (siter)->offset == offset + i)
+        {
+          elt = g_sequence_get (siter);
+          siter = g_sequence_iter_next (siter);
+        }
+
+      if (visible)
+        requested_state = visible[i];
+      else
+        requested_state = gtk_tree_model_filter_visible (filter, &real_c_iter);
+      has_child = gtk_tree_model_iter_has_child (c_model, &real_c_iter);
+
+      if (elt && elt->visible_siter)
+        type = requested_state ? FILTER_RUN_CHANGED : FILTER_RUN_DELETED;
+      else if (requested_state)
+        type = FILTER_RUN_INSERTED;
+      else
+        type = FILTER_RUN_NONE;
+
+      /* Rows that stay hidden take up no position, so they do not
+       * interrupt a run
+       */
+      if (type != FILTER_RUN_NONE && type != run.type)
+        {
+          if (run.type != FILTER_RUN_NONE)
+            gtk_tree_model_filter_flush_run (filter, &run);
+
+          run.type = type;
+          run.start = pos;
+        }
+
+      switch (type)
+        {
+        case FILTER_RUN_NONE:
+          break;
+
+        case FILTER_RUN_CHANGED:
+          if (!run.first)
+            run.first = elt;
+          pos++;
+          break;
+
+        case FILTER_RUN_DELETED:
+          gtk_tree_model_filter_remove_elt_from_level_full (filter, level,
+                                                            elt, FALSE);
+          break;
+
+        case FILTER_RUN_INSERTED:
+          if (!elt)
+            elt = gtk_tree_model_filter_insert_elt_in_level (filter,
+                                                             &real_c_iter,
+                                                             level,
+                                                             offset + i,
+                                                             &index);
+
+          elt->visible_siter = g_sequence_insert_sorted (level->visible_seq,
+                                                         elt,
+                                                         filter_elt_cmp, NULL);
+          if (!run.first)
+            run.first = elt;
+          pos++;
+          break;
+
+        default:
+          g_assert_not_reached ();
+        }
+
+      if (type != FILTER_RUN_NONE)
+        run.n_rows++;
+
+      if (has_child && (recurse || type == FILTER_RUN_CHANGED ||
+                        type == FILTER_RUN_INSERTED))
+        {
+          if (run.type != FILTER_RUN_NONE)
+            gtk_tree_model_filter_flush_run (filter, &run);
+
+          if (type == FILTER_RUN_CHANGED || type == FILTER_RUN_INSERTED)
+            gtk_tree_model_filter_update_children (filter, level, elt);
+
+          if (recurse)
+            {
+              gtk_tree_model_filter_refilter_children (filter, &real_c_iter);
+
+              /* The descendants may have changed the visibility of
+               * this row through gtk_tree_model_filter_check_ancestors()
+               */
+              dummy.offset = offset + i;
+              pos = g_sequence_iter_get_position (g_sequence_search (level->visible_seq,
+                                                                     &dummy,
+                                                                     filter_elt_cmp,
+                                                                     NULL));
+            }
+        }
+    }
+
+  if (run.type != FILTER_RUN_NONE)
+    gtk_tree_model_filter_flush_run (filter, &run);
+
+  if (run.structure_changed)
+    gtk_tree_model_filter_clear_cache (filter);
+
+  g_free (visible);
+}
+
+static void
+gtk_tree_model_filter_rows_changed (GtkTreeModel *c_model,
+                                    GtkTreePath  *c_path,
+                                    GtkTreeIter  *c_iter,
+                                    gint          n_rows,
+                                    gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *real_path = NULL;
+  GtkTreePath *row_path;
+  GtkTreeIter row_iter;
+  gint i;
+
+  if (filter->priv->virtual_root)
+    real_path = gtk_tree_model_filter_remove_root (c_path,
+                                                   filter->priv->virtual_root);
+  else
+    real_path = gtk_tree_path_copy (c_path);
+
+  if (filter->priv->root && real_path &&
+      gtk_tree_path_get_depth (real_path) == 1)
+    {
+      gtk_tree_model_filter_refilter_root_range (filter, c_iter,
+                                                 gtk_tree_path_get_indices (real_path)[0],
+                                                 n_rows, FALSE, FALSE);
+      gtk_tree_path_free (real_path);
+      return;
+    }
+
+  if (real_path)
+    gtk_tree_path_free (real_path);
+
+  /* Deeper levels are handled row by row */
+  row_path = gtk_tree_path_copy (c_path);
+  row_iter = *c_iter;
+
+  for (i = 0; i < n_rows; i++)
+    {
+      if (i > 0)
+        {
+          gtk_tree_path_next (row_path);
+          if (!gtk_tree_model_iter_next (c_model, &row_iter))
+            break;
+        }
+
+      gtk_tree_model_filter_row_changed (c_model, row_path, &row_iter, data);
+    }
+
+  gtk_tree_path_free (row_path);
+}
+
 static void
 gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
                                     GtkTreePath  *c_path,
@@ -2129,6 +2627,10 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
 
   g_return_if_fail (c_path != NULL || c_iter != NULL);
 
+  /* Already handled in gtk_tree_model_filter_rows_inserted() */
+  if (_gtk_tree_model_is_range_row (c_model, c_path))
+    return;
+
   if (!c_path)
     {
       c_path = gtk_tree_model_get_path (c_model, c_iter);
@@ -2290,6 +2792,230 @@ done:
     gtk_tree_path_free (c_path);
 }
 
+/* Like gtk_tree_model_filter_row_inserted(), but for @n_rows
+ * consecutive rows. The offsets in the level are only updated once,
+ * and the visible rows are announced with a single rows-inserted,
+ * since they end up next to each other in the visible sequence.
+ */
+static void
+gtk_tree_model_filter_rows_inserted (GtkTreeModel *c_model,
+                                     GtkTreePath  *c_path,
+                                     GtkTreeIter  *c_iter,
+                                     gint          n_rows,
+                                     gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *real_path = NULL;
+  GtkTreePath *path;
+  GtkTreeIter real_c_iter;
+  GtkTreeIter iter;
+  GtkTreeIter children;
+
+  FilterElt *elt = NULL;
+  FilterElt *first_elt = NULL;
+  FilterLevel *level = NULL;
+  FilterLevel *parent_level = NULL;
+  GSequenceIter *siter;
+  FilterElt dummy;
+  GPtrArray *new_elts = NULL;
+
+  gint i, k, offset;
+  gint n_visible_before;
+
+  /* the rows have already been inserted. so we need to fixup the
+   * virtual root here first
+   */
+  if (filter->priv->virtual_root)
+    {
+      if (gtk_tree_path_get_depth (filter->priv->virtual_root) >=
+          gtk_tree_path_get_depth (c_path))
+        {
+          gint depth;
+          gint *v_indices, *c_indices;
+          gboolean common_prefix = TRUE;
+
+          depth = gtk_tree_path_get_depth (c_path) - 1;
+          v_indices = gtk_tree_path_get_indices (filter->priv->virtual_root);
+          c_indices = gtk_tree_path_get_indices (c_path);
+
+          for (i = 0; i < depth; i++)
+            if (v_indices[i] != c_indices[i])
+              {
+                common_prefix = FALSE;
+                break;
+              }
+
+          if (common_prefix && v_indices[depth] >= c_indices[depth])
+            v_indices[depth] += n_rows;
+        }
+    }
+
+  /* subtract virtual root if necessary */
+  if (filter->priv->virtual_root)
+    {
+      real_path = gtk_tree_model_filter_remove_root (c_path,
+                                                     filter->priv->virtual_root);
+      /* not our child */
+      if (!real_path)
+        return;
+    }
+  else
+    real_path = gtk_tree_path_copy (c_path);
+
+  if (!filter->priv->root)
+    {
+      /* The root level has not been exposed to the view yet, so
+       * building it emits the signals for the new rows.
+       */
+      gtk_tree_model_filter_build_level (filter, NULL, NULL, TRUE);
+
+      if (filter->priv->root)
+        goto done;
+    }
+
+  if (gtk_tree_path_get_depth (real_path) - 1 >= 1)
+    {
+      gboolean found = FALSE;
+      GtkTreePath *parent = gtk_tree_path_copy (real_path);
+      gtk_tree_path_up (parent);
+
+      found = find_elt_with_offset (filter, parent, &parent_level, &elt);
+
+      gtk_tree_path_free (parent);
+
+      if (!found)
+        /* Parent is not in the cache and probably being filtered out */
+        goto done;
+
+      level = elt->children;
+    }
+  else
+    level = FILTER_LEVEL (filter->priv->root);
+
+  if (!level)
+    {
+      if (elt && elt->visible_siter)
+        {
+          /* The level in which the new nodes should be inserted does not
+           * exist, but the parent, elt, does.  If elt is visible, emit
+           * row-has-child-toggled.
+           */
+          iter.stamp = filter->priv->stamp;
+          iter.user_data = parent_level;
+          iter.user_data2 = elt;
+
+          path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
+          if (path)
+            {
+              gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter),
+                                                    path, &iter);
+              gtk_tree_path_free (path);
+            }
+        }
+      goto done;
+    }
+
+  offset = gtk_tree_path_get_indices (real_path)[gtk_tree_path_get_depth (real_path) - 1];
+
+  /* update the offsets of all nodes after the new ones in one go */
+  dummy.offset = offset;
+  siter = g_sequence_search (level->seq, &dummy, filter_elt_cmp, NULL);
+  siter = g_sequence_iter_prev (siter);
+  for (; !g_sequence_iter_is_end (siter); siter = g_sequence_iter_next (siter))
+    {
+      FilterElt *e = g_sequence_get (siter);
+
+      if (e->offset >= offset)
+        e->offset += n_rows;
+    }
+
+  /* only insert the visible ones */
+  n_visible_before = g_sequence_get_length (level->visible_seq);
+  new_elts = g_ptr_array_new ();
+  real_c_iter = *c_iter;
+
+  for (k = 0; k < n_rows; k++)
+    {
+      if (k > 0 && !gtk_tree_model_iter_next (c_model, &real_c_iter))
+        break;
+
+      if (gtk_tree_model_filter_visible (filter, &real_c_iter))
+        {
+          FilterElt *felt;
+
+          felt = gtk_tree_model_filter_insert_elt_in_level (filter,
+                                                            &real_c_iter,
+                                                            level,
+                                                            offset + k,
+                                                            &i);
+
+          /* insert_elt_in_level defaults to FALSE */
+          felt->visible_siter = g_sequence_insert_sorted (level->visible_seq,
+                                                          felt,
+                                                          filter_elt_cmp, NULL);
+          g_ptr_array_add (new_elts, felt);
+        }
+    }
+
+done:
+  gtk_tree_model_filter_check_ancestors (filter, real_path);
+
+  if (new_elts && new_elts->len > 0)
+    {
+      gtk_tree_model_filter_increment_stamp (filter);
+
+      first_elt = g_ptr_array_index (new_elts, 0);
+
+      /* The new nodes are in the same level, so they are either all
+       * visible to the clients or none of them is
+       */
+      if (gtk_tree_model_filter_elt_is_visible_in_target (level, first_elt))
+        {
+          iter.stamp = filter->priv->stamp;
+          iter.user_data = level;
+          iter.user_data2 = first_elt;
+
+          path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
+
+          if (!level->parent_level || level->ext_ref_count > 0)
+            gtk_tree_model_rows_inserted (GTK_TREE_MODEL (filter),
+                                          path, &iter, new_elts->len);
+
+          if (level->parent_level && level->parent_elt->ext_ref_count > 0 &&
+              n_visible_before == 0)
+            {
+              /* These are the first visible nodes in this level */
+              gtk_tree_path_up (path);
+              gtk_tree_model_get_iter (GTK_TREE_MODEL (filter), &iter, path);
+
+              gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter),
+                                                    path,
+                                                    &iter);
+            }
+
+          gtk_tree_path_free (path);
+
+          for (k = 0; k < new_elts->len; k++)
+            {
+              FilterElt *felt = g_ptr_array_index (new_elts, k);
+
+              iter.stamp = filter->priv->stamp;
+              iter.user_data = level;
+              iter.user_data2 = felt;
+              gtk_tree_model_filter_convert_iter_to_child_iter (filter, &real_c_iter, &iter);
+
+              if (gtk_tree_model_iter_children (c_model, &children, &real_c_iter))
+                gtk_tree_model_filter_update_children (filter, level, felt);
+            }
+        }
+    }
+
+  if (new_elts)
+    g_ptr_array_unref (new_elts);
+
+  gtk_tree_path_free (real_path);
+}
+
 static void
 gtk_tree_model_filter_row_has_child_toggled (GtkTreeModel *c_model,
                                              GtkTreePath  *c_path,
@@ -2540,6 +3266,10 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
 
   g_return_if_fail (c_path != NULL);
 
+  /* Already handled in gtk_tree_model_filter_rows_deleted() */
+  if (_gtk_tree_model_is_range_row (c_model, c_path))
+    return;
+
   /* special case the deletion of an ancestor of the virtual root */
   if (filter->priv->virtual_root &&
       (gtk_tree_path_is_ancestor (c_path, filter->priv->virtual_root) ||
@@ -2701,6 +3431,132 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
   gtk_tree_path_free (path);
 }
 
+/* Like gtk_tree_model_filter_row_deleted(), but for @n_rows
+ * consecutive child rows.  Rows in the root level are removed in one
+ * pass, and the visible ones among them, which are adjacent in the
+ * filter, are announced with a single rows-deleted.
+ */
+static void
+gtk_tree_model_filter_rows_deleted (GtkTreeModel *c_model,
+                                    GtkTreePath  *c_path,
+                                    gint          n_rows,
+                                    gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *real_path = NULL;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GSequenceIter *siter, *next;
+  FilterLevel *level = FILTER_LEVEL (filter->priv->root);
+  FilterElt *elt;
+  FilterElt dummy;
+  gboolean is_first;
+  gint offset, start;
+  gint n_cached, n_visible;
+  gint i;
+
+  if (level)
+    {
+      if (filter->priv->virtual_root)
+        real_path = gtk_tree_model_filter_remove_root (c_path,
+                                                       filter->priv->virtual_root);
+      else
+        real_path = gtk_tree_path_copy (c_path);
+    }
+
+  if (!real_path || gtk_tree_path_get_depth (real_path) != 1)
+    goto row_by_row;
+
+  offset = gtk_tree_path_get_indices (real_path)[0];
+  gtk_tree_path_free (real_path);
+  real_path = NULL;
+
+  dummy.offset = offset - 1;
+  siter = g_sequence_search (level->seq, &dummy, filter_elt_cmp, NULL);
+  start = g_sequence_iter_get_position (g_sequence_search (level->visible_seq,
+                                                           &dummy,
+                                                           filter_elt_cmp,
+                                                           NULL));
+  is_first = siter == g_sequence_get_begin_iter (level->seq);
+
+  n_cached = 0;
+  for (next = siter;
+       !g_sequence_iter_is_end (next) && GET_ELT (next)->offset < offset + n_rows;
+       next = g_sequence_iter_next (next))
+    n_cached++;
+
+  /* The root level would go away, the single row code knows how */
+  if (n_cached > 0 && n_cached == g_sequence_get_length (level->seq))
+    goto row_by_row;
+
+  iter.stamp = filter->priv->stamp;
+  iter.user_data = level;
+
+  n_visible = 0;
+  for (i = 0; i < n_cached; i++)
+    {
+      elt = g_sequence_get (siter);
+      iter.user_data2 = elt;
+
+      /* See gtk_tree_model_filter_row_deleted() */
+      while (elt->ext_ref_count > 0)
+        gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (data), &iter,
+                                               TRUE, FALSE);
+
+      if (elt->children)
+        while (elt->ref_count > 1)
+          gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (data), &iter,
+                                                 FALSE, FALSE);
+      else
+        while (elt->ref_count > 0)
+          gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (data), &iter,
+                                                 FALSE, FALSE);
+
+      if (elt->children)
+        gtk_tree_model_filter_free_level (filter, elt->children,
+                                          FALSE, FALSE, FALSE);
+
+      if (elt->visible_siter)
+        {
+          g_sequence_remove (elt->visible_siter);
+          n_visible++;
+        }
+
+      next = g_sequence_iter_next (siter);
+      g_sequence_remove (siter);
+      siter = next;
+    }
+
+  for (; !g_sequence_iter_is_end (siter); siter = g_sequence_iter_next (siter))
+    GET_ELT (siter)->offset -= n_rows;
+
+  /* Take a reference on the new first node, see above */
+  if (is_first && n_cached > 0)
+    {
+      iter.user_data2 = g_sequence_get (g_sequence_get_begin_iter (level->seq));
+      gtk_tree_model_filter_real_ref_node (GTK_TREE_MODEL (filter),
+                                           &iter, FALSE);
+    }
+
+  if (n_visible > 0)
+    {
+      gtk_tree_model_filter_increment_stamp (filter);
+
+      path = gtk_tree_path_new_from_indices (start, -1);
+      gtk_tree_model_rows_deleted (GTK_TREE_MODEL (data), path, n_visible);
+      gtk_tree_path_free (path);
+    }
+
+  return;
+
+row_by_row:
+  if (real_path)
+    gtk_tree_path_free (real_path);
+
+  for (i = 0; i < n_rows; i++)
+    gtk_tree_model_filter_row_deleted (c_model, c_path, data);
+}
+
 static void
 gtk_tree_model_filter_rows_reordered (GtkTreeModel *c_model,
                                       GtkTreePath  *c_path,
@@ -3639,10 +4495,16 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
                                    filter->priv->changed_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->inserted_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->rows_inserted_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->has_child_toggled_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->deleted_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->rows_changed_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->rows_deleted_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->reordered_id);
 
@@ -3671,6 +4533,10 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_filter_row_inserted),
                           filter);
+      filter->priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_filter_rows_inserted),
+                          filter);
       filter->priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_filter_row_has_child_toggled),
@@ -3679,6 +4545,14 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
         g_signal_connect (child_model, "row-deleted",
                           G_CALLBACK (gtk_tree_model_filter_row_deleted),
                           filter);
+      filter->priv->rows_changed_id =
+        g_signal_connect (child_model, "rows-changed",
+                          G_CALLBACK (gtk_tree_model_filter_rows_changed),
+                          filter);
+      filter->priv->rows_deleted_id =
+        g_signal_connect (child_model, "rows-deleted",
+                          G_CALLBACK (gtk_tree_model_filter_rows_deleted),
+                          filter);
       filter->priv->reordered_id =
         g_signal_connect (child_model, "rows-reordered",
                           G_CALLBACK (gtk_tree_model_filter_rows_reordered),
@@ -3858,6 +4732,43 @@ gtk_tree_model_filter_set_visible_func (GtkTreeModelFilter            *filter,
   filter->priv->visible_method_set = TRUE;
 }
 
+/**
+ * gtk_tree_model_filter_set_visible_func_concurrent:
+ * @filter: A #GtkTreeModelFilter.
+ * @func: A #GtkTreeModelFilterVisibleFunc, the visible function
+ * @data: (allow-none): User data to pass to the visible function, or %NULL
+ * @destroy: (allow-none): Destroy notifier of @data, or %NULL
+ *
+ * Like gtk_tree_model_filter_set_visible_func(), but declares that
+ * @func may be called from several threads at the same time.
+ *
+ * gtk_tree_model_filter_refilter() then evaluates @func for large
+ * levels in a pool of worker threads, and applies the results on the
+ * calling thread.  While it does, @func must only read from the child
+ * model, and the child model must allow concurrent reads, as
+ * #GtkListStore and #GtkTreeStore do when they are not modified.
+ * Any other state @func uses has to be thread-safe as well.
+ *
+ * All other evaluations, such as for inserted or changed rows, still
+ * happen on the thread that modifies the child model.
+ *
+ * Since: 3.24
+ */
+void
+gtk_tree_model_filter_set_visible_func_concurrent (GtkTreeModelFilter            *filter,
+                                                   GtkTreeModelFilterVisibleFunc  func,
+                                                   gpointer                       data,
+                                                   GDestroyNotify                 destroy)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+  g_return_if_fail (func != NULL);
+  g_return_if_fail (filter->priv->visible_method_set == FALSE);
+
+  gtk_tree_model_filter_set_visible_func (filter, func, data, destroy);
+
+  filter->priv->visible_concurrent = TRUE;
+}
+
 /**
  * gtk_tree_model_filter_set_modify_func:
  * @filter: A #GtkTreeModelFilter.
@@ -4246,6 +5157,29 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
   return FALSE;
 }
 
+static void
+gtk_tree_model_filter_refilter_children (GtkTreeModelFilter *filter,
+                                         GtkTreeIter        *c_parent)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreeIter c_iter;
+
+  if (!gtk_tree_model_iter_children (c_model, &c_iter, c_parent))
+    return;
+
+  do
+    {
+      GtkTreePath *c_path;
+
+      c_path = gtk_tree_model_get_path (c_model, &c_iter);
+      gtk_tree_model_filter_refilter_helper (c_model, c_path, &c_iter, filter);
+      gtk_tree_path_free (c_path);
+
+      gtk_tree_model_filter_refilter_children (filter, &c_iter);
+    }
+  while (gtk_tree_model_iter_next (c_model, &c_iter));
+}
+
 /**
  * gtk_tree_model_filter_refilter:
  * @filter: A #GtkTreeModelFilter.
@@ -4253,17 +5187,50 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
  * Emits ::row_changed for each row in the child model, which causes
  * the filter to re-evaluate whether a row is visible or not.
  *
+ * Adjacent top-level rows that change in the same way are announced
+ * with a single #GtkTreeModel::rows-inserted, #GtkTreeModel::rows-deleted
+ * or #GtkTreeModel::rows-changed signal.
+ *
  * Since: 2.4
  */
 void
 gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
+  GtkTreeModel *c_model;
+  GtkTreeIter root_iter, c_iter;
+  GtkTreeIter *c_parent = NULL;
+
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
-  /* S L O W */
-  gtk_tree_model_foreach (filter->priv->child_model,
-                          gtk_tree_model_filter_refilter_helper,
-                          filter);
+  c_model = filter->priv->child_model;
+
+  if (!filter->priv->root)
+    {
+      /* Nothing has been exposed yet; the first visible row
+       * builds the root level
+       */
+      gtk_tree_model_foreach (c_model,
+                              gtk_tree_model_filter_refilter_helper,
+                              filter);
+      return;
+    }
+
+  if (filter->priv->virtual_root)
+    {
+      if (filter->priv->virtual_root_deleted ||
+          !gtk_tree_model_get_iter (c_model, &root_iter,
+                                    filter->priv->virtual_root))
+        return;
+
+      c_parent = &root_iter;
+    }
+
+  if (!gtk_tree_model_iter_children (c_model, &c_iter, c_parent))
+    return;
+
+  gtk_tree_model_filter_refilter_root_range (filter, &c_iter, 0,
+                                             gtk_tree_model_iter_n_children (c_model, c_parent),
+                                             TRUE, TRUE);
 }
 
 /**
@@ -115,6 +115,11 @@ void          gtk_tree_model_filter_set_visible_func           (GtkTreeModelFilt
                                                                 GtkTreeModelFilterVisibleFunc func,
                                                                 gpointer                      data,
                                                                 GDestroyNotify                destroy);
+GDK_AVAILABLE_IN_3_24
+void          gtk_tree_model_filter_set_visible_func_concurrent (GtkTreeModelFilter          *filter,
+                                                                GtkTreeModelFilterVisibleFunc func,
+                                                                gpointer                      data,
+                                                                GDestroyNotify                destroy);
 GDK_AVAILABLE_IN_ALL
 void          gtk_tree_model_filter_set_modify_func            (GtkTreeModelFilter           *filter,
                                                                 gint                          n_columns,
@@ -0,0 +1,30 @@
+/* gtktreemodelprivate.h
+ * Copyright (C) 2000  Red Hat, Inc.,  Jonathan Blandford <jrb@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_TREE_MODEL_PRIVATE_H__
+#define __GTK_TREE_MODEL_PRIVATE_H__
+
+#include "gtktreemodel.h"
+
+G_BEGIN_DECLS
+
+gboolean _gtk_tree_model_is_range_row (GtkTreeModel *tree_model,
+                                       GtkTreePath  *path);
+
+G_END_DECLS
+
+#endif /* __GTK_TREE_MODEL_PRIVATE_H__ */
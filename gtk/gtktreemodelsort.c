@@ -23,6 +23,7 @@
 #include "gtktreesortable.h"
 #include "gtktreestore.h"
 #include "gtktreedatalist.h"
+#include "gtktreemodelprivate.h"
 #include "gtkintl.h"
 #include "gtkprivate.h"
 #include "gtktreednd.h"
@@ -245,8 +246,46 @@ struct _SortData
   GtkTreePath *parent_path;
   gint *parent_path_indices;
   gint parent_path_depth;
+
+  /* set if sort_func is the built-in compare function of a column */
+  gint key_column;
+  GType key_type;
+
+  /* the value of key_elt in key_column, fetched only once */
+  SortElt *key_elt;
+  GValue key_value;
 };
 
+/* Sorting a level on a column that uses the built-in compare function
+ * fetches every value only once, into an array of these, and sorts
+ * that instead of the sequence.
+ */
+typedef enum
+{
+  SORT_KEY_NONE,
+  SORT_KEY_SIGNED,
+  SORT_KEY_UNSIGNED,
+  SORT_KEY_DOUBLE,
+  SORT_KEY_STRING
+} SortKeyType;
+
+typedef struct
+{
+  SortElt *elt;
+  union {
+    gint64   v_signed;
+    guint64  v_unsigned;
+    gdouble  v_double;
+    gchar   *v_string; /* collation key, see g_utf8_collate_key() */
+  } key;
+} SortKey;
+
+typedef struct
+{
+  SortKeyType type;
+  GtkSortType order;
+} SortKeyInfo;
+
 /* Properties */
 enum {
   PROP_0,
@@ -254,6 +293,13 @@ enum {
   PROP_MODEL
 };
 
+/* Levels with at least this many rows are sorted by several threads
+ * when the sort column changes, in chunks no smaller than the second
+ * value.
+ */
+#define SORT_KEY_PARALLEL_MIN_ROWS 16384
+#define SORT_KEY_PARALLEL_MIN_CHUNK 4096
+
 
 struct _GtkTreeModelSortPrivate
 {
@@ -276,8 +322,10 @@ struct _GtkTreeModelSortPrivate
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
+  gulong rows_deleted_id;
   gulong reordered_id;
 };
 
@@ -327,6 +375,11 @@ static void gtk_tree_model_sort_row_inserted          (GtkTreeModel          *mo
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
 						       gpointer               data);
+static void gtk_tree_model_sort_rows_inserted         (GtkTreeModel          *model,
+						       GtkTreePath           *path,
+						       GtkTreeIter           *iter,
+						       gint                   n_rows,
+						       gpointer               data);
 static void gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel          *model,
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
@@ -334,6 +387,10 @@ static void gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel          *mo
 static void gtk_tree_model_sort_row_deleted           (GtkTreeModel          *model,
 						       GtkTreePath           *path,
 						       gpointer               data);
+static void gtk_tree_model_sort_rows_deleted          (GtkTreeModel          *model,
+						       GtkTreePath           *path,
+						       gint                   n_rows,
+						       gpointer               data);
 static void gtk_tree_model_sort_rows_reordered        (GtkTreeModel          *s_model,
 						       GtkTreePath           *s_path,
 						       GtkTreeIter           *s_iter,
@@ -658,6 +715,9 @@ fill_sort_data (SortData         *data,
   GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
 
   data->tree_model_sort = tree_model_sort;
+  data->key_column = -1;
+  data->key_type = G_TYPE_INVALID;
+  data->key_elt = NULL;
 
   if (priv->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
     {
@@ -681,6 +741,13 @@ fill_sort_data (SortData         *data,
       data->sort_data = priv->default_sort_data;
     }
 
+  if (data->sort_func == _gtk_tree_data_list_compare_func)
+    {
+      data->key_column = GPOINTER_TO_INT (data->sort_data);
+      data->key_type = gtk_tree_model_get_column_type (priv->child_model,
+                                                       data->key_column);
+    }
+
   if (level->parent_elt)
     {
       data->parent_path = gtk_tree_model_sort_elt_get_path (level->parent_level,
@@ -698,9 +765,57 @@ fill_sort_data (SortData         *data,
 static void
 free_sort_data (SortData *data)
 {
+  if (data->key_elt)
+    g_value_unset (&data->key_value);
+
   gtk_tree_path_free (data->parent_path);
 }
 
+static void
+sort_data_get_child_iter (SortData      *data,
+                          const SortElt *elt,
+                          GtkTreeIter   *child_iter)
+{
+  GtkTreeModelSort *tree_model_sort = data->tree_model_sort;
+
+  if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+    *child_iter = elt->iter;
+  else
+    {
+      data->parent_path_indices [data->parent_path_depth-1] = elt->offset;
+      gtk_tree_model_get_iter (tree_model_sort->priv->child_model,
+                               child_iter, data->parent_path);
+    }
+}
+
+static void
+sort_data_get_key_value (SortData      *data,
+                         const SortElt *elt,
+                         GValue        *value)
+{
+  GtkTreeIter child_iter;
+
+  sort_data_get_child_iter (data, elt, &child_iter);
+  gtk_tree_model_get_value (data->tree_model_sort->priv->child_model,
+                            &child_iter, data->key_column, value);
+}
+
+/* Makes comparisons against @elt reuse its value instead of fetching
+ * it again, which halves the number of values fetched when moving a
+ * changed row into place.
+ */
+static void
+sort_data_set_key_elt (SortData *data,
+                       SortElt  *elt)
+{
+  if (data->key_column < 0)
+    return;
+
+  memset (&data->key_value, 0, sizeof (GValue));
+  sort_data_get_key_value (data, elt, &data->key_value);
+  data->key_elt = elt;
+}
+
 static SortElt *
 lookup_elt_with_offset (GtkTreeModelSort *tree_model_sort,
                         SortLevel        *level,
@@ -730,6 +845,41 @@ lookup_elt_with_offset (GtkTreeModelSort *tree_model_sort,
   return GET_ELT (siter);
 }
 
+/* Checks whether @elt, whose row changed, can stay where it is.  Most
+ * changes do not affect the sort column, and this costs two comparisons
+ * where moving the row costs a binary search of the level.
+ *
+ * Like g_sequence_sort_changed(), a row that compares equal to one of
+ * its neighbours is not moved.
+ */
+static gboolean
+gtk_tree_model_sort_elt_in_place (SortElt  *elt,
+                                  SortData *data)
+{
+  GSequenceIter *siter;
+  gint prev_cmp = -1, next_cmp = -1;
+
+  if (!g_sequence_iter_is_begin (elt->siter))
+    {
+      siter = g_sequence_iter_prev (elt->siter);
+      prev_cmp = gtk_tree_model_sort_compare_func (g_sequence_get (siter),
+                                                   elt, data);
+      if (prev_cmp == 0)
+        return TRUE;
+    }
+
+  siter = g_sequence_iter_next (elt->siter);
+  if (!g_sequence_iter_is_end (siter))
+    {
+      next_cmp = gtk_tree_model_sort_compare_func (elt, g_sequence_get (siter),
+                                                   data);
+      if (next_cmp == 0)
+        return TRUE;
+    }
+
+  return prev_cmp < 0 && next_cmp < 0;
+}
+
 
 static void
 gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
@@ -799,9 +949,11 @@ gtk_tree_model_sort_row_changed (GtkTreeModel *s_model,
   old_index = g_sequence_iter_get_position (elt->siter);
 
   fill_sort_data (&sort_data, tree_model_sort, level);
-  g_sequence_sort_changed (elt->siter,
-                           gtk_tree_model_sort_compare_func,
-                           &sort_data);
+  sort_data_set_key_elt (&sort_data, elt);
+  if (!gtk_tree_model_sort_elt_in_place (elt, &sort_data))
+    g_sequence_sort_changed (elt->siter,
+                             gtk_tree_model_sort_compare_func,
+                             &sort_data);
   free_sort_data (&sort_data);
 
   index = g_sequence_iter_get_position (elt->siter);
@@ -903,6 +1055,10 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
 
   g_return_if_fail (s_path != NULL || s_iter != NULL);
 
+  /* Already handled in gtk_tree_model_sort_rows_inserted() */
+  if (_gtk_tree_model_is_range_row (s_model, s_path))
+    return;
+
   if (!s_path)
     {
       s_path = gtk_tree_model_get_path (s_model, s_iter);
@@ -995,6 +1151,203 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
   return;
 }
 
+static gint
+sort_elt_position_compare (gconstpointer a,
+                           gconstpointer b,
+                           gpointer      user_data)
+{
+  const SortElt *elt_a = *(SortElt **) a;
+  const SortElt *elt_b = *(SortElt **) b;
+
+  return elt_a->old_index - elt_b->old_index;
+}
+
+/* Like gtk_tree_model_sort_row_inserted(), but for @n_rows consecutive
+ * child rows. The offsets in the level are only updated once, and new
+ * rows that end up next to each other are announced with a single
+ * rows-inserted.
+ */
+static void
+gtk_tree_model_sort_rows_inserted (GtkTreeModel *s_model,
+                                   GtkTreePath  *s_path,
+                                   GtkTreeIter  *s_iter,
+                                   gint          n_rows,
+                                   gpointer      data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GtkTreeIter real_s_iter;
+  GSequenceIter *siter, *end_siter;
+  SortData sort_data;
+  SortElt **new_elts;
+  SortElt *elt;
+  SortLevel *level;
+  SortLevel *parent_level = NULL;
+  gint n_new = 0;
+  gint depth, offset;
+  gint i = 0, k, end;
+
+  parent_level = level = SORT_LEVEL (priv->root);
+
+  depth = gtk_tree_path_get_depth (s_path);
+  offset = gtk_tree_path_get_indices (s_path)[depth - 1];
+  new_elts = g_new (SortElt *, n_rows);
+
+  if (!priv->root)
+    {
+      gtk_tree_model_sort_build_level (tree_model_sort, NULL, NULL);
+
+      /* the build level already put the inserted rows in the level,
+       * we only need to find them to announce them
+       */
+      if (depth > 1 || !priv->root)
+        goto done;
+
+      level = SORT_LEVEL (priv->root);
+      end_siter = g_sequence_get_end_iter (level->seq);
+      for (siter = g_sequence_get_begin_iter (level->seq);
+           siter != end_siter;
+           siter = g_sequence_iter_next (siter))
+        {
+          elt = g_sequence_get (siter);
+
+          if (elt->offset >= offset && elt->offset < offset + n_rows)
+            new_elts[n_new++] = elt;
+        }
+
+      goto submit;
+    }
+
+  /* find the parent level */
+  while (i < depth - 1)
+    {
+      if (!level)
+	{
+	  /* level not yet build, we won't cover this signal */
+	  goto done;
+	}
+
+      if (g_sequence_get_length (level->seq) < gtk_tree_path_get_indices (s_path)[i])
+	{
+	  g_warning ("%s: A node was inserted with a parent that's not in the tree.\n"
+		     "This possibly means that a GtkTreeModel inserted a child node\n"
+		     "before the parent was inserted.",
+		     G_STRLOC);
+	  goto done;
+	}
+
+      elt = lookup_elt_with_offset (tree_model_sort, level,
+                                    gtk_tree_path_get_indices (s_path)[i],
+                                    NULL);
+
+      if (!elt || !elt->children)
+	{
+	  /* not covering this signal */
+	  goto done;
+	}
+
+      level = elt->children;
+      parent_level = level;
+      i++;
+    }
+
+  if (!parent_level)
+    goto done;
+
+  if (level->ref_count == 0 && level != priv->root)
+    {
+      gtk_tree_model_sort_free_level (tree_model_sort, level, TRUE);
+      goto done;
+    }
+
+  /* update all larger offsets */
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      elt = g_sequence_get (siter);
+
+      if (elt->offset >= offset)
+        elt->offset += n_rows;
+    }
+
+  fill_sort_data (&sort_data, tree_model_sort, level);
+
+  real_s_iter = *s_iter;
+  for (k = 0; k < n_rows; k++)
+    {
+      if (k > 0 && !gtk_tree_model_iter_next (s_model, &real_s_iter))
+        break;
+
+      elt = sort_elt_new ();
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+        elt->iter = real_s_iter;
+      elt->offset = offset + k;
+      elt->zero_ref_count = 0;
+      elt->ref_count = 0;
+      elt->children = NULL;
+
+      if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
+          priv->default_sort_func == NO_SORT_FUNC)
+        elt->siter = g_sequence_insert_sorted (level->seq, elt,
+                                               gtk_tree_model_sort_offset_compare_func,
+                                               &sort_data);
+      else
+        elt->siter = g_sequence_insert_sorted (level->seq, elt,
+                                               gtk_tree_model_sort_compare_func,
+                                               &sort_data);
+
+      new_elts[n_new++] = elt;
+    }
+
+  free_sort_data (&sort_data);
+
+ submit:
+  if (n_new == 0)
+    goto done;
+
+  path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort,
+							      s_path,
+							      FALSE);
+  if (!path)
+    goto done;
+
+  gtk_tree_path_up (path);
+  gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+  /* Announce the new rows in the order they ended up in, so that
+   * every signal describes a valid intermediate state
+   */
+  for (k = 0; k < n_new; k++)
+    new_elts[k]->old_index = g_sequence_iter_get_position (new_elts[k]->siter);
+
+  g_qsort_with_data (new_elts, n_new, sizeof (SortElt *),
+                     sort_elt_position_compare, NULL);
+
+  for (k = 0; k < n_new; k = end)
+    {
+      for (end = k + 1; end < n_new; end++)
+        if (new_elts[end]->old_index != new_elts[end - 1]->old_index + 1)
+          break;
+
+      iter.stamp = priv->stamp;
+      iter.user_data = level;
+      iter.user_data2 = new_elts[k];
+
+      gtk_tree_path_append_index (path, new_elts[k]->old_index);
+      gtk_tree_model_rows_inserted (GTK_TREE_MODEL (data), path, &iter, end - k);
+      gtk_tree_path_up (path);
+    }
+
+  gtk_tree_path_free (path);
+
+ done:
+  g_free (new_elts);
+}
+
 static void
 gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel *s_model,
 					   GtkTreePath  *s_path,
@@ -1031,6 +1384,10 @@ gtk_tree_model_sort_row_deleted (GtkTreeModel *s_model,
 
   g_return_if_fail (s_path != NULL);
 
+  /* Already handled in gtk_tree_model_sort_rows_deleted() */
+  if (_gtk_tree_model_is_range_row (s_model, s_path))
+    return;
+
   path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort, s_path, FALSE);
   if (path == NULL)
     return;
@@ -1085,6 +1442,105 @@ gtk_tree_model_sort_row_deleted (GtkTreeModel *s_model,
   gtk_tree_path_free (path);
 }
 
+/* Like gtk_tree_model_sort_row_deleted(), but for @n_rows consecutive
+ * child rows.  The level is walked only once to remove the rows and
+ * to fix up the offsets of the remaining ones.  The deleted rows are
+ * usually scattered over the sorted level; they are announced as runs
+ * of adjacent rows, starting at the end so that the earlier paths stay
+ * valid.
+ */
+static void
+gtk_tree_model_sort_rows_deleted (GtkTreeModel *s_model,
+                                  GtkTreePath  *s_path,
+                                  gint          n_rows,
+                                  gpointer      data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GSequenceIter *siter;
+  SortLevel *level;
+  SortElt *elt;
+  gint *positions;
+  SortElt **elts;
+  gint offset, position;
+  gint i, n, end;
+
+  path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort, s_path, FALSE);
+  if (path == NULL)
+    return;
+
+  gtk_tree_model_get_iter (GTK_TREE_MODEL (data), &iter, path);
+
+  level = SORT_LEVEL (iter.user_data);
+  offset = SORT_ELT (iter.user_data2)->offset;
+
+  if (level->ref_count == 0 && g_sequence_get_length (level->seq) == n_rows)
+    {
+      /* The whole level goes away, the single row code knows how */
+      gtk_tree_path_free (path);
+
+      for (i = 0; i < n_rows; i++)
+        gtk_tree_model_sort_row_deleted (s_model, s_path, data);
+      return;
+    }
+
+  positions = g_new (gint, n_rows);
+  elts = g_new (SortElt *, n_rows);
+  n = 0;
+
+  for (siter = g_sequence_get_begin_iter (level->seq), position = 0;
+       !g_sequence_iter_is_end (siter);
+       siter = g_sequence_iter_next (siter), position++)
+    {
+      elt = g_sequence_get (siter);
+
+      if (elt->offset >= offset + n_rows)
+        elt->offset -= n_rows;
+      else if (elt->offset >= offset && n < n_rows)
+        {
+          positions[n] = position;
+          elts[n++] = elt;
+        }
+    }
+
+  iter.stamp = tree_model_sort->priv->stamp;
+  iter.user_data = level;
+
+  for (i = 0; i < n; i++)
+    {
+      elt = elts[i];
+      iter.user_data2 = elt;
+
+      while (elt->ref_count > 0)
+        gtk_tree_model_sort_real_unref_node (GTK_TREE_MODEL (data), &iter, FALSE);
+
+      if (elt->children)
+        gtk_tree_model_sort_free_level (tree_model_sort,
+                                        elt->children, FALSE);
+
+      g_sequence_remove (elt->siter);
+    }
+
+  gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+  gtk_tree_path_up (path);
+  for (end = n; end > 0; end = i)
+    {
+      for (i = end - 1; i > 0; i--)
+        if (positions[i - 1] != positions[i] - 1)
+          break;
+
+      gtk_tree_path_append_index (path, positions[i]);
+      gtk_tree_model_rows_deleted (GTK_TREE_MODEL (data), path, end - i);
+      gtk_tree_path_up (path);
+    }
+
+  gtk_tree_path_free (path);
+  g_free (positions);
+  g_free (elts);
+}
+
 static void
 gtk_tree_model_sort_rows_reordered (GtkTreeModel *s_model,
 				    GtkTreePath  *s_path,
@@ -1137,33 +1593,11 @@ gtk_tree_model_sort_rows_reordered (GtkTreeModel *s_model,
       return;
     }
 
+  /* The new offset of the row at old offset i is tmp_array[i] */
   tmp_array = g_new (int, length);
+  for (i = 0; i < length; i++)
+    tmp_array[new_order[i]] = i;
 
-  /* FIXME: I need to think about whether this can be done in a more
-   * efficient way?
-   */
-  i = 0;
-  end_siter = g_sequence_get_end_iter (level->seq);
-  for (siter = g_sequence_get_begin_iter (level->seq);
-       siter != end_siter;
-       siter = g_sequence_iter_next (siter))
-    {
-      gint j;
-      SortElt *elt = g_sequence_get (siter);
-
-      for (j = 0; j < length; j++)
-	{
-	  if (elt->offset == new_order[j])
-	    tmp_array[i] = j;
-	}
-
-      i++;
-    }
-
-  /* This loop cannot be merged with the above loop nest, because that
-   * would introduce duplicate offsets.
-   */
-  i = 0;
   end_siter = g_sequence_get_end_iter (level->seq);
   for (siter = g_sequence_get_begin_iter (level->seq);
        siter != end_siter;
@@ -1171,8 +1605,7 @@ gtk_tree_model_sort_rows_reordered (GtkTreeModel *s_model,
     {
       SortElt *elt = g_sequence_get (siter);
 
-      elt->offset = tmp_array[i];
-      i++;
+      elt->offset = tmp_array[elt->offset];
     }
   g_free (tmp_array);
 
@@ -1834,22 +2267,36 @@ gtk_tree_model_sort_compare_func (gconstpointer a,
   GtkTreeIter iter_a, iter_b;
   gint retval;
 
-  if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+  if (data->key_elt && (sa == data->key_elt || sb == data->key_elt))
     {
-      iter_a = sa->iter;
-      iter_b = sb->iter;
+      GValue value = G_VALUE_INIT;
+
+      if (sa == data->key_elt)
+        {
+          sort_data_get_key_value (data, sb, &value);
+          retval = _gtk_tree_data_list_compare_values (data->key_type,
+                                                       &data->key_value,
+                                                       &value);
+        }
+      else
+        {
+          sort_data_get_key_value (data, sa, &value);
+          retval = _gtk_tree_data_list_compare_values (data->key_type,
+                                                       &value,
+                                                       &data->key_value);
+        }
+
+      g_value_unset (&value);
     }
   else
     {
-      data->parent_path_indices [data->parent_path_depth-1] = sa->offset;
-      gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->child_model), &iter_a, data->parent_path);
-      data->parent_path_indices [data->parent_path_depth-1] = sb->offset;
-      gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->child_model), &iter_b, data->parent_path);
-    }
+      sort_data_get_child_iter (data, sa, &iter_a);
+      sort_data_get_child_iter (data, sb, &iter_b);
 
-  retval = (* data->sort_func) (GTK_TREE_MODEL (priv->child_model),
-				&iter_a, &iter_b,
-				data->sort_data);
+      retval = (* data->sort_func) (GTK_TREE_MODEL (priv->child_model),
+                                    &iter_a, &iter_b,
+                                    data->sort_data);
+    }
 
   if (priv->order == GTK_SORT_DESCENDING)
     {
@@ -1892,6 +2339,393 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+static SortKeyType
+sort_key_type_for_type (GType type)
+{
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_INT:
+    case G_TYPE_LONG:
+    case G_TYPE_INT64:
+    case G_TYPE_ENUM:
+      return SORT_KEY_SIGNED;
+    case G_TYPE_UCHAR:
+    case G_TYPE_UINT:
+    case G_TYPE_ULONG:
+    case G_TYPE_UINT64:
+    case G_TYPE_FLAGS:
+      return SORT_KEY_UNSIGNED;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      return SORT_KEY_DOUBLE;
+    case G_TYPE_STRING:
+      return SORT_KEY_STRING;
+    default:
+      /* Leave the warning about it to _gtk_tree_data_list_compare_values() */
+      return SORT_KEY_NONE;
+    }
+}
+
+static void
+sort_key_set_value (SortKey      *key,
+                    const GValue *value)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value)))
+    {
+    case G_TYPE_BOOLEAN:
+      key->key.v_signed = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      key->key.v_signed = g_value_get_schar (value);
+      break;
+    case G_TYPE_INT:
+      key->key.v_signed = g_value_get_int (value);
+      break;
+    case G_TYPE_LONG:
+      key->key.v_signed = g_value_get_long (value);
+      break;
+    case G_TYPE_INT64:
+      key->key.v_signed = g_value_get_int64 (value);
+      break;
+    case G_TYPE_ENUM:
+      key->key.v_signed = g_value_get_enum (value);
+      break;
+    case G_TYPE_UCHAR:
+      key->key.v_unsigned = g_value_get_uchar (value);
+      break;
+    case G_TYPE_UINT:
+      key->key.v_unsigned = g_value_get_uint (value);
+      break;
+    case G_TYPE_ULONG:
+      key->key.v_unsigned = g_value_get_ulong (value);
+      break;
+    case G_TYPE_UINT64:
+      key->key.v_unsigned = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_FLAGS:
+      key->key.v_unsigned = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      key->key.v_double = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      key->key.v_double = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      /* turned into a collation key by sort_keys_sort() */
+      key->key.v_string = g_value_dup_string (value);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gint
+sort_key_compare_func (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      user_data)
+{
+  const SortKey *ka = a;
+  const SortKey *kb = b;
+  const SortKeyInfo *info = user_data;
+  gint retval;
+
+  switch (info->type)
+    {
+    case SORT_KEY_SIGNED:
+      retval = ka->key.v_signed < kb->key.v_signed ? -1 :
+               ka->key.v_signed == kb->key.v_signed ? 0 : 1;
+      break;
+    case SORT_KEY_UNSIGNED:
+      retval = ka->key.v_unsigned < kb->key.v_unsigned ? -1 :
+               ka->key.v_unsigned == kb->key.v_unsigned ? 0 : 1;
+      break;
+    case SORT_KEY_DOUBLE:
+      retval = ka->key.v_double < kb->key.v_double ? -1 :
+               ka->key.v_double == kb->key.v_double ? 0 : 1;
+      break;
+    case SORT_KEY_STRING:
+      retval = strcmp (ka->key.v_string, kb->key.v_string);
+      break;
+    case SORT_KEY_NONE:
+    default:
+      g_assert_not_reached ();
+      retval = 0;
+    }
+
+  if (info->order == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+	retval = -1;
+      else if (retval < 0)
+	retval = 1;
+    }
+
+  return retval;
+}
+
+/* Sorts keys[start..end), which g_qsort_with_data() does stably */
+static void
+sort_keys_sort (SortKey     *keys,
+                gint         start,
+                gint         end,
+                SortKeyInfo *info)
+{
+  gint i;
+
+  if (info->type == SORT_KEY_STRING)
+    {
+      for (i = start; i < end; i++)
+        {
+          gchar *str = keys[i].key.v_string;
+
+          keys[i].key.v_string = g_utf8_collate_key (str ? str : "", -1);
+          g_free (str);
+        }
+    }
+
+  g_qsort_with_data (keys + start, end - start, sizeof (SortKey),
+                     sort_key_compare_func, info);
+}
+
+/* Merges the sorted keys[start..mid) and keys[mid..end), preferring
+ * the first run for equal keys to keep the sort stable.
+ */
+static void
+sort_keys_merge (SortKey     *keys,
+                 SortKey     *tmp,
+                 gint         start,
+                 gint         mid,
+                 gint         end,
+                 SortKeyInfo *info)
+{
+  gint i = start, j = mid, k = start;
+
+  while (i < mid && j < end)
+    {
+      if (sort_key_compare_func (&keys[j], &keys[i], info) < 0)
+        tmp[k++] = keys[j++];
+      else
+        tmp[k++] = keys[i++];
+    }
+  while (i < mid)
+    tmp[k++] = keys[i++];
+  while (j < end)
+    tmp[k++] = keys[j++];
+
+  memcpy (keys + start, tmp + start, (end - start) * sizeof (SortKey));
+}
+
+/* The parallel sort runs in rounds: first each chunk of the keys is
+ * sorted, then neighbouring runs are merged pairwise until one is left.
+ * The jobs of a round are spread over a thread pool, the calling thread
+ * running the first one itself.
+ */
+typedef struct
+{
+  GMutex mutex;
+  GCond cond;
+  gint pending;
+} SortKeyRound;
+
+typedef struct
+{
+  SortKeyRound *round;
+  SortKeyInfo *info;
+  SortKey *keys;
+  SortKey *tmp; /* NULL when sorting a chunk */
+  gint start;
+  gint mid;
+  gint end;
+} SortKeyJob;
+
+static GThreadPool *sort_key_pool = NULL;
+
+static void
+sort_key_job_run (SortKeyJob *job)
+{
+  if (job->tmp)
+    sort_keys_merge (job->keys, job->tmp, job->start, job->mid, job->end,
+                     job->info);
+  else
+    sort_keys_sort (job->keys, job->start, job->end, job->info);
+}
+
+static void
+sort_key_job_thread (gpointer data,
+                     gpointer user_data)
+{
+  SortKeyJob *job = data;
+  SortKeyRound *round = job->round;
+
+  sort_key_job_run (job);
+
+  g_mutex_lock (&round->mutex);
+  if (--round->pending == 0)
+    g_cond_signal (&round->cond);
+  g_mutex_unlock (&round->mutex);
+}
+
+static void
+sort_keys_run_round (SortKeyJob *jobs,
+                     gint        n_jobs)
+{
+  SortKeyRound round;
+  gint i;
+
+  g_mutex_init (&round.mutex);
+  g_cond_init (&round.cond);
+  round.pending = n_jobs - 1;
+
+  for (i = 0; i < n_jobs; i++)
+    jobs[i].round = &round;
+
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (sort_key_pool, &jobs[i], NULL);
+
+  sort_key_job_run (&jobs[0]);
+
+  g_mutex_lock (&round.mutex);
+  while (round.pending > 0)
+    g_cond_wait (&round.cond, &round.mutex);
+  g_mutex_unlock (&round.mutex);
+
+  g_mutex_clear (&round.mutex);
+  g_cond_clear (&round.cond);
+}
+
+static void
+sort_keys_sort_parallel (SortKey     *keys,
+                         gint         n_keys,
+                         SortKeyInfo *info)
+{
+  gint n_threads, n_runs, i;
+  gint *bounds;
+  SortKeyJob *jobs;
+  SortKey *tmp;
+
+  n_threads = g_get_num_processors ();
+
+  n_runs = 1;
+  while (n_runs < n_threads &&
+         n_keys / (n_runs * 2) >= SORT_KEY_PARALLEL_MIN_CHUNK)
+    n_runs *= 2;
+
+  if (n_runs < 2)
+    {
+      sort_keys_sort (keys, 0, n_keys, info);
+      return;
+    }
+
+  if (sort_key_pool == NULL)
+    sort_key_pool = g_thread_pool_new (sort_key_job_thread, NULL,
+                                       n_threads, FALSE, NULL);
+
+  bounds = g_new (gint, n_runs + 1);
+  for (i = 0; i <= n_runs; i++)
+    bounds[i] = (gint) ((gint64) n_keys * i / n_runs);
+
+  jobs = g_new (SortKeyJob, n_runs);
+  for (i = 0; i < n_runs; i++)
+    {
+      jobs[i].info = info;
+      jobs[i].keys = keys;
+      jobs[i].tmp = NULL;
+      jobs[i].start = bounds[i];
+      jobs[i].end = bounds[i + 1];
+    }
+  sort_keys_run_round (jobs, n_runs);
+
+  tmp = g_new (SortKey, n_keys);
+  while (n_runs > 1)
+    {
+      /* n_runs is a power of two, so the runs always pair up */
+      for (i = 0; i < n_runs / 2; i++)
+        {
+          jobs[i].tmp = tmp;
+          jobs[i].start = bounds[2 * i];
+          jobs[i].mid = bounds[2 * i + 1];
+          jobs[i].end = bounds[2 * i + 2];
+        }
+      sort_keys_run_round (jobs, n_runs / 2);
+
+      n_runs /= 2;
+      for (i = 0; i <= n_runs; i++)
+        bounds[i] = bounds[2 * i];
+    }
+
+  g_free (tmp);
+  g_free (jobs);
+  g_free (bounds);
+}
+
+/* Sorts @level on the values of data->key_column, fetching each of
+ * them once instead of twice per comparison.  The comparisons are those
+ * of _gtk_tree_data_list_compare_func(), and equal rows keep their
+ * order, so the result is the same as that of g_sequence_sort().
+ *
+ * Returns %FALSE if the level has to be sorted the regular way.
+ */
+static gboolean
+gtk_tree_model_sort_sort_level_by_key (GtkTreeModelSort *tree_model_sort,
+                                       SortLevel        *level,
+                                       SortData         *data)
+{
+  GSequenceIter *siter, *end_siter;
+  SortKeyInfo info;
+  SortKey *keys;
+  gint n_keys, i;
+
+  if (data->key_column < 0)
+    return FALSE;
+
+  info.type = sort_key_type_for_type (data->key_type);
+  info.order = tree_model_sort->priv->order;
+  if (info.type == SORT_KEY_NONE)
+    return FALSE;
+
+  n_keys = g_sequence_get_length (level->seq);
+  keys = g_new (SortKey, n_keys);
+
+  /* The child model is only accessed from this thread */
+  i = 0;
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      GValue value = G_VALUE_INIT;
+
+      keys[i].elt = g_sequence_get (siter);
+      sort_data_get_key_value (data, keys[i].elt, &value);
+      sort_key_set_value (&keys[i], &value);
+      g_value_unset (&value);
+      i++;
+    }
+
+  if (n_keys >= SORT_KEY_PARALLEL_MIN_ROWS)
+    sort_keys_sort_parallel (keys, n_keys, &info);
+  else
+    sort_keys_sort (keys, 0, n_keys, &info);
+
+  /* Moving every row to the end in sorted order leaves the sequence
+   * sorted, and keeps the sequence iters of the rows valid.
+   */
+  for (i = 0; i < n_keys; i++)
+    {
+      g_sequence_move (keys[i].elt->siter, end_siter);
+
+      if (info.type == SORT_KEY_STRING)
+        g_free (keys[i].key.v_string);
+    }
+
+  g_free (keys);
+
+  return TRUE;
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1940,7 +2774,8 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
   if (data.sort_func == NO_SORT_FUNC)
     g_sequence_sort (level->seq, gtk_tree_model_sort_offset_compare_func,
                      &data);
-  else
+  else if (!gtk_tree_model_sort_sort_level_by_key (tree_model_sort, level,
+                                                   &data))
     g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, &data);
 
   free_sort_data (&data);
@@ -2142,10 +2977,14 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
                                    priv->changed_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->inserted_id);
+      g_signal_handler_disconnect (priv->child_model,
+                                   priv->rows_inserted_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->has_child_toggled_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->deleted_id);
+      g_signal_handler_disconnect (priv->child_model,
+                                   priv->rows_deleted_id);
       g_signal_handler_disconnect (priv->child_model,
 				   priv->reordered_id);
 
@@ -2173,6 +3012,10 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_sort_row_inserted),
                           tree_model_sort);
+      priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_sort_rows_inserted),
+                          tree_model_sort);
       priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_sort_row_has_child_toggled),
@@ -2181,6 +3024,10 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
         g_signal_connect (child_model, "row-deleted",
                           G_CALLBACK (gtk_tree_model_sort_row_deleted),
                           tree_model_sort);
+      priv->rows_deleted_id =
+        g_signal_connect (child_model, "rows-deleted",
+                          G_CALLBACK (gtk_tree_model_sort_rows_deleted),
+                          tree_model_sort);
       priv->reordered_id =
 	g_signal_connect (child_model, "rows-reordered",
 			  G_CALLBACK (gtk_tree_model_sort_rows_reordered),
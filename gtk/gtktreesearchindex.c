@@ -0,0 +1,1083 @@
+/* gtktreesearchindex.c
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtktreesearchindexprivate.h"
+
+#include <string.h>
+
+#include "gdk/gdk.h"
+
+/* The search index keeps the normalized and case folded text of the
+ * search column for every row of a list model. The texts are collected
+ * in an idle handler, a few rows at a time, and a table is built from
+ * them in a worker thread. Until that is done, the index is not ready
+ * and the caller has to search the model itself.
+ *
+ * The table has an entry for every text, or with substring search, for
+ * every character of every text, standing for the rest of the text from
+ * there. The entries are sorted by that text, so the ones starting with
+ * a key are found with two binary searches. The rows of the entries are
+ * kept in a wavelet matrix, which finds the closest row to a given one
+ * among the entries in a range, in as many steps as a row number has
+ * bits. Together, a search takes logarithmic time however many rows
+ * match.
+ *
+ * Changes to the model while the texts are collected are applied to
+ * the texts collected so far. Changes after that do not touch the
+ * table. They are recorded as a list of insertions and deletions that
+ * maps the rows of the table to the current ones, and new texts are
+ * kept next to it and searched one by one. Reordering the model or too
+ * many changes make the index start over.
+ *
+ * A substring table takes memory for every character of the texts, so
+ * the index gives up on models with more text than MAX_SUBSTRING_CHARS
+ * and is never ready for them; searching then walks the model.
+ */
+
+/* How long the idle handler collects texts at a time, in microseconds */
+#define BUILD_TIME_SLICE 5000
+
+/* Number of changes since the texts were collected before the index
+ * is rebuilt */
+#define MAX_UPDATES 256
+
+/* Number of characters of all texts above which a substring index is
+ * not built. Each costs a table entry and a row in the wavelet matrix,
+ * about 12 bytes with the text itself. */
+#define MAX_SUBSTRING_CHARS (4 * 1024 * 1024)
+
+typedef struct _SearchEntry SearchEntry;
+typedef struct _RowMatrix   RowMatrix;
+typedef struct _SearchTable SearchTable;
+typedef struct _Update      Update;
+typedef struct _DirtyRow    DirtyRow;
+
+struct _SearchEntry
+{
+  guint row;
+  guint offset;
+};
+
+struct _RowMatrix
+{
+  guint    n_bits;
+  guint    n_words;             /* per level */
+  guint64 *bits;                /* one bit vector per level */
+  guint32 *ranks;               /* set bits in front of each word */
+  guint   *zeros;               /* clear bits per level */
+};
+
+struct _SearchTable
+{
+  GPtrArray   *keys;            /* folded text per row, or NULL */
+  SearchEntry *entries;         /* sorted by their text and row */
+  guint        n_entries;
+  RowMatrix    rows;            /* rows of the sorted entries */
+};
+
+struct _Update
+{
+  gint position;
+  gint delta;                   /* 1 for an insertion, -1 for a deletion */
+};
+
+struct _DirtyRow
+{
+  gint   row;
+  gchar *key;
+};
+
+struct _GtkTreeSearchIndex
+{
+  GtkTreeModel *model;
+  gint          column;
+
+  GPtrArray    *build_keys;     /* texts collected so far */
+  gsize         build_chars;
+  guint         build_id;
+  GCancellable *build_cancellable;
+
+  SearchTable  *table;
+  GArray       *updates;        /* changes since the texts were collected */
+  GArray       *dirty;          /* rows whose text is not in the table */
+
+  gulong        changed_id;
+  gulong        inserted_id;
+  gulong        deleted_id;
+  gulong        reordered_id;
+
+  guint         substring : 1;
+  guint         ready     : 1;
+  guint         too_big   : 1;
+};
+
+gchar *
+_gtk_tree_search_index_fold (const gchar *str)
+{
+  gchar *normalized, *folded;
+
+  normalized = g_utf8_normalize (str, -1, G_NORMALIZE_ALL);
+  if (normalized == NULL)
+    return NULL;
+
+  folded = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return folded;
+}
+
+static gchar *
+get_key (GtkTreeSearchIndex *index,
+         GtkTreeIter        *iter)
+{
+  GValue value = G_VALUE_INIT;
+  GValue transformed = G_VALUE_INIT;
+  const gchar *str;
+  gchar *key = NULL;
+
+  gtk_tree_model_get_value (index->model, iter, index->column, &value);
+
+  g_value_init (&transformed, G_TYPE_STRING);
+
+  if (g_value_transform (&value, &transformed))
+    {
+      str = g_value_get_string (&transformed);
+      if (str)
+        key = _gtk_tree_search_index_fold (str);
+    }
+
+  g_value_unset (&transformed);
+  g_value_unset (&value);
+
+  return key;
+}
+
+/* Row matrix {{{1 */
+
+static inline guint
+popcount (guint64 x)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll (x);
+#else
+  x = x - ((x >> 1) & G_GUINT64_CONSTANT (0x5555555555555555));
+  x = (x & G_GUINT64_CONSTANT (0x3333333333333333)) + ((x >> 2) & G_GUINT64_CONSTANT (0x3333333333333333));
+  x = (x + (x >> 4)) & G_GUINT64_CONSTANT (0x0f0f0f0f0f0f0f0f);
+  return (x * G_GUINT64_CONSTANT (0x0101010101010101)) >> 56;
+#endif
+}
+
+/* Number of set bits in front of @i on @level */
+static inline guint
+row_matrix_rank (const RowMatrix *matrix,
+                 guint            level,
+                 guint            i)
+{
+  guint word = level * matrix->n_words + i / 64;
+  guint64 mask = (G_GUINT64_CONSTANT (1) << (i % 64)) - 1;
+
+  return matrix->ranks[word] + popcount (matrix->bits[word] & mask);
+}
+
+/* Each level holds one bit of every value, starting with the highest.
+ * The values are then stably sorted by that bit for the next level,
+ * so the values of a range with the same bits so far stay together.
+ * @values is used as scratch space.
+ */
+static void
+row_matrix_init (RowMatrix *matrix,
+                 guint     *values,
+                 guint      n_values,
+                 guint      max_value)
+{
+  guint *scratch, *next;
+  guint level, i;
+
+  matrix->n_bits = g_bit_storage (max_value);
+  matrix->n_words = n_values / 64 + 1;
+  matrix->bits = g_new0 (guint64, matrix->n_bits * matrix->n_words);
+  matrix->ranks = g_new (guint32, matrix->n_bits * matrix->n_words);
+  matrix->zeros = g_new (guint, matrix->n_bits);
+
+  scratch = next = g_new (guint, n_values);
+
+  for (level = 0; level < matrix->n_bits; level++)
+    {
+      guint shift = matrix->n_bits - 1 - level;
+      guint64 *bits = matrix->bits + level * matrix->n_words;
+      guint32 *ranks = matrix->ranks + level * matrix->n_words;
+      guint n_zeros = 0, n_ones = 0;
+      guint32 rank = 0;
+      guint *tmp;
+
+      for (i = 0; i < n_values; i++)
+        {
+          if ((values[i] >> shift) & 1)
+            bits[i / 64] |= G_GUINT64_CONSTANT (1) << (i % 64);
+          else
+            n_zeros++;
+        }
+
+      for (i = 0; i < matrix->n_words; i++)
+        {
+          ranks[i] = rank;
+          rank += popcount (bits[i]);
+        }
+
+      matrix->zeros[level] = n_zeros;
+
+      for (i = 0; i < n_values; i++)
+        {
+          if ((values[i] >> shift) & 1)
+            next[n_zeros + n_ones++] = values[i];
+          else
+            next[i - n_ones] = values[i];
+        }
+
+      tmp = values;
+      values = next;
+      next = tmp;
+    }
+
+  g_free (scratch);
+}
+
+static void
+row_matrix_clear (RowMatrix *matrix)
+{
+  g_free (matrix->bits);
+  g_free (matrix->ranks);
+  g_free (matrix->zeros);
+}
+
+/* Returns the smallest value at least @x among the positions @a to @b
+ * of @level, or -1. While @tight, the bits so far are those of @x. The
+ * tight path is followed once, and every branch leaving it upwards
+ * runs straight down, so this takes at most two steps per level.
+ */
+static gint
+row_matrix_next (const RowMatrix *matrix,
+                 guint            level,
+                 guint            a,
+                 guint            b,
+                 guint            x,
+                 gboolean         tight,
+                 guint            value)
+{
+  guint a1, b1, bit;
+  gint result;
+
+  if (a >= b)
+    return -1;
+
+  if (level == matrix->n_bits)
+    return value;
+
+  a1 = row_matrix_rank (matrix, level, a);
+  b1 = row_matrix_rank (matrix, level, b);
+  bit = tight ? (x >> (matrix->n_bits - 1 - level)) & 1 : 0;
+
+  if (bit == 0)
+    {
+      result = row_matrix_next (matrix, level + 1, a - a1, b - b1,
+                                x, tight, value << 1);
+      if (result >= 0)
+        return result;
+    }
+
+  return row_matrix_next (matrix, level + 1,
+                          matrix->zeros[level] + a1, matrix->zeros[level] + b1,
+                          x, tight && bit == 1, (value << 1) | 1);
+}
+
+/* Same as row_matrix_next(), for the largest value at most @x */
+static gint
+row_matrix_prev (const RowMatrix *matrix,
+                 guint            level,
+                 guint            a,
+                 guint            b,
+                 guint            x,
+                 gboolean         tight,
+                 guint            value)
+{
+  guint a1, b1, bit;
+  gint result;
+
+  if (a >= b)
+    return -1;
+
+  if (level == matrix->n_bits)
+    return value;
+
+  a1 = row_matrix_rank (matrix, level, a);
+  b1 = row_matrix_rank (matrix, level, b);
+  bit = tight ? (x >> (matrix->n_bits - 1 - level)) & 1 : 1;
+
+  if (bit == 1)
+    {
+      result = row_matrix_prev (matrix, level + 1,
+                                matrix->zeros[level] + a1, matrix->zeros[level] + b1,
+                                x, tight, (value << 1) | 1);
+      if (result >= 0)
+        return result;
+    }
+
+  return row_matrix_prev (matrix, level + 1, a - a1, b - b1,
+                          x, tight && bit == 0, value << 1);
+}
+
+/* Search table {{{1 */
+
+static inline const gchar *
+entry_text (GPtrArray         *keys,
+            const SearchEntry *entry)
+{
+  return (const gchar *) g_ptr_array_index (keys, entry->row) + entry->offset;
+}
+
+static gint
+compare_entries (gconstpointer a,
+                 gconstpointer b,
+                 gpointer      data)
+{
+  const SearchEntry *entry1 = a;
+  const SearchEntry *entry2 = b;
+  gint result;
+
+  result = strcmp (entry_text (data, entry1), entry_text (data, entry2));
+  if (result != 0)
+    return result;
+
+  if (entry1->row != entry2->row)
+    return entry1->row < entry2->row ? -1 : 1;
+
+  return entry1->offset < entry2->offset ? -1 : entry1->offset > entry2->offset;
+}
+
+static SearchTable *
+search_table_new (GPtrArray *keys,
+                  gboolean   substring)
+{
+  SearchTable *table;
+  guint *rows;
+  guint row, i;
+
+  table = g_slice_new0 (SearchTable);
+  table->keys = g_ptr_array_ref (keys);
+
+  for (row = 0; row < keys->len; row++)
+    {
+      const gchar *key = g_ptr_array_index (keys, row);
+
+      if (key == NULL)
+        continue;
+
+      table->n_entries += substring ? g_utf8_strlen (key, -1) : 1;
+    }
+
+  table->entries = g_new (SearchEntry, table->n_entries);
+
+  i = 0;
+  for (row = 0; row < keys->len; row++)
+    {
+      const gchar *key = g_ptr_array_index (keys, row);
+      const gchar *p;
+
+      if (key == NULL)
+        continue;
+
+      if (!substring)
+        {
+          table->entries[i].row = row;
+          table->entries[i].offset = 0;
+          i++;
+          continue;
+        }
+
+      for (p = key; *p; p = g_utf8_next_char (p))
+        {
+          table->entries[i].row = row;
+          table->entries[i].offset = p - key;
+          i++;
+        }
+    }
+
+  g_qsort_with_data (table->entries, table->n_entries, sizeof (SearchEntry),
+                     compare_entries, keys);
+
+  rows = g_new (guint, table->n_entries);
+  for (i = 0; i < table->n_entries; i++)
+    rows[i] = table->entries[i].row;
+
+  row_matrix_init (&table->rows, rows, table->n_entries, keys->len);
+  g_free (rows);
+
+  return table;
+}
+
+static void
+search_table_free (SearchTable *table)
+{
+  g_ptr_array_unref (table->keys);
+  g_free (table->entries);
+  row_matrix_clear (&table->rows);
+  g_slice_free (SearchTable, table);
+}
+
+/* Finds the entries whose text starts with @key, from @a to @b */
+static void
+search_table_find_range (SearchTable *table,
+                         const gchar *key,
+                         guint       *a,
+                         guint       *b)
+{
+  gsize len = strlen (key);
+  guint lo, hi;
+
+  /* The entries starting with key come after all texts that are
+   * smaller than key itself ... */
+  lo = 0;
+  hi = table->n_entries;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (strcmp (entry_text (table->keys, &table->entries[mid]), key) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  *a = lo;
+
+  /* ... and before the first text that has a bigger start */
+  hi = table->n_entries;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (strncmp (entry_text (table->keys, &table->entries[mid]), key, len) <= 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  *b = lo;
+}
+
+/* Building {{{1 */
+
+typedef struct
+{
+  GPtrArray *keys;
+  gboolean   substring;
+} BuildData;
+
+static void
+build_data_free (BuildData *data)
+{
+  g_ptr_array_unref (data->keys);
+  g_slice_free (BuildData, data);
+}
+
+static void
+build_thread (GTask        *task,
+              gpointer      source_object,
+              gpointer      task_data,
+              GCancellable *cancellable)
+{
+  BuildData *data = task_data;
+
+  g_task_return_pointer (task,
+                         search_table_new (data->keys, data->substring),
+                         (GDestroyNotify) search_table_free);
+}
+
+static void
+build_done (GObject      *source_object,
+            GAsyncResult *result,
+            gpointer      data)
+{
+  GtkTreeSearchIndex *index;
+
+  /* The index may be gone already */
+  if (g_cancellable_is_cancelled (g_task_get_cancellable (G_TASK (result))))
+    return;
+
+  index = data;
+  index->table = g_task_propagate_pointer (G_TASK (result), NULL);
+  g_clear_object (&index->build_cancellable);
+  index->ready = TRUE;
+}
+
+static void
+clear_changes (GtkTreeSearchIndex *index)
+{
+  guint i;
+
+  for (i = 0; i < index->dirty->len; i++)
+    g_free (g_array_index (index->dirty, DirtyRow, i).key);
+
+  g_array_set_size (index->dirty, 0);
+  g_array_set_size (index->updates, 0);
+}
+
+static void
+finish_build (GtkTreeSearchIndex *index)
+{
+  BuildData *data;
+  GTask *task;
+
+  /* From now on, changes are counted against the collected texts,
+   * which the worker thread owns.
+   */
+  clear_changes (index);
+
+  data = g_slice_new (BuildData);
+  data->keys = index->build_keys;
+  data->substring = index->substring;
+  index->build_keys = NULL;
+
+  index->build_cancellable = g_cancellable_new ();
+  task = g_task_new (NULL, index->build_cancellable, build_done, index);
+  g_task_set_task_data (task, data, (GDestroyNotify) build_data_free);
+  g_task_run_in_thread (task, build_thread);
+  g_object_unref (task);
+}
+
+static gboolean
+build_idle (gpointer data)
+{
+  GtkTreeSearchIndex *index = data;
+  GtkTreeIter iter;
+  gint64 deadline;
+  gboolean valid;
+
+  deadline = g_get_monotonic_time () + BUILD_TIME_SLICE;
+
+  /* The model may have changed since the last time, so continue from
+   * the number of texts collected rather than from an iter */
+  valid = gtk_tree_model_iter_nth_child (index->model, &iter, NULL,
+                                         index->build_keys->len);
+  while (valid)
+    {
+      gchar *key = get_key (index, &iter);
+
+      if (index->substring && key)
+        {
+          index->build_chars += g_utf8_strlen (key, -1);
+          if (index->build_chars > MAX_SUBSTRING_CHARS)
+            {
+              g_free (key);
+              g_clear_pointer (&index->build_keys, g_ptr_array_unref);
+              index->too_big = TRUE;
+              index->build_id = 0;
+              return G_SOURCE_REMOVE;
+            }
+        }
+
+      g_ptr_array_add (index->build_keys, key);
+      valid = gtk_tree_model_iter_next (index->model, &iter);
+
+      if (valid && index->build_keys->len % 64 == 0 && g_get_monotonic_time () > deadline)
+        return G_SOURCE_CONTINUE;
+    }
+
+  index->build_id = 0;
+  finish_build (index);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+start_build (GtkTreeSearchIndex *index)
+{
+  if (index->build_cancellable)
+    {
+      g_cancellable_cancel (index->build_cancellable);
+      g_clear_object (&index->build_cancellable);
+    }
+
+  g_clear_pointer (&index->build_keys, g_ptr_array_unref);
+  index->build_keys = g_ptr_array_new_with_free_func (g_free);
+  index->build_chars = 0;
+  g_clear_pointer (&index->table, search_table_free);
+  clear_changes (index);
+  index->ready = FALSE;
+
+  if (index->build_id == 0)
+    {
+      index->build_id = gdk_threads_add_idle_full (G_PRIORITY_LOW, build_idle, index, NULL);
+      g_source_set_name_by_id (index->build_id, "[gtk+] gtk_tree_search_index_build");
+    }
+}
+
+/* Changes {{{1 */
+
+/* Returns the current row of the table's @row, and whether it still
+ * exists. For a deleted row, that is the row that followed it, so the
+ * result grows with @row either way.
+ */
+static gint
+map_row (GtkTreeSearchIndex *index,
+         guint               row,
+         gboolean           *alive)
+{
+  gint position = row;
+  guint i;
+
+  *alive = TRUE;
+
+  for (i = 0; i < index->updates->len; i++)
+    {
+      const Update *update = &g_array_index (index->updates, Update, i);
+
+      if (update->delta > 0)
+        {
+          if (position >= update->position)
+            position++;
+        }
+      else if (position > update->position)
+        position--;
+      else if (position == update->position)
+        *alive = FALSE;
+    }
+
+  return position;
+}
+
+/* Returns the first row of the table that maps to a row after @row */
+static guint
+find_table_row_after (GtkTreeSearchIndex *index,
+                      gint                row)
+{
+  guint lo = 0, hi = index->table->keys->len;
+  gboolean alive;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (map_row (index, mid, &alive) <= row)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static DirtyRow *
+find_dirty (GtkTreeSearchIndex *index,
+            gint                row)
+{
+  guint i;
+
+  for (i = 0; i < index->dirty->len; i++)
+    {
+      DirtyRow *dirty = &g_array_index (index->dirty, DirtyRow, i);
+
+      if (dirty->row == row)
+        return dirty;
+    }
+
+  return NULL;
+}
+
+static void
+add_update (GtkTreeSearchIndex *index,
+            gint                position,
+            gint                delta)
+{
+  Update update = { position, delta };
+  guint i;
+
+  g_array_append_val (index->updates, update);
+
+  for (i = 0; i < index->dirty->len; i++)
+    {
+      DirtyRow *dirty = &g_array_index (index->dirty, DirtyRow, i);
+
+      if (delta > 0 ? dirty->row >= position : dirty->row > position)
+        dirty->row += delta;
+    }
+}
+
+static void
+add_dirty (GtkTreeSearchIndex *index,
+           gint                row,
+           GtkTreeIter        *iter)
+{
+  DirtyRow dirty = { row, get_key (index, iter) };
+
+  g_array_append_val (index->dirty, dirty);
+}
+
+/* Returns whether the change has to be recorded. Changes while the
+ * texts are collected are applied to them right away, and an index
+ * that gave up ignores them.
+ */
+static gboolean
+begin_update (GtkTreeSearchIndex *index,
+              GtkTreePath        *path)
+{
+  if (index->too_big)
+    return FALSE;
+
+  if (gtk_tree_path_get_depth (path) != 1 ||
+      index->updates->len + 2 > MAX_UPDATES)
+    {
+      start_build (index);
+      return FALSE;
+    }
+
+  return index->build_id == 0;
+}
+
+static void
+set_build_key (GtkTreeSearchIndex *index,
+               guint               row,
+               gchar              *key)
+{
+  gchar **slot = (gchar **) &g_ptr_array_index (index->build_keys, row);
+
+  if (index->substring)
+    {
+      if (*slot)
+        index->build_chars -= g_utf8_strlen (*slot, -1);
+      if (key)
+        index->build_chars += g_utf8_strlen (key, -1);
+    }
+
+  g_free (*slot);
+  *slot = key;
+}
+
+static void
+row_changed (GtkTreeModel       *model,
+             GtkTreePath        *path,
+             GtkTreeIter        *iter,
+             GtkTreeSearchIndex *index)
+{
+  DirtyRow *dirty;
+  guint row;
+
+  if (!begin_update (index, path))
+    {
+      /* Rows that are not collected yet will be later */
+      if (index->build_id != 0 &&
+          gtk_tree_path_get_depth (path) == 1)
+        {
+          row = gtk_tree_path_get_indices (path)[0];
+          if (row < index->build_keys->len)
+            set_build_key (index, row, get_key (index, iter));
+        }
+      return;
+    }
+
+  row = gtk_tree_path_get_indices (path)[0];
+
+  dirty = find_dirty (index, row);
+  if (dirty)
+    {
+      g_free (dirty->key);
+      dirty->key = get_key (index, iter);
+      return;
+    }
+
+  /* The row of the table goes away, and a new one takes its place */
+  add_update (index, row, -1);
+  add_update (index, row, 1);
+  add_dirty (index, row, iter);
+}
+
+static void
+row_inserted (GtkTreeModel       *model,
+              GtkTreePath        *path,
+              GtkTreeIter        *iter,
+              GtkTreeSearchIndex *index)
+{
+  guint row;
+
+  if (!begin_update (index, path))
+    {
+      if (index->build_id != 0 &&
+          gtk_tree_path_get_depth (path) == 1)
+        {
+          row = gtk_tree_path_get_indices (path)[0];
+          if (row <= index->build_keys->len)
+            {
+              g_ptr_array_insert (index->build_keys, row, NULL);
+              set_build_key (index, row, get_key (index, iter));
+            }
+        }
+      return;
+    }
+
+  row = gtk_tree_path_get_indices (path)[0];
+
+  add_update (index, row, 1);
+  add_dirty (index, row, iter);
+}
+
+static void
+row_deleted (GtkTreeModel       *model,
+             GtkTreePath        *path,
+             GtkTreeSearchIndex *index)
+{
+  DirtyRow *dirty;
+  guint row;
+
+  if (!begin_update (index, path))
+    {
+      if (index->build_id != 0 &&
+          gtk_tree_path_get_depth (path) == 1)
+        {
+          row = gtk_tree_path_get_indices (path)[0];
+          if (row < index->build_keys->len)
+            {
+              set_build_key (index, row, NULL);
+              g_ptr_array_remove_index (index->build_keys, row);
+            }
+        }
+      return;
+    }
+
+  row = gtk_tree_path_get_indices (path)[0];
+
+  dirty = find_dirty (index, row);
+  if (dirty)
+    {
+      g_free (dirty->key);
+      g_array_remove_index_fast (index->dirty, dirty - (DirtyRow *) index->dirty->data);
+    }
+
+  add_update (index, row, -1);
+}
+
+static void
+rows_reordered (GtkTreeModel       *model,
+                GtkTreePath        *path,
+                GtkTreeIter        *iter,
+                gint               *new_order,
+                GtkTreeSearchIndex *index)
+{
+  if (!index->too_big)
+    start_build (index);
+}
+
+/* API {{{1 */
+
+/* Creates an index of @column of @model, which has to be a list.
+ * If @substring is set, rows are found by any part of their text,
+ * otherwise by its start.
+ */
+GtkTreeSearchIndex *
+_gtk_tree_search_index_new (GtkTreeModel *model,
+                            gint          column,
+                            gboolean      substring)
+{
+  GtkTreeSearchIndex *index;
+
+  g_return_val_if_fail (gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY, NULL);
+
+  index = g_slice_new0 (GtkTreeSearchIndex);
+  index->model = g_object_ref (model);
+  index->column = column;
+  index->substring = substring != FALSE;
+  index->updates = g_array_new (FALSE, FALSE, sizeof (Update));
+  index->dirty = g_array_new (FALSE, FALSE, sizeof (DirtyRow));
+
+  index->changed_id = g_signal_connect (model, "row-changed",
+                                        G_CALLBACK (row_changed), index);
+  index->inserted_id = g_signal_connect (model, "row-inserted",
+                                         G_CALLBACK (row_inserted), index);
+  index->deleted_id = g_signal_connect (model, "row-deleted",
+                                        G_CALLBACK (row_deleted), index);
+  index->reordered_id = g_signal_connect (model, "rows-reordered",
+                                          G_CALLBACK (rows_reordered), index);
+
+  start_build (index);
+
+  return index;
+}
+
+void
+_gtk_tree_search_index_free (GtkTreeSearchIndex *index)
+{
+  if (index->build_cancellable)
+    {
+      g_cancellable_cancel (index->build_cancellable);
+      g_object_unref (index->build_cancellable);
+    }
+
+  if (index->build_id)
+    g_source_remove (index->build_id);
+
+  g_signal_handler_disconnect (index->model, index->changed_id);
+  g_signal_handler_disconnect (index->model, index->inserted_id);
+  g_signal_handler_disconnect (index->model, index->deleted_id);
+  g_signal_handler_disconnect (index->model, index->reordered_id);
+  g_object_unref (index->model);
+
+  if (index->build_keys)
+    g_ptr_array_unref (index->build_keys);
+  if (index->table)
+    search_table_free (index->table);
+
+  clear_changes (index);
+  g_array_unref (index->updates);
+  g_array_unref (index->dirty);
+
+  g_slice_free (GtkTreeSearchIndex, index);
+}
+
+/* Returns whether _gtk_tree_search_index_find() can be used */
+gboolean
+_gtk_tree_search_index_is_ready (GtkTreeSearchIndex *index)
+{
+  return index->ready;
+}
+
+static gboolean
+dirty_matches (GtkTreeSearchIndex *index,
+               const DirtyRow     *dirty,
+               const gchar        *key)
+{
+  if (dirty->key == NULL)
+    return FALSE;
+
+  if (index->substring)
+    return strstr (dirty->key, key) != NULL;
+
+  return g_str_has_prefix (dirty->key, key);
+}
+
+static gint
+find_next (GtkTreeSearchIndex *index,
+           const gchar        *key,
+           gint                row)
+{
+  SearchTable *table = index->table;
+  guint a, b, first;
+  gint match, result = -1;
+  gboolean alive;
+  guint i;
+
+  search_table_find_range (table, key, &a, &b);
+
+  /* Rows of the table that were deleted since are skipped; there are
+   * only so many of them */
+  first = find_table_row_after (index, row);
+  while (first < table->keys->len)
+    {
+      match = row_matrix_next (&table->rows, 0, a, b, first, TRUE, 0);
+      if (match < 0)
+        break;
+
+      first = match + 1;
+      match = map_row (index, match, &alive);
+      if (alive)
+        {
+          result = match;
+          break;
+        }
+    }
+
+  for (i = 0; i < index->dirty->len; i++)
+    {
+      const DirtyRow *dirty = &g_array_index (index->dirty, DirtyRow, i);
+
+      if (dirty->row > row && (result < 0 || dirty->row < result) &&
+          dirty_matches (index, dirty, key))
+        result = dirty->row;
+    }
+
+  return result;
+}
+
+static gint
+find_prev (GtkTreeSearchIndex *index,
+           const gchar        *key,
+           gint                row)
+{
+  SearchTable *table = index->table;
+  guint a, b, last;
+  gint match, result = -1;
+  gboolean alive;
+  guint i;
+
+  search_table_find_range (table, key, &a, &b);
+
+  /* The rows of the table before the first one that maps to @row
+   * or later */
+  last = find_table_row_after (index, row - 1);
+  while (last > 0)
+    {
+      match = row_matrix_prev (&table->rows, 0, a, b, last - 1, TRUE, 0);
+      if (match < 0)
+        break;
+
+      last = match;
+      match = map_row (index, match, &alive);
+      if (alive)
+        {
+          result = match;
+          break;
+        }
+    }
+
+  for (i = 0; i < index->dirty->len; i++)
+    {
+      const DirtyRow *dirty = &g_array_index (index->dirty, DirtyRow, i);
+
+      if (dirty->row < row && dirty->row > result &&
+          dirty_matches (index, dirty, key))
+        result = dirty->row;
+    }
+
+  return result;
+}
+
+/* Returns the first row after @row whose text matches @key, or with
+ * @backwards, the last one before @row. Pass -1 as @row to start from
+ * the top. Returns -1 if there is no such row.
+ */
+gint
+_gtk_tree_search_index_find (GtkTreeSearchIndex *index,
+                             const gchar        *key,
+                             gint                row,
+                             gboolean            backwards)
+{
+  gchar *folded;
+  gint result;
+
+  g_return_val_if_fail (index->ready, -1);
+
+  folded = _gtk_tree_search_index_fold (key);
+  if (folded == NULL)
+    return -1;
+
+  if (backwards)
+    result = find_prev (index, folded, row);
+  else
+    result = find_next (index, folded, row);
+
+  g_free (folded);
+
+  return result;
+}
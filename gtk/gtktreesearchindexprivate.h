@@ -0,0 +1,40 @@
+/* gtktreesearchindexprivate.h
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_TREE_SEARCH_INDEX_PRIVATE_H__
+#define __GTK_TREE_SEARCH_INDEX_PRIVATE_H__
+
+#include <gtk/gtktreemodel.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkTreeSearchIndex GtkTreeSearchIndex;
+
+GtkTreeSearchIndex *_gtk_tree_search_index_new      (GtkTreeModel       *model,
+                                                     gint                column,
+                                                     gboolean            substring);
+void                _gtk_tree_search_index_free     (GtkTreeSearchIndex *index);
+gboolean            _gtk_tree_search_index_is_ready (GtkTreeSearchIndex *index);
+gint                _gtk_tree_search_index_find     (GtkTreeSearchIndex *index,
+                                                     const gchar        *key,
+                                                     gint                row,
+                                                     gboolean            backwards);
+gchar *             _gtk_tree_search_index_fold     (const gchar        *str);
+
+G_END_DECLS
+
+#endif /* __GTK_TREE_SEARCH_INDEX_PRIVATE_H__ */
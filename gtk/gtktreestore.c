@@ -1654,6 +1654,125 @@ gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
   validate_tree ((GtkTreeStore *)tree_store);
 }
 
+/**
+ * gtk_tree_store_insert_rows_with_valuesv:
+ * @tree_store: A #GtkTreeStore
+ * @parent: (allow-none): A valid #GtkTreeIter, or %NULL
+ * @position: position to insert the new rows, or -1 for last
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_values × @n_rows GValues
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows new children of @parent at @position and fills
+ * them with @values. The values are given column by column: the
+ * value for column @columns`[i]` of the new row @j is
+ * @values`[i * n_rows + j]`.
+ *
+ * Unless @tree_store is sorted, this emits a single
+ * #GtkTreeModel::rows-inserted signal for all the new rows.
+ * If @tree_store is sorted, @position is ignored and the rows are
+ * inserted like gtk_tree_store_insert_with_valuesv() does.
+ *
+ * Since: 3.24
+ */
+void
+gtk_tree_store_insert_rows_with_valuesv (GtkTreeStore *tree_store,
+                                         GtkTreeIter  *parent,
+                                         gint          position,
+                                         gint          n_rows,
+                                         gint         *columns,
+                                         GValue       *values,
+                                         gint          n_values)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GtkTreePath *path;
+  GNode *parent_node;
+  GNode *sibling;
+  GNode *prev;
+  GNode *new_node;
+  GtkTreeIter iter;
+  GtkTreeIter first;
+  gboolean had_children;
+  gint row, i;
+
+  g_return_if_fail (GTK_IS_TREE_STORE (tree_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  if (parent)
+    g_return_if_fail (VALID_ITER (parent, tree_store));
+
+  if (n_rows == 0)
+    return;
+
+  if (GTK_TREE_STORE_IS_SORTED (tree_store))
+    {
+      GValue *row_values;
+
+      /* The rows end up all over the place */
+      row_values = g_new (GValue, MAX (n_values, 1));
+      for (row = 0; row < n_rows; row++)
+        {
+          for (i = 0; i < n_values; i++)
+            row_values[i] = values[i * n_rows + row];
+
+          gtk_tree_store_insert_with_valuesv (tree_store, NULL, parent, -1,
+                                              columns, row_values, n_values);
+        }
+      g_free (row_values);
+
+      return;
+    }
+
+  if (parent)
+    parent_node = parent->user_data;
+  else
+    parent_node = priv->root;
+
+  priv->columns_dirty = TRUE;
+
+  had_children = parent_node->children != NULL;
+
+  /* Insert after the previous row, so appending only walks the
+   * children once
+   */
+  sibling = position < 0 ? NULL : g_node_nth_child (parent_node, position);
+  if (sibling)
+    prev = sibling->prev;
+  else
+    prev = g_node_last_child (parent_node);
+
+  iter.stamp = priv->stamp;
+  for (row = 0; row < n_rows; row++)
+    {
+      new_node = g_node_new (NULL);
+      g_node_insert_after (parent_node, prev, new_node);
+      prev = new_node;
+
+      iter.user_data = new_node;
+      if (row == 0)
+        first = iter;
+
+      for (i = 0; i < n_values; i++)
+        gtk_tree_store_real_set_value (tree_store, &iter, columns[i],
+                                       &values[i * n_rows + row], FALSE);
+    }
+
+  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), &first);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (tree_store), path, &first, n_rows);
+
+  if (parent_node != priv->root && !had_children)
+    {
+      gtk_tree_path_up (path);
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
+    }
+
+  gtk_tree_path_free (path);
+
+  validate_tree ((GtkTreeStore *)tree_store);
+}
+
 /**
  * gtk_tree_store_prepend:
  * @tree_store: A #GtkTreeStore
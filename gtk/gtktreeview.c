@@ -28,7 +28,13 @@
 #include "gtkrbtree.h"
 #include "gtktreednd.h"
 #include "gtktreeprivate.h"
+#include "gtktreesearchindexprivate.h"
+#include "gtktreemodelprivate.h"
 #include "gtkcellrenderer.h"
+#include "gtkcellrenderertextprivate.h"
+#include "gtkcellareabox.h"
+#include "gtkcellareaprivate.h"
+#include "gtkorientable.h"
 #include "gtkmarshalers.h"
 #include "gtkbuildable.h"
 #include "gtkbutton.h"
@@ -243,6 +249,10 @@ typedef enum {
 #define GTK_TREE_VIEW_PRIORITY_SCROLL_SYNC (GTK_TREE_VIEW_PRIORITY_VALIDATE + 2)
 /* 3/5 of gdkframeclockidle.c's FRAME_INTERVAL (16667 microsecs) */
 #define GTK_TREE_VIEW_TIME_MS_PER_IDLE 10
+/* Rows that are measured by one worker thread job, see
+ * gtk_tree_view_set_background_validation()
+ */
+#define GTK_TREE_VIEW_BACKGROUND_BATCH_SIZE 1024
 #define SCROLL_EDGE_SIZE 15
 #define GTK_TREE_VIEW_SEARCH_DIALOG_TIMEOUT 5000
 #define AUTO_EXPAND_TIMEOUT 500
@@ -253,6 +263,8 @@ typedef enum {
 #define TREE_WINDOW_Y_TO_RBTREE_Y(tree_view,y) ((y) + tree_view->priv->dy)
 #define RBTREE_Y_TO_TREE_WINDOW_Y(tree_view,y) ((y) - tree_view->priv->dy)
 
+typedef struct _GtkTreeViewBackgroundState GtkTreeViewBackgroundState;
+
 typedef struct _GtkTreeViewColumnReorder GtkTreeViewColumnReorder;
 struct _GtkTreeViewColumnReorder
 {
@@ -325,6 +337,9 @@ struct _GtkTreeViewPrivate
   guint validate_rows_timer;
   guint scroll_sync_timer;
 
+  /* Only set once background validation was enabled */
+  GtkTreeViewBackgroundState *background_state;
+
   /* Indentation and expander layout */
   GtkTreeViewColumn *expander_column;
 
@@ -438,6 +453,9 @@ struct _GtkTreeViewPrivate
   GtkWidget *search_entry;
   gulong search_entry_changed_id;
   guint typeselect_flush_timeout;
+  GtkTreeViewSearchIndex search_index_mode;
+  GtkTreeSearchIndex *search_index;
+  gint search_row;
 
   /* Grid and tree lines */
   GtkTreeViewGridLines grid_lines;
@@ -453,6 +471,12 @@ struct _GtkTreeViewPrivate
   gpointer row_separator_data;
   GDestroyNotify row_separator_destroy;
 
+  /* Height classes for fixed height mode */
+  GtkTreeViewRowHeightClassFunc row_height_class_func;
+  gpointer row_height_class_data;
+  GDestroyNotify row_height_class_destroy;
+  GArray *row_height_classes;
+
   /* Gestures */
   GtkGesture *multipress_gesture;
   GtkGesture *column_multipress_gesture;
@@ -468,6 +492,8 @@ struct _GtkTreeViewPrivate
   guint fixed_height_mode : 1;
   guint fixed_height_check : 1;
 
+  guint background_validation : 1;
+
   guint activate_on_single_click : 1;
   guint reorderable : 1;
   guint header_has_focus : 1;
@@ -565,6 +591,8 @@ enum {
   PROP_ENABLE_TREE_LINES,
   PROP_TOOLTIP_COLUMN,
   PROP_ACTIVATE_ON_SINGLE_CLICK,
+  PROP_BACKGROUND_VALIDATION,
+  PROP_SEARCH_INDEX,
   LAST_PROP,
   /* overridden */
   PROP_HADJUSTMENT = LAST_PROP,
@@ -681,10 +709,20 @@ static void gtk_tree_view_row_changed                     (GtkTreeModel    *mode
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_changed                    (GtkTreeModel    *model,
+							   GtkTreePath     *path,
+							   GtkTreeIter     *iter,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_inserted                    (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_inserted                   (GtkTreeModel    *model,
+							   GtkTreePath     *path,
+							   GtkTreeIter     *iter,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_has_child_toggled           (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
@@ -709,6 +747,10 @@ static gboolean do_validate_rows         (GtkTreeView *tree_view,
 					  gboolean     queue_resize);
 static gboolean validate_rows            (GtkTreeView *tree_view);
 static void     install_presize_handler  (GtkTreeView *tree_view);
+static void     background_validation_reset       (GtkTreeView *tree_view);
+static void     background_validation_row_changed (GtkTreeView *tree_view,
+                                                   GtkRBNode   *node);
+static void     background_validation_free        (GtkTreeViewBackgroundState *bg);
 static void     install_scroll_sync_handler (GtkTreeView *tree_view);
 static void     gtk_tree_view_set_top_row   (GtkTreeView *tree_view,
 					     GtkTreePath *path,
@@ -856,6 +898,7 @@ static gboolean gtk_tree_view_search_iter               (GtkTreeModel     *model
 							 gint              n);
 static void     gtk_tree_view_search_init               (GtkWidget        *entry,
 							 GtkTreeView      *tree_view);
+static void     gtk_tree_view_update_search_index       (GtkTreeView      *tree_view);
 static void     gtk_tree_view_put                       (GtkTreeView      *tree_view,
 							 GtkWidget        *child_widget,
                                                          GtkTreePath      *path,
@@ -1224,6 +1267,37 @@ gtk_tree_view_class_init (GtkTreeViewClass *class)
                             FALSE,
                             GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkTreeView:background-validation:
+   *
+   * Whether rows that are not visible are measured by worker threads.
+   * See gtk_tree_view_set_background_validation() for details.
+   *
+   * Since: 3.24
+   */
+  tree_view_props[PROP_BACKGROUND_VALIDATION] =
+      g_param_spec_boolean ("background-validation",
+                            P_("Background Validation"),
+                            P_("Whether rows are measured in worker threads"),
+                            FALSE,
+                            GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
+  /**
+   * GtkTreeView:search-index:
+   *
+   * The kind of index kept for interactive search.
+   * See gtk_tree_view_set_search_index() for details.
+   *
+   * Since: 3.24
+   */
+  tree_view_props[PROP_SEARCH_INDEX] =
+      g_param_spec_enum ("search-index",
+                         P_("Search Index"),
+                         P_("The kind of index kept for interactive search"),
+                         GTK_TYPE_TREE_VIEW_SEARCH_INDEX,
+                         GTK_TREE_VIEW_SEARCH_INDEX_NONE,
+                         GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (o_class, LAST_PROP, tree_view_props);
 
   /* Style properties */
@@ -1809,6 +1883,7 @@ gtk_tree_view_init (GtkTreeView *tree_view)
   priv->presize_handler_tick_cb = 0;
   priv->scroll_sync_timer = 0;
   priv->fixed_height = -1;
+  priv->row_height_classes = g_array_new (FALSE, FALSE, sizeof (gint));
   priv->fixed_height_mode = FALSE;
   priv->fixed_height_check = 0;
   priv->selection = _gtk_tree_selection_new_with_tree_view (tree_view);
@@ -1818,6 +1893,8 @@ gtk_tree_view_init (GtkTreeView *tree_view)
   priv->search_equal_func = gtk_tree_view_search_equal_func;
   priv->search_custom_entry_set = FALSE;
   priv->typeselect_flush_timeout = 0;
+  priv->search_index_mode = GTK_TREE_VIEW_SEARCH_INDEX_NONE;
+  priv->search_row = -1;
   priv->init_hadjust_value = TRUE;    
   priv->width = 0;
           
@@ -1994,6 +2071,12 @@ G_GNUC_END_IGNORE_DEPRECATIONS
     case PROP_ACTIVATE_ON_SINGLE_CLICK:
       gtk_tree_view_set_activate_on_single_click (tree_view, g_value_get_boolean (value));
       break;
+    case PROP_BACKGROUND_VALIDATION:
+      gtk_tree_view_set_background_validation (tree_view, g_value_get_boolean (value));
+      break;
+    case PROP_SEARCH_INDEX:
+      gtk_tree_view_set_search_index (tree_view, g_value_get_enum (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2078,6 +2161,12 @@ gtk_tree_view_get_property (GObject    *object,
     case PROP_ACTIVATE_ON_SINGLE_CLICK:
       g_value_set_boolean (value, tree_view->priv->activate_on_single_click);
       break;
+    case PROP_BACKGROUND_VALIDATION:
+      g_value_set_boolean (value, tree_view->priv->background_validation);
+      break;
+    case PROP_SEARCH_INDEX:
+      g_value_set_enum (value, tree_view->priv->search_index_mode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2087,6 +2176,11 @@ gtk_tree_view_get_property (GObject    *object,
 static void
 gtk_tree_view_finalize (GObject *object)
 {
+  GtkTreeView *tree_view = GTK_TREE_VIEW (object);
+
+  g_clear_pointer (&tree_view->priv->background_state, background_validation_free);
+  g_array_unref (tree_view->priv->row_height_classes);
+
   G_OBJECT_CLASS (gtk_tree_view_parent_class)->finalize (object);
 }
 
@@ -2129,6 +2223,7 @@ gtk_tree_view_buildable_get_internal_child (GtkBuildable      *buildable,
 static void
 gtk_tree_view_free_rbtree (GtkTreeView *tree_view)
 {
+  background_validation_reset (tree_view);
   _gtk_rbtree_free (tree_view->priv->tree);
 
   tree_view->priv->tree = NULL;
@@ -2251,6 +2346,8 @@ gtk_tree_view_destroy (GtkWidget *widget)
       tree_view->priv->search_user_data = NULL;
     }
 
+  g_clear_pointer (&tree_view->priv->search_index, _gtk_tree_search_index_free);
+
   if (tree_view->priv->search_position_destroy && tree_view->priv->search_position_user_data)
     {
       tree_view->priv->search_position_destroy (tree_view->priv->search_position_user_data);
@@ -2262,6 +2359,12 @@ gtk_tree_view_destroy (GtkWidget *widget)
       tree_view->priv->row_separator_destroy (tree_view->priv->row_separator_data);
       tree_view->priv->row_separator_data = NULL;
     }
+
+  if (tree_view->priv->row_height_class_destroy && tree_view->priv->row_height_class_data)
+    {
+      tree_view->priv->row_height_class_destroy (tree_view->priv->row_height_class_data);
+      tree_view->priv->row_height_class_data = NULL;
+    }
   
   gtk_tree_view_set_model (tree_view, NULL);
 
@@ -5601,6 +5704,12 @@ draw_bin (cairo_t *cr,
   GtkWidget *widget = GTK_WIDGET (user_data);
   GtkTreeView *tree_view = GTK_TREE_VIEW (widget);
   GList *tmp_list;
+#ifdef G_ENABLE_DEBUG
+  guint64 n_direct = 0, n_properties = 0;
+
+  if (GTK_DEBUG_CHECK (TREE))
+    _gtk_cell_area_get_attribute_statistics (&n_direct, &n_properties);
+#endif
 
   cairo_save (cr);
 
@@ -5609,6 +5718,22 @@ draw_bin (cairo_t *cr,
 
   cairo_restore (cr);
 
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (TREE))
+    {
+      guint64 n_frame_direct, n_frame_properties;
+
+      _gtk_cell_area_get_attribute_statistics (&n_frame_direct, &n_frame_properties);
+      n_frame_direct -= n_direct;
+      n_frame_properties -= n_properties;
+
+      g_message ("%s %p: frame drawn with %" G_GUINT64_FORMAT " cell property sets, "
+                 "%" G_GUINT64_FORMAT " avoided",
+                 G_OBJECT_TYPE_NAME (tree_view), tree_view,
+                 n_frame_properties, n_frame_direct);
+    }
+#endif
+
   /* We can't just chain up to Container::draw as it will try to send the
    * event to the headers, so we handle propagating it to our children
    * (eg. widgets being edited) ourselves.
@@ -6846,6 +6971,908 @@ initialize_fixed_height_mode (GtkTreeView *tree_view)
                                  tree_view->priv->fixed_height, TRUE);
 }
 
+/* Returns the height of the row at @iter in fixed height mode,
+ * or -1 if it is not known yet.
+ */
+static gint
+gtk_tree_view_get_fixed_row_height (GtkTreeView *tree_view,
+                                    GtkTreeIter *iter,
+                                    gint         depth)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+  gint height_class;
+
+  if (priv->row_height_class_func == NULL)
+    return priv->fixed_height;
+
+  if (!priv->fixed_height_mode)
+    return -1;
+
+  height_class = priv->row_height_class_func (priv->model, iter, depth,
+                                              priv->row_height_class_data);
+  g_return_val_if_fail (height_class >= 0, -1);
+
+  if (height_class >= priv->row_height_classes->len)
+    return -1;
+
+  return g_array_index (priv->row_height_classes, gint, height_class);
+}
+
+static void
+initialize_row_height_classes_for_tree (GtkTreeView *tree_view,
+                                        GtkRBTree   *tree,
+                                        GtkTreeIter *iter,
+                                        gint         depth)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+  GtkRBNode *node;
+  GtkTreeIter child;
+
+  node = _gtk_rbtree_first (tree);
+
+  do
+    {
+      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID))
+        {
+          gint height;
+
+          height = gtk_tree_view_get_fixed_row_height (tree_view, iter, depth);
+          if (height < 0)
+            {
+              GtkTreePath *path;
+              gint height_class;
+
+              /* First row of its class, measure it */
+              path = _gtk_tree_path_new_from_rbtree (tree, node);
+              validate_row (tree_view, tree, node, iter, path);
+              gtk_tree_path_free (path);
+
+              height_class = priv->row_height_class_func (priv->model, iter, depth,
+                                                          priv->row_height_class_data);
+              if (height_class >= 0)
+                {
+                  height = -1;
+                  while (priv->row_height_classes->len <= height_class)
+                    g_array_append_val (priv->row_height_classes, height);
+
+                  g_array_index (priv->row_height_classes, gint, height_class) =
+                    gtk_tree_view_get_row_height (tree_view, node);
+                }
+            }
+          else
+            {
+              _gtk_rbtree_node_set_height (tree, node, height);
+              _gtk_rbtree_node_mark_valid (tree, node);
+            }
+        }
+
+      if (node->children &&
+          GTK_RBNODE_FLAG_SET (node->children->root, GTK_RBNODE_DESCENDANTS_INVALID) &&
+          gtk_tree_model_iter_children (priv->model, &child, iter))
+        initialize_row_height_classes_for_tree (tree_view, node->children, &child, depth + 1);
+
+      node = _gtk_rbtree_next (tree, node);
+    }
+  while (node != NULL && gtk_tree_model_iter_next (priv->model, iter));
+}
+
+/* Like initialize_fixed_height_mode(), but measures one row per
+ * height class and gives all other invalid rows the height of
+ * their class.
+ */
+static void
+initialize_row_height_classes (GtkTreeView *tree_view)
+{
+  GtkTreeIter iter;
+
+  if (!tree_view->priv->tree ||
+      !GTK_RBNODE_FLAG_SET (tree_view->priv->tree->root, GTK_RBNODE_DESCENDANTS_INVALID))
+    return;
+
+  if (!gtk_tree_model_get_iter_first (tree_view->priv->model, &iter))
+    return;
+
+  initialize_row_height_classes_for_tree (tree_view, tree_view->priv->tree, &iter, 1);
+}
+
+/* Background validation
+ *
+ * Measuring a row means laying out the text of all its cells, which
+ * is what keeps do_validate_rows() busy for large models. When all
+ * cells are plain text cells, the main thread only reads the texts
+ * of the rows that need validation from the model, and worker
+ * threads lay them out with their own PangoContext. The difference
+ * between the size of the text and the size of the cell is measured
+ * once on the main thread, using the first row.
+ *
+ * Results are applied in batches. A batch is dropped if the rows it
+ * refers to may have gone away since; every change that can free or
+ * reorder rbtree nodes bumps the stamp.
+ */
+typedef struct
+{
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  cairo_font_options_t *font_options;
+  gdouble resolution;
+  PangoDirection base_dir;
+} BackgroundFont;
+
+typedef struct
+{
+  gint model_column;
+  gint column_index;
+  /* Height of the cell minus the height of its text */
+  gint height_overhead;
+  PangoAttrList *attrs;
+  gboolean single_paragraph;
+} BackgroundCell;
+
+typedef struct
+{
+  GtkTreeViewColumn *column;
+  /* Widest text measured in the background, rows that exceed it
+   * are measured on the main thread to update the column width
+   */
+  gint max_text_width;
+} BackgroundColumn;
+
+struct _GtkTreeViewBackgroundState
+{
+  guint stamp;
+  guint n_pending;
+  GCancellable *cancellable;
+
+  /* Where the scan for rows that need validation continues */
+  GtkRBTree *scan_tree;
+  GtkRBNode *scan_node;
+  guint scan_done : 1;
+
+  /* How rows are measured, see background_validation_setup() */
+  guint setup_done : 1;
+  guint usable : 1;
+  BackgroundFont font;
+  GArray *cells;
+  GArray *columns;
+  gint max_depth;
+
+  /* Rows that changed while a batch measuring them was running */
+  GHashTable *changed_nodes;
+};
+
+typedef struct
+{
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  gint depth;
+  /* Result: the tallest cell */
+  gint height;
+} BackgroundRow;
+
+typedef struct
+{
+  guint stamp;
+  BackgroundFont font;
+  guint n_cells;
+  BackgroundCell *cells;
+  guint n_columns;
+  GArray *rows;
+  GPtrArray *texts;
+  /* Result: the width of the texts of each column of each row */
+  gint *widths;
+} BackgroundBatch;
+
+static void
+background_font_copy (BackgroundFont       *dest,
+                      const BackgroundFont *src)
+{
+  dest->font_desc = pango_font_description_copy (src->font_desc);
+  dest->language = src->language;
+  dest->font_options = src->font_options ? cairo_font_options_copy (src->font_options) : NULL;
+  dest->resolution = src->resolution;
+  dest->base_dir = src->base_dir;
+}
+
+static void
+background_font_clear (BackgroundFont *font)
+{
+  g_clear_pointer (&font->font_desc, pango_font_description_free);
+  g_clear_pointer (&font->font_options, cairo_font_options_destroy);
+}
+
+/* Called in any thread. Every thread has its own default font map,
+ * which is all that makes this work.
+ */
+static PangoContext *
+background_font_create_context (const BackgroundFont *font)
+{
+  PangoContext *context;
+
+  context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+  pango_context_set_font_description (context, font->font_desc);
+  pango_context_set_language (context, font->language);
+  pango_context_set_base_dir (context, font->base_dir);
+  pango_cairo_context_set_resolution (context, font->resolution);
+  pango_cairo_context_set_font_options (context, font->font_options);
+
+  return context;
+}
+
+static void
+background_measure_text (PangoLayout *layout,
+                         const gchar *text,
+                         gint        *width,
+                         gint        *height)
+{
+  PangoRectangle rect;
+
+  pango_layout_set_text (layout, text ? text : "", -1);
+  pango_layout_get_pixel_extents (layout, NULL, &rect);
+
+  *width = rect.width;
+  *height = rect.height;
+}
+
+static void
+background_batch_free (BackgroundBatch *batch)
+{
+  guint i;
+
+  background_font_clear (&batch->font);
+  for (i = 0; i < batch->n_cells; i++)
+    pango_attr_list_unref (batch->cells[i].attrs);
+  g_free (batch->cells);
+  g_array_unref (batch->rows);
+  g_ptr_array_unref (batch->texts);
+  g_free (batch->widths);
+  g_slice_free (BackgroundBatch, batch);
+}
+
+static BackgroundBatch *
+background_batch_new (GtkTreeViewBackgroundState *bg)
+{
+  BackgroundBatch *batch;
+  guint i;
+
+  batch = g_slice_new0 (BackgroundBatch);
+  batch->stamp = bg->stamp;
+  background_font_copy (&batch->font, &bg->font);
+
+  /* Attribute lists are not thread-safe, every batch gets its own */
+  batch->n_cells = bg->cells->len;
+  batch->cells = g_new (BackgroundCell, batch->n_cells);
+  for (i = 0; i < batch->n_cells; i++)
+    {
+      batch->cells[i] = g_array_index (bg->cells, BackgroundCell, i);
+      batch->cells[i].attrs = pango_attr_list_copy (batch->cells[i].attrs);
+    }
+
+  batch->n_columns = bg->columns->len;
+  batch->rows = g_array_sized_new (FALSE, FALSE, sizeof (BackgroundRow),
+                                   GTK_TREE_VIEW_BACKGROUND_BATCH_SIZE);
+  batch->texts = g_ptr_array_new_full (GTK_TREE_VIEW_BACKGROUND_BATCH_SIZE * batch->n_cells,
+                                       g_free);
+
+  return batch;
+}
+
+static void
+background_batch_add_row (BackgroundBatch *batch,
+                          GtkTreeModel    *model,
+                          GtkTreeIter     *iter,
+                          GtkRBTree       *tree,
+                          GtkRBNode       *node,
+                          gint             depth)
+{
+  BackgroundRow row = { tree, node, depth, 0 };
+  guint i;
+
+  g_array_append_val (batch->rows, row);
+
+  for (i = 0; i < batch->n_cells; i++)
+    {
+      gchar *text;
+
+      gtk_tree_model_get (model, iter, batch->cells[i].model_column, &text, -1);
+      g_ptr_array_add (batch->texts, text);
+    }
+}
+
+/* Runs in a worker thread, must not touch the tree view */
+static void
+background_measure_thread (GTask        *task,
+                           gpointer      source_object,
+                           gpointer      task_data,
+                           GCancellable *cancellable)
+{
+  BackgroundBatch *batch = task_data;
+  PangoContext *context;
+  PangoLayout **layouts;
+  guint i, j;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  context = background_font_create_context (&batch->font);
+  layouts = g_new (PangoLayout *, batch->n_cells);
+  for (j = 0; j < batch->n_cells; j++)
+    {
+      layouts[j] = pango_layout_new (context);
+      pango_layout_set_attributes (layouts[j], batch->cells[j].attrs);
+      pango_layout_set_single_paragraph_mode (layouts[j], batch->cells[j].single_paragraph);
+    }
+
+  batch->widths = g_new0 (gint, batch->rows->len * batch->n_columns);
+
+  for (i = 0; i < batch->rows->len; i++)
+    {
+      BackgroundRow *row = &g_array_index (batch->rows, BackgroundRow, i);
+
+      for (j = 0; j < batch->n_cells; j++)
+        {
+          BackgroundCell *cell = &batch->cells[j];
+          gint width, height;
+
+          background_measure_text (layouts[j],
+                                   g_ptr_array_index (batch->texts, i * batch->n_cells + j),
+                                   &width, &height);
+
+          row->height = MAX (row->height, cell->height_overhead + height);
+          batch->widths[i * batch->n_columns + cell->column_index] += width;
+        }
+    }
+
+  for (j = 0; j < batch->n_cells; j++)
+    g_object_unref (layouts[j]);
+  g_free (layouts);
+  g_object_unref (context);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+background_validation_clear_setup (GtkTreeViewBackgroundState *bg)
+{
+  guint i;
+
+  if (bg->cells)
+    {
+      for (i = 0; i < bg->cells->len; i++)
+        pango_attr_list_unref (g_array_index (bg->cells, BackgroundCell, i).attrs);
+      g_clear_pointer (&bg->cells, g_array_unref);
+    }
+  g_clear_pointer (&bg->columns, g_array_unref);
+  background_font_clear (&bg->font);
+
+  bg->max_depth = 0;
+  bg->usable = FALSE;
+  bg->setup_done = FALSE;
+}
+
+/* Finds out whether the rows of @tree_view can be measured in the
+ * background and how. That is the case if all visible cells are text
+ * cells that get nothing but their text from the model.
+ */
+static gboolean
+background_validation_setup (GtkTreeView *tree_view)
+{
+  GtkTreeViewBackgroundState *bg = tree_view->priv->background_state;
+  GtkWidget *widget = GTK_WIDGET (tree_view);
+  GtkStyleContext *style_context;
+  PangoContext *widget_context, *context;
+  PangoLayout *layout;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GtkRBNode *node;
+  GList *list;
+  gint column_index;
+
+  if (bg->setup_done)
+    return bg->usable;
+
+  bg->setup_done = TRUE;
+
+  if (tree_view->priv->model == NULL ||
+      tree_view->priv->tree == NULL ||
+      tree_view->priv->row_separator_func != NULL ||
+      gtk_widget_get_font_map (widget) != NULL)
+    return FALSE;
+
+  widget_context = gtk_widget_get_pango_context (widget);
+  bg->font.font_desc = pango_font_description_copy (pango_context_get_font_description (widget_context));
+  bg->font.language = pango_context_get_language (widget_context);
+  bg->font.base_dir = pango_context_get_base_dir (widget_context);
+  bg->font.resolution = pango_cairo_context_get_resolution (widget_context);
+  if (pango_cairo_context_get_font_options (widget_context))
+    bg->font.font_options = cairo_font_options_copy (pango_cairo_context_get_font_options (widget_context));
+
+  bg->cells = g_array_new (FALSE, FALSE, sizeof (BackgroundCell));
+  bg->columns = g_array_new (FALSE, FALSE, sizeof (BackgroundColumn));
+
+  /* The first row is used to find the size of everything but the text */
+  node = _gtk_rbtree_first (tree_view->priv->tree);
+  path = _gtk_tree_path_new_from_rbtree (tree_view->priv->tree, node);
+  gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
+  gtk_tree_path_free (path);
+
+  context = background_font_create_context (&bg->font);
+  layout = pango_layout_new (context);
+
+  style_context = gtk_widget_get_style_context (widget);
+  gtk_style_context_save (style_context);
+  gtk_style_context_add_class (style_context, GTK_STYLE_CLASS_CELL);
+
+  bg->usable = TRUE;
+  column_index = 0;
+
+  for (list = tree_view->priv->columns; list && bg->usable; list = list->next)
+    {
+      GtkTreeViewColumn *column = list->data;
+      BackgroundColumn background_column = { column, -1 };
+      GtkCellArea *area;
+      GList *cells, *l;
+      guint n_cells = 0;
+
+      if (!gtk_tree_view_column_get_visible (column))
+        continue;
+
+      area = gtk_cell_layout_get_area (GTK_CELL_LAYOUT (column));
+      if (!GTK_IS_CELL_AREA_BOX (area) ||
+          gtk_orientable_get_orientation (GTK_ORIENTABLE (area)) != GTK_ORIENTATION_HORIZONTAL)
+        {
+          bg->usable = FALSE;
+          break;
+        }
+
+      gtk_tree_view_column_cell_set_cell_data (column, tree_view->priv->model, &iter,
+                                               GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
+                                               node->children ? TRUE : FALSE);
+
+      cells = gtk_cell_layout_get_cells (GTK_CELL_LAYOUT (column));
+      for (l = cells; l; l = l->next)
+        {
+          GtkCellRenderer *renderer = l->data;
+          BackgroundCell cell;
+          gint cell_height, text_width, text_height;
+          gchar *text;
+
+          if (!gtk_cell_renderer_get_visible (renderer))
+            continue;
+
+          if (!GTK_IS_CELL_RENDERER_TEXT (renderer) ||
+              !_gtk_cell_renderer_text_is_measured_by_text (GTK_CELL_RENDERER_TEXT (renderer)))
+            {
+              bg->usable = FALSE;
+              break;
+            }
+
+          cell.model_column = _gtk_cell_area_get_sole_attribute_column (area, renderer, "text");
+          if (cell.model_column < 0 ||
+              gtk_tree_model_get_column_type (tree_view->priv->model, cell.model_column) != G_TYPE_STRING)
+            {
+              bg->usable = FALSE;
+              break;
+            }
+
+          cell.column_index = column_index;
+          cell.attrs = _gtk_cell_renderer_text_get_measure_attributes (GTK_CELL_RENDERER_TEXT (renderer),
+                                                                       widget,
+                                                                       &cell.single_paragraph);
+
+          gtk_cell_area_request_renderer (area, renderer, GTK_ORIENTATION_VERTICAL,
+                                          widget, -1, &cell_height, NULL);
+
+          gtk_tree_model_get (tree_view->priv->model, &iter, cell.model_column, &text, -1);
+          pango_layout_set_attributes (layout, cell.attrs);
+          pango_layout_set_single_paragraph_mode (layout, cell.single_paragraph);
+          background_measure_text (layout, text, &text_width, &text_height);
+          g_free (text);
+
+          cell.height_overhead = cell_height - text_height;
+
+          g_array_append_val (bg->cells, cell);
+          n_cells++;
+        }
+      g_list_free (cells);
+
+      if (n_cells == 0)
+        bg->usable = FALSE;
+
+      g_array_append_val (bg->columns, background_column);
+      column_index++;
+    }
+
+  gtk_style_context_restore (style_context);
+
+  g_object_unref (layout);
+  g_object_unref (context);
+
+  if (bg->columns->len == 0)
+    bg->usable = FALSE;
+
+  return bg->usable;
+}
+
+/* Forgets about all batches that are running and about how rows are
+ * measured. Called whenever rbtree nodes might be freed or reordered,
+ * or the columns change.
+ */
+static void
+background_validation_reset (GtkTreeView *tree_view)
+{
+  GtkTreeViewBackgroundState *bg = tree_view->priv->background_state;
+
+  if (bg == NULL)
+    return;
+
+  bg->stamp++;
+
+  if (bg->n_pending > 0)
+    {
+      g_cancellable_cancel (bg->cancellable);
+      g_object_unref (bg->cancellable);
+      bg->cancellable = g_cancellable_new ();
+    }
+
+  bg->scan_tree = NULL;
+  bg->scan_node = NULL;
+  bg->scan_done = FALSE;
+  g_hash_table_remove_all (bg->changed_nodes);
+
+  background_validation_clear_setup (bg);
+}
+
+static GtkTreeViewBackgroundState *
+background_validation_new (void)
+{
+  GtkTreeViewBackgroundState *bg;
+
+  bg = g_slice_new0 (GtkTreeViewBackgroundState);
+  bg->cancellable = g_cancellable_new ();
+  bg->changed_nodes = g_hash_table_new (NULL, NULL);
+
+  return bg;
+}
+
+/* Running batches keep the tree view alive, so there are none left */
+static void
+background_validation_free (GtkTreeViewBackgroundState *bg)
+{
+  g_assert (bg->n_pending == 0);
+
+  background_validation_clear_setup (bg);
+  g_object_unref (bg->cancellable);
+  g_hash_table_unref (bg->changed_nodes);
+  g_slice_free (GtkTreeViewBackgroundState, bg);
+}
+
+static void
+background_validation_row_changed (GtkTreeView *tree_view,
+                                   GtkRBNode   *node)
+{
+  GtkTreeViewBackgroundState *bg = tree_view->priv->background_state;
+
+  if (bg != NULL && bg->n_pending > 0)
+    g_hash_table_add (bg->changed_nodes, node);
+}
+
+static gboolean
+background_row_needs_validation (GtkTreeViewBackgroundState *bg,
+                                 BackgroundRow              *row)
+{
+  return (GTK_RBNODE_FLAG_SET (row->node, GTK_RBNODE_INVALID) ||
+          GTK_RBNODE_FLAG_SET (row->node, GTK_RBNODE_COLUMN_INVALID)) &&
+         !g_hash_table_contains (bg->changed_nodes, row->node);
+}
+
+static gboolean
+background_validate_row_now (GtkTreeView   *tree_view,
+                             BackgroundRow *row)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gboolean changed;
+
+  path = _gtk_tree_path_new_from_rbtree (row->tree, row->node);
+  gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
+  changed = validate_row (tree_view, row->tree, row->node, &iter, path);
+  gtk_tree_path_free (path);
+
+  return changed;
+}
+
+static void
+background_batch_apply (GtkTreeView     *tree_view,
+                        BackgroundBatch *batch)
+{
+  GtkTreeViewBackgroundState *bg = tree_view->priv->background_state;
+  gint vertical_separator, grid_line_width, expander_size;
+  gboolean draw_hgrid_lines;
+  gboolean changed = FALSE;
+  gint *widest;
+  gint deepest = -1;
+  gint y = -1;
+  guint i, c;
+
+  gtk_widget_style_get (GTK_WIDGET (tree_view),
+                        "vertical-separator", &vertical_separator,
+                        "grid-line-width", &grid_line_width,
+                        NULL);
+  draw_hgrid_lines =
+    tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_HORIZONTAL
+    || tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_BOTH;
+  expander_size = gtk_tree_view_get_expander_size (tree_view);
+
+  /* Column widths and the padding of the expander column come from
+   * the widest and deepest rows, which get measured on the main thread.
+   */
+  widest = g_newa (gint, batch->n_columns);
+  for (c = 0; c < batch->n_columns; c++)
+    widest[c] = -1;
+
+  for (i = 0; i < batch->rows->len; i++)
+    {
+      BackgroundRow *row = &g_array_index (batch->rows, BackgroundRow, i);
+
+      if (!background_row_needs_validation (bg, row))
+        continue;
+
+      for (c = 0; c < batch->n_columns; c++)
+        {
+          BackgroundColumn *column = &g_array_index (bg->columns, BackgroundColumn, c);
+          gint width = batch->widths[i * batch->n_columns + c];
+
+          if (width > column->max_text_width)
+            {
+              column->max_text_width = width;
+              widest[c] = i;
+            }
+        }
+
+      if (row->depth > bg->max_depth)
+        {
+          bg->max_depth = row->depth;
+          deepest = i;
+        }
+    }
+
+  for (c = 0; c < batch->n_columns; c++)
+    {
+      if (widest[c] >= 0 &&
+          background_row_needs_validation (bg, &g_array_index (batch->rows, BackgroundRow, widest[c])))
+        changed |= background_validate_row_now (tree_view, &g_array_index (batch->rows, BackgroundRow, widest[c]));
+    }
+
+  if (deepest >= 0 &&
+      background_row_needs_validation (bg, &g_array_index (batch->rows, BackgroundRow, deepest)))
+    changed |= background_validate_row_now (tree_view, &g_array_index (batch->rows, BackgroundRow, deepest));
+
+  for (i = 0; i < batch->rows->len; i++)
+    {
+      BackgroundRow *row = &g_array_index (batch->rows, BackgroundRow, i);
+      gint height;
+
+      if (!background_row_needs_validation (bg, row))
+        continue;
+
+      /* Keep this in sync with validate_row() */
+      height = MAX (row->height + vertical_separator, expander_size);
+      if (draw_hgrid_lines)
+        height += grid_line_width;
+
+      if (height != GTK_RBNODE_GET_HEIGHT (row->node))
+        {
+          _gtk_rbtree_node_set_height (row->tree, row->node, height);
+
+          if (y == -1)
+            y = gtk_tree_view_get_row_y_offset (tree_view, row->tree, row->node);
+          changed = TRUE;
+        }
+
+      _gtk_rbtree_node_mark_valid (row->tree, row->node);
+      tree_view->priv->post_validation_flag = TRUE;
+    }
+
+  if (changed)
+    {
+      /* If rows above the current position have changed height, this has
+       * affected the current view and thus needs a redraw.
+       */
+      if (y != -1 && y < gtk_adjustment_get_value (tree_view->priv->vadjustment))
+        gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+
+      gtk_widget_queue_resize_no_redraw (GTK_WIDGET (tree_view));
+    }
+}
+
+static void
+background_batch_done (GObject      *source,
+                       GAsyncResult *result,
+                       gpointer      data)
+{
+  GtkTreeView *tree_view = GTK_TREE_VIEW (source);
+  GtkTreeViewBackgroundState *bg = tree_view->priv->background_state;
+  BackgroundBatch *batch = g_task_get_task_data (G_TASK (result));
+
+  bg->n_pending--;
+
+  if (g_task_propagate_boolean (G_TASK (result), NULL) &&
+      batch->stamp == bg->stamp &&
+      tree_view->priv->tree != NULL)
+    background_batch_apply (tree_view, batch);
+
+  if (bg->n_pending == 0)
+    {
+      g_hash_table_remove_all (bg->changed_nodes);
+
+      /* Rows that changed or were added behind the scan still need
+       * validation, start over.
+       */
+      if (bg->scan_done)
+        {
+          bg->scan_done = FALSE;
+
+          if (tree_view->priv->tree != NULL &&
+              GTK_RBNODE_FLAG_SET (tree_view->priv->tree->root, GTK_RBNODE_DESCENDANTS_INVALID))
+            install_presize_handler (tree_view);
+        }
+    }
+}
+
+static void
+background_batch_run (GtkTreeView     *tree_view,
+                      BackgroundBatch *batch)
+{
+  GtkTreeViewBackgroundState *bg = tree_view->priv->background_state;
+  GTask *task;
+
+  task = g_task_new (tree_view, bg->cancellable, background_batch_done, NULL);
+  g_task_set_task_data (task, batch, (GDestroyNotify) background_batch_free);
+  g_task_run_in_thread (task, background_measure_thread);
+  g_object_unref (task);
+
+  bg->n_pending++;
+}
+
+/* The background counterpart of do_validate_rows(): reads the rows
+ * that need validation and hands them to worker threads. Returns
+ * %FALSE if the rows can't be measured in the background, otherwise
+ * sets @more to whether there are more rows to read.
+ */
+static gboolean
+do_background_validate_rows (GtkTreeView *tree_view,
+                             gboolean    *more)
+{
+  GtkTreeViewBackgroundState *bg = tree_view->priv->background_state;
+  BackgroundBatch *batch = NULL;
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GTimer *timer;
+  gboolean valid = TRUE;
+  gint depth;
+  guint i = 0;
+
+  if (!background_validation_setup (tree_view))
+    return FALSE;
+
+  /* Wait for the running batches, see background_batch_done() */
+  if (bg->scan_done)
+    {
+      *more = FALSE;
+      return TRUE;
+    }
+
+  if (bg->scan_node != NULL)
+    {
+      tree = bg->scan_tree;
+      node = bg->scan_node;
+    }
+  else
+    {
+      tree = tree_view->priv->tree;
+      node = _gtk_rbtree_first (tree);
+    }
+
+  path = _gtk_tree_path_new_from_rbtree (tree, node);
+  gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
+  depth = gtk_tree_path_get_depth (path);
+  gtk_tree_path_free (path);
+
+  timer = g_timer_new ();
+  g_timer_start (timer);
+
+  while (node != NULL)
+    {
+      GtkRBTree *next_tree;
+      GtkRBNode *next_node;
+
+      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) ||
+          GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
+        {
+          if (batch == NULL)
+            batch = background_batch_new (bg);
+
+          background_batch_add_row (batch, tree_view->priv->model, &iter, tree, node, depth);
+
+          if (batch->rows->len == GTK_TREE_VIEW_BACKGROUND_BATCH_SIZE)
+            {
+              background_batch_run (tree_view, batch);
+              batch = NULL;
+            }
+        }
+
+      _gtk_rbtree_next_full (tree, node, &next_tree, &next_node);
+
+      if (next_node == NULL)
+        {
+          node = NULL;
+          break;
+        }
+
+      if (next_tree == tree)
+        {
+          valid = gtk_tree_model_iter_next (tree_view->priv->model, &iter);
+        }
+      else if (next_tree == node->children)
+        {
+          GtkTreeIter parent = iter;
+
+          valid = gtk_tree_model_iter_children (tree_view->priv->model, &iter, &parent);
+          depth++;
+        }
+      else
+        {
+          path = _gtk_tree_path_new_from_rbtree (next_tree, next_node);
+          gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
+          depth = gtk_tree_path_get_depth (path);
+          gtk_tree_path_free (path);
+        }
+
+      if (!valid)
+        break;
+
+      tree = next_tree;
+      node = next_node;
+
+      if (++i % 64 == 0 &&
+          g_timer_elapsed (timer, NULL) >= GTK_TREE_VIEW_TIME_MS_PER_IDLE / 1000.)
+        break;
+    }
+
+  g_timer_destroy (timer);
+
+  /* The model went out of sync with the tree, don't measure the rows
+   * collected so far, as they may not be the rows they claim to be.
+   */
+  if (!valid && batch != NULL)
+    background_batch_free (batch);
+
+  TREE_VIEW_INTERNAL_ASSERT (valid, FALSE);
+
+  if (batch != NULL)
+    background_batch_run (tree_view, batch);
+
+  bg->scan_tree = tree;
+  bg->scan_node = node;
+
+  if (node != NULL)
+    *more = TRUE;
+  else if (bg->n_pending > 0)
+    {
+      bg->scan_done = TRUE;
+      *more = FALSE;
+    }
+  else
+    {
+      bg->scan_tree = NULL;
+      *more = GTK_RBNODE_FLAG_SET (tree_view->priv->tree->root, GTK_RBNODE_DESCENDANTS_INVALID);
+    }
+
+  return TRUE;
+}
+
 /* Our strategy for finding nodes to validate is a little convoluted.  We find
  * the left-most uninvalidated node.  We then try walking right, validating
  * nodes.  Once we find a valid node, we repeat the previous process of finding
@@ -6881,12 +7908,18 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
   if (tree_view->priv->fixed_height_mode)
     {
-      if (tree_view->priv->fixed_height < 0)
+      if (tree_view->priv->row_height_class_func)
+        initialize_row_height_classes (tree_view);
+      else if (tree_view->priv->fixed_height < 0)
         initialize_fixed_height_mode (tree_view);
 
       return FALSE;
     }
 
+  if (tree_view->priv->background_validation &&
+      do_background_validate_rows (tree_view, &retval))
+    return retval;
+
   timer = g_timer_new ();
   g_timer_start (timer);
 
@@ -7292,6 +8325,7 @@ _gtk_tree_view_install_mark_rows_col_dirty (GtkTreeView *tree_view,
 					    gboolean     install_handler)
 {
   tree_view->priv->mark_rows_col_dirty = TRUE;
+  background_validation_reset (tree_view);
 
   if (install_handler)
     install_presize_handler (tree_view);
@@ -8477,6 +9511,7 @@ gtk_tree_view_set_fixed_height_mode (GtkTreeView *tree_view,
     {
       tree_view->priv->fixed_height_mode = 0;
       tree_view->priv->fixed_height = -1;
+      g_array_set_size (tree_view->priv->row_height_classes, 0);
     }
   else 
     {
@@ -8495,28 +9530,97 @@ gtk_tree_view_set_fixed_height_mode (GtkTreeView *tree_view,
       
       tree_view->priv->fixed_height_mode = 1;
       tree_view->priv->fixed_height = -1;
+      g_array_set_size (tree_view->priv->row_height_classes, 0);
     }
 
   /* force a revalidation */
   install_presize_handler (tree_view);
 
-  g_object_notify_by_pspec (G_OBJECT (tree_view), tree_view_props[PROP_FIXED_HEIGHT_MODE]);
+  g_object_notify_by_pspec (G_OBJECT (tree_view), tree_view_props[PROP_FIXED_HEIGHT_MODE]);
+}
+
+/**
+ * gtk_tree_view_get_fixed_height_mode:
+ * @tree_view: a #GtkTreeView
+ * 
+ * Returns whether fixed height mode is turned on for @tree_view.
+ * 
+ * Returns: %TRUE if @tree_view is in fixed height mode
+ * 
+ * Since: 2.6
+ **/
+gboolean
+gtk_tree_view_get_fixed_height_mode (GtkTreeView *tree_view)
+{
+  return tree_view->priv->fixed_height_mode;
+}
+
+/**
+ * gtk_tree_view_set_background_validation:
+ * @tree_view: a #GtkTreeView
+ * @enable: %TRUE to measure rows in worker threads
+ *
+ * Enables or disables measuring rows in worker threads.
+ *
+ * After a model is set, #GtkTreeView measures all its rows in idle
+ * handlers to find the size of the scrollable area, which keeps the
+ * main loop busy for a long time with models that have many rows.
+ * With background validation, the rows that are not visible are laid
+ * out by worker threads instead, and the main thread only reads their
+ * texts from the model.
+ *
+ * This only works if all visible columns contain nothing but
+ * #GtkCellRendererText cells that only have their
+ * #GtkCellRendererText:text property mapped to a string column of the
+ * model, no cell data functions, and no wrap width. Everything else
+ * about the cells must be the same in all rows. If that is not the
+ * case, or @tree_view has a row separator function, rows are measured
+ * on the main thread as usual.
+ *
+ * Fixed height mode takes precedence over background validation.
+ *
+ * Since: 3.24
+ */
+void
+gtk_tree_view_set_background_validation (GtkTreeView *tree_view,
+                                         gboolean     enable)
+{
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  enable = enable != FALSE;
+
+  if (enable == tree_view->priv->background_validation)
+    return;
+
+  if (enable && tree_view->priv->background_state == NULL)
+    tree_view->priv->background_state = background_validation_new ();
+  else
+    background_validation_reset (tree_view);
+
+  tree_view->priv->background_validation = enable;
+
+  install_presize_handler (tree_view);
+
+  g_object_notify_by_pspec (G_OBJECT (tree_view), tree_view_props[PROP_BACKGROUND_VALIDATION]);
 }
 
 /**
- * gtk_tree_view_get_fixed_height_mode:
+ * gtk_tree_view_get_background_validation:
  * @tree_view: a #GtkTreeView
- * 
- * Returns whether fixed height mode is turned on for @tree_view.
- * 
- * Returns: %TRUE if @tree_view is in fixed height mode
- * 
- * Since: 2.6
- **/
+ *
+ * Returns whether rows of @tree_view are measured in worker threads.
+ * See gtk_tree_view_set_background_validation().
+ *
+ * Returns: %TRUE if background validation is enabled
+ *
+ * Since: 3.24
+ */
 gboolean
-gtk_tree_view_get_fixed_height_mode (GtkTreeView *tree_view)
+gtk_tree_view_get_background_validation (GtkTreeView *tree_view)
 {
-  return tree_view->priv->fixed_height_mode;
+  g_return_val_if_fail (GTK_IS_TREE_VIEW (tree_view), FALSE);
+
+  return tree_view->priv->background_validation;
 }
 
 /* Returns TRUE if the focus is within the headers, after the focus operation is
@@ -8820,6 +9924,7 @@ gtk_tree_view_style_updated (GtkWidget *widget)
 	}
 
       tree_view->priv->fixed_height = -1;
+      g_array_set_size (tree_view->priv->row_height_classes, 0);
       _gtk_rbtree_mark_invalid (tree_view->priv->tree);
     }
 }
@@ -8949,21 +10054,57 @@ gtk_tree_view_put (GtkTreeView       *tree_view,
 /* TreeModel Callbacks
  */
 
+/* Returns whether @path is one of the @n_rows siblings starting at @first */
+static gboolean
+path_in_range (GtkTreePath *path,
+               GtkTreePath *first,
+               gint         n_rows)
+{
+  gint depth = gtk_tree_path_get_depth (first);
+  gint *indices, *first_indices;
+  gint i;
+
+  if (gtk_tree_path_get_depth (path) != depth)
+    return FALSE;
+
+  indices = gtk_tree_path_get_indices (path);
+  first_indices = gtk_tree_path_get_indices (first);
+
+  for (i = 0; i < depth - 1; i++)
+    if (indices[i] != first_indices[i])
+      return FALSE;
+
+  return indices[depth - 1] >= first_indices[depth - 1] &&
+         indices[depth - 1] < first_indices[depth - 1] + n_rows;
+}
+
+/* Updates the nodes of @n_rows consecutive rows, starting at @path */
 static void
-gtk_tree_view_row_changed (GtkTreeModel *model,
-			   GtkTreePath  *path,
-			   GtkTreeIter  *iter,
-			   gpointer      data)
+gtk_tree_view_change_rows (GtkTreeView  *tree_view,
+                           GtkTreeModel *model,
+                           GtkTreePath  *path,
+                           GtkTreeIter  *iter,
+                           gint          n_rows)
 {
-  GtkTreeView *tree_view = (GtkTreeView *)data;
   GtkRBTree *tree;
   GtkRBNode *node;
+  GtkTreeIter real_iter;
   gboolean free_path = FALSE;
+  gboolean need_presize = TRUE;
+  gboolean columns_dirty = FALSE;
   GList *list;
   GtkTreePath *cursor_path;
+  gint depth;
+  gint k;
 
   g_return_if_fail (path != NULL || iter != NULL);
 
+  if (path == NULL)
+    {
+      path = gtk_tree_model_get_path (model, iter);
+      free_path = TRUE;
+    }
+
   if (tree_view->priv->cursor_node != NULL)
     cursor_path = _gtk_tree_path_new_from_rbtree (tree_view->priv->cursor_tree,
                                                   tree_view->priv->cursor_node);
@@ -8971,19 +10112,16 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
     cursor_path = NULL;
 
   if (tree_view->priv->edited_column &&
-      (cursor_path == NULL || gtk_tree_path_compare (cursor_path, path) == 0))
+      (cursor_path == NULL || path_in_range (cursor_path, path, n_rows)))
     gtk_tree_view_stop_editing (tree_view, TRUE);
 
   if (cursor_path != NULL)
     gtk_tree_path_free (cursor_path);
 
-  if (path == NULL)
-    {
-      path = gtk_tree_model_get_path (model, iter);
-      free_path = TRUE;
-    }
-  else if (iter == NULL)
-    gtk_tree_model_get_iter (model, iter, path);
+  if (iter)
+    real_iter = *iter;
+  else
+    gtk_tree_model_get_iter (model, &real_iter, path);
 
   if (_gtk_tree_view_find_node (tree_view,
 				path,
@@ -8995,18 +10133,43 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
   if (tree == NULL)
     goto done;
 
-  _gtk_tree_view_accessible_changed (tree_view, tree, node);
+  need_presize = !tree_view->priv->fixed_height_mode;
+  depth = gtk_tree_path_get_depth (path);
 
-  if (tree_view->priv->fixed_height_mode
-      && tree_view->priv->fixed_height >= 0)
+  for (k = 0; k < n_rows; k++)
     {
-      _gtk_rbtree_node_set_height (tree, node, tree_view->priv->fixed_height);
-      if (gtk_widget_get_realized (GTK_WIDGET (tree_view)))
-	gtk_tree_view_node_queue_redraw (tree_view, tree, node);
+      gint height = -1;
+
+      if (k > 0)
+        {
+          node = _gtk_rbtree_next (tree, node);
+          if (node == NULL ||
+              !gtk_tree_model_iter_next (model, &real_iter))
+            break;
+        }
+
+      _gtk_tree_view_accessible_changed (tree_view, tree, node);
+
+      if (tree_view->priv->fixed_height_mode)
+        height = gtk_tree_view_get_fixed_row_height (tree_view, &real_iter, depth);
+
+      if (height >= 0)
+        {
+          _gtk_rbtree_node_set_height (tree, node, height);
+          if (gtk_widget_get_realized (GTK_WIDGET (tree_view)))
+            gtk_tree_view_node_queue_redraw (tree_view, tree, node);
+        }
+      else
+        {
+          _gtk_rbtree_node_mark_invalid (tree, node);
+          background_validation_row_changed (tree_view, node);
+          columns_dirty = TRUE;
+          need_presize = TRUE;
+        }
     }
-  else
+
+  if (columns_dirty)
     {
-      _gtk_rbtree_node_mark_invalid (tree, node);
       for (list = tree_view->priv->columns; list; list = list->next)
         {
           GtkTreeViewColumn *column;
@@ -9023,37 +10186,58 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
     }
 
  done:
-  if (!tree_view->priv->fixed_height_mode &&
-      gtk_widget_get_realized (GTK_WIDGET (tree_view)))
+  if (need_presize && gtk_widget_get_realized (GTK_WIDGET (tree_view)))
     install_presize_handler (tree_view);
   if (free_path)
     gtk_tree_path_free (path);
 }
 
 static void
-gtk_tree_view_row_inserted (GtkTreeModel *model,
-			    GtkTreePath  *path,
-			    GtkTreeIter  *iter,
-			    gpointer      data)
+gtk_tree_view_row_changed (GtkTreeModel *model,
+			   GtkTreePath  *path,
+			   GtkTreeIter  *iter,
+			   gpointer      data)
+{
+  /* Already handled in gtk_tree_view_rows_changed() */
+  if (_gtk_tree_model_is_range_row (model, path))
+    return;
+
+  gtk_tree_view_change_rows (GTK_TREE_VIEW (data), model, path, iter, 1);
+}
+
+static void
+gtk_tree_view_rows_changed (GtkTreeModel *model,
+                            GtkTreePath  *path,
+                            GtkTreeIter  *iter,
+                            gint          n_rows,
+                            gpointer      data)
+{
+  gtk_tree_view_change_rows (GTK_TREE_VIEW (data), model, path, iter, n_rows);
+}
+
+/* Inserts nodes for @n_rows consecutive rows, starting at @path */
+static void
+gtk_tree_view_insert_rows (GtkTreeView  *tree_view,
+                           GtkTreeModel *model,
+                           GtkTreePath  *path,
+                           GtkTreeIter  *iter,
+                           gint          n_rows)
 {
-  GtkTreeView *tree_view = (GtkTreeView *) data;
   gint *indices;
   GtkRBTree *tree;
   GtkRBNode *tmpnode = NULL;
+  GtkRBNode *first_node = NULL;
+  GtkTreePath *row_path;
+  GtkTreeIter row_iter;
   gint depth;
   gint i = 0;
   gint height;
   gboolean free_path = FALSE;
   gboolean node_visible = TRUE;
+  gboolean need_validation = TRUE;
 
   g_return_if_fail (path != NULL || iter != NULL);
 
-  if (tree_view->priv->fixed_height_mode
-      && tree_view->priv->fixed_height >= 0)
-    height = tree_view->priv->fixed_height;
-  else
-    height = 0;
-
   if (path == NULL)
     {
       path = gtk_tree_model_get_path (model, iter);
@@ -9068,11 +10252,23 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
   tree = tree_view->priv->tree;
 
   /* Update all row-references */
-  gtk_tree_row_reference_inserted (G_OBJECT (data), path);
+  row_path = gtk_tree_path_copy (path);
+  for (i = 0; i < n_rows; i++)
+    {
+      gtk_tree_row_reference_inserted (G_OBJECT (tree_view), row_path);
+      gtk_tree_path_next (row_path);
+    }
+  gtk_tree_path_free (row_path);
+
   depth = gtk_tree_path_get_depth (path);
   indices = gtk_tree_path_get_indices (path);
 
+  /* Keep the search continuing from the same row */
+  if (depth == 1 && tree_view->priv->search_row >= indices[0])
+    tree_view->priv->search_row += n_rows;
+
   /* First, find the parent tree */
+  i = 0;
   while (i < depth - 1)
     {
       if (tree == NULL)
@@ -9097,7 +10293,7 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
 	   * try to catch it anyway, just to be safe, in case the model hasn't.
 	   */
 	  GtkTreePath *tmppath = _gtk_tree_path_new_from_rbtree (tree, tmpnode);
-	  gtk_tree_view_row_has_child_toggled (model, tmppath, NULL, data);
+	  gtk_tree_view_row_has_child_toggled (model, tmppath, NULL, tree_view);
 	  gtk_tree_path_free (tmppath);
           goto done;
 	}
@@ -9112,28 +10308,51 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
       goto done;
     }
 
-  /* ref the node */
-  gtk_tree_model_ref_node (tree_view->priv->model, iter);
-  if (indices[depth - 1] == 0)
-    {
-      tmpnode = _gtk_rbtree_find_count (tree, 1);
-      tmpnode = _gtk_rbtree_insert_before (tree, tmpnode, height, FALSE);
-    }
-  else
+  need_validation = FALSE;
+  row_iter = *iter;
+
+  for (i = 0; i < n_rows; i++)
     {
-      tmpnode = _gtk_rbtree_find_count (tree, indices[depth - 1]);
-      tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
+      if (i > 0 && !gtk_tree_model_iter_next (model, &row_iter))
+        break;
+
+      height = 0;
+      if (tree_view->priv->fixed_height_mode)
+        height = MAX (gtk_tree_view_get_fixed_row_height (tree_view, &row_iter, depth), 0);
+
+      /* ref the node */
+      gtk_tree_model_ref_node (tree_view->priv->model, &row_iter);
+      if (i > 0)
+        tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
+      else if (indices[depth - 1] == 0)
+        {
+          tmpnode = _gtk_rbtree_find_count (tree, 1);
+          tmpnode = _gtk_rbtree_insert_before (tree, tmpnode, height, FALSE);
+        }
+      else
+        {
+          tmpnode = _gtk_rbtree_find_count (tree, indices[depth - 1]);
+          tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
+        }
+
+      if (i == 0)
+        first_node = tmpnode;
+
+      if (height > 0)
+        _gtk_rbtree_node_mark_valid (tree, tmpnode);
+      else
+        need_validation = TRUE;
+
+      _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
     }
 
-  _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
+  node_visible = node_is_visible (tree_view, tree, first_node) ||
+                 node_is_visible (tree_view, tree, tmpnode);
 
  done:
-  if (height > 0)
+  if (!need_validation)
     {
-      if (tree)
-        _gtk_rbtree_node_mark_valid (tree, tmpnode);
-
-      if (node_visible && node_is_visible (tree_view, tree, tmpnode))
+      if (node_visible)
 	gtk_widget_queue_resize (GTK_WIDGET (tree_view));
       else
 	gtk_widget_queue_resize_no_redraw (GTK_WIDGET (tree_view));
@@ -9144,6 +10363,29 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
     gtk_tree_path_free (path);
 }
 
+static void
+gtk_tree_view_row_inserted (GtkTreeModel *model,
+			    GtkTreePath  *path,
+			    GtkTreeIter  *iter,
+			    gpointer      data)
+{
+  /* Already handled in gtk_tree_view_rows_inserted() */
+  if (_gtk_tree_model_is_range_row (model, path))
+    return;
+
+  gtk_tree_view_insert_rows (GTK_TREE_VIEW (data), model, path, iter, 1);
+}
+
+static void
+gtk_tree_view_rows_inserted (GtkTreeModel *model,
+                             GtkTreePath  *path,
+                             GtkTreeIter  *iter,
+                             gint          n_rows,
+                             gpointer      data)
+{
+  gtk_tree_view_insert_rows (GTK_TREE_VIEW (data), model, path, iter, n_rows);
+}
+
 static void
 gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 				     GtkTreePath  *path,
@@ -9263,12 +10505,20 @@ gtk_tree_view_row_deleted (GtkTreeModel *model,
 
   gtk_tree_row_reference_deleted (G_OBJECT (data), path);
 
+  /* Keep the search continuing from the same row, or from the
+   * one before it if that is the one that went away */
+  if (gtk_tree_path_get_depth (path) == 1 &&
+      tree_view->priv->search_row >= gtk_tree_path_get_indices (path)[0])
+    tree_view->priv->search_row--;
+
   if (_gtk_tree_view_find_node (tree_view, path, &tree, &node))
     return;
 
   if (tree == NULL)
     return;
 
+  background_validation_reset (tree_view);
+
   /* check if the selection has been changed */
   _gtk_rbtree_traverse (tree, node, G_POST_ORDER,
                         check_selection_helper, &selection_changed);
@@ -9403,6 +10653,19 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
 				    iter,
 				    new_order);
 
+  if (gtk_tree_path_get_depth (parent) == 0 &&
+      tree_view->priv->search_row >= 0)
+    {
+      gint i;
+
+      for (i = 0; i < len; i++)
+        if (new_order[i] == tree_view->priv->search_row)
+          {
+            tree_view->priv->search_row = i;
+            break;
+          }
+    }
+
   if (_gtk_tree_view_find_node (tree_view,
 				parent,
 				&tree,
@@ -9424,6 +10687,7 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
   /* we need to be unprelighted */
   ensure_unprelighted (tree_view);
 
+  background_validation_reset (tree_view);
   _gtk_rbtree_reorder (tree, new_order, len);
 
   _gtk_tree_view_accessible_reorder (tree_view);
@@ -9569,11 +10833,15 @@ gtk_tree_view_build_tree (GtkTreeView *tree_view,
       gtk_tree_model_ref_node (tree_view->priv->model, iter);
       temp = _gtk_rbtree_insert_after (tree, temp, 0, FALSE);
 
-      if (tree_view->priv->fixed_height > 0)
+      if (tree_view->priv->fixed_height_mode &&
+          GTK_RBNODE_FLAG_SET (temp, GTK_RBNODE_INVALID))
         {
-          if (GTK_RBNODE_FLAG_SET (temp, GTK_RBNODE_INVALID))
+          gint height;
+
+          height = gtk_tree_view_get_fixed_row_height (tree_view, iter, depth);
+          if (height > 0)
 	    {
-              _gtk_rbtree_node_set_height (tree, temp, tree_view->priv->fixed_height);
+              _gtk_rbtree_node_set_height (tree, temp, height);
 	      _gtk_rbtree_node_mark_valid (tree, temp);
 	    }
         }
@@ -11456,9 +12724,15 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_changed,
 					    tree_view);
+      g_signal_handlers_disconnect_by_func (tree_view->priv->model,
+					    gtk_tree_view_rows_changed,
+					    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_inserted,
 					    tree_view);
+      g_signal_handlers_disconnect_by_func (tree_view->priv->model,
+					    gtk_tree_view_rows_inserted,
+					    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_has_child_toggled,
 					    tree_view);
@@ -11492,6 +12766,7 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       tree_view->priv->search_column = -1;
       tree_view->priv->fixed_height_check = 0;
       tree_view->priv->fixed_height = -1;
+      g_array_set_size (tree_view->priv->row_height_classes, 0);
       tree_view->priv->dy = tree_view->priv->top_row_dy = 0;
     }
 
@@ -11523,10 +12798,18 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"row-changed",
 			G_CALLBACK (gtk_tree_view_row_changed),
 			tree_view);
+      g_signal_connect (tree_view->priv->model,
+			"rows-changed",
+			G_CALLBACK (gtk_tree_view_rows_changed),
+			tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-inserted",
 			G_CALLBACK (gtk_tree_view_row_inserted),
 			tree_view);
+      g_signal_connect (tree_view->priv->model,
+			"rows-inserted",
+			G_CALLBACK (gtk_tree_view_rows_inserted),
+			tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-has-child-toggled",
 			G_CALLBACK (gtk_tree_view_row_has_child_toggled),
@@ -11561,6 +12844,8 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 
   gtk_tree_view_real_set_cursor (tree_view, NULL, CURSOR_INVALID);
 
+  gtk_tree_view_update_search_index (tree_view);
+
   g_object_notify_by_pspec (G_OBJECT (tree_view), tree_view_props[PROP_MODEL]);
 
   if (tree_view->priv->selection)
@@ -13024,6 +14309,7 @@ gtk_tree_view_real_collapse_row (GtkTreeView *tree_view,
                                           tree, node,
                                           GTK_CELL_RENDERER_EXPANDED);
 
+  background_validation_reset (tree_view);
   _gtk_rbtree_remove (node->children);
 
   if (cursor_changed)
@@ -14867,9 +16153,88 @@ gtk_tree_view_set_search_column (GtkTreeView *tree_view,
     return;
 
   tree_view->priv->search_column = column;
+  gtk_tree_view_update_search_index (tree_view);
   g_object_notify_by_pspec (G_OBJECT (tree_view), tree_view_props[PROP_SEARCH_COLUMN]);
 }
 
+static void
+gtk_tree_view_update_search_index (GtkTreeView *tree_view)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+
+  g_clear_pointer (&priv->search_index, _gtk_tree_search_index_free);
+  priv->search_row = -1;
+
+  if (priv->search_index_mode == GTK_TREE_VIEW_SEARCH_INDEX_NONE ||
+      priv->model == NULL ||
+      priv->search_column < 0 ||
+      (gtk_tree_model_get_flags (priv->model) & GTK_TREE_MODEL_LIST_ONLY) == 0)
+    return;
+
+  priv->search_index = _gtk_tree_search_index_new (priv->model, priv->search_column,
+                                                   priv->search_index_mode == GTK_TREE_VIEW_SEARCH_INDEX_SUBSTRING);
+}
+
+/**
+ * gtk_tree_view_set_search_index:
+ * @tree_view: a #GtkTreeView
+ * @index: the kind of search index to keep
+ *
+ * Sets what kind of index @tree_view keeps for interactive search.
+ *
+ * Without an index, every search walks the rows of the model and
+ * compares the search column of each one with the search text.
+ * With %GTK_TREE_VIEW_SEARCH_INDEX_PREFIX, the case folded texts of
+ * the search column are collected in idle handlers and sorted in a
+ * worker thread, so rows starting with the search text are found
+ * without looking at the model. %GTK_TREE_VIEW_SEARCH_INDEX_SUBSTRING
+ * collects the texts in the same way, but finds rows that contain the
+ * search text anywhere. Since it sorts every suffix of every text, it
+ * takes memory proportional to the total length of the texts rather
+ * than to the number of rows, and models with more than a few million
+ * characters of text are searched as without an index. The index
+ * follows changes to the model.
+ *
+ * The index is only used for models that are lists, and only with the
+ * default search equal function. Until it has been built, searching
+ * walks the model as usual.
+ *
+ * Since: 3.24
+ */
+void
+gtk_tree_view_set_search_index (GtkTreeView            *tree_view,
+                                GtkTreeViewSearchIndex  index)
+{
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  if (tree_view->priv->search_index_mode == index)
+    return;
+
+  tree_view->priv->search_index_mode = index;
+  gtk_tree_view_update_search_index (tree_view);
+
+  g_object_notify_by_pspec (G_OBJECT (tree_view), tree_view_props[PROP_SEARCH_INDEX]);
+}
+
+/**
+ * gtk_tree_view_get_search_index:
+ * @tree_view: a #GtkTreeView
+ *
+ * Returns the kind of index @tree_view keeps for interactive search.
+ * See gtk_tree_view_set_search_index().
+ *
+ * Returns: the kind of search index
+ *
+ * Since: 3.24
+ */
+GtkTreeViewSearchIndex
+gtk_tree_view_get_search_index (GtkTreeView *tree_view)
+{
+  g_return_val_if_fail (GTK_IS_TREE_VIEW (tree_view), GTK_TREE_VIEW_SEARCH_INDEX_NONE);
+
+  return tree_view->priv->search_index_mode;
+}
+
 /**
  * gtk_tree_view_get_search_equal_func: (skip)
  * @tree_view: A #GtkTreeView
@@ -15379,6 +16744,25 @@ gtk_tree_view_search_move (GtkWidget   *window,
   if (!gtk_tree_model_get_iter_first (model, &iter))
     return TRUE;
 
+  if (gtk_tree_view_search_use_index (tree_view))
+    {
+      gint row;
+
+      row = _gtk_tree_search_index_find (tree_view->priv->search_index, text,
+                                         tree_view->priv->search_row, up);
+      if (row >= 0)
+        {
+          gtk_tree_view_search_select_row (tree_view, selection, row);
+          tree_view->priv->selected_iter += up?(-1):(1);
+          return TRUE;
+        }
+
+      /* return to old row */
+      if (tree_view->priv->search_row >= 0)
+        gtk_tree_view_search_select_row (tree_view, selection, tree_view->priv->search_row);
+      return FALSE;
+    }
+
   ret = gtk_tree_view_search_iter (model, selection, &iter, text,
 				   &count, up?((tree_view->priv->selected_iter) - 1):((tree_view->priv->selected_iter + 1)));
 
@@ -15401,11 +16785,11 @@ gtk_tree_view_search_move (GtkWidget   *window,
 }
 
 static gboolean
-gtk_tree_view_search_equal_func (GtkTreeModel *model,
-				 gint          column,
-				 const gchar  *key,
-				 GtkTreeIter  *iter,
-				 gpointer      search_data)
+gtk_tree_view_search_matches (GtkTreeModel *model,
+                              gint          column,
+                              const gchar  *key,
+                              GtkTreeIter  *iter,
+                              gboolean      substring)
 {
   gboolean retval = TRUE;
   const gchar *str;
@@ -15443,7 +16827,12 @@ gtk_tree_view_search_equal_func (GtkTreeModel *model,
       case_normalized_string = g_utf8_casefold (normalized_string, -1);
       case_normalized_key = g_utf8_casefold (normalized_key, -1);
 
-      if (strncmp (case_normalized_key, case_normalized_string, strlen (case_normalized_key)) == 0)
+      if (substring)
+        {
+          if (strstr (case_normalized_string, case_normalized_key) != NULL)
+            retval = FALSE;
+        }
+      else if (strncmp (case_normalized_key, case_normalized_string, strlen (case_normalized_key)) == 0)
         retval = FALSE;
     }
 
@@ -15456,6 +16845,63 @@ gtk_tree_view_search_equal_func (GtkTreeModel *model,
   return retval;
 }
 
+static gboolean
+gtk_tree_view_search_equal_func (GtkTreeModel *model,
+				 gint          column,
+				 const gchar  *key,
+				 GtkTreeIter  *iter,
+				 gpointer      search_data)
+{
+  return gtk_tree_view_search_matches (model, column, key, iter, FALSE);
+}
+
+/* Whether rows are matched by the default search equal function,
+ * or with a substring search index, by their text containing the key */
+static gboolean
+gtk_tree_view_search_row_matches (GtkTreeView  *tree_view,
+                                  GtkTreeModel *model,
+                                  const gchar  *key,
+                                  GtkTreeIter  *iter)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+
+  if (priv->search_equal_func == gtk_tree_view_search_equal_func)
+    return !gtk_tree_view_search_matches (model, priv->search_column, key, iter,
+                                          priv->search_index_mode == GTK_TREE_VIEW_SEARCH_INDEX_SUBSTRING);
+
+  return !priv->search_equal_func (model, priv->search_column, key, iter, priv->search_user_data);
+}
+
+static gboolean
+gtk_tree_view_search_use_index (GtkTreeView *tree_view)
+{
+  return tree_view->priv->search_index != NULL &&
+         tree_view->priv->search_equal_func == gtk_tree_view_search_equal_func &&
+         _gtk_tree_search_index_is_ready (tree_view->priv->search_index);
+}
+
+static void
+gtk_tree_view_search_select_row (GtkTreeView      *tree_view,
+                                 GtkTreeSelection *selection,
+                                 gint              row)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  path = gtk_tree_path_new_from_indices (row, -1);
+
+  if (gtk_tree_model_get_iter (tree_view->priv->model, &iter, path))
+    {
+      gtk_tree_view_scroll_to_cell (tree_view, path, NULL,
+                                    TRUE, 0.5, 0.0);
+      gtk_tree_selection_select_iter (selection, &iter);
+      gtk_tree_view_real_set_cursor (tree_view, path, CLAMP_NODE);
+      tree_view->priv->search_row = row;
+    }
+
+  gtk_tree_path_free (path);
+}
+
 static gboolean
 gtk_tree_view_search_iter (GtkTreeModel     *model,
 			   GtkTreeSelection *selection,
@@ -15475,7 +16921,7 @@ gtk_tree_view_search_iter (GtkTreeModel     *model,
 
   do
     {
-      if (! tree_view->priv->search_equal_func (model, tree_view->priv->search_column, text, iter, tree_view->priv->search_user_data))
+      if (gtk_tree_view_search_row_matches (tree_view, model, text, iter))
         {
           (*count)++;
           if (*count == n)
@@ -15485,6 +16931,9 @@ gtk_tree_view_search_iter (GtkTreeModel     *model,
               gtk_tree_selection_select_iter (selection, iter);
               gtk_tree_view_real_set_cursor (tree_view, path, CLAMP_NODE);
 
+              if (gtk_tree_path_get_depth (path) == 1)
+                tree_view->priv->search_row = gtk_tree_path_get_indices (path)[0];
+
 	      if (path)
 		gtk_tree_path_free (path);
 
@@ -15599,6 +17048,19 @@ gtk_tree_view_search_init (GtkWidget   *entry,
   if (!gtk_tree_model_get_iter_first (model, &iter))
     return;
 
+  if (gtk_tree_view_search_use_index (tree_view))
+    {
+      gint row;
+
+      row = _gtk_tree_search_index_find (tree_view->priv->search_index, text, -1, FALSE);
+      if (row >= 0)
+        {
+          gtk_tree_view_search_select_row (tree_view, selection, row);
+          tree_view->priv->selected_iter = 1;
+        }
+      return;
+    }
+
   ret = gtk_tree_view_search_iter (model, selection,
 				   &iter, text,
 				   &count, 1);
@@ -15927,7 +17389,53 @@ gtk_tree_view_set_row_separator_func (GtkTreeView                 *tree_view,
   tree_view->priv->row_separator_destroy = destroy;
 
   /* Have the tree recalculate heights */
+  background_validation_reset (tree_view);
+  _gtk_rbtree_mark_invalid (tree_view->priv->tree);
+  gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+}
+
+/**
+ * gtk_tree_view_set_row_height_class_func:
+ * @tree_view: a #GtkTreeView
+ * @func: (allow-none): a #GtkTreeViewRowHeightClassFunc
+ * @data: (allow-none): user data to pass to @func, or %NULL
+ * @destroy: (allow-none): destroy notifier for @data, or %NULL
+ *
+ * Sets the row height class function, which lets fixed height mode
+ * work with rows of different heights. Rows are sorted into a small
+ * number of height classes by @func, and only one row of each class
+ * is measured. All other rows are assumed to have the height of
+ * their class, so the view does not have to validate them.
+ *
+ * The function is only used when #GtkTreeView:fixed-height-mode is
+ * enabled. If it is %NULL, all rows are assumed to have the same
+ * height. This is the default value.
+ *
+ * Since: 3.24
+ **/
+void
+gtk_tree_view_set_row_height_class_func (GtkTreeView                   *tree_view,
+                                         GtkTreeViewRowHeightClassFunc  func,
+                                         gpointer                       data,
+                                         GDestroyNotify                 destroy)
+{
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  if (tree_view->priv->row_height_class_destroy)
+    tree_view->priv->row_height_class_destroy (tree_view->priv->row_height_class_data);
+
+  tree_view->priv->row_height_class_func = func;
+  tree_view->priv->row_height_class_data = data;
+  tree_view->priv->row_height_class_destroy = destroy;
+
+  if (!tree_view->priv->fixed_height_mode)
+    return;
+
+  /* Have the tree recalculate heights */
+  tree_view->priv->fixed_height = -1;
+  g_array_set_size (tree_view->priv->row_height_classes, 0);
   _gtk_rbtree_mark_invalid (tree_view->priv->tree);
+  install_presize_handler (tree_view);
   gtk_widget_queue_resize (GTK_WIDGET (tree_view));
 }
 
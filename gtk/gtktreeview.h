@@ -51,6 +51,24 @@ typedef enum
   GTK_TREE_VIEW_DROP_INTO_OR_AFTER
 } GtkTreeViewDropPosition;
 
+/**
+ * GtkTreeViewSearchIndex:
+ * @GTK_TREE_VIEW_SEARCH_INDEX_NONE: no index, searching walks the model
+ * @GTK_TREE_VIEW_SEARCH_INDEX_PREFIX: index finding rows that start with the search text
+ * @GTK_TREE_VIEW_SEARCH_INDEX_SUBSTRING: index finding rows that contain the search text
+ *
+ * The kind of index a #GtkTreeView keeps for interactive search.
+ * See gtk_tree_view_set_search_index().
+ *
+ * Since: 3.24
+ */
+typedef enum
+{
+  GTK_TREE_VIEW_SEARCH_INDEX_NONE,
+  GTK_TREE_VIEW_SEARCH_INDEX_PREFIX,
+  GTK_TREE_VIEW_SEARCH_INDEX_SUBSTRING
+} GtkTreeViewSearchIndex;
+
 #define GTK_TYPE_TREE_VIEW		(gtk_tree_view_get_type ())
 #define GTK_TREE_VIEW(obj)		(G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_TYPE_TREE_VIEW, GtkTreeView))
 #define GTK_TREE_VIEW_CLASS(klass)	(G_TYPE_CHECK_CLASS_CAST ((klass), GTK_TYPE_TREE_VIEW, GtkTreeViewClass))
@@ -196,6 +214,29 @@ typedef gboolean (*GtkTreeViewSearchEqualFunc) (GtkTreeModel            *model,
 typedef gboolean (*GtkTreeViewRowSeparatorFunc) (GtkTreeModel      *model,
 						 GtkTreeIter       *iter,
 						 gpointer           data);
+/**
+ * GtkTreeViewRowHeightClassFunc:
+ * @model: the #GtkTreeModel
+ * @iter: a #GtkTreeIter pointing at a row in @model
+ * @depth: the depth of the row, 1 for toplevel rows
+ * @data: (closure): user data
+ *
+ * Function type for sorting rows into height classes for fixed height
+ * mode. All rows that are put into the same class must have the same
+ * height. Classes are numbered from 0 and should be kept small, as
+ * one row of each class is measured.
+ *
+ * A common way to implement this is to return @depth - 1 for trees
+ * whose rows only differ in height from level to level.
+ *
+ * Returns: the height class of the row
+ *
+ * Since: 3.24
+ */
+typedef gint     (*GtkTreeViewRowHeightClassFunc) (GtkTreeModel      *model,
+                                                   GtkTreeIter       *iter,
+                                                   gint               depth,
+                                                   gpointer           data);
 typedef void     (*GtkTreeViewSearchPositionFunc) (GtkTreeView  *tree_view,
 						   GtkWidget    *search_dialog,
 						   gpointer      user_data);
@@ -445,6 +486,11 @@ gint                       gtk_tree_view_get_search_column     (GtkTreeView
 GDK_AVAILABLE_IN_ALL
 void                       gtk_tree_view_set_search_column     (GtkTreeView                *tree_view,
 								gint                        column);
+GDK_AVAILABLE_IN_3_24
+void                       gtk_tree_view_set_search_index      (GtkTreeView                *tree_view,
+								GtkTreeViewSearchIndex      index);
+GDK_AVAILABLE_IN_3_24
+GtkTreeViewSearchIndex     gtk_tree_view_get_search_index      (GtkTreeView                *tree_view);
 GDK_AVAILABLE_IN_ALL
 GtkTreeViewSearchEqualFunc gtk_tree_view_get_search_equal_func (GtkTreeView                *tree_view);
 GDK_AVAILABLE_IN_ALL
@@ -521,6 +567,11 @@ void     gtk_tree_view_set_fixed_height_mode (GtkTreeView          *tree_view,
 					      gboolean              enable);
 GDK_AVAILABLE_IN_ALL
 gboolean gtk_tree_view_get_fixed_height_mode (GtkTreeView          *tree_view);
+GDK_AVAILABLE_IN_3_24
+void     gtk_tree_view_set_background_validation (GtkTreeView      *tree_view,
+                                                  gboolean          enable);
+GDK_AVAILABLE_IN_3_24
+gboolean gtk_tree_view_get_background_validation (GtkTreeView      *tree_view);
 GDK_AVAILABLE_IN_ALL
 void     gtk_tree_view_set_hover_selection   (GtkTreeView          *tree_view,
 					      gboolean              hover);
@@ -547,6 +598,11 @@ void                        gtk_tree_view_set_row_separator_func (GtkTreeView
 								  GtkTreeViewRowSeparatorFunc func,
 								  gpointer                    data,
 								  GDestroyNotify              destroy);
+GDK_AVAILABLE_IN_3_24
+void                        gtk_tree_view_set_row_height_class_func (GtkTreeView                   *tree_view,
+                                                                     GtkTreeViewRowHeightClassFunc  func,
+                                                                     gpointer                       data,
+                                                                     GDestroyNotify                 destroy);
 
 GDK_AVAILABLE_IN_ALL
 GtkTreeViewGridLines        gtk_tree_view_get_grid_lines         (GtkTreeView                *tree_view);
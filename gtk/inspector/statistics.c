@@ -27,6 +27,11 @@
 #include "gtkcelllayout.h"
 #include "gtksearchbar.h"
 #include "gtklabel.h"
+#include "gtkcssnodeprivate.h"
+#include "gtkcssselectorprivate.h"
+#include "gtksizerequestcacheprivate.h"
+#include "gtkcellareaprivate.h"
+#include "gtkcellrenderertextprivate.h"
 
 enum
 {
@@ -54,6 +59,14 @@ struct _GtkInspectorStatisticsPrivate
   guint update_source_id;
   GtkWidget *search_entry;
   GtkWidget *search_bar;
+  GtkWidget *css_styles;
+  GtkWidget *css_selectors;
+  guint css_update_source_id;
+  GtkWidget *size_requests;
+  GtkListStore *size_request_model;
+  GHashTable *size_request_iters;
+  GtkWidget *cell_attributes;
+  GtkWidget *text_layouts;
 };
 
 typedef struct {
@@ -63,6 +76,14 @@ typedef struct {
   GtkGraphData *cumulative;
 } TypeData;
 
+enum
+{
+  SIZE_REQUEST_COLUMN_TYPE_NAME,
+  SIZE_REQUEST_COLUMN_HITS,
+  SIZE_REQUEST_COLUMN_MISSES,
+  SIZE_REQUEST_COLUMN_EVICTIONS
+};
+
 enum
 {
   COLUMN_TYPE,
@@ -333,6 +354,144 @@ hierarchy_changed (GtkWidget *widget,
                     G_CALLBACK (key_press_event), widget);
 }
 
+static gboolean
+update_css_statistics (gpointer data)
+{
+  GtkInspectorStatistics *sl = data;
+  guint64 n_lookups, n_cache_hits, n_shared;
+  guint64 n_rejected, n_matches;
+  gchar *text;
+
+  gtk_css_node_get_style_statistics (&n_lookups, &n_cache_hits, &n_shared);
+  _gtk_css_selector_tree_get_match_statistics (&n_rejected, &n_matches);
+
+  text = g_strdup_printf (_("Styles: %" G_GUINT64_FORMAT " computed, %.1f%% cached, %.1f%% shared"),
+                          n_lookups,
+                          n_lookups ? 100.0 * n_cache_hits / n_lookups : 0.0,
+                          n_lookups ? 100.0 * n_shared / n_lookups : 0.0);
+  gtk_label_set_text (GTK_LABEL (sl->priv->css_styles), text);
+  g_free (text);
+
+  text = g_strdup_printf (_("Selectors: %" G_GUINT64_FORMAT " matched, %" G_GUINT64_FORMAT " rejected by ancestor filter"),
+                          n_matches, n_rejected);
+  gtk_label_set_text (GTK_LABEL (sl->priv->css_selectors), text);
+  g_free (text);
+
+  return TRUE;
+}
+
+static void
+update_size_request_statistics (GtkInspectorStatistics *sl)
+{
+  guint64 n_hits, n_misses, n_evictions;
+  guint n_extra;
+  GList *stats, *l;
+  gchar *text;
+
+  _gtk_size_request_cache_get_totals (&n_hits, &n_misses, &n_evictions, &n_extra);
+
+  text = g_strdup_printf (_("Size requests: %.1f%% cached, %" G_GUINT64_FORMAT " evictions, %u extra slots"),
+                          n_hits + n_misses ? 100.0 * n_hits / (n_hits + n_misses) : 0.0,
+                          n_evictions, n_extra);
+  gtk_label_set_text (GTK_LABEL (sl->priv->size_requests), text);
+  g_free (text);
+
+  stats = _gtk_size_request_cache_get_statistics ();
+  for (l = stats; l; l = l->next)
+    {
+      SizeRequestCacheStats *type_stats = l->data;
+      GtkTreeIter *iter;
+
+      iter = g_hash_table_lookup (sl->priv->size_request_iters, GSIZE_TO_POINTER (type_stats->type));
+      if (iter == NULL)
+        {
+          iter = g_new (GtkTreeIter, 1);
+          gtk_list_store_insert_with_values (sl->priv->size_request_model, iter, -1,
+                                             SIZE_REQUEST_COLUMN_TYPE_NAME, g_type_name (type_stats->type),
+                                             -1);
+          g_hash_table_insert (sl->priv->size_request_iters, GSIZE_TO_POINTER (type_stats->type), iter);
+        }
+
+      gtk_list_store_set (sl->priv->size_request_model, iter,
+                          SIZE_REQUEST_COLUMN_HITS, type_stats->n_hits,
+                          SIZE_REQUEST_COLUMN_MISSES, type_stats->n_misses,
+                          SIZE_REQUEST_COLUMN_EVICTIONS, type_stats->n_evictions,
+                          -1);
+    }
+  g_list_free (stats);
+}
+
+static void
+update_cell_attribute_statistics (GtkInspectorStatistics *sl)
+{
+  guint64 n_direct, n_properties;
+  gchar *text;
+
+  _gtk_cell_area_get_attribute_statistics (&n_direct, &n_properties);
+
+  text = g_strdup_printf (_("Cell attributes: %" G_GUINT64_FORMAT " property sets, %" G_GUINT64_FORMAT " avoided"),
+                          n_properties, n_direct);
+  gtk_label_set_text (GTK_LABEL (sl->priv->cell_attributes), text);
+  g_free (text);
+}
+
+static void
+update_text_layout_statistics (GtkInspectorStatistics *sl)
+{
+  guint64 n_hits, n_misses, n_evictions;
+  gsize n_bytes;
+  gchar *size, *text;
+
+  _gtk_cell_renderer_text_get_layout_cache_statistics (&n_hits, &n_misses, &n_evictions, &n_bytes);
+
+  size = g_format_size (n_bytes);
+  text = g_strdup_printf (_("Cell layouts: %.1f%% cached, %" G_GUINT64_FORMAT " evictions, %s"),
+                          n_hits + n_misses ? 100.0 * n_hits / (n_hits + n_misses) : 0.0,
+                          n_evictions, size);
+  gtk_label_set_text (GTK_LABEL (sl->priv->text_layouts), text);
+  g_free (text);
+  g_free (size);
+}
+
+static gboolean
+update_statistics (gpointer data)
+{
+  GtkInspectorStatistics *sl = data;
+
+  update_css_statistics (sl);
+  update_size_request_statistics (sl);
+  update_cell_attribute_statistics (sl);
+  update_text_layout_statistics (sl);
+
+  return TRUE;
+}
+
+static void
+map (GtkWidget *widget)
+{
+  GtkInspectorStatistics *sl = GTK_INSPECTOR_STATISTICS (widget);
+
+  GTK_WIDGET_CLASS (gtk_inspector_statistics_parent_class)->map (widget);
+
+  _gtk_size_request_cache_set_collect_statistics (TRUE);
+
+  sl->priv->css_update_source_id = gdk_threads_add_timeout_seconds (1, update_statistics, sl);
+  update_statistics (sl);
+}
+
+static void
+unmap (GtkWidget *widget)
+{
+  GtkInspectorStatistics *sl = GTK_INSPECTOR_STATISTICS (widget);
+
+  g_source_remove (sl->priv->css_update_source_id);
+  sl->priv->css_update_source_id = 0;
+
+  _gtk_size_request_cache_set_collect_statistics (FALSE);
+
+  GTK_WIDGET_CLASS (gtk_inspector_statistics_parent_class)->unmap (widget);
+}
+
 static void
 gtk_inspector_statistics_init (GtkInspectorStatistics *sl)
 {
@@ -355,6 +514,7 @@ gtk_inspector_statistics_init (GtkInspectorStatistics *sl)
                                       cell_data_delta,
                                       GINT_TO_POINTER (COLUMN_CUMULATIVE2), NULL);
   sl->priv->counts = g_hash_table_new_full (NULL, NULL, NULL, type_data_free);
+  sl->priv->size_request_iters = g_hash_table_new_full (NULL, NULL, NULL, g_free);
 
   gtk_tree_view_set_search_entry (sl->priv->view, GTK_ENTRY (sl->priv->search_entry));
   gtk_tree_view_set_search_equal_func (sl->priv->view, match_row, sl, NULL);
@@ -389,6 +549,7 @@ finalize (GObject *object)
     g_source_remove (sl->priv->update_source_id);
 
   g_hash_table_unref (sl->priv->counts);
+  g_hash_table_unref (sl->priv->size_request_iters);
 
   G_OBJECT_CLASS (gtk_inspector_statistics_parent_class)->finalize (object);
 }
@@ -444,6 +605,9 @@ gtk_inspector_statistics_class_init (GtkInspectorStatisticsClass *klass)
   object_class->constructed = constructed;
   object_class->finalize = finalize;
 
+  widget_class->map = map;
+  widget_class->unmap = unmap;
+
   g_object_class_install_property (object_class, PROP_BUTTON,
       g_param_spec_object ("button", NULL, NULL,
                            GTK_TYPE_WIDGET, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
@@ -462,7 +626,13 @@ gtk_inspector_statistics_class_init (GtkInspectorStatisticsClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, renderer_cumulative2);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_entry);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_bar);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, size_requests);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, size_request_model);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, cell_attributes);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, text_layouts);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, excuse);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, css_styles);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, css_selectors);
 
 }
 
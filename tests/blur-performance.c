@@ -1,5 +1,6 @@
 /* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
 
+#include <string.h>
 #include <gtk/gtkcairoblurprivate.h>
 
 static void
@@ -16,15 +17,59 @@ init_surface (cairo_t *cr)
   cairo_fill (cr);
 }
 
+static double
+time_blur (cairo_t         *cr,
+           cairo_surface_t *surface,
+           GTimer          *timer,
+           int              radius)
+{
+  init_surface (cr);
+  cairo_surface_flush (surface);
+  g_timer_start (timer);
+  _gtk_cairo_blur_surface (surface, radius, GTK_BLUR_X | GTK_BLUR_Y);
+  return g_timer_elapsed (timer, NULL);
+}
+
+/* Checks that the vectorized code, if any, produces exactly
+ * the same result as the scalar code */
+static gboolean
+check_blur (cairo_t         *cr,
+            cairo_surface_t *surface,
+            int              radius)
+{
+  guchar *expected;
+  gsize size;
+  gboolean result;
+
+  size = cairo_image_surface_get_stride (surface) * cairo_image_surface_get_height (surface);
+
+  _gtk_cairo_blur_set_simd_enabled (FALSE);
+  init_surface (cr);
+  _gtk_cairo_blur_surface (surface, radius, GTK_BLUR_X | GTK_BLUR_Y);
+  cairo_surface_flush (surface);
+  expected = g_memdup (cairo_image_surface_get_data (surface), size);
+
+  _gtk_cairo_blur_set_simd_enabled (TRUE);
+  init_surface (cr);
+  _gtk_cairo_blur_surface (surface, radius, GTK_BLUR_X | GTK_BLUR_Y);
+  cairo_surface_flush (surface);
+  result = memcmp (expected, cairo_image_surface_get_data (surface), size) == 0;
+
+  g_free (expected);
+
+  return result;
+}
+
 int
 main (int argc, char **argv)
 {
   cairo_surface_t *surface;
   cairo_t *cr;
   GTimer *timer;
-  double msec;
+  double scalar_sec, simd_sec;
   int i, j;
   int size;
+  int failures = 0;
 
   timer = g_timer_new ();
 
@@ -34,21 +79,39 @@ main (int argc, char **argv)
 
   cr = cairo_create (surface);
 
+  g_print ("Using %s implementation\n", _gtk_cairo_blur_get_implementation ());
+
   /* We do everything three times, first two as warmup */
   for (j = 0; j < 2; j++)
     {
       for (i = 1; i < 16; i++)
 	{
-	  init_surface (cr);
-	  g_timer_start (timer);
-	  _gtk_cairo_blur_surface (surface, i, GTK_BLUR_X | GTK_BLUR_Y);
-	  msec = g_timer_elapsed (timer, NULL) * 1000;
+	  _gtk_cairo_blur_set_simd_enabled (FALSE);
+	  scalar_sec = time_blur (cr, surface, timer, i);
+	  _gtk_cairo_blur_set_simd_enabled (TRUE);
+	  simd_sec = time_blur (cr, surface, timer, i);
+
 	  if (j == 1)
-	    g_print ("Radius %2d: %.2f msec, %.2f kpixels/msec:\n", i, msec, size*size/(msec*1000));
+	    g_print ("Radius %2d: scalar %.2f msec, %.1f Mpixels/s; %s %.2f msec, %.1f Mpixels/s\n",
+	             i,
+	             scalar_sec * 1000, size * size / (scalar_sec * 1000000),
+	             _gtk_cairo_blur_get_implementation (),
+	             simd_sec * 1000, size * size / (simd_sec * 1000000));
 	}
     }
 
+  for (i = 1; i < 64; i++)
+    {
+      if (!check_blur (cr, surface, i))
+        {
+          g_print ("Radius %2d: result differs from scalar implementation\n", i);
+          failures++;
+        }
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
   g_timer_destroy (timer);
 
-  return 0;
+  return failures ? 1 : 0;
 }
@@ -816,6 +816,63 @@ test_completion_subclass3 (void)
   g_test_trap_assert_stderr ("*ignoring construct property*");
 }
 
+static gint
+get_text_width (GtkCellRenderer *cell,
+                GtkWidget       *widget)
+{
+  gint width;
+
+  gtk_cell_renderer_get_preferred_width (cell, widget, NULL, &width);
+
+  return width;
+}
+
+/* test that text renderers sharing a widget don't get each other's
+ * cached layouts, and that changes to the renderer are picked up */
+static void
+test_text_layout_cache (void)
+{
+  GtkWidget *widget;
+  GtkCellRenderer *cell1, *cell2;
+  PangoAttrList *attrs;
+  gint narrow, wide;
+
+  widget = gtk_label_new (NULL);
+  g_object_ref_sink (widget);
+  cell1 = g_object_ref_sink (gtk_cell_renderer_text_new ());
+  cell2 = g_object_ref_sink (gtk_cell_renderer_text_new ());
+
+  g_object_set (cell1, "text", "x", NULL);
+  g_object_set (cell2, "text", "xxxxxxxxxx", NULL);
+  narrow = get_text_width (cell1, widget);
+  wide = get_text_width (cell2, widget);
+  g_assert_cmpint (narrow, <, wide);
+
+  /* The same text in another renderer gives the same layout */
+  g_object_set (cell2, "text", "x", NULL);
+  g_assert_cmpint (get_text_width (cell2, widget), ==, narrow);
+  g_assert_cmpint (get_text_width (cell1, widget), ==, narrow);
+
+  g_object_set (cell2, "scale", 4.0, NULL);
+  g_assert_cmpint (get_text_width (cell2, widget), >, narrow);
+  g_assert_cmpint (get_text_width (cell1, widget), ==, narrow);
+
+  attrs = pango_attr_list_new ();
+  pango_attr_list_insert (attrs, pango_attr_scale_new (4.0));
+  g_object_set (cell1, "attributes", attrs, NULL);
+  g_assert_cmpint (get_text_width (cell1, widget), >, narrow);
+  pango_attr_list_unref (attrs);
+
+  g_object_set (cell1, "markup", "<big>x</big>", NULL);
+  g_assert_cmpint (get_text_width (cell1, widget), >, narrow);
+  g_object_set (cell1, "text", "x", "attributes", NULL, NULL);
+  g_assert_cmpint (get_text_width (cell1, widget), ==, narrow);
+
+  g_object_unref (cell1);
+  g_object_unref (cell2);
+  g_object_unref (widget);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -868,5 +925,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/tests/completion-subclass3", test_completion_subclass3);
   g_test_add_func ("/tests/completion-subclass3/subprocess", test_completion_subclass3_subprocess);
 
+  g_test_add_func ("/tests/text-layout-cache", test_text_layout_cache);
+
   return g_test_run();
 }
@@ -0,0 +1,347 @@
+/* GtkColumnStore tests.
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "treemodel.h"
+
+enum
+{
+  COLUMN_BOOLEAN,
+  COLUMN_INT,
+  COLUMN_DOUBLE,
+  COLUMN_FLOAT,
+  COLUMN_STRING,
+  COLUMN_OBJECT,
+  N_COLUMNS
+};
+
+static GtkColumnStore *
+create_column_store (void)
+{
+  return gtk_column_store_new (N_COLUMNS,
+                               G_TYPE_BOOLEAN,
+                               G_TYPE_INT,
+                               G_TYPE_DOUBLE,
+                               G_TYPE_FLOAT,
+                               G_TYPE_STRING,
+                               G_TYPE_OBJECT);
+}
+
+static void
+check_row (GtkColumnStore *store,
+           gint            n,
+           gint            value)
+{
+  GtkTreeIter iter;
+  gchar *str, *expected;
+  gint int_value;
+  gfloat float_value;
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, n));
+  g_assert (gtk_column_store_iter_is_valid (store, &iter));
+
+  expected = g_strdup_printf ("row %d", value);
+
+  /* The typed accessors and the GtkTreeModel API have to agree */
+  g_assert_cmpint (gtk_column_store_get_int (store, &iter, COLUMN_INT), ==, value);
+  g_assert_cmpstr (gtk_column_store_get_string (store, &iter, COLUMN_STRING), ==, expected);
+  g_assert_cmpfloat (gtk_column_store_get_double (store, &iter, COLUMN_DOUBLE), ==, value / 2.0);
+  g_assert_cmpfloat (gtk_column_store_get_float (store, &iter, COLUMN_FLOAT), ==, value / 4.0f);
+  g_assert_cmpfloat (gtk_column_store_get_double (store, &iter, COLUMN_FLOAT), ==, value / 4.0f);
+  g_assert (gtk_column_store_get_boolean (store, &iter, COLUMN_BOOLEAN) == (value % 2));
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                      COLUMN_INT, &int_value,
+                      COLUMN_FLOAT, &float_value,
+                      COLUMN_STRING, &str,
+                      -1);
+  g_assert_cmpint (int_value, ==, value);
+  g_assert_cmpfloat (float_value, ==, value / 4.0f);
+  g_assert_cmpstr (str, ==, expected);
+
+  g_free (str);
+  g_free (expected);
+}
+
+static void
+column_store_insert (GtkColumnStore *store,
+                     gint            position,
+                     gint            value)
+{
+  gchar *str;
+
+  str = g_strdup_printf ("row %d", value);
+  gtk_column_store_insert_with_values (store, NULL, position,
+                                       COLUMN_BOOLEAN, value % 2,
+                                       COLUMN_INT, value,
+                                       COLUMN_DOUBLE, value / 2.0,
+                                       COLUMN_FLOAT, value / 4.0,
+                                       COLUMN_STRING, str,
+                                       -1);
+  g_free (str);
+}
+
+static void
+column_store_test_insert (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  gint i;
+
+  store = create_column_store ();
+
+  for (i = 0; i < 100; i++)
+    column_store_insert (store, -1, i * 2);
+  /* Fill the gaps from the back, moving the rows after them */
+  for (i = 99; i >= 0; i--)
+    column_store_insert (store, i + 1, i * 2 + 1);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 200);
+  for (i = 0; i < 200; i++)
+    check_row (store, i, i);
+
+  /* New rows start out zeroed */
+  gtk_column_store_insert (store, &iter, 0);
+  g_assert_cmpint (gtk_column_store_get_int (store, &iter, COLUMN_INT), ==, 0);
+  g_assert_cmpstr (gtk_column_store_get_string (store, &iter, COLUMN_STRING), ==, NULL);
+  g_assert (gtk_column_store_get_object (store, &iter, COLUMN_OBJECT) == NULL);
+
+  g_object_unref (store);
+}
+
+static void
+column_store_test_remove (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  gint i;
+
+  store = create_column_store ();
+
+  for (i = 0; i < 10; i++)
+    column_store_insert (store, -1, i);
+
+  /* Removing sets the iter to the next row */
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 0));
+  g_assert (gtk_column_store_remove (store, &iter));
+  g_assert_cmpint (gtk_column_store_get_int (store, &iter, COLUMN_INT), ==, 1);
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 4));
+  g_assert (gtk_column_store_remove (store, &iter));
+  g_assert_cmpint (gtk_column_store_get_int (store, &iter, COLUMN_INT), ==, 6);
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 7));
+  g_assert (!gtk_column_store_remove (store, &iter));
+  g_assert (!gtk_column_store_iter_is_valid (store, &iter));
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 7);
+  check_row (store, 0, 1);
+  check_row (store, 3, 4);
+  check_row (store, 4, 6);
+  check_row (store, 6, 8);
+
+  g_object_unref (store);
+}
+
+static void
+rows_deleted_cb (GtkTreeModel *model,
+                 GtkTreePath  *path,
+                 gint          n_rows,
+                 gpointer      user_data)
+{
+  *(gint *) user_data += n_rows;
+}
+
+static void
+column_store_test_clear (void)
+{
+  GtkColumnStore *store;
+  SignalMonitor *monitor;
+  gint i, n_deleted = 0;
+
+  store = create_column_store ();
+
+  for (i = 0; i < 5; i++)
+    column_store_insert (store, -1, i);
+
+  g_signal_connect (store, "rows-deleted",
+                    G_CALLBACK (rows_deleted_cb), &n_deleted);
+
+  /* Handlers of row-deleted still see every row go */
+  monitor = signal_monitor_new (GTK_TREE_MODEL (store));
+  for (i = 0; i < 5; i++)
+    signal_monitor_append_signal (monitor, ROW_DELETED, "0");
+
+  gtk_column_store_clear (store);
+
+  signal_monitor_assert_is_empty (monitor);
+  signal_monitor_free (monitor);
+
+  g_assert_cmpint (n_deleted, ==, 5);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 0);
+
+  g_object_unref (store);
+}
+
+static void
+column_store_test_strings (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter1, iter2;
+
+  store = create_column_store ();
+
+  gtk_column_store_insert_with_values (store, &iter1, -1,
+                                       COLUMN_STRING, "shared", -1);
+  gtk_column_store_insert_with_values (store, &iter2, -1,
+                                       COLUMN_STRING, "shared", -1);
+
+  /* Equal strings are only stored once */
+  g_assert (gtk_column_store_get_string (store, &iter1, COLUMN_STRING) ==
+            gtk_column_store_get_string (store, &iter2, COLUMN_STRING));
+
+  /* ... and stay around while a row still uses them */
+  gtk_column_store_set (store, &iter1, COLUMN_STRING, "other", -1);
+  g_assert_cmpstr (gtk_column_store_get_string (store, &iter2, COLUMN_STRING), ==, "shared");
+  gtk_column_store_set (store, &iter2, COLUMN_STRING, "shared", -1);
+  g_assert_cmpstr (gtk_column_store_get_string (store, &iter2, COLUMN_STRING), ==, "shared");
+  gtk_column_store_set (store, &iter2, COLUMN_STRING, NULL, -1);
+  g_assert_cmpstr (gtk_column_store_get_string (store, &iter2, COLUMN_STRING), ==, NULL);
+
+  g_object_unref (store);
+}
+
+static void
+column_store_test_object (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  GObject *object, *value;
+
+  store = create_column_store ();
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+  g_object_add_weak_pointer (object, (gpointer *) &object);
+
+  gtk_column_store_insert_with_values (store, &iter, -1,
+                                       COLUMN_OBJECT, object, -1);
+  g_object_unref (object);
+  g_assert (object != NULL);
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                      COLUMN_OBJECT, &value, -1);
+  g_assert (value == object);
+  g_assert (gtk_column_store_get_object (store, &iter, COLUMN_OBJECT) == object);
+  g_object_unref (value);
+
+  gtk_column_store_remove (store, &iter);
+  g_assert (object == NULL);
+
+  g_object_unref (store);
+}
+
+static void
+notify_cb (GObject    *object,
+           GParamSpec *pspec,
+           gpointer    user_data)
+{
+  (*(gint *) user_data)++;
+}
+
+static void
+column_store_test_apply_attributes (void)
+{
+  GtkColumnStore *store;
+  GtkCellArea *area;
+  GtkCellRenderer *text, *toggle, *progress;
+  GtkTreeIter iter1, iter2;
+  gchar *str;
+  gboolean active;
+  gint value, n_notifies = 0, n_toggle_notifies = 0;
+
+  store = create_column_store ();
+  column_store_insert (store, -1, 1);
+  column_store_insert (store, -1, 2);
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter1, NULL, 0));
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter2, NULL, 1));
+
+  area = gtk_cell_area_box_new ();
+  g_object_ref_sink (area);
+
+  text = gtk_cell_renderer_text_new ();
+  toggle = gtk_cell_renderer_toggle_new ();
+  progress = gtk_cell_renderer_progress_new ();
+  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (area), text, TRUE);
+  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (area), toggle, FALSE);
+  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (area), progress, FALSE);
+  gtk_cell_layout_set_attributes (GTK_CELL_LAYOUT (area), text,
+                                  "text", COLUMN_STRING, NULL);
+  gtk_cell_layout_set_attributes (GTK_CELL_LAYOUT (area), toggle,
+                                  "active", COLUMN_BOOLEAN, NULL);
+  gtk_cell_layout_set_attributes (GTK_CELL_LAYOUT (area), progress,
+                                  "value", COLUMN_INT, NULL);
+
+  /* Typed columns are set without going through the properties,
+   * but the renderers have to end up in the same state */
+  gtk_cell_area_apply_attributes (area, GTK_TREE_MODEL (store), &iter1, FALSE, FALSE);
+  g_object_get (text, "text", &str, NULL);
+  g_object_get (toggle, "active", &active, NULL);
+  g_object_get (progress, "value", &value, NULL);
+  g_assert_cmpstr (str, ==, "row 1");
+  g_assert (active);
+  g_assert_cmpint (value, ==, 1);
+  g_free (str);
+
+  /* Listeners still get notified */
+  g_signal_connect (text, "notify::text", G_CALLBACK (notify_cb), &n_notifies);
+  gtk_cell_area_apply_attributes (area, GTK_TREE_MODEL (store), &iter2, FALSE, FALSE);
+  g_assert_cmpint (n_notifies, ==, 1);
+  g_object_get (text, "text", &str, NULL);
+  g_object_get (toggle, "active", &active, NULL);
+  g_object_get (progress, "value", &value, NULL);
+  g_assert_cmpstr (str, ==, "row 2");
+  g_assert (!active);
+  g_assert_cmpint (value, ==, 2);
+  g_free (str);
+
+  /* So do listeners for all properties */
+  g_signal_connect (toggle, "notify", G_CALLBACK (notify_cb), &n_toggle_notifies);
+  gtk_cell_area_apply_attributes (area, GTK_TREE_MODEL (store), &iter1, FALSE, FALSE);
+  g_assert_cmpint (n_toggle_notifies, ==, 1);
+  g_object_get (toggle, "active", &active, NULL);
+  g_assert (active);
+
+  g_object_unref (area);
+  g_object_unref (store);
+}
+
+void
+register_column_store_tests (void)
+{
+  g_test_add_func ("/ColumnStore/insert",
+                   column_store_test_insert);
+  g_test_add_func ("/ColumnStore/remove",
+                   column_store_test_remove);
+  g_test_add_func ("/ColumnStore/clear",
+                   column_store_test_clear);
+  g_test_add_func ("/ColumnStore/strings",
+                   column_store_test_strings);
+  g_test_add_func ("/ColumnStore/object",
+                   column_store_test_object);
+  g_test_add_func ("/ColumnStore/apply-attributes",
+                   column_store_test_apply_attributes);
+}
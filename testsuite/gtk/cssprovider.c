@@ -62,6 +62,140 @@ test_section_load_nonexisting_file (void)
   g_object_unref (provider);
 }
 
+static void
+assert_color (GtkWidget  *widget,
+              const char *expected)
+{
+  GdkRGBA color, expected_color;
+
+  gdk_rgba_parse (&expected_color, expected);
+  gtk_style_context_get_color (gtk_widget_get_style_context (widget),
+                               gtk_widget_get_state_flags (widget),
+                               &color);
+
+  g_assert (gdk_rgba_equal (&color, &expected_color));
+}
+
+static void
+test_reload_changed_rules (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *box, *a, *b;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "label.a { color: red; }\n"
+                                   "label.b { color: blue; }",
+                                   -1, NULL);
+
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  a = gtk_label_new ("a");
+  b = gtk_label_new ("b");
+  gtk_container_add (GTK_CONTAINER (box), a);
+  gtk_container_add (GTK_CONTAINER (box), b);
+  gtk_style_context_add_class (gtk_widget_get_style_context (a), "a");
+  gtk_style_context_add_class (gtk_widget_get_style_context (b), "b");
+  gtk_style_context_add_provider (gtk_widget_get_style_context (a),
+                                  GTK_STYLE_PROVIDER (provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_USER);
+  gtk_style_context_add_provider (gtk_widget_get_style_context (b),
+                                  GTK_STYLE_PROVIDER (provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  assert_color (a, "red");
+  assert_color (b, "blue");
+
+  /* change one rule */
+  gtk_css_provider_load_from_data (provider,
+                                   "label.a { color: green; }\n"
+                                   "label.b { color: blue; }",
+                                   -1, NULL);
+  assert_color (a, "green");
+  assert_color (b, "blue");
+
+  /* add a rule that only matches in a different state */
+  gtk_css_provider_load_from_data (provider,
+                                   "label.a { color: green; }\n"
+                                   "label.b { color: blue; }\n"
+                                   "label.b:disabled { color: yellow; }",
+                                   -1, NULL);
+  assert_color (b, "blue");
+  gtk_widget_set_sensitive (b, FALSE);
+  assert_color (b, "yellow");
+  gtk_widget_set_sensitive (b, TRUE);
+
+  /* reorder rules of equal specificity */
+  gtk_css_provider_load_from_data (provider,
+                                   "label.a { color: green; }\n"
+                                   "label { color: black; }\n"
+                                   "label.b { color: blue; }",
+                                   -1, NULL);
+  assert_color (a, "green");
+  gtk_css_provider_load_from_data (provider,
+                                   "label { color: black; }\n"
+                                   "label.b { color: blue; }\n"
+                                   "label.a { color: green; }",
+                                   -1, NULL);
+  assert_color (a, "green");
+  assert_color (b, "blue");
+
+  /* symbolic colors change everything */
+  gtk_css_provider_load_from_data (provider,
+                                   "@define-color fg red;\n"
+                                   "label.a { color: @fg; }",
+                                   -1, NULL);
+  assert_color (a, "red");
+  gtk_css_provider_load_from_data (provider,
+                                   "@define-color fg blue;\n"
+                                   "label.a { color: @fg; }",
+                                   -1, NULL);
+  assert_color (a, "blue");
+
+  g_object_unref (g_object_ref_sink (box));
+  g_object_unref (provider);
+}
+
+static void
+test_reload_style_cache (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *window, *box, *label;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "label.a { color: red; }",
+                                   -1, NULL);
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  gtk_container_add (GTK_CONTAINER (window), box);
+
+  /* Leaves a style for label.a in the box's style cache */
+  label = gtk_label_new ("a");
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), "a");
+  gtk_container_add (GTK_CONTAINER (box), label);
+  assert_color (label, "red");
+  gtk_widget_destroy (label);
+
+  /* Nothing in the box is affected by the reload now */
+  gtk_css_provider_load_from_data (provider,
+                                   "label.a { color: green; }",
+                                   -1, NULL);
+
+  label = gtk_label_new ("a");
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), "a");
+  gtk_container_add (GTK_CONTAINER (box), label);
+  assert_color (label, "green");
+
+  gtk_widget_destroy (window);
+  gtk_style_context_remove_provider_for_screen (gdk_screen_get_default (),
+                                                GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -71,6 +205,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/cssprovider/section-in-load-from-data", test_section_in_load_from_data);
   g_test_add_func ("/cssprovider/section-in-style-property", test_section_in_style_property);
   g_test_add_func ("/cssprovider/load-nonexisting-file", test_section_load_nonexisting_file);
+  g_test_add_func ("/cssprovider/reload-changed-rules", test_reload_changed_rules);
+  g_test_add_func ("/cssprovider/reload-style-cache", test_reload_style_cache);
 
   return g_test_run ();
 }
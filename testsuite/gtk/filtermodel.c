@@ -5551,6 +5551,331 @@ specific_list_store_clear (void)
   gtk_list_store_clear (list);
 }
 
+static gboolean
+specific_refilter_ranges_visible_func (GtkTreeModel *model,
+                                       GtkTreeIter  *iter,
+                                       gpointer      data)
+{
+  gint *threshold = data;
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  return value < *threshold;
+}
+
+static void
+specific_refilter_ranges_count (GtkTreeModel *model,
+                                GtkTreePath  *path,
+                                gint          n_rows,
+                                gpointer      data)
+{
+  gint *count = data;
+
+  (*count)++;
+}
+
+static void
+specific_refilter_ranges (void)
+{
+  GtkTreeIter iter;
+  GtkListStore *list;
+  GtkTreeModel *filter;
+  GtkWidget *view G_GNUC_UNUSED;
+  gint threshold = 100;
+  gint n_inserted = 0, n_deleted = 0;
+  GValue values[10] = { G_VALUE_INIT, };
+  gint column = 0;
+  gint i, value;
+
+  list = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 100; i++)
+    gtk_list_store_insert_with_values (list, NULL, i, 0, i, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (list), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          specific_refilter_ranges_visible_func,
+                                          &threshold, NULL);
+  view = gtk_tree_view_new_with_model (filter);
+
+  g_signal_connect (filter, "rows-inserted",
+                    G_CALLBACK (specific_refilter_ranges_count), &n_inserted);
+  g_signal_connect (filter, "rows-deleted",
+                    G_CALLBACK (specific_refilter_ranges_count), &n_deleted);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 100);
+
+  /* Hiding the tail is a single range */
+  threshold = 40;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  g_assert_cmpint (n_deleted, ==, 1);
+  g_assert_cmpint (n_inserted, ==, 0);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 40);
+
+  /* And so is showing part of it again */
+  threshold = 70;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  g_assert_cmpint (n_deleted, ==, 1);
+  g_assert_cmpint (n_inserted, ==, 1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 70);
+
+  g_assert (gtk_tree_model_iter_nth_child (filter, &iter, NULL, 69));
+  gtk_tree_model_get (filter, &iter, 0, &value, -1);
+  g_assert_cmpint (value, ==, 69);
+
+  /* Changes to a block of child rows */
+  for (i = 0; i < 10; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], -1);
+    }
+  gtk_list_store_set_rows_valuesv (list, 10, 10, &column, values, 1);
+  for (i = 0; i < 10; i++)
+    g_value_unset (&values[i]);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 70);
+  g_assert (gtk_tree_model_iter_nth_child (filter, &iter, NULL, 15));
+  gtk_tree_model_get (filter, &iter, 0, &value, -1);
+  g_assert_cmpint (value, ==, -1);
+
+  g_object_unref (filter);
+  g_object_unref (list);
+}
+
+static gboolean
+specific_concurrent_refilter_visible_func (GtkTreeModel *model,
+                                           GtkTreeIter  *iter,
+                                           gpointer      data)
+{
+  GRegex *regex = *(GRegex **) data;
+  gboolean visible;
+  gchar *text;
+
+  gtk_tree_model_get (model, iter, 0, &text, -1);
+  visible = text && g_regex_match (regex, text, 0, NULL);
+  g_free (text);
+
+  return visible;
+}
+
+static gdouble
+specific_concurrent_refilter_time (GtkTreeModel *filter,
+                                   GRegex      **regex,
+                                   const gchar  *pattern)
+{
+  GRegex *old_regex = *regex;
+  gdouble elapsed;
+
+  *regex = g_regex_new (pattern, G_REGEX_OPTIMIZE, 0, NULL);
+  g_regex_unref (old_regex);
+
+  g_test_timer_start ();
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  elapsed = g_test_timer_elapsed ();
+
+  return elapsed;
+}
+
+static void
+specific_concurrent_refilter (void)
+{
+  guint n = g_test_perf () ? 200000 : 5000;
+  GtkListStore *list;
+  GtkTreeModel *serial, *concurrent;
+  GRegex *serial_regex, *concurrent_regex;
+  GtkWidget *view G_GNUC_UNUSED;
+  GtkWidget *view2 G_GNUC_UNUSED;
+  gdouble serial_sec, concurrent_sec;
+  guint i;
+
+  list = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < n; i++)
+    {
+      gchar *text = g_strdup_printf ("row %u: %x %o", i, i * 7919, i * 31);
+      gtk_list_store_insert_with_values (list, NULL, i, 0, text, -1);
+      g_free (text);
+    }
+
+  /* The regex is read through a pointer, so the visible functions
+   * pick up the new one on refilter
+   */
+  serial_regex = g_regex_new (".", 0, 0, NULL);
+  concurrent_regex = g_regex_new (".", 0, 0, NULL);
+
+  serial = gtk_tree_model_filter_new (GTK_TREE_MODEL (list), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (serial),
+                                          specific_concurrent_refilter_visible_func,
+                                          &serial_regex, NULL);
+  view = gtk_tree_view_new_with_model (serial);
+
+  concurrent = gtk_tree_model_filter_new (GTK_TREE_MODEL (list), NULL);
+  gtk_tree_model_filter_set_visible_func_concurrent (GTK_TREE_MODEL_FILTER (concurrent),
+                                                     specific_concurrent_refilter_visible_func,
+                                                     &concurrent_regex, NULL);
+  view2 = gtk_tree_view_new_with_model (concurrent);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (serial, NULL), ==, n);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (concurrent, NULL), ==, n);
+
+  serial_sec = specific_concurrent_refilter_time (serial, &serial_regex,
+                                                  "^row [0-9]*7: [a-f]+");
+  concurrent_sec = specific_concurrent_refilter_time (concurrent, &concurrent_regex,
+                                                      "^row [0-9]*7: [a-f]+");
+
+  if (g_test_perf ())
+    {
+      g_test_minimized_result (serial_sec, "serial refilter of %u rows: %gsec",
+                               n, serial_sec);
+      g_test_minimized_result (concurrent_sec, "concurrent refilter of %u rows: %gsec",
+                               n, concurrent_sec);
+    }
+
+  /* Both filters must end up with the same rows */
+  g_assert_cmpint (gtk_tree_model_iter_n_children (serial, NULL), ==,
+                   gtk_tree_model_iter_n_children (concurrent, NULL));
+
+  for (i = 0; i < (guint) gtk_tree_model_iter_n_children (serial, NULL); i++)
+    {
+      GtkTreeIter a, b;
+      gchar *text_a, *text_b;
+
+      g_assert (gtk_tree_model_iter_nth_child (serial, &a, NULL, i));
+      g_assert (gtk_tree_model_iter_nth_child (concurrent, &b, NULL, i));
+      gtk_tree_model_get (serial, &a, 0, &text_a, -1);
+      gtk_tree_model_get (concurrent, &b, 0, &text_b, -1);
+      g_assert_cmpstr (text_a, ==, text_b);
+      g_free (text_a);
+      g_free (text_b);
+    }
+
+  g_object_unref (serial);
+  g_object_unref (concurrent);
+  g_object_unref (list);
+  g_regex_unref (serial_regex);
+  g_regex_unref (concurrent_regex);
+}
+
+static gint n_other_thread_calls;
+
+static gboolean
+specific_concurrent_rows_changed_visible_func (GtkTreeModel *model,
+                                               GtkTreeIter  *iter,
+                                               gpointer      data)
+{
+  if (g_thread_self () != data)
+    g_atomic_int_inc (&n_other_thread_calls);
+
+  return TRUE;
+}
+
+static void
+specific_concurrent_rows_changed (void)
+{
+  GtkListStore *list;
+  GtkTreeModel *filter;
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  gint n = 5000;
+  gint i;
+
+  list = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < n; i++)
+    gtk_list_store_insert_with_values (list, NULL, i, 0, i, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (list), NULL);
+  gtk_tree_model_filter_set_visible_func_concurrent (GTK_TREE_MODEL_FILTER (filter),
+                                                     specific_concurrent_rows_changed_visible_func,
+                                                     g_thread_self (), NULL);
+  g_assert (gtk_tree_model_get_iter_first (filter, &iter));
+
+  /* Only refilter() may use the thread pool; ranges of changed rows
+   * are evaluated by the thread that changes the child model
+   */
+  n_other_thread_calls = 0;
+  path = gtk_tree_path_new_first ();
+  g_assert (gtk_tree_model_get_iter (GTK_TREE_MODEL (list), &iter, path));
+  gtk_tree_model_rows_changed (GTK_TREE_MODEL (list), path, &iter, n);
+  gtk_tree_path_free (path);
+  g_assert_cmpint (n_other_thread_calls, ==, 0);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, n);
+
+  g_object_unref (filter);
+  g_object_unref (list);
+}
+
+static void
+specific_insert_rows (void)
+{
+  GtkTreeIter iter;
+  GtkListStore *list;
+  GtkTreeModel *filter;
+  SignalMonitor *monitor;
+  GValue values[8] = { G_VALUE_INIT, };
+  gint columns[2] = { 0, 1 };
+  gint expected[] = { 0, 10, 12, 13, 2 };
+  gboolean visible[] = { TRUE, FALSE, TRUE, TRUE };
+  gint i, value;
+
+  list = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_BOOLEAN);
+  gtk_list_store_insert_with_values (list, NULL, -1, 0, 0, 1, TRUE, -1);
+  gtk_list_store_insert_with_values (list, NULL, -1, 0, 1, 1, FALSE, -1);
+  gtk_list_store_insert_with_values (list, NULL, -1, 0, 2, 1, TRUE, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (list), NULL);
+  gtk_tree_model_filter_set_visible_column (GTK_TREE_MODEL_FILTER (filter), 1);
+
+  /* Build the root level */
+  g_assert (gtk_tree_model_get_iter_first (filter, &iter));
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 2);
+
+  monitor = signal_monitor_new (filter);
+
+  /* The visible rows of the block end up next to each other, so they
+   * are announced as one range and then split up for row-inserted.
+   */
+  signal_monitor_append_rows_inserted (monitor, "1", 3);
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "1");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "2");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "3");
+
+  for (i = 0; i < 4; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 10 + i);
+      g_value_init (&values[4 + i], G_TYPE_BOOLEAN);
+      g_value_set_boolean (&values[4 + i], visible[i]);
+    }
+
+  gtk_list_store_insert_rows_with_valuesv (list, 1, 4, columns, values, 2);
+  signal_monitor_assert_is_empty (monitor);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 5);
+
+  /* A block without visible rows only moves the offsets */
+  for (i = 0; i < 4; i++)
+    g_value_set_boolean (&values[4 + i], FALSE);
+
+  gtk_list_store_insert_rows_with_valuesv (list, 0, 4, columns, values, 2);
+  signal_monitor_assert_is_empty (monitor);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 5);
+
+  for (i = 0; i < G_N_ELEMENTS (expected); i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (filter, &iter, NULL, i));
+      gtk_tree_model_get (filter, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected[i]);
+    }
+
+  for (i = 0; i < 8; i++)
+    g_value_unset (&values[i]);
+
+  signal_monitor_free (monitor);
+  g_object_unref (filter);
+  g_object_unref (list);
+}
+
 static void
 specific_sort_ref_leaf_and_remove_ancestor (void)
 {
@@ -7106,6 +7431,14 @@ register_filter_model_tests (void)
                    specific_filter_add_child);
   g_test_add_func ("/TreeModelFilter/specific/list-store-clear",
                    specific_list_store_clear);
+  g_test_add_func ("/TreeModelFilter/specific/refilter-ranges",
+                   specific_refilter_ranges);
+  g_test_add_func ("/TreeModelFilter/specific/concurrent-refilter",
+                   specific_concurrent_refilter);
+  g_test_add_func ("/TreeModelFilter/specific/concurrent-rows-changed",
+                   specific_concurrent_rows_changed);
+  g_test_add_func ("/TreeModelFilter/specific/insert-rows",
+                   specific_insert_rows);
   g_test_add_func ("/TreeModelFilter/specific/sort-ref-leaf-and-remove-ancestor",
                    specific_sort_ref_leaf_and_remove_ancestor);
   g_test_add_func ("/TreeModelFilter/specific/ref-leaf-and-remove-ancestor",
@@ -0,0 +1,202 @@
+#include <gtk/gtk.h>
+
+#define N_ITEMS 10000
+#define LINE_LENGTH 4
+
+typedef struct {
+  gint n_created;
+  gint n_bound;
+} RecycleData;
+
+static GtkWidget *
+create_widget (gpointer item,
+               gpointer user_data)
+{
+  RecycleData *data = user_data;
+  GtkWidget *label;
+
+  data->n_created++;
+
+  label = gtk_label_new (g_object_get_data (item, "text"));
+  gtk_widget_set_size_request (label, 40, 20);
+
+  return label;
+}
+
+static void
+bind_widget (gpointer   item,
+             GtkWidget *widget,
+             gpointer   user_data)
+{
+  RecycleData *data = user_data;
+
+  data->n_bound++;
+
+  gtk_label_set_text (GTK_LABEL (widget), g_object_get_data (item, "text"));
+}
+
+static GObject *
+create_item (gint i)
+{
+  GObject *item = g_object_new (G_TYPE_OBJECT, NULL);
+
+  g_object_set_data_full (item, "text", g_strdup_printf ("%d", i), g_free);
+
+  return item;
+}
+
+static void
+wait_for_children (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+/* Checks that the children show the items they claim to, and that
+ * they cover whole lines starting at the first one. Returns the
+ * index of the first child.
+ */
+static gint
+check_recycled_children (GtkFlowBox *box,
+                         GListModel *model)
+{
+  GList *children, *l;
+  gint first = -1;
+  gint i = 0;
+
+  children = gtk_container_get_children (GTK_CONTAINER (box));
+  g_assert (children != NULL);
+
+  for (l = children; l; l = l->next)
+    {
+      GtkFlowBoxChild *child = l->data;
+      GtkWidget *label;
+      GObject *item;
+      gint index;
+
+      index = gtk_flow_box_child_get_index (child);
+      if (first < 0)
+        first = index;
+      g_assert_cmpint (index, ==, first + i);
+
+      label = gtk_bin_get_child (GTK_BIN (child));
+      item = g_list_model_get_item (model, index);
+      g_assert_cmpstr (gtk_label_get_text (GTK_LABEL (label)), ==, g_object_get_data (item, "text"));
+      g_object_unref (item);
+
+      i++;
+    }
+  g_list_free (children);
+
+  g_assert_cmpint (first % LINE_LENGTH, ==, 0);
+
+  return first;
+}
+
+static void
+test_bind_model_recycled (void)
+{
+  GtkWidget *window, *sw;
+  GtkFlowBox *box;
+  GtkAdjustment *vadjustment;
+  GListStore *store;
+  GObject *item;
+  RecycleData data = { 0, 0 };
+  GList *children;
+  gint n_children, n_created;
+  gint first;
+  gint i;
+
+  store = g_list_store_new (G_TYPE_OBJECT);
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      item = create_item (i);
+      g_list_store_append (store, item);
+      g_object_unref (item);
+    }
+
+  window = gtk_offscreen_window_new ();
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (sw),
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+  gtk_widget_set_size_request (sw, 200, 200);
+  gtk_container_add (GTK_CONTAINER (window), sw);
+
+  box = GTK_FLOW_BOX (gtk_flow_box_new ());
+  gtk_flow_box_set_min_children_per_line (box, LINE_LENGTH);
+  gtk_flow_box_set_max_children_per_line (box, LINE_LENGTH);
+  gtk_container_add (GTK_CONTAINER (sw), GTK_WIDGET (box));
+
+  vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (sw));
+  gtk_flow_box_set_vadjustment (box, vadjustment);
+
+  gtk_flow_box_bind_model_recycled (box, G_LIST_MODEL (store),
+                                    create_widget, bind_widget,
+                                    &data, NULL);
+
+  gtk_widget_show_all (window);
+  gtk_test_widget_wait_for_draw (window);
+  wait_for_children ();
+
+  /* Only a few children exist */
+  children = gtk_container_get_children (GTK_CONTAINER (box));
+  n_children = g_list_length (children);
+  g_list_free (children);
+  g_assert_cmpint (n_children, >, 0);
+  g_assert_cmpint (n_children, <, N_ITEMS);
+  g_assert_cmpint (data.n_created, >=, n_children);
+  g_assert (gtk_flow_box_get_child_at_index (box, N_ITEMS - 1) == NULL);
+  first = check_recycled_children (box, G_LIST_MODEL (store));
+  g_assert_cmpint (first, ==, 0);
+
+  /* Scroll into the middle, reusing the children */
+  gtk_adjustment_set_value (vadjustment,
+                            (gtk_adjustment_get_upper (vadjustment) -
+                             gtk_adjustment_get_page_size (vadjustment)) / 2);
+  gtk_test_widget_wait_for_draw (window);
+  wait_for_children ();
+
+  first = check_recycled_children (box, G_LIST_MODEL (store));
+  g_assert_cmpint (first, >, 0);
+  g_assert_cmpint (data.n_bound, >, 0);
+  g_assert (gtk_flow_box_get_child_at_index (box, 0) == NULL);
+
+  /* Changes above the window move it by less than a line */
+  n_created = data.n_created;
+
+  g_list_store_remove (store, 0);
+  check_recycled_children (box, G_LIST_MODEL (store));
+
+  g_list_store_remove (store, 0);
+  g_list_store_remove (store, 0);
+  check_recycled_children (box, G_LIST_MODEL (store));
+
+  item = create_item (-1);
+  g_list_store_insert (store, 0, item);
+  g_object_unref (item);
+  check_recycled_children (box, G_LIST_MODEL (store));
+
+  gtk_test_widget_wait_for_draw (window);
+  wait_for_children ();
+
+  /* Changes inside the window rebind the children after them */
+  first = check_recycled_children (box, G_LIST_MODEL (store));
+  g_list_store_remove (store, first + 1);
+  check_recycled_children (box, G_LIST_MODEL (store));
+
+  /* All of that only reused children */
+  g_assert_cmpint (data.n_created, <=, n_created + LINE_LENGTH);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/flowbox/bind-model-recycled", test_bind_model_recycled);
+
+  return g_test_run ();
+}
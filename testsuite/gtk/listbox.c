@@ -434,6 +434,125 @@ test_header (void)
   g_object_unref (list);
 }
 
+typedef struct {
+  gint n_created;
+  gint n_bound;
+} RecycleData;
+
+static GtkWidget *
+create_widget (gpointer item,
+               gpointer user_data)
+{
+  RecycleData *data = user_data;
+
+  data->n_created++;
+
+  return gtk_label_new (g_object_get_data (item, "text"));
+}
+
+static void
+bind_widget (gpointer   item,
+             GtkWidget *widget,
+             gpointer   user_data)
+{
+  RecycleData *data = user_data;
+
+  data->n_bound++;
+
+  gtk_label_set_text (GTK_LABEL (widget), g_object_get_data (item, "text"));
+}
+
+static void
+check_recycled_rows (GtkListBox *list,
+                     GListModel *model)
+{
+  GList *children, *l;
+
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  for (l = children; l; l = l->next)
+    {
+      GtkListBoxRow *row = l->data;
+      GtkWidget *label;
+      GObject *item;
+
+      label = gtk_bin_get_child (GTK_BIN (row));
+      item = g_list_model_get_item (model, gtk_list_box_row_get_index (row));
+      g_assert_cmpstr (gtk_label_get_text (GTK_LABEL (label)), ==, g_object_get_data (item, "text"));
+      g_object_unref (item);
+    }
+  g_list_free (children);
+}
+
+static void
+test_bind_model_recycled (void)
+{
+  GtkListBox *list;
+  GListStore *store;
+  GtkListBoxRow *row;
+  RecycleData data = { 0, 0 };
+  GList *children;
+  gint n_rows;
+  gint row_height, height;
+  gint i;
+
+  store = g_list_store_new (G_TYPE_OBJECT);
+  for (i = 0; i < 10000; i++)
+    {
+      GObject *item = g_object_new (G_TYPE_OBJECT, NULL);
+
+      g_object_set_data_full (item, "text", g_strdup_printf ("%d", i), g_free);
+      g_list_store_append (store, item);
+      g_object_unref (item);
+    }
+
+  list = GTK_LIST_BOX (gtk_list_box_new ());
+  g_object_ref_sink (list);
+  gtk_widget_show (GTK_WIDGET (list));
+
+  gtk_list_box_bind_model_recycled (list, G_LIST_MODEL (store),
+                                    create_widget, bind_widget,
+                                    &data, NULL);
+
+  /* Only a few rows exist */
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  n_rows = g_list_length (children);
+  g_list_free (children);
+  g_assert_cmpint (n_rows, >, 0);
+  g_assert_cmpint (n_rows, <, 10000);
+  g_assert_cmpint (data.n_created, ==, n_rows);
+  g_assert (gtk_list_box_get_row_at_index (list, 9999) == NULL);
+  check_recycled_rows (list, G_LIST_MODEL (store));
+
+  /* Items without rows are as high as the rows we have */
+  row = gtk_list_box_get_row_at_index (list, 0);
+  gtk_widget_get_preferred_height (GTK_WIDGET (row), &row_height, NULL);
+  gtk_widget_get_preferred_height (GTK_WIDGET (list), &height, NULL);
+  g_assert_cmpint (row_height, >, 0);
+  /* give or take the list's own padding and border */
+  g_assert_cmpint (height, >=, 10000 * row_height);
+  g_assert_cmpint (height, <, 10001 * row_height);
+
+  row = gtk_list_box_get_row_at_index (list, 1);
+  gtk_list_box_select_row (list, row);
+
+  /* Removing the first item rebinds the existing rows */
+  g_list_store_remove (store, 0);
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  g_assert_cmpint (g_list_length (children), ==, n_rows);
+  g_list_free (children);
+  g_assert_cmpint (data.n_created, ==, n_rows);
+  g_assert_cmpint (data.n_bound, >, 0);
+  check_recycled_rows (list, G_LIST_MODEL (store));
+
+  /* and the selection moved along with the item */
+  row = gtk_list_box_get_row_at_index (list, 0);
+  g_assert (gtk_list_box_row_is_selected (row));
+  g_assert (gtk_list_box_get_selected_row (list) == row);
+
+  g_object_unref (list);
+  g_object_unref (store);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -444,6 +563,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/listbox/multi-selection", test_multi_selection);
   g_test_add_func ("/listbox/filter", test_filter);
   g_test_add_func ("/listbox/header", test_header);
+  g_test_add_func ("/listbox/bind-model-recycled", test_bind_model_recycled);
 
   return g_test_run ();
 }
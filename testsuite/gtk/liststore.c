@@ -24,6 +24,8 @@
  */
 
 #include <gtk/gtk.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "treemodel.h"
 
@@ -455,6 +457,95 @@ list_store_test_insert_before_NULL (void)
   g_object_unref (store);
 }
 
+static void
+count_rows_inserted (GtkTreeModel *model,
+                     GtkTreePath  *path,
+                     GtkTreeIter  *iter,
+                     gint          n_rows,
+                     gpointer      data)
+{
+  gint *count = data;
+
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 1);
+  *count += n_rows;
+}
+
+static void
+count_row_inserted (GtkTreeModel *model,
+                    GtkTreePath  *path,
+                    GtkTreeIter  *iter,
+                    gpointer      data)
+{
+  gint *count = data;
+
+  (*count)++;
+}
+
+static void
+list_store_test_insert_rows (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  GValue values[6] = { G_VALUE_INIT, };
+  gint columns[2] = { 0, 1 };
+  gint n_range = 0, n_single = 0;
+  gchar *str;
+  gint i, n;
+
+  store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 0, 1, "first", -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 4, 1, "last", -1);
+
+  g_signal_connect (store, "rows-inserted",
+                    G_CALLBACK (count_rows_inserted), &n_range);
+  g_signal_connect (store, "row-inserted",
+                    G_CALLBACK (count_row_inserted), &n_single);
+
+  /* Three rows, given column by column */
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], i + 1);
+      g_value_init (&values[3 + i], G_TYPE_STRING);
+      g_value_take_string (&values[3 + i], g_strdup_printf ("row %d", i + 1));
+    }
+
+  gtk_list_store_insert_rows_with_valuesv (store, 1, 3, columns, values, 2);
+
+  /* One range, split up for single row handlers */
+  g_assert_cmpint (n_range, ==, 3);
+  g_assert_cmpint (n_single, ==, 3);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 5);
+
+  i = 0;
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &n, 1, &str, -1);
+      g_assert_cmpint (n, ==, i);
+      if (i > 0 && i < 4)
+        g_assert_cmpint (atoi (str + strlen ("row ")), ==, i);
+      g_free (str);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+
+  /* Replace the values of the same rows */
+  for (i = 0; i < 3; i++)
+    g_value_set_int (&values[i], 10 + i);
+
+  gtk_list_store_set_rows_valuesv (store, 1, 3, columns, values, 1);
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 3);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &n, -1);
+  g_assert_cmpint (n, ==, 12);
+
+  for (i = 0; i < 6; i++)
+    g_value_unset (&values[i]);
+
+  g_object_unref (store);
+}
+
 /* setting values */
 static void
 list_store_set_gvalue_to_transform (void)
@@ -1033,6 +1124,8 @@ register_list_store_tests (void)
 		   list_store_test_insert_before);
   g_test_add_func ("/ListStore/insert-before-NULL",
 		   list_store_test_insert_before_NULL);
+  g_test_add_func ("/ListStore/insert-rows",
+                   list_store_test_insert_rows);
 
   /* setting values (FIXME) */
   g_test_add_func ("/ListStore/set-gvalue-to-transform",
@@ -1030,6 +1030,269 @@ sorted_insert (void)
 }
 
 
+static gint
+resort_int_compare (GtkTreeModel *model,
+                    GtkTreeIter  *a,
+                    GtkTreeIter  *b,
+                    gpointer      user_data)
+{
+  gint column = GPOINTER_TO_INT (user_data);
+  gint value_a, value_b;
+
+  gtk_tree_model_get (model, a, column, &value_a, -1);
+  gtk_tree_model_get (model, b, column, &value_b, -1);
+
+  return value_a < value_b ? -1 : value_a == value_b ? 0 : 1;
+}
+
+static gint
+resort_string_compare (GtkTreeModel *model,
+                       GtkTreeIter  *a,
+                       GtkTreeIter  *b,
+                       gpointer      user_data)
+{
+  gint column = GPOINTER_TO_INT (user_data);
+  gchar *value_a, *value_b;
+  gint retval;
+
+  gtk_tree_model_get (model, a, column, &value_a, -1);
+  gtk_tree_model_get (model, b, column, &value_b, -1);
+
+  retval = g_utf8_collate (value_a ? value_a : "", value_b ? value_b : "");
+
+  g_free (value_a);
+  g_free (value_b);
+
+  return retval;
+}
+
+static void
+check_same_order (GtkTreeModel *model1,
+                  GtkTreeModel *model2)
+{
+  GtkTreeIter iter1, iter2;
+  gboolean valid1, valid2;
+
+  valid1 = gtk_tree_model_get_iter_first (model1, &iter1);
+  valid2 = gtk_tree_model_get_iter_first (model2, &iter2);
+
+  while (valid1 && valid2)
+    {
+      gint id1, id2;
+
+      gtk_tree_model_get (model1, &iter1, 0, &id1, -1);
+      gtk_tree_model_get (model2, &iter2, 0, &id2, -1);
+      g_assert_cmpint (id1, ==, id2);
+
+      valid1 = gtk_tree_model_iter_next (model1, &iter1);
+      valid2 = gtk_tree_model_iter_next (model2, &iter2);
+    }
+
+  g_assert (!valid1 && !valid2);
+}
+
+static void
+rows_reordered_count_cb (GtkTreeModel *model,
+                         GtkTreePath  *path,
+                         GtkTreeIter  *iter,
+                         gpointer      new_order,
+                         gpointer      user_data)
+{
+  (* (gint *) user_data)++;
+}
+
+/* Sorting on a column with the built-in compare function takes a
+ * different path than sorting with a custom one, and has to produce
+ * the same order, ties included.
+ */
+static void
+resort_large_level (void)
+{
+  const struct {
+    gint column;
+    GtkSortType order;
+  } sorts[] = {
+    { 1, GTK_SORT_ASCENDING },
+    { 2, GTK_SORT_ASCENDING },
+    { 1, GTK_SORT_DESCENDING },
+    { 2, GTK_SORT_DESCENDING },
+    { 0, GTK_SORT_ASCENDING }
+  };
+  guint n = g_test_perf () ? 200000 : 20000;
+  GtkListStore *store;
+  GtkTreeModel *sort_model, *reference;
+  GtkTreeIter iter, sort_iter;
+  gint n_reordered = 0;
+  gint value;
+  guint i;
+
+  store = gtk_list_store_new (3, G_TYPE_INT, G_TYPE_INT, G_TYPE_STRING);
+  for (i = 0; i < n; i++)
+    {
+      gchar *str;
+
+      /* plenty of ties in both columns */
+      str = g_strdup_printf ("%c%d", 'a' + g_test_rand_int_range (0, 26),
+                             g_test_rand_int_range (0, n / 8));
+      gtk_list_store_insert_with_values (store, NULL, i,
+                                         0, i,
+                                         1, g_test_rand_int_range (0, n / 4),
+                                         2, str,
+                                         -1);
+      g_free (str);
+    }
+
+  sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+
+  reference = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (reference), 0,
+                                   resort_int_compare, GINT_TO_POINTER (0), NULL);
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (reference), 1,
+                                   resort_int_compare, GINT_TO_POINTER (1), NULL);
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (reference), 2,
+                                   resort_string_compare, GINT_TO_POINTER (2), NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (sorts); i++)
+    {
+      gdouble elapsed;
+
+      g_test_timer_start ();
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                            sorts[i].column, sorts[i].order);
+      elapsed = g_test_timer_elapsed ();
+
+      if (g_test_perf ())
+        g_test_minimized_result (elapsed, "sorting %u rows on column %d: %gsec",
+                                 n, sorts[i].column, elapsed);
+
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (reference),
+                                            sorts[i].column, sorts[i].order);
+
+      check_same_order (sort_model, reference);
+    }
+
+  /* Changing a row to a value that keeps it in place must not reorder */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        1, GTK_SORT_ASCENDING);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (reference),
+                                        1, GTK_SORT_ASCENDING);
+  g_signal_connect (sort_model, "rows-reordered",
+                    G_CALLBACK (rows_reordered_count_cb), &n_reordered);
+
+  gtk_tree_model_iter_nth_child (sort_model, &sort_iter, NULL, n / 2);
+  gtk_tree_model_sort_convert_iter_to_child_iter (GTK_TREE_MODEL_SORT (sort_model),
+                                                  &iter, &sort_iter);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &value, -1);
+  gtk_list_store_set (store, &iter, 1, value, -1);
+  g_assert_cmpint (n_reordered, ==, 0);
+  check_same_order (sort_model, reference);
+
+  /* ... and moving it has to end up where the reference puts it */
+  gtk_list_store_set (store, &iter, 1, -1, -1);
+  g_assert_cmpint (n_reordered, ==, 1);
+  check_same_order (sort_model, reference);
+
+  gtk_list_store_set (store, &iter, 1, n, -1);
+  g_assert_cmpint (n_reordered, ==, 2);
+  check_same_order (sort_model, reference);
+
+  g_object_unref (sort_model);
+  g_object_unref (reference);
+  g_object_unref (store);
+}
+
+static void
+insert_rows_check_values (GtkTreeModel *model,
+                          const gint   *expected,
+                          gint          n_expected)
+{
+  GtkTreeIter iter;
+  gint i, value;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, NULL), ==, n_expected);
+
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (model, &iter, NULL, i));
+      gtk_tree_model_get (model, &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected[i]);
+    }
+}
+
+static void
+insert_rows (void)
+{
+  const gint unsorted[] = { 10, 20, 30, 40, 30, 50 };
+  const gint sorted[] = { 10, 20, 25, 30, 30, 40, 45, 47, 50 };
+  GtkListStore *store;
+  GtkTreeModel *sort_model;
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  SignalMonitor *monitor;
+  GValue values[3] = { G_VALUE_INIT, };
+  gint column = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 10, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 30, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 50, -1);
+
+  sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+
+  /* Build the root level */
+  g_assert (gtk_tree_model_get_iter_first (sort_model, &iter));
+
+  monitor = signal_monitor_new (sort_model);
+
+  for (i = 0; i < 3; i++)
+    g_value_init (&values[i], G_TYPE_INT);
+
+  /* Unsorted, the block stays in one piece */
+  g_value_set_int (&values[0], 20);
+  g_value_set_int (&values[1], 30);
+  g_value_set_int (&values[2], 40);
+
+  signal_monitor_append_rows_inserted (monitor, "1", 3);
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "1");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "2");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "3");
+
+  gtk_list_store_insert_rows_with_valuesv (store, 1, 3, &column, values, 1);
+  signal_monitor_assert_is_empty (monitor);
+  insert_rows_check_values (sort_model, unsorted, G_N_ELEMENTS (unsorted));
+
+  /* Sorted, it is announced as the runs it ends up in, in order */
+  path = gtk_tree_path_new ();
+  signal_monitor_append_signal_path (monitor, ROWS_REORDERED, path);
+  gtk_tree_path_free (path);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_ASCENDING);
+  signal_monitor_assert_is_empty (monitor);
+
+  g_value_set_int (&values[0], 45);
+  g_value_set_int (&values[1], 25);
+  g_value_set_int (&values[2], 47);
+
+  signal_monitor_append_rows_inserted (monitor, "2", 1);
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "2");
+  signal_monitor_append_rows_inserted (monitor, "6", 2);
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "6");
+  signal_monitor_append_signal (monitor, ROW_INSERTED, "7");
+
+  gtk_list_store_insert_rows_with_valuesv (store, 0, 3, &column, values, 1);
+  signal_monitor_assert_is_empty (monitor);
+  insert_rows_check_values (sort_model, sorted, G_N_ELEMENTS (sorted));
+
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+
+  signal_monitor_free (monitor);
+  g_object_unref (sort_model);
+  g_object_unref (store);
+}
+
 static void
 specific_bug_300089 (void)
 {
@@ -1230,6 +1493,10 @@ register_sort_model_tests (void)
                    rows_reordered_two_levels);
   g_test_add_func ("/TreeModelSort/sorted-insert",
                    sorted_insert);
+  g_test_add_func ("/TreeModelSort/resort-large-level",
+                   resort_large_level);
+  g_test_add_func ("/TreeModelSort/insert-rows",
+                   insert_rows);
 
   g_test_add_func ("/TreeModelSort/specific/bug-300089",
                    specific_bug_300089);
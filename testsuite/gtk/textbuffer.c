@@ -1556,6 +1556,313 @@ test_get_iter (void)
   g_object_unref (buffer);
 }
 
+static void
+append_lines (GtkTextBuffer *buffer,
+              guint          n)
+{
+  GtkTextIter iter;
+  gchar line[32];
+  guint i;
+
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  for (i = 0; i < n; i++)
+    {
+      g_snprintf (line, sizeof (line), "line %u\n", i);
+      gtk_text_buffer_insert (buffer, &iter, line, -1);
+    }
+}
+
+static void
+check_appended_lines (GtkTextBuffer *buffer,
+                      guint          n)
+{
+  GtkTextIter start, end;
+  gchar expected[32];
+  gchar *text;
+  guint i;
+
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, n + 1);
+
+  for (i = 0; i < n; i += MAX (n / 100, 1))
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &start, i);
+      end = start;
+      gtk_text_iter_forward_line (&end);
+      text = gtk_text_iter_get_text (&start, &end);
+      g_snprintf (expected, sizeof (expected), "line %u\n", i);
+      g_assert_cmpstr (text, ==, expected);
+      g_free (text);
+    }
+}
+
+static void
+test_append_lines (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  guint debug_flags;
+  guint n = g_test_perf () ? 1000000 : 100000;
+  gdouble elapsed;
+  gchar *text;
+
+  /* Mix appends with edits that split and merge the segments */
+  buffer = gtk_text_buffer_new (NULL);
+  append_lines (buffer, 1000);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 10, 2);
+  gtk_text_buffer_insert (buffer, &start, "XX", -1);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 10, 2);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &end, 10, 4);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 20, 6);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 22);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 20);
+  end = start;
+  gtk_text_iter_forward_line (&end);
+  text = gtk_text_iter_get_text (&start, &end);
+  g_assert_cmpstr (text, ==, "line 2line 22\n");
+  g_free (text);
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  append_lines (buffer, 10);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 31);
+  g_object_unref (buffer);
+
+  /* The btree consistency checks make appending quadratic */
+  debug_flags = gtk_get_debug_flags ();
+  gtk_set_debug_flags (debug_flags & ~GTK_DEBUG_TEXT);
+
+  buffer = gtk_text_buffer_new (NULL);
+
+  g_test_timer_start ();
+  append_lines (buffer, n);
+  elapsed = g_test_timer_elapsed ();
+
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "appending %u lines: %gsec", n, elapsed);
+
+  check_appended_lines (buffer, n);
+  g_object_unref (buffer);
+
+  gtk_set_debug_flags (debug_flags);
+}
+
+static void
+max_lines_insert_cb (GtkTextBuffer *buffer,
+                     GtkTextIter   *location,
+                     const gchar   *text,
+                     gint           len,
+                     gpointer       user_data)
+{
+  GtkTextIter start;
+  gchar *inserted;
+
+  /* Lines are only dropped after the handlers ran */
+  start = *location;
+  g_assert_true (gtk_text_iter_backward_chars (&start, g_utf8_strlen (text, len)));
+  inserted = gtk_text_iter_get_text (&start, location);
+  g_assert_cmpint (strncmp (inserted, text, len), ==, 0);
+  g_free (inserted);
+}
+
+static void
+max_lines_delete_cb (GtkTextBuffer *buffer,
+                     GtkTextIter   *start,
+                     GtkTextIter   *end,
+                     gint          *n_deletions)
+{
+  g_assert_true (gtk_text_iter_is_start (start));
+  g_assert_true (gtk_text_iter_starts_line (end));
+  (*n_deletions)++;
+}
+
+static void
+test_max_lines (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextMark *mark;
+  GtkTextIter start, end, iter;
+  gchar expected[32];
+  gchar *text;
+  gint n_lines;
+  gint n_deletions = 0;
+
+  buffer = gtk_text_buffer_new (NULL);
+  tag = gtk_text_buffer_create_tag (buffer, "bold", NULL);
+
+  append_lines (buffer, 500);
+
+  /* A tag that spans the lines that get dropped, and one that ends there */
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 10);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 480);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 0);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 5);
+  gtk_text_buffer_apply_tag_by_name (buffer, "bold", &start, &end);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, 2);
+  mark = gtk_text_buffer_create_mark (buffer, NULL, &iter, FALSE);
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, 490);
+  gtk_text_buffer_place_cursor (buffer, &iter);
+
+  g_signal_connect_after (buffer, "insert-text", G_CALLBACK (max_lines_insert_cb), NULL);
+  g_signal_connect (buffer, "delete-range", G_CALLBACK (max_lines_delete_cb), &n_deletions);
+
+  gtk_text_buffer_set_max_lines (buffer, 100);
+  g_assert_cmpint (n_deletions, ==, 1);
+  g_assert_cmpint (gtk_text_buffer_get_max_lines (buffer), ==, 100);
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  g_assert_cmpint (n_lines, <=, 100);
+  g_assert_cmpint (n_lines, >, 90);
+
+  /* The mark moved to the start, the cursor stayed on its line */
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, mark);
+  g_assert (gtk_text_iter_is_start (&iter));
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+  g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, 490 - (501 - n_lines));
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  g_assert (gtk_text_iter_has_tag (&iter, tag));
+  g_assert (gtk_text_iter_begins_tag (&iter, tag));
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, 480 - (501 - n_lines));
+  g_assert (gtk_text_iter_ends_tag (&iter, tag));
+
+  /* Appending keeps the buffer bounded, and the iter valid */
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, "first\nsecond\n", -1);
+  g_assert (gtk_text_iter_is_end (&iter));
+
+  append_lines (buffer, 1000);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), <=, 100);
+  g_assert_cmpint (n_deletions, >, 1);
+  g_assert_cmpint (n_deletions, <, 1000 / 6);
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  gtk_text_buffer_get_iter_at_line (buffer, &start, n_lines - 2);
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  text = gtk_text_iter_get_text (&start, &end);
+  g_snprintf (expected, sizeof (expected), "line %u\n", 999);
+  g_assert_cmpstr (text, ==, expected);
+  g_free (text);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  g_assert (!gtk_text_iter_has_tag (&iter, tag));
+
+  /* Inserting many lines at once can drop some of them again */
+  gtk_text_buffer_set_max_lines (buffer, 3);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), <=, 3);
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, "a\nb\nc\nd\ne\n", -1);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), <=, 3);
+  g_assert (gtk_text_iter_is_start (&iter));
+
+  gtk_text_buffer_set_max_lines (buffer, 0);
+  append_lines (buffer, 10);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), >, 10);
+
+  g_object_unref (buffer);
+}
+
+/* Checks that exactly the lines starting with "tagged" have @tag,
+ * on all of their text
+ */
+static void
+check_tagged_lines (GtkTextBuffer *buffer,
+                    GtkTextTag    *tag)
+{
+  GtkTextIter start, end;
+  gint i, n_lines;
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  for (i = 0; i < n_lines - 1; i++)
+    {
+      gchar *text;
+
+      gtk_text_buffer_get_iter_at_line (buffer, &start, i);
+      end = start;
+      gtk_text_iter_forward_to_line_end (&end);
+      text = gtk_text_iter_get_text (&start, &end);
+
+      if (g_str_has_prefix (text, "tagged"))
+        {
+          g_assert_true (gtk_text_iter_has_tag (&start, tag));
+          g_assert_true (gtk_text_iter_has_tag (&end, tag));
+        }
+      else
+        {
+          g_assert_false (gtk_text_iter_has_tag (&start, tag));
+          g_assert_false (gtk_text_iter_has_tag (&end, tag));
+        }
+
+      g_free (text);
+    }
+}
+
+static void
+test_max_lines_tags (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextIter iter, start;
+  gchar line[32];
+  gint offset;
+  gint i;
+
+  buffer = gtk_text_buffer_new (NULL);
+  tag = gtk_text_buffer_create_tag (buffer, "tagged", NULL);
+  gtk_text_buffer_set_max_lines (buffer, 20);
+
+  /* Lines are only dropped after the tags have been applied
+   * at the offsets of the inserted text
+   */
+  for (i = 0; i < 300; i++)
+    {
+      gtk_text_buffer_get_end_iter (buffer, &iter);
+
+      switch (i % 4)
+        {
+        case 0:
+          g_snprintf (line, sizeof (line), "tagged %d\n", i);
+          gtk_text_buffer_insert_with_tags_by_name (buffer, &iter, line, -1, "tagged", NULL);
+          break;
+
+        case 1:
+          g_snprintf (line, sizeof (line), "tagged %d\n", i);
+          gtk_text_buffer_insert_with_tags (buffer, &iter, line, -1, tag, NULL);
+          break;
+
+        case 2:
+          /* Same within a user action */
+          g_snprintf (line, sizeof (line), "tagged %d\n", i);
+          gtk_text_buffer_begin_user_action (buffer);
+          offset = gtk_text_iter_get_offset (&iter);
+          gtk_text_buffer_insert (buffer, &iter, line, -1);
+          gtk_text_buffer_get_iter_at_offset (buffer, &start, offset);
+          gtk_text_buffer_apply_tag (buffer, tag, &start, &iter);
+          gtk_text_buffer_end_user_action (buffer);
+          break;
+
+        default:
+          g_snprintf (line, sizeof (line), "plain %d\n", i);
+          gtk_text_buffer_insert (buffer, &iter, line, -1);
+          break;
+        }
+
+      g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), <=, 20);
+      check_tagged_lines (buffer, tag);
+    }
+
+  /* The iter of the last insertion still points to its end */
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_buffer_insert_with_tags (buffer, &iter, "tagged\n", -1, tag, NULL);
+  g_assert_true (gtk_text_iter_is_end (&iter));
+  check_tagged_lines (buffer, tag);
+
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1575,6 +1882,9 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Tag", test_tag);
   g_test_add_func ("/TextBuffer/Clipboard", test_clipboard);
   g_test_add_func ("/TextBuffer/Get iter", test_get_iter);
+  g_test_add_func ("/TextBuffer/Append lines", test_append_lines);
+  g_test_add_func ("/TextBuffer/Max lines", test_max_lines);
+  g_test_add_func ("/TextBuffer/Max lines tags", test_max_lines_tags);
 
   return g_test_run();
 }
@@ -0,0 +1,638 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "gtk/gtktextlayoutprivate.h" /* Private header, to look at cached displays */
+
+static GdkRectangle
+get_line_end_location (GtkTextView *view,
+                       gint         line)
+{
+  GtkTextBuffer *buffer = gtk_text_view_get_buffer (view);
+  GtkTextIter iter;
+  GdkRectangle location;
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+  if (!gtk_text_iter_ends_line (&iter))
+    gtk_text_iter_forward_to_line_end (&iter);
+
+  gtk_text_view_get_iter_location (view, &iter, &location);
+
+  return location;
+}
+
+static void
+visit_all_lines (GtkTextView *view)
+{
+  gint i, n_lines;
+
+  n_lines = gtk_text_buffer_get_line_count (gtk_text_view_get_buffer (view));
+  for (i = 0; i < n_lines; i++)
+    get_line_end_location (view, i);
+}
+
+/* Line displays are cached by the layout; check that the cached
+ * displays follow edits and tag changes.
+ */
+static void
+test_line_display_cache (void)
+{
+  GtkWidget *view;
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextIter start, end;
+  GdkRectangle loc0, loc1, loc2, loc;
+  GString *text;
+  gint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < 1000; i++)
+    g_string_append_printf (text, "%.*s\n", i % 10 + 1, "xxxxxxxxxx");
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+  g_string_free (text, TRUE);
+  tag = gtk_text_buffer_create_tag (buffer, "big", NULL);
+
+  view = gtk_text_view_new_with_buffer (buffer);
+  g_object_ref_sink (view);
+
+  loc0 = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  loc1 = get_line_end_location (GTK_TEXT_VIEW (view), 1);
+  loc2 = get_line_end_location (GTK_TEXT_VIEW (view), 2);
+  g_assert_cmpint (loc0.x, <, loc1.x);
+  g_assert_cmpint (loc1.x, <, loc2.x);
+
+  /* More lines than are kept, so line 0 has to be laid out again */
+  visit_all_lines (GTK_TEXT_VIEW (view));
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  g_assert_cmpint (loc.x, ==, loc0.x);
+
+  /* Edits */
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 0);
+  gtk_text_buffer_insert (buffer, &start, "x", -1);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  g_assert_cmpint (loc.x, ==, loc1.x);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 0);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 1);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  g_assert_cmpint (loc.x, ==, loc1.x);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 1);
+  g_assert_cmpint (loc.x, ==, loc2.x);
+
+  /* Applying a tag, and changing it */
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 0);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 1);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  g_assert_cmpint (loc.x, ==, loc1.x);
+
+  g_object_set (tag, "scale", PANGO_SCALE_XX_LARGE, NULL);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  g_assert_cmpint (loc.x, >, loc1.x);
+  g_assert_cmpint (loc.height, >, loc1.height);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 1);
+  g_assert_cmpint (loc.x, ==, loc2.x);
+
+  g_object_set (tag, "scale", 1.0, NULL);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  g_assert_cmpint (loc.x, ==, loc1.x);
+  g_assert_cmpint (loc.height, ==, loc1.height);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 0);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 1);
+  gtk_text_buffer_remove_all_tags (buffer, &start, &end);
+  g_object_set (tag, "scale", PANGO_SCALE_XX_LARGE, NULL);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 0);
+  g_assert_cmpint (loc.x, ==, loc1.x);
+
+  /* Changes to the view's style */
+  gtk_text_view_set_left_margin (GTK_TEXT_VIEW (view), 100);
+  loc = get_line_end_location (GTK_TEXT_VIEW (view), 1);
+  g_assert_cmpint (loc.x, ==, loc2.x + 100);
+
+  g_object_unref (view);
+  g_object_unref (buffer);
+}
+
+static GtkWidget *
+create_sized_view (GtkTextBuffer *buffer,
+                   gboolean       background_validation)
+{
+  GtkWidget *window;
+  GtkWidget *sw;
+  GtkWidget *view;
+
+  window = gtk_offscreen_window_new ();
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (sw),
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+  gtk_widget_set_size_request (sw, 200, 200);
+
+  view = gtk_text_view_new_with_buffer (buffer);
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), GTK_WRAP_WORD);
+  gtk_text_view_set_background_validation (GTK_TEXT_VIEW (view), background_validation);
+
+  gtk_container_add (GTK_CONTAINER (sw), view);
+  gtk_container_add (GTK_CONTAINER (window), sw);
+  gtk_widget_show_all (window);
+
+  return view;
+}
+
+static void
+wait_for_validation (GtkWidget *view)
+{
+  gint64 end_time;
+
+  end_time = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+  while (gtk_text_view_get_validation_progress (GTK_TEXT_VIEW (view)) < 1.0 &&
+         g_get_monotonic_time () < end_time)
+    {
+      if (!g_main_context_iteration (NULL, FALSE))
+        g_usleep (1000);
+    }
+
+  g_assert_cmpfloat (gtk_text_view_get_validation_progress (GTK_TEXT_VIEW (view)), ==, 1.0);
+}
+
+static void
+assert_same_line_sizes (GtkWidget *view,
+                        GtkWidget *reference)
+{
+  GtkTextBuffer *buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+  GtkTextIter iter;
+  gint y, height, ref_y, ref_height;
+  gint i, n_lines;
+
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  for (i = 0; i < n_lines; i++)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, i);
+      gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &y, &height);
+      gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (reference), &iter, &ref_y, &ref_height);
+      g_assert_cmpint (y, ==, ref_y);
+      g_assert_cmpint (height, ==, ref_height);
+    }
+}
+
+static void
+test_background_validation (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextIter start, end;
+  GtkWidget *view;
+  GtkWidget *reference;
+  GString *text;
+  gint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < 20000; i++)
+    {
+      if (i % 3 == 0)
+        g_string_append (text, "A somewhat longer line that has to be wrapped to fit\n");
+      else
+        g_string_append_printf (text, "Line %d\n", i);
+    }
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+  g_string_free (text, TRUE);
+
+  tag = gtk_text_buffer_create_tag (buffer, "big", "scale", PANGO_SCALE_XX_LARGE, NULL);
+  for (i = 5; i < 20000; i += 1000)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &start, i);
+      gtk_text_buffer_get_iter_at_line (buffer, &end, i + 1);
+      gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+    }
+
+  view = create_sized_view (buffer, TRUE);
+  reference = create_sized_view (buffer, FALSE);
+
+  g_assert_true (gtk_text_view_get_background_validation (GTK_TEXT_VIEW (view)));
+
+  wait_for_validation (view);
+  wait_for_validation (reference);
+  assert_same_line_sizes (view, reference);
+
+  /* Changes after validation are picked up as well */
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_insert (buffer, &end, "\nOne more line that is long enough to wrap", -1);
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 10000);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 10010);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+
+  wait_for_validation (view);
+  wait_for_validation (reference);
+  assert_same_line_sizes (view, reference);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (view));
+  gtk_widget_destroy (gtk_widget_get_toplevel (reference));
+  g_object_unref (buffer);
+}
+
+static void
+test_estimate_line_heights (void)
+{
+  GtkTextBuffer *buffer;
+  GtkWidget *view;
+  GtkTextIter iter;
+  GString *text;
+  gint n_lines = 100000;
+  gint y, height, line_height;
+  gint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < n_lines; i++)
+    g_string_append_printf (text, "Line %d\n", i);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+  g_string_free (text, TRUE);
+
+  view = create_sized_view (buffer, FALSE);
+  gtk_text_view_set_estimate_line_heights (GTK_TEXT_VIEW (view), TRUE);
+  g_assert_true (gtk_text_view_get_estimate_line_heights (GTK_TEXT_VIEW (view)));
+
+  /* Let the lines on screen be laid out, but not the whole buffer */
+  while (gtk_text_view_get_validation_progress (GTK_TEXT_VIEW (view)) == 0.0)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpfloat (gtk_text_view_get_validation_progress (GTK_TEXT_VIEW (view)), <, 1.0);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &y, &line_height);
+  g_assert_cmpint (line_height, >, 0);
+
+  /* All lines have the same height, so the estimate is exact */
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, n_lines - 1);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &y, &height);
+  g_assert_cmpint (height, ==, line_height);
+  g_assert_cmpint (y, ==, (n_lines - 1) * line_height);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, n_lines / 2);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &y, &height);
+  g_assert_cmpint (y, ==, n_lines / 2 * line_height);
+
+  /* Without estimates, lines that were not laid out take no space */
+  gtk_text_view_set_estimate_line_heights (GTK_TEXT_VIEW (view), FALSE);
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, n_lines - 1);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &y, &height);
+  g_assert_cmpint (y, <, (n_lines - 1) * line_height);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (view));
+  g_object_unref (buffer);
+}
+
+typedef struct {
+  gint n_changed;
+  gint y;
+  gint old_height;
+  gint new_height;
+  gint n_invalidated;
+} LayoutChanges;
+
+static void
+layout_changed_cb (GtkTextLayout *layout,
+                   gint           y,
+                   gint           old_height,
+                   gint           new_height,
+                   LayoutChanges *changes)
+{
+  changes->n_changed++;
+  changes->y = y;
+  changes->old_height = old_height;
+  changes->new_height = new_height;
+}
+
+static void
+layout_invalidated_cb (GtkTextLayout *layout,
+                       LayoutChanges *changes)
+{
+  changes->n_invalidated++;
+}
+
+static GtkTextLayout *
+create_layout (GtkTextBuffer *buffer,
+               GtkWidget     *widget)
+{
+  GtkTextLayout *layout;
+  GtkTextAttributes *style;
+  PangoContext *ltr_context, *rtl_context;
+
+  layout = gtk_text_layout_new ();
+
+  ltr_context = gtk_widget_create_pango_context (widget);
+  pango_context_set_base_dir (ltr_context, PANGO_DIRECTION_LTR);
+  rtl_context = gtk_widget_create_pango_context (widget);
+  pango_context_set_base_dir (rtl_context, PANGO_DIRECTION_RTL);
+  gtk_text_layout_set_contexts (layout, ltr_context, rtl_context);
+  g_object_unref (ltr_context);
+  g_object_unref (rtl_context);
+
+  style = gtk_text_attributes_new ();
+  style->font = pango_font_description_from_string ("Sans 10");
+  style->wrap_mode = GTK_WRAP_WORD;
+  gtk_text_layout_set_default_style (layout, style);
+  gtk_text_attributes_unref (style);
+
+  gtk_text_layout_set_screen_width (layout, 200);
+  gtk_text_layout_set_buffer (layout, buffer);
+
+  return layout;
+}
+
+static GtkTextLineDisplay *
+get_line_display (GtkTextLayout *layout,
+                  gint           line_number,
+                  GtkTextLine  **line)
+{
+  GtkTextIter iter;
+  GSList *lines;
+  gint y, height;
+
+  gtk_text_buffer_get_iter_at_line (layout->buffer, &iter, line_number);
+  gtk_text_layout_get_line_yrange (layout, &iter, &y, &height);
+  lines = gtk_text_layout_get_lines (layout, y, y + 1, NULL);
+  g_assert_nonnull (lines);
+  *line = lines->data;
+  g_slist_free (lines);
+
+  return gtk_text_layout_get_line_display (layout, *line, FALSE);
+}
+
+/* Dropping lines from the start of the buffer must only move the
+ * remaining lines up, without laying them out again.
+ */
+static void
+test_max_lines (void)
+{
+  GtkTextBuffer *buffer;
+  GtkWidget *view;
+  GtkTextLayout *layout;
+  GtkTextLineDisplay *display;
+  GtkTextLine *line, *line_after;
+  LayoutChanges changes = { 0, };
+  GtkTextIter iter;
+  GString *text;
+  gint n_lines, n_deleted, kept;
+  gint view_top, view_y, view_height;
+  gint layout_top, layout_y, layout_height;
+  gint y, height;
+  gint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < 2000; i++)
+    {
+      if (i % 3 == 0)
+        g_string_append (text, "A somewhat longer line that has to be wrapped to fit\n");
+      else
+        g_string_append_printf (text, "Line %d\n", i);
+    }
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+  g_string_free (text, TRUE);
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+
+  view = create_sized_view (buffer, FALSE);
+  wait_for_validation (view);
+
+  layout = create_layout (buffer, view);
+  gtk_text_layout_validate (layout, G_MAXINT);
+  g_assert_true (gtk_text_layout_is_valid (layout));
+
+  /* A line that is kept, and one past the lines that are dropped */
+  kept = 1500;
+  display = get_line_display (layout, kept, &line);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, kept);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &view_y, &view_height);
+  gtk_text_layout_get_line_yrange (layout, &iter, &layout_y, &layout_height);
+
+  g_signal_connect (layout, "changed", G_CALLBACK (layout_changed_cb), &changes);
+  g_signal_connect (layout, "invalidated", G_CALLBACK (layout_invalidated_cb), &changes);
+
+  /* Where the new first line is now */
+  n_deleted = n_lines - 1000 + 1000 / 16;
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, n_deleted);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &view_top, NULL);
+  gtk_text_layout_get_line_yrange (layout, &iter, &layout_top, NULL);
+
+  gtk_text_buffer_set_max_lines (buffer, 1000);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, n_lines - n_deleted);
+
+  /* Nothing was invalidated, the layout reported the dropped range */
+  g_assert_true (gtk_text_layout_is_valid (layout));
+  g_assert_cmpfloat (gtk_text_view_get_validation_progress (GTK_TEXT_VIEW (view)), ==, 1.0);
+  g_assert_cmpint (changes.n_invalidated, ==, 0);
+  g_assert_cmpint (changes.n_changed, ==, 1);
+  g_assert_cmpint (changes.y, ==, 0);
+  g_assert_cmpint (changes.old_height, ==, layout_top);
+  g_assert_cmpint (changes.new_height, ==, 0);
+
+  /* The kept line moved up by the height of the dropped lines */
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, kept - n_deleted);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (view), &iter, &y, &height);
+  g_assert_cmpint (y, ==, view_y - view_top);
+  g_assert_cmpint (height, ==, view_height);
+  gtk_text_layout_get_line_yrange (layout, &iter, &y, &height);
+  g_assert_cmpint (y, ==, layout_y - layout_top);
+  g_assert_cmpint (height, ==, layout_height);
+
+  /* ... and kept its cached display */
+  g_assert_true (get_line_display (layout, kept - n_deleted, &line_after) == display);
+  g_assert_true (line_after == line);
+
+  gtk_text_layout_set_buffer (layout, NULL);
+  g_object_unref (layout);
+  gtk_widget_destroy (gtk_widget_get_toplevel (view));
+  g_object_unref (buffer);
+}
+
+typedef struct
+{
+  gint n_allocations;
+  gint x;
+  gint y;
+} ChildPosition;
+
+static void
+child_allocated (GtkTextLayout *layout,
+                 GtkWidget     *child,
+                 gint           x,
+                 gint           y,
+                 gpointer       data)
+{
+  ChildPosition *pos = data;
+
+  pos->n_allocations++;
+  pos->x = x;
+  pos->y = y;
+}
+
+static void
+batch_done (GObject      *source,
+            GAsyncResult *result,
+            gpointer      data)
+{
+  *(GAsyncResult **) data = g_object_ref (result);
+}
+
+/* A layout set up like GtkTextView does it */
+static GtkTextLayout *
+create_layout (GtkTextBuffer *buffer,
+               GtkWidget     *widget)
+{
+  GtkTextLayout *layout;
+  GtkTextAttributes *style;
+  PangoContext *ltr_context, *rtl_context;
+
+  layout = gtk_text_layout_new ();
+  gtk_text_layout_set_buffer (layout, buffer);
+
+  ltr_context = gtk_widget_create_pango_context (widget);
+  pango_context_set_base_dir (ltr_context, PANGO_DIRECTION_LTR);
+  rtl_context = gtk_widget_create_pango_context (widget);
+  pango_context_set_base_dir (rtl_context, PANGO_DIRECTION_RTL);
+  gtk_text_layout_set_contexts (layout, ltr_context, rtl_context);
+
+  style = gtk_text_attributes_new ();
+  style->font = pango_font_description_copy (pango_context_get_font_description (ltr_context));
+  style->wrap_mode = GTK_WRAP_WORD;
+  gtk_text_layout_set_default_style (layout, style);
+  gtk_text_attributes_unref (style);
+
+  g_object_unref (ltr_context);
+  g_object_unref (rtl_context);
+
+  gtk_text_layout_set_screen_width (layout, 200);
+
+  return layout;
+}
+
+/* Drives the batches of background validation directly, and checks
+ * that they end up with the sizes and child positions of validating
+ * on the main thread.
+ */
+static void
+test_background_validation_batches (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextLayout *layout, *reference;
+  GtkTextChildAnchor *anchor;
+  GtkWidget *widget, *child, *ref_child;
+  GtkTextIter iter;
+  GAsyncResult *result = NULL;
+  ChildPosition pos = { 0, }, ref_pos = { 0, };
+  GString *text;
+  gint y, height, ref_y, ref_height;
+  gint i, n_batches;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < 2000; i++)
+    {
+      if (i % 3 == 0)
+        g_string_append (text, "A somewhat longer line that has to be wrapped to fit\n");
+      else
+        g_string_append_printf (text, "Line %d\n", i);
+    }
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, -1);
+  g_string_free (text, TRUE);
+
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 1501, 4);
+  anchor = gtk_text_buffer_create_child_anchor (buffer, &iter);
+
+  widget = g_object_ref_sink (gtk_label_new (NULL));
+  layout = create_layout (buffer, widget);
+  reference = create_layout (buffer, widget);
+
+  child = g_object_ref_sink (gtk_label_new ("Child"));
+  ref_child = g_object_ref_sink (gtk_label_new ("Child"));
+  gtk_text_child_anchor_register_child (anchor, child, layout);
+  gtk_text_child_anchor_register_child (anchor, ref_child, reference);
+  g_signal_connect (layout, "allocate-child", G_CALLBACK (child_allocated), &pos);
+  g_signal_connect (reference, "allocate-child", G_CALLBACK (child_allocated), &ref_pos);
+
+  n_batches = 0;
+  while (_gtk_text_layout_validate_async (layout, NULL, batch_done, &result))
+    {
+      n_batches++;
+
+      while (result == NULL)
+        g_main_context_iteration (NULL, TRUE);
+
+      g_assert_true (_gtk_text_layout_validate_finish (layout, result, NULL));
+      g_clear_object (&result);
+    }
+
+  /* The whole buffer went through the workers, in several batches */
+  g_assert_cmpint (n_batches, >, 1);
+  g_assert_true (gtk_text_layout_is_valid (layout));
+
+  gtk_text_layout_validate (reference, G_MAXINT);
+  g_assert_true (gtk_text_layout_is_valid (reference));
+
+  for (i = 0; i < gtk_text_buffer_get_line_count (buffer); i++)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, i);
+      gtk_text_layout_get_line_yrange (layout, &iter, &y, &height);
+      gtk_text_layout_get_line_yrange (reference, &iter, &ref_y, &ref_height);
+      g_assert_cmpint (y, ==, ref_y);
+      g_assert_cmpint (height, ==, ref_height);
+    }
+
+  /* Lines with children are still measured on the main thread,
+   * which allocates the children
+   */
+  g_assert_cmpint (pos.n_allocations, >, 0);
+  g_assert_cmpint (ref_pos.n_allocations, >, 0);
+  g_assert_cmpint (pos.x, ==, ref_pos.x);
+  g_assert_cmpint (pos.y, ==, ref_pos.y);
+
+  gtk_text_child_anchor_unregister_child (anchor, child);
+  gtk_text_child_anchor_unregister_child (anchor, ref_child);
+  gtk_text_layout_set_buffer (layout, NULL);
+  gtk_text_layout_set_buffer (reference, NULL);
+  g_object_unref (layout);
+  g_object_unref (reference);
+  g_object_unref (child);
+  g_object_unref (ref_child);
+  g_object_unref (widget);
+  g_object_unref (buffer);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/textview/line-display-cache", test_line_display_cache);
+  g_test_add_func ("/textview/background-validation", test_background_validation);
+  g_test_add_func ("/textview/background-validation-batches", test_background_validation_batches);
+  g_test_add_func ("/textview/estimate-line-heights", test_estimate_line_heights);
+  g_test_add_func ("/textview/max-lines", test_max_lines);
+
+  return g_test_run ();
+}
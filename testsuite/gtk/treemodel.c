@@ -29,6 +29,7 @@ main (int    argc,
 
   register_list_store_tests ();
   register_tree_store_tests ();
+  register_column_store_tests ();
   register_model_ref_count_tests ();
   register_sort_model_tests ();
   register_filter_model_tests ();
@@ -60,6 +61,9 @@ signal_name_to_string (SignalName signal)
       case ROWS_REORDERED:
           return "rows-reordered";
 
+      case ROWS_INSERTED:
+          return "rows-inserted";
+
       default:
           /* Fall through */
           break;
@@ -73,7 +77,9 @@ typedef struct
   SignalName signal;
   GtkTreePath *path;
 
-  /* For rows-reordered */
+  /* For rows-reordered, len is also the number of rows
+   * for rows-inserted
+   */
   int *new_order;
   int len;
 }
@@ -120,6 +126,7 @@ struct _SignalMonitor
   GQueue *queue;
   GtkTreeModel *client;
   gulong signal_ids[LAST_SIGNAL];
+  gboolean monitor_ranges;
 };
 
 
@@ -129,10 +136,17 @@ signal_monitor_generic_handler (SignalMonitor *m,
                                 GtkTreeModel  *model,
                                 GtkTreeIter   *iter,
                                 GtkTreePath   *path,
-                                int           *new_order)
+                                int           *new_order,
+                                int            n_rows)
 {
   Signal *s;
 
+  /* Range signals are only checked by the tests that ask for them;
+   * everybody else sees them through the per-row emissions.
+   */
+  if (signal == ROWS_INSERTED && !m->monitor_ranges)
+    return;
+
   if (g_queue_is_empty (m->queue))
     {
       gchar *path_str;
@@ -194,6 +208,9 @@ signal_monitor_generic_handler (SignalMonitor *m,
         g_assert (s->new_order[i] == new_order[i]);
     }
 
+  if (signal == ROWS_INSERTED)
+    g_assert_cmpint (s->len, ==, n_rows);
+
   s = g_queue_pop_tail (m->queue);
 
   signal_free (s);
@@ -206,7 +223,7 @@ signal_monitor_row_inserted (GtkTreeModel *model,
                              gpointer      data)
 {
   signal_monitor_generic_handler (data, ROW_INSERTED,
-                                  model, iter, path, NULL);
+                                  model, iter, path, NULL, 0);
 }
 
 static void
@@ -215,7 +232,7 @@ signal_monitor_row_deleted (GtkTreeModel *model,
                             gpointer      data)
 {
   signal_monitor_generic_handler (data, ROW_DELETED,
-                                  model, NULL, path, NULL);
+                                  model, NULL, path, NULL, 0);
 }
 
 static void
@@ -225,7 +242,7 @@ signal_monitor_row_changed (GtkTreeModel *model,
                             gpointer      data)
 {
   signal_monitor_generic_handler (data, ROW_CHANGED,
-                                  model, iter, path, NULL);
+                                  model, iter, path, NULL, 0);
 }
 
 static void
@@ -235,7 +252,7 @@ signal_monitor_row_has_child_toggled (GtkTreeModel *model,
                                       gpointer      data)
 {
   signal_monitor_generic_handler (data, ROW_HAS_CHILD_TOGGLED,
-                                  model, iter, path, NULL);
+                                  model, iter, path, NULL, 0);
 }
 
 static void
@@ -246,7 +263,18 @@ signal_monitor_rows_reordered (GtkTreeModel *model,
                                gpointer      data)
 {
   signal_monitor_generic_handler (data, ROWS_REORDERED,
-                                  model, iter, path, new_order);
+                                  model, iter, path, new_order, 0);
+}
+
+static void
+signal_monitor_rows_inserted (GtkTreeModel *model,
+                              GtkTreePath  *path,
+                              GtkTreeIter  *iter,
+                              gint          n_rows,
+                              gpointer      data)
+{
+  signal_monitor_generic_handler (data, ROWS_INSERTED,
+                                  model, iter, path, NULL, n_rows);
 }
 
 SignalMonitor *
@@ -278,6 +306,10 @@ signal_monitor_new (GtkTreeModel *client)
                                                     "rows-reordered",
                                                     G_CALLBACK (signal_monitor_rows_reordered),
                                                     m);
+  m->signal_ids[ROWS_INSERTED] = g_signal_connect (client,
+                                                   "rows-inserted",
+                                                   G_CALLBACK (signal_monitor_rows_inserted),
+                                                   m);
 
   return m;
 }
@@ -343,3 +375,21 @@ signal_monitor_append_signal (SignalMonitor *m,
 
   gtk_tree_path_free (path);
 }
+
+void
+signal_monitor_append_rows_inserted (SignalMonitor *m,
+                                     const gchar   *path_string,
+                                     int            n_rows)
+{
+  Signal *s;
+  GtkTreePath *path;
+
+  path = gtk_tree_path_new_from_string (path_string);
+
+  s = signal_new (ROWS_INSERTED, path);
+  s->len = n_rows;
+  g_queue_push_head (m->queue, s);
+  m->monitor_ranges = TRUE;
+
+  gtk_tree_path_free (path);
+}
@@ -19,6 +19,7 @@
 
 void register_list_store_tests ();
 void register_tree_store_tests ();
+void register_column_store_tests ();
 void register_sort_model_tests ();
 void register_filter_model_tests ();
 void register_model_ref_count_tests ();
@@ -36,6 +37,7 @@ enum _SignalName
   ROW_CHANGED,
   ROW_HAS_CHILD_TOGGLED,
   ROWS_REORDERED,
+  ROWS_INSERTED,
   LAST_SIGNAL
 };
 
@@ -56,3 +58,6 @@ void           signal_monitor_append_signal_path      (SignalMonitor *m,
 void           signal_monitor_append_signal           (SignalMonitor *m,
                                                        SignalName     signal,
                                                        const gchar   *path_string);
+void           signal_monitor_append_rows_inserted    (SignalMonitor *m,
+                                                       const gchar   *path_string,
+                                                       int            n_rows);
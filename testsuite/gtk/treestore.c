@@ -458,6 +458,73 @@ tree_store_test_insert_before_NULL (void)
   g_object_unref (store);
 }
 
+static void
+count_has_child_toggled (GtkTreeModel *model,
+                         GtkTreePath  *path,
+                         GtkTreeIter  *iter,
+                         gpointer      data)
+{
+  gint *count = data;
+
+  (*count)++;
+}
+
+static void
+tree_store_test_insert_rows (void)
+{
+  GtkTreeIter parent, iter;
+  GtkTreeStore *store;
+  GValue values[10] = { G_VALUE_INIT, };
+  gint column = 0;
+  gint toggled = 0;
+  gint i, n;
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  gtk_tree_store_append (store, &parent, NULL);
+
+  g_signal_connect (store, "row-has-child-toggled",
+                    G_CALLBACK (count_has_child_toggled), &toggled);
+
+  for (i = 0; i < 10; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], i < 5 ? i : i + 5);
+    }
+
+  /* Append to a parent without children */
+  gtk_tree_store_insert_rows_with_valuesv (store, &parent, -1, 5,
+                                           &column, values, 1);
+  g_assert_cmpint (toggled, ==, 1);
+
+  /* Append to a parent with children */
+  gtk_tree_store_insert_rows_with_valuesv (store, &parent, -1, 5,
+                                           &column, values + 5, 1);
+  g_assert_cmpint (toggled, ==, 1);
+
+  /* Insert in the middle */
+  for (i = 0; i < 5; i++)
+    g_value_set_int (&values[i], i + 5);
+  gtk_tree_store_insert_rows_with_valuesv (store, &parent, 5, 5,
+                                           &column, values, 1);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), &parent), ==, 15);
+
+  i = 0;
+  g_assert (gtk_tree_model_iter_children (GTK_TREE_MODEL (store), &iter, &parent));
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &n, -1);
+      g_assert_cmpint (n, ==, i);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+
+  for (i = 0; i < 10; i++)
+    g_value_unset (&values[i]);
+
+  g_object_unref (store);
+}
+
 /* setting values */
 static void
 tree_store_set_gvalue_to_transform (void)
@@ -1095,6 +1162,8 @@ register_tree_store_tests (void)
 		   tree_store_test_insert_before);
   g_test_add_func ("/TreeStore/insert-before-NULL",
 		   tree_store_test_insert_before_NULL);
+  g_test_add_func ("/TreeStore/insert-rows",
+                   tree_store_test_insert_rows);
 
   /* setting values (FIXME) */
   g_test_add_func ("/TreeStore/set-gvalue-to-transform",
@@ -344,6 +344,552 @@ test_selection_empty (void)
   gtk_widget_destroy (view);
 }
 
+static void
+test_insert_rows (void)
+{
+  GtkTreePath *path;
+  GtkListStore *list_store;
+  GtkTreeModel *filter;
+  GtkTreeSelection *selection;
+  GtkWidget *view;
+  GValue values[8] = { G_VALUE_INIT, };
+  gint columns[2] = { 0, 1 };
+  gboolean visible[] = { TRUE, FALSE, TRUE, TRUE };
+  gint i;
+
+  list_store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_BOOLEAN);
+  for (i = 0; i < 5; i++)
+    gtk_list_store_insert_with_values (list_store, NULL, i, 0, i, 1, TRUE, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (list_store), NULL);
+  gtk_tree_model_filter_set_visible_column (GTK_TREE_MODEL_FILTER (filter), 1);
+  view = gtk_tree_view_new_with_model (filter);
+
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (view));
+  gtk_tree_selection_set_mode (selection, GTK_SELECTION_MULTIPLE);
+
+  path = gtk_tree_path_new_from_indices (3, -1);
+  gtk_tree_selection_select_path (selection, path);
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_path_new_from_indices (4, -1);
+  gtk_tree_view_set_cursor (GTK_TREE_VIEW (view), path, NULL, FALSE);
+  gtk_tree_path_free (path);
+
+  /* Three of the four rows pass the filter, and reach the view
+   * as a single range in front of the selection and the cursor.
+   */
+  for (i = 0; i < 4; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 10 + i);
+      g_value_init (&values[4 + i], G_TYPE_BOOLEAN);
+      g_value_set_boolean (&values[4 + i], visible[i]);
+    }
+
+  gtk_list_store_insert_rows_with_valuesv (list_store, 2, 4, columns, values, 2);
+
+  for (i = 0; i < 8; i++)
+    g_value_unset (&values[i]);
+
+  g_assert_cmpint (gtk_tree_selection_count_selected_rows (selection), ==, 1);
+
+  for (i = 2; i < 5; i++)
+    {
+      path = gtk_tree_path_new_from_indices (i, -1);
+      g_assert_false (gtk_tree_selection_path_is_selected (selection, path));
+      gtk_tree_path_free (path);
+    }
+
+  path = gtk_tree_path_new_from_indices (6, -1);
+  g_assert_true (gtk_tree_selection_path_is_selected (selection, path));
+  gtk_tree_path_free (path);
+
+  gtk_tree_view_get_cursor (GTK_TREE_VIEW (view), &path, NULL);
+  g_assert_nonnull (path);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 7);
+  gtk_tree_path_free (path);
+
+  /* Every new row got a node */
+  gtk_tree_selection_select_all (selection);
+  g_assert_cmpint (gtk_tree_selection_count_selected_rows (selection), ==, 8);
+
+  gtk_widget_destroy (view);
+  g_object_unref (filter);
+  g_object_unref (list_store);
+}
+
+static GtkWidget *
+create_sized_view (GtkTreeModel *model,
+                   gboolean      background_validation)
+{
+  GtkWidget *window;
+  GtkWidget *sw;
+  GtkWidget *view;
+
+  window = gtk_offscreen_window_new ();
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_widget_set_size_request (sw, 200, 200);
+
+  view = gtk_tree_view_new_with_model (model);
+  gtk_tree_view_set_background_validation (GTK_TREE_VIEW (view), background_validation);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view),
+                                               0,
+                                               "Test",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+
+  gtk_container_add (GTK_CONTAINER (sw), view);
+  gtk_container_add (GTK_CONTAINER (window), sw);
+  gtk_widget_show_all (window);
+
+  return view;
+}
+
+static gint
+get_row_height (GtkWidget *view,
+                gint       index)
+{
+  GtkTreePath *path;
+  GdkRectangle rect;
+
+  path = gtk_tree_path_new_from_indices (index, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (view), path, NULL, &rect);
+  gtk_tree_path_free (path);
+
+  return rect.height;
+}
+
+static gboolean
+rows_are_sized (GtkWidget *view,
+                GtkWidget *reference,
+                gint       n_rows)
+{
+  gint i;
+
+  /* Rows with two lines must be taller than rows with one */
+  if (get_row_height (view, n_rows - 1) <= get_row_height (view, n_rows - 2))
+    return FALSE;
+
+  for (i = 0; i < n_rows; i++)
+    if (get_row_height (view, i) != get_row_height (reference, i))
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+test_background_validation (void)
+{
+  GtkListStore *store;
+  GtkWidget *view;
+  GtkWidget *reference;
+  gint64 end_time;
+  gint n_rows = 5000;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < n_rows; i++)
+    gtk_list_store_insert_with_values (store, NULL, i,
+                                       0, i % 2 ? "Two\nlines" : "One line",
+                                       -1);
+
+  view = create_sized_view (GTK_TREE_MODEL (store), TRUE);
+  reference = create_sized_view (GTK_TREE_MODEL (store), FALSE);
+
+  g_assert_true (gtk_tree_view_get_background_validation (GTK_TREE_VIEW (view)));
+
+  end_time = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+  while (!rows_are_sized (view, reference, n_rows) &&
+         g_get_monotonic_time () < end_time)
+    {
+      if (!g_main_context_iteration (NULL, FALSE))
+        g_usleep (1000);
+    }
+
+  g_assert_true (rows_are_sized (view, reference, n_rows));
+
+  /* Changes after validation are picked up as well */
+  gtk_list_store_insert_with_values (store, NULL, n_rows,
+                                     0, "One line", -1);
+  gtk_list_store_insert_with_values (store, NULL, n_rows + 1,
+                                     0, "Three\nlines\nnow", -1);
+  n_rows += 2;
+
+  end_time = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+  while (!rows_are_sized (view, reference, n_rows) &&
+         g_get_monotonic_time () < end_time)
+    {
+      if (!g_main_context_iteration (NULL, FALSE))
+        g_usleep (1000);
+    }
+
+  g_assert_true (rows_are_sized (view, reference, n_rows));
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (view));
+  gtk_widget_destroy (gtk_widget_get_toplevel (reference));
+  g_object_unref (store);
+}
+
+static gint
+height_class_by_depth (GtkTreeModel *model,
+                       GtkTreeIter  *iter,
+                       gint          depth,
+                       gpointer      data)
+{
+  return depth - 1;
+}
+
+static gint
+get_path_height (GtkWidget   *view,
+                 const gchar *path_string)
+{
+  GtkTreePath *path;
+  GdkRectangle rect;
+
+  path = gtk_tree_path_new_from_string (path_string);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (view), path, NULL, &rect);
+  gtk_tree_path_free (path);
+
+  return rect.height;
+}
+
+static void
+test_row_height_classes (void)
+{
+  GtkTreeStore *store;
+  GtkTreeIter parent;
+  GtkTreeViewColumn *column;
+  GtkWidget *window;
+  GtkWidget *view;
+  GtkWidget *reference;
+  gint i, j;
+
+  store = gtk_tree_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 10; i++)
+    {
+      gtk_tree_store_insert_with_values (store, &parent, NULL, i,
+                                         0, "Parent", -1);
+      for (j = 0; j < 10; j++)
+        gtk_tree_store_insert_with_values (store, NULL, &parent, j,
+                                           0, "Child\nwith two lines", -1);
+    }
+
+  window = gtk_offscreen_window_new ();
+  view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  column = gtk_tree_view_column_new_with_attributes ("Test",
+                                                     gtk_cell_renderer_text_new (),
+                                                     "text", 0,
+                                                     NULL);
+  gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+  gtk_tree_view_column_set_fixed_width (column, 200);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (view), column);
+  gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (view), TRUE);
+  gtk_tree_view_set_row_height_class_func (GTK_TREE_VIEW (view),
+                                           height_class_by_depth,
+                                           NULL, NULL);
+  gtk_tree_view_expand_all (GTK_TREE_VIEW (view));
+  gtk_container_add (GTK_CONTAINER (window), view);
+  gtk_widget_show_all (window);
+
+  window = gtk_offscreen_window_new ();
+  reference = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (reference),
+                                               0,
+                                               "Test",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_expand_all (GTK_TREE_VIEW (reference));
+  gtk_container_add (GTK_CONTAINER (window), reference);
+  gtk_widget_show_all (window);
+
+  gtk_test_widget_wait_for_draw (view);
+  gtk_test_widget_wait_for_draw (reference);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_assert_cmpint (get_path_height (view, "9"), ==, get_path_height (reference, "9"));
+  g_assert_cmpint (get_path_height (view, "9:9"), ==, get_path_height (reference, "9:9"));
+  g_assert_cmpint (get_path_height (view, "9:9"), >, get_path_height (view, "9"));
+
+  /* Rows added later get the height of their class right away */
+  gtk_tree_store_insert_with_values (store, &parent, NULL, 10,
+                                     0, "Parent", -1);
+  g_assert_cmpint (get_path_height (view, "10"), ==, get_path_height (view, "0"));
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (view));
+  gtk_widget_destroy (gtk_widget_get_toplevel (reference));
+  g_object_unref (store);
+}
+
+static GtkWidget *
+create_search_view (GtkTreeModel           *model,
+                    GtkTreeViewSearchIndex  index)
+{
+  GtkWidget *view, *entry;
+
+  view = gtk_tree_view_new_with_model (model);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1, "Text",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_set_search_index (GTK_TREE_VIEW (view), index);
+
+  entry = gtk_entry_new ();
+  gtk_tree_view_set_search_entry (GTK_TREE_VIEW (view), GTK_ENTRY (entry));
+
+  g_object_ref_sink (view);
+
+  return view;
+}
+
+static gint
+search_row (GtkWidget   *view,
+            const gchar *text)
+{
+  GtkEntry *entry;
+  GtkTreePath *path;
+  gint row = -1;
+
+  entry = gtk_tree_view_get_search_entry (GTK_TREE_VIEW (view));
+  gtk_entry_set_text (entry, "");
+
+  path = gtk_tree_path_new_first ();
+  gtk_tree_view_set_cursor (GTK_TREE_VIEW (view), path, NULL, FALSE);
+  gtk_tree_path_free (path);
+
+  gtk_entry_set_text (entry, text);
+
+  gtk_tree_view_get_cursor (GTK_TREE_VIEW (view), &path, NULL);
+  if (path)
+    {
+      row = gtk_tree_path_get_indices (path)[0];
+      gtk_tree_path_free (path);
+    }
+
+  return row;
+}
+
+static gint
+search_next_row (GtkWidget *view)
+{
+  GtkEntry *entry;
+  GtkTreePath *path;
+  GdkEvent *event;
+  gboolean handled;
+  gint row = -1;
+
+  entry = gtk_tree_view_get_search_entry (GTK_TREE_VIEW (view));
+
+  event = gdk_event_new (GDK_KEY_PRESS);
+  event->key.keyval = GDK_KEY_Down;
+  g_signal_emit_by_name (entry, "key-press-event", event, &handled);
+  gdk_event_free (event);
+
+  gtk_tree_view_get_cursor (GTK_TREE_VIEW (view), &path, NULL);
+  if (path)
+    {
+      row = gtk_tree_path_get_indices (path)[0];
+      gtk_tree_path_free (path);
+    }
+
+  return row;
+}
+
+static void
+count_values_modify (GtkTreeModel *model,
+                     GtkTreeIter  *iter,
+                     GValue       *value,
+                     gint          column,
+                     gpointer      data)
+{
+  GtkTreeModel *child_model;
+  GtkTreeIter child_iter;
+  GValue child_value = G_VALUE_INIT;
+  gint *n_values = data;
+
+  (*n_values)++;
+
+  child_model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (model));
+  gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (model),
+                                                    &child_iter, iter);
+  gtk_tree_model_get_value (child_model, &child_iter, column, &child_value);
+  g_value_copy (&child_value, value);
+  g_value_unset (&child_value);
+}
+
+/* Waits until searching @view does not look at the model anymore,
+ * which is when its index is ready.
+ */
+static void
+wait_for_search_index (GtkWidget *view,
+                       gint      *n_values)
+{
+  while (TRUE)
+    {
+      *n_values = 0;
+      search_row (view, "row 1");
+      if (*n_values == 0)
+        break;
+
+      g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+static void
+test_search_index (void)
+{
+  const gchar *queries[] = { "row 1", "ROW 19", "émile", "EMILE 7", "mile 5", "5", "nothing" };
+  GType types[] = { G_TYPE_STRING };
+  GtkListStore *store;
+  GtkTreeModel *filter;
+  GtkWidget *plain, *prefix, *substring;
+  GtkTreeIter iter;
+  gint n_values = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 2000; i++)
+    {
+      gchar *text = g_strdup_printf (i % 3 ? "Row %d" : "\xc3\x89mile %d", 1999 - i);
+      gtk_list_store_insert_with_values (store, NULL, i, 0, text, -1);
+      g_free (text);
+    }
+
+  /* The indexed views see the rows through a filter that counts how
+   * often a value is looked up */
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_modify_func (GTK_TREE_MODEL_FILTER (filter),
+                                         G_N_ELEMENTS (types), types,
+                                         count_values_modify, &n_values, NULL);
+
+  plain = create_search_view (GTK_TREE_MODEL (store), GTK_TREE_VIEW_SEARCH_INDEX_NONE);
+  prefix = create_search_view (filter, GTK_TREE_VIEW_SEARCH_INDEX_PREFIX);
+  substring = create_search_view (filter, GTK_TREE_VIEW_SEARCH_INDEX_SUBSTRING);
+
+  /* While the index is built, searching walks the model */
+  for (i = 0; i < G_N_ELEMENTS (queries); i++)
+    g_assert_cmpint (search_row (prefix, queries[i]), ==, search_row (plain, queries[i]));
+
+  g_assert_cmpint (search_row (substring, "mile 5"), ==, 1401);
+  g_assert_cmpint (search_row (substring, "w 1997"), ==, 2);
+
+  wait_for_search_index (prefix, &n_values);
+  wait_for_search_index (substring, &n_values);
+
+  /* Afterwards, it gives the same results without looking at the model */
+  n_values = 0;
+  for (i = 0; i < G_N_ELEMENTS (queries); i++)
+    g_assert_cmpint (search_row (prefix, queries[i]), ==, search_row (plain, queries[i]));
+
+  g_assert_cmpint (search_row (substring, "mile 5"), ==, 1401);
+  g_assert_cmpint (search_row (substring, "w 1997"), ==, 2);
+  g_assert_cmpint (n_values, ==, 0);
+
+  /* Changes to the model are followed */
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 1000);
+  gtk_list_store_set (store, &iter, 0, "Changed", -1);
+  gtk_list_store_insert_with_values (store, NULL, 500, 0, "Inserted", -1);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 10);
+  gtk_list_store_remove (store, &iter);
+
+  n_values = 0;
+  g_assert_cmpint (search_row (prefix, "changed"), ==, 1000);
+  g_assert_cmpint (search_row (prefix, "inser"), ==, 499);
+  g_assert_cmpint (search_row (substring, "hange"), ==, 1000);
+  for (i = 0; i < G_N_ELEMENTS (queries); i++)
+    g_assert_cmpint (search_row (prefix, queries[i]), ==, search_row (plain, queries[i]));
+  g_assert_cmpint (n_values, ==, 0);
+
+  /* Moving to the next match continues after the current one, also
+   * when rows are inserted or deleted in front of it */
+  search_row (plain, "row 19");
+  search_row (prefix, "row 19");
+  g_assert_cmpint (search_next_row (prefix), ==, search_next_row (plain));
+
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, "Inserted", -1);
+
+  n_values = 0;
+  g_assert_cmpint (search_next_row (prefix), ==, search_next_row (plain));
+  g_assert_cmpint (n_values, ==, 0);
+
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_list_store_remove (store, &iter);
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_list_store_remove (store, &iter);
+
+  n_values = 0;
+  g_assert_cmpint (search_next_row (prefix), ==, search_next_row (plain));
+  g_assert_cmpint (n_values, ==, 0);
+
+  g_object_unref (plain);
+  g_object_unref (prefix);
+  g_object_unref (substring);
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
+/* A model that keeps growing while its texts are collected still
+ * gets an index
+ */
+static void
+test_search_index_append (void)
+{
+  GType types[] = { G_TYPE_STRING };
+  GtkListStore *store;
+  GtkTreeModel *filter;
+  GtkWidget *view;
+  gint n_values = 0;
+  gint n_rows = 50000;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < n_rows; i++)
+    {
+      gchar *text = g_strdup_printf ("Row %d", i);
+      gtk_list_store_insert_with_values (store, NULL, i, 0, text, -1);
+      g_free (text);
+    }
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_modify_func (GTK_TREE_MODEL_FILTER (filter),
+                                         G_N_ELEMENTS (types), types,
+                                         count_values_modify, &n_values, NULL);
+  view = create_search_view (filter, GTK_TREE_VIEW_SEARCH_INDEX_PREFIX);
+
+  for (i = 0; ; i++)
+    {
+      gchar *text = g_strdup_printf ("Appended %d", i);
+
+      g_assert_cmpint (i, <, 10000);
+
+      gtk_list_store_insert_with_values (store, NULL, -1, 0, text, -1);
+      gtk_list_store_insert_with_values (store, NULL, 0, 0, text, -1);
+      g_free (text);
+      n_rows += 2;
+
+      n_values = 0;
+      search_row (view, "row 0");
+      if (n_values == 0)
+        break;
+
+      g_main_context_iteration (NULL, TRUE);
+    }
+
+  n_values = 0;
+  g_assert_cmpint (search_row (view, "row 0"), ==, i + 1);
+  g_assert_cmpint (search_row (view, "appended 0"), ==, i);
+  g_assert_cmpint (search_next_row (view), ==, n_rows - i - 1);
+  g_assert_cmpint (n_values, ==, 0);
+
+  g_object_unref (view);
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -359,6 +905,13 @@ main (int    argc,
                    test_row_separator_height);
   g_test_add_func ("/TreeView/selection/count", test_selection_count);
   g_test_add_func ("/TreeView/selection/empty", test_selection_empty);
+  g_test_add_func ("/TreeView/selection/insert-rows", test_insert_rows);
+  g_test_add_func ("/TreeView/sizing/background-validation",
+                   test_background_validation);
+  g_test_add_func ("/TreeView/sizing/row-height-classes",
+                   test_row_height_classes);
+  g_test_add_func ("/TreeView/search/index", test_search_index);
+  g_test_add_func ("/TreeView/search/index-append", test_search_index_append);
 
   return g_test_run ();
 }